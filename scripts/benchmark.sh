@@ -0,0 +1,15 @@
+# This script compiles and runs the performance benchmarks.
+#!/bin/bash
+# Compile the benchmarks
+echo "Compiling the benchmarks..."
+
+# mamba activate pytraj_env
+
+cmake -S ./test -B test/build -Wno-dev -DCMAKE_BUILD_TYPE=Release
+make -C ./test/build PyTraj_bench
+
+# Run the benchmarks
+echo "Running the benchmarks..."
+./test/build/PyTraj_bench
+
+echo "Done."
@@ -0,0 +1,44 @@
+import sys
+import os
+from ctypes import *
+from impact_plot import *
+
+# Specify the input file names (without the extension), run_0 to run_4 by default
+config_files = sys.argv[1:] if len(sys.argv) > 1 else [f"run_{i}" for i in range(5)]
+
+# Check for the existence of the input files
+for config_file in config_files:
+    config_path = f"./input/{config_file}.toml"
+    if not os.path.isfile(config_path):
+        print(f"Error: The input file {config_file}.toml does not exist.")
+        sys.exit()
+
+# Import the necessary functions from the Python library
+sys.path.append('.')
+from src.pylib import *
+so_file = "./build/libPyTraj.so"
+pytraj = CDLL(so_file)
+
+# Code block to run the Monte Carlo simulations of all scenarios in one batch
+if __name__ == "__main__":
+    # Read the configuration files (read_config creates the output directories)
+    scenarios = []
+    for config_file in config_files:
+        print("Reading configuration file " + config_file + ".toml...")
+        scenarios.append(read_config(config_file))
+    print("Configuration files read.")
+
+    stats = batch_run(scenarios)
+    print_batch_stats(stats)
+    print("Monte Carlo simulations complete.")
+
+    for config_file, run_params in zip(config_files, scenarios):
+        print(f"{config_file} aimpoint: ({run_params.x_aim}, {run_params.y_aim}, {run_params.z_aim})")
+
+        # Copy the input file to the output directory
+        os.system(f"cp ./input/{config_file}.toml ./output/{config_file}")
+
+        # Plot the impact data
+        print("Plotting impact data of " + config_file + "...")
+        impact_plot("./output/" + config_file + "/", run_params)
+    print("Impact data plotted.")
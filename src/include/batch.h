@@ -0,0 +1,283 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <gsl/gsl_rng.h>
+#include "trajectory.h"
+#include "pool.h"
+
+// Define the number of run parameters that determine the nominal trajectory of update_aimpoint
+#define BATCH_NOMINAL_PARAMS 5
+
+// Define the number of reentry vehicle types, each with its own vehicle profile
+#define BATCH_NUM_VEHICLES 2
+
+// Define a struct to store the statistics of a batch of scenarios
+typedef struct batch_stats{
+    int num_scenarios; // number of scenarios
+    int num_runs; // number of Monte Carlo runs of all scenarios
+    int num_nominals; // number of nominal trajectories flown, one per distinct nominal
+    int num_vehicles; // number of vehicle profiles built, one per reentry vehicle type in use
+    int num_threads; // number of threads of the pool
+    double wall_time; // wall-clock time of the runs in seconds
+    double busy_time; // sum over the runs of their flight times in seconds
+    double utilization; // busy time over the wall-clock time of all threads
+} batch_stats;
+
+// Define a struct to store one Monte Carlo run of a batch
+typedef struct batch_task{
+    int scenario; // index of the scenario
+    int run; // index of the run in the scenario
+    double cost; // estimated integration steps of the run
+} batch_task;
+
+// Define a struct to store the inputs and outputs of the runs of a batch
+typedef struct batch_context{
+    runparams *scenarios; // run parameters of each scenario
+    const vehicle *profiles; // shared vehicle profile of each reentry vehicle type
+    uint64_t seed; // seed of every scenario, as in mc_run
+    const batch_task *tasks; // runs in the order of the parallel loop
+    state **impact_states; // impact states of the runs of each scenario
+    double *run_times; // flight time of each task in seconds
+} batch_context;
+
+void batch_nominal_params(runparams *run_params, double *params){
+    /*
+    Gets the run parameters that the nominal trajectory of update_aimpoint depends on, once its errors, navigation
+    and guidance are turned off. Scenarios with equal parameters share one nominal trajectory
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        params: double *
+            array of BATCH_NOMINAL_PARAMS values to be filled
+    */
+
+    params[0] = run_params->time_step_main;
+    params[1] = run_params->time_step_reentry;
+    params[2] = run_params->theta_long;
+    params[3] = run_params->theta_lat;
+    params[4] = run_params->rv_type;
+}
+
+int compare_batch_tasks(const void *a, const void *b){
+    /*
+    Orders the runs of a batch by decreasing estimated cost, then by scenario and run, for qsort
+
+    INPUTS:
+    ----------
+        a: const void *
+            pointer to the first run
+        b: const void *
+            pointer to the second run
+    OUTPUTS:
+    ----------
+        order: int
+            -1, 0 or 1 if the first run is to be dealt before, with or after the second
+    */
+
+    const batch_task *x = (const batch_task *)a;
+    const batch_task *y = (const batch_task *)b;
+    if (x->cost != y->cost){
+        return (x->cost < y->cost) - (x->cost > y->cost);
+    }
+    if (x->scenario != y->scenario){
+        return (x->scenario > y->scenario) - (x->scenario < y->scenario);
+    }
+    return (x->run > y->run) - (x->run < y->run);
+}
+
+void batch_task_run(void *context, int index){
+    /*
+    Flies one Monte Carlo run of a batch with the shared vehicle profile of its scenario (pool_task interface)
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the batch_context struct
+        index: int
+            index of the run in the parallel loop
+    */
+
+    batch_context *batch = (batch_context *)context;
+    const batch_task *task = &batch->tasks[index];
+    runparams *run_params = &batch->scenarios[task->scenario];
+
+    double start = pool_clock();
+    batch->impact_states[task->scenario][task->run] = mc_vehicle_run(run_params, batch->seed, task->run, &batch->profiles[run_params->rv_type], NULL);
+    batch->run_times[index] = pool_clock() - start;
+}
+
+batch_stats batch_run(runparams *scenarios, int num_scenarios, int num_threads){
+    /*
+    Runs the Monte Carlo simulations of several scenarios on one worker pool. Each scenario gets the aimpoint of
+    update_aimpoint and the runs of mc_run, written to its impact_data_path in the format of mc_run, so that the
+    batch reproduces the scenarios run one at a time. Scenarios that share a nominal trajectory (the same time
+    steps, thrust angles and reentry vehicle) share one nominal flight, and scenarios with the same reentry vehicle
+    type share its vehicle profile. The runs of all scenarios then form one parallel loop. The pool starts each
+    thread on an equal contiguous range of the loop, so the runs are dealt to the ranges in turn by decreasing
+    estimated cost: every range starts with its most expensive runs and holds an equal share of the work, and
+    stealing evens out the rest. Trajectory output is not written in a batch
+
+    INPUTS:
+    ----------
+        scenarios: runparams *
+            array of run parameters of each scenario, whose aimpoints are updated
+        num_scenarios: int
+            number of scenarios
+        num_threads: int
+            number of threads of the pool (0: one per online processor)
+    OUTPUTS:
+    ----------
+        stats: batch_stats
+            numbers of runs, nominal flights and vehicle profiles, and the utilization of the threads
+    */
+
+    batch_stats stats = {0};
+    stats.num_scenarios = num_scenarios;
+    stats.num_threads = (num_threads > 0) ? num_threads : pool_default_threads();
+
+    gsl_rng_env_setup();
+    uint64_t seed = gsl_rng_default_seed;
+
+    // Build the vehicle profiles in use
+    vehicle profiles[BATCH_NUM_VEHICLES];
+    int built[BATCH_NUM_VEHICLES] = {0};
+    for (int s = 0; s < num_scenarios; s++){
+        int rv_type = scenarios[s].rv_type;
+        if (rv_type < 0 || rv_type >= BATCH_NUM_VEHICLES){
+            printf("Error: Invalid RV type\n");
+            exit(1);
+        }
+        if (!built[rv_type]){
+            profiles[rv_type] = (rv_type == 1) ? init_mmiii_swerve() : init_mmiii_ballistic();
+            built[rv_type] = 1;
+            stats.num_vehicles++;
+        }
+        scenarios[s].traj_output = 0;
+        scenarios[s].traj_archive = 0;
+    }
+
+    // Fly the distinct nominal trajectories and update the aimpoints
+    double (*nominal_params)[BATCH_NOMINAL_PARAMS] = malloc(num_scenarios * sizeof(*nominal_params));
+    cart_vector *nominal_aimpoints = malloc(num_scenarios * sizeof(cart_vector));
+    for (int s = 0; s < num_scenarios; s++){
+        double params[BATCH_NOMINAL_PARAMS];
+        batch_nominal_params(&scenarios[s], params);
+        int nominal = 0;
+        while (nominal < stats.num_nominals && memcmp(nominal_params[nominal], params, sizeof(params)) != 0){
+            nominal++;
+        }
+        if (nominal == stats.num_nominals){
+            memcpy(nominal_params[nominal], params, sizeof(params));
+            nominal_aimpoints[nominal] = update_aimpoint(scenarios[s], scenarios[s].theta_long);
+            stats.num_nominals++;
+        }
+        scenarios[s].x_aim = nominal_aimpoints[nominal].x;
+        scenarios[s].y_aim = nominal_aimpoints[nominal].y;
+        scenarios[s].z_aim = nominal_aimpoints[nominal].z;
+    }
+    free(nominal_params);
+    free(nominal_aimpoints);
+
+    // List the runs of all scenarios
+    for (int s = 0; s < num_scenarios; s++){
+        stats.num_runs += scenarios[s].num_runs;
+    }
+    batch_task *tasks = malloc(stats.num_runs * sizeof(batch_task));
+    state **impact_states = malloc(num_scenarios * sizeof(state *));
+    int num_tasks = 0;
+    for (int s = 0; s < num_scenarios; s++){
+        vehicle *profile = &profiles[scenarios[s].rv_type];
+        double cost = profile->booster.total_burn_time / scenarios[s].time_step_main + EXPECTED_REENTRY_TIME / scenarios[s].time_step_reentry;
+        impact_states[s] = malloc(scenarios[s].num_runs * sizeof(state));
+        for (int run = 0; run < scenarios[s].num_runs; run++){
+            tasks[num_tasks].scenario = s;
+            tasks[num_tasks].run = run;
+            tasks[num_tasks].cost = cost;
+            num_tasks++;
+        }
+    }
+    if (stats.num_threads > num_tasks){
+        stats.num_threads = (num_tasks > 0) ? num_tasks : 1;
+    }
+
+    // Deal the runs, most expensive first, to the contiguous ranges the pool starts its threads on (see pool_run)
+    qsort(tasks, num_tasks, sizeof(batch_task), compare_batch_tasks);
+    batch_task *dealt = malloc(num_tasks * sizeof(batch_task));
+    int dealt_count = 0;
+    for (int round = 0; dealt_count < num_tasks; round++){
+        for (int i = 0; i < stats.num_threads; i++){
+            int begin = (int)((long)num_tasks * i / stats.num_threads);
+            int end = (int)((long)num_tasks * (i + 1) / stats.num_threads);
+            if (begin + round < end){
+                dealt[begin + round] = tasks[dealt_count];
+                dealt_count++;
+            }
+        }
+    }
+    free(tasks);
+    tasks = dealt;
+
+    batch_context batch;
+    batch.scenarios = scenarios;
+    batch.profiles = profiles;
+    batch.seed = seed;
+    batch.tasks = tasks;
+    batch.impact_states = impact_states;
+    batch.run_times = malloc(num_tasks * sizeof(double));
+    double start = pool_clock();
+    parallel_for(stats.num_threads, batch_task_run, &batch, num_tasks);
+    stats.wall_time = pool_clock() - start;
+    for (int i = 0; i < num_tasks; i++){
+        stats.busy_time += batch.run_times[i];
+    }
+    stats.utilization = (stats.wall_time > 0) ? stats.busy_time / (stats.wall_time * stats.num_threads) : 0;
+
+    // Output the impact data of each scenario
+    for (int s = 0; s < num_scenarios; s++){
+        if (scenarios[s].impact_data_path != NULL){
+            FILE *impact_file = fopen(scenarios[s].impact_data_path, "w");
+            if (impact_file == NULL){
+                printf("Error: Could not open impact data file %s\n", scenarios[s].impact_data_path);
+            }
+            else{
+                fprintf(impact_file, "t, x, y, z, vx, vy, vz\n");
+                for (int run = 0; run < scenarios[s].num_runs; run++){
+                    state *impact_state = &impact_states[s][run];
+                    fprintf(impact_file, "%f, %f, %f, %f, %f, %f, %f\n", impact_state->t, impact_state->x, impact_state->y, impact_state->z, impact_state->vx, impact_state->vy, impact_state->vz);
+                }
+                fclose(impact_file);
+            }
+        }
+        free(impact_states[s]);
+    }
+
+    free(impact_states);
+    free(tasks);
+    free(batch.run_times);
+
+    return stats;
+}
+
+void print_batch_stats(batch_stats *stats){
+    /*
+    Prints the statistics of a batch of scenarios
+
+    INPUTS:
+    ----------
+        stats: batch_stats *
+            pointer to the batch statistics struct
+    */
+
+    printf("Batch of %d scenarios: %d runs on %d threads\n", stats->num_scenarios, stats->num_runs, stats->num_threads);
+    printf("Shared caches: %d nominal trajectories, %d vehicle profiles\n", stats->num_nominals, stats->num_vehicles);
+    printf("Wall time: %f s, thread utilization: %.1f%%\n", stats->wall_time, 100 * stats->utilization);
+}
+
+#endif
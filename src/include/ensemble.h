@@ -0,0 +1,368 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <gsl/gsl_rng.h>
+#include "trajectory.h"
+#include "lincov.h"
+#include "pool.h"
+
+// Define the magic string and the version of the post-burnout ensemble files
+#define ENSEMBLE_MAGIC "PTENSMBL"
+#define ENSEMBLE_VERSION 2
+
+// Define the number of boost-side run parameters, which a replay must share with the saved ensemble
+#define ENSEMBLE_BOOST_PARAMS 17
+
+// Define a struct to store the header of a post-burnout ensemble file
+typedef struct ensemble_header{
+    char magic[8]; // ENSEMBLE_MAGIC
+    int32_t version; // ENSEMBLE_VERSION
+    int32_t num_runs; // number of records
+    int64_t record_size; // size of a record in bytes, which ties the file to the struct layout of the build
+    uint64_t seed; // seed of the saved campaign
+    int32_t rv_type; // reentry vehicle type the boost was flown with
+    int32_t atm_error; // atmospheric perturbation flag the boost was flown with
+    double boost_params[ENSEMBLE_BOOST_PARAMS]; // boost-side run parameters (see ensemble_boost_params)
+} ensemble_header;
+
+// Define a struct to store one run of a post-burnout ensemble
+typedef struct ensemble_record{
+    flight_snapshot snapshot; // flight state at the first step after burnout
+    philox_state rng_state; // state of the random number generator of the run
+} ensemble_record;
+
+// Define a struct to store the inputs and outputs of the runs of an ensemble
+typedef struct ensemble_batch{
+    runparams *run_params; // pointer to the run parameters struct
+    ensemble_header *header; // pointer to the header of the ensemble
+    ensemble_record *records; // record of each run
+    int *steps; // integration steps of each run
+    state *impact_states; // impact state of each run (replay only)
+} ensemble_batch;
+
+void ensemble_boost_params(runparams *run_params, double *params){
+    /*
+    Gets the run parameters that act before burnout, with the reentry time step, which the saved first step after
+    burnout was flown with. A replay may change any other parameter (the reentry vehicle type and maneuverability,
+    the atmospheric perturbation flag, the guidance and lift update periods and the aimpoint)
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        params: double *
+            array of ENSEMBLE_BOOST_PARAMS values to be filled
+    */
+
+    params[0] = run_params->time_step_main;
+    params[1] = run_params->theta_long;
+    params[2] = run_params->theta_lat;
+    params[3] = run_params->grav_error;
+    params[4] = run_params->gnss_nav;
+    params[5] = run_params->ins_nav;
+    params[6] = run_params->imu_period;
+    params[7] = run_params->gnss_period;
+    params[8] = run_params->initial_x_error;
+    params[9] = run_params->initial_pos_error;
+    params[10] = run_params->initial_vel_error;
+    params[11] = run_params->initial_angle_error;
+    params[12] = run_params->acc_scale_stability;
+    params[13] = run_params->gyro_bias_stability;
+    params[14] = run_params->gyro_noise;
+    params[15] = run_params->gnss_noise;
+    params[16] = run_params->time_step_reentry;
+}
+
+void ensemble_save_task(void *context, int index){
+    /*
+    Flies one run of a Monte Carlo campaign up to the first step after burnout and stores its record (pool_task
+    interface). The run draws its errors exactly as the Monte Carlo run of the same index
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the ensemble_batch struct
+        index: int
+            index of the run
+    */
+
+    ensemble_batch *batch = (ensemble_batch *)context;
+    runparams *run_params = batch->run_params;
+    gsl_rng *rng = philox_alloc(batch->header->seed, index, PHILOX_STREAM_RUN);
+
+    vehicle vehicle;
+    if (run_params->rv_type == 0){
+        vehicle = init_mmiii_ballistic();
+    }
+    else if (run_params->rv_type == 1){
+        vehicle = init_mmiii_swerve();
+    }
+    else{
+        printf("Error: Invalid RV type\n");
+        exit(1);
+    }
+
+    state initial_state = init_true_state(run_params, rng);
+    flight flight;
+    flight_init(&flight, run_params, &initial_state, &vehicle, rng, NULL);
+    for (int i = 0; i < MAX_FLIGHT_STEPS; i++){
+        if (flight_step(&flight) || flight.new_true_state.t > vehicle.booster.total_burn_time){
+            break;
+        }
+    }
+
+    ensemble_record *record = &batch->records[index];
+    memset(record, 0, sizeof(ensemble_record));
+    flight_snapshot_take(&record->snapshot, &flight);
+    record->snapshot.flight.run_params = NULL;
+    record->rng_state = *(philox_state *)rng->state;
+    batch->steps[index] = flight.steps;
+    gsl_rng_free(rng);
+}
+
+int ensemble_save(runparams run_params, const char *path){
+    /*
+    Flies the boost phase of the run_params.num_runs runs of a Monte Carlo campaign in parallel and saves the
+    post-burnout ensemble to a binary file: for each run, the whole flight state at the first step after burnout
+    (true, estimated and desired states, IMU errors, error models, sensor noise, rate groups and vehicle mass) and
+    the state of its random number generator. ensemble_replay continues the runs from there
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+        path: const char *
+            path of the ensemble file
+    OUTPUTS:
+    ----------
+        num_runs: int
+            number of runs saved, -1 if the file could not be written
+    */
+
+    run_params.traj_output = 0;
+    run_params.traj_archive = 0;
+
+    gsl_rng_env_setup();
+
+    ensemble_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ENSEMBLE_MAGIC, sizeof(header.magic));
+    header.version = ENSEMBLE_VERSION;
+    header.num_runs = run_params.num_runs;
+    header.record_size = sizeof(ensemble_record);
+    header.seed = gsl_rng_default_seed;
+    header.rv_type = run_params.rv_type;
+    header.atm_error = run_params.atm_error;
+    ensemble_boost_params(&run_params, header.boost_params);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL){
+        printf("Error: Could not open ensemble file %s\n", path);
+        return -1;
+    }
+
+    ensemble_batch batch;
+    batch.run_params = &run_params;
+    batch.header = &header;
+    batch.records = malloc(header.num_runs * sizeof(ensemble_record));
+    batch.steps = malloc(header.num_runs * sizeof(int));
+    batch.impact_states = NULL;
+    parallel_for(run_params.num_threads, ensemble_save_task, &batch, header.num_runs);
+
+    int written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(batch.records, sizeof(ensemble_record), header.num_runs, file) == (size_t)header.num_runs;
+    fclose(file);
+    free(batch.records);
+    free(batch.steps);
+    if (!written){
+        printf("Error: Could not write ensemble file %s\n", path);
+        return -1;
+    }
+
+    return header.num_runs;
+}
+
+void ensemble_replay_task(void *context, int index){
+    /*
+    Continues one run of a post-burnout ensemble to impact with the reentry-side settings of the run parameters
+    (pool_task interface)
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the ensemble_batch struct
+        index: int
+            index of the run
+    */
+
+    ensemble_batch *batch = (ensemble_batch *)context;
+    runparams *run_params = batch->run_params;
+    ensemble_record *record = &batch->records[index];
+
+    gsl_rng *rng = gsl_rng_alloc(gsl_rng_philox4x32);
+    *(philox_state *)rng->state = record->rng_state;
+
+    flight flight;
+    vehicle vehicle;
+    flight_snapshot_restore(&record->snapshot, &flight, &vehicle, rng, NULL);
+    flight.run_params = run_params;
+    int saved_steps = flight.steps;
+
+    // Swap in the reentry vehicle, whose mass is the vehicle mass after burnout
+    if (run_params->rv_type != batch->header->rv_type){
+        vehicle.rv = (run_params->rv_type == 1) ? init_swerve_rv() : init_ballistic_rv();
+        vehicle.current_mass = vehicle.rv.rv_mass;
+    }
+
+    // Draw the atmosphere of the reentry if the perturbation flag has changed
+    if (run_params->atm_error != batch->header->atm_error){
+        gsl_rng *atm_rng = philox_alloc(batch->header->seed, index, PHILOX_STREAM_REPLAY);
+        flight.atm_model = init_atm(run_params, atm_rng);
+        gsl_rng_free(atm_rng);
+    }
+
+    // Update periods of the reentry models
+    if (flight.guidance_group.period != run_params->guidance_period){
+        rate_group_init(&flight.guidance_group, run_params->guidance_period);
+    }
+    if (flight.lift_group.period != run_params->lift_period){
+        rate_group_init(&flight.lift_group, run_params->lift_period);
+    }
+
+    state final_state = flight.new_true_state;
+    int impacted = 0;
+    for (int i = 0; i < MAX_FLIGHT_STEPS; i++){
+        if (flight_step(&flight)){
+            impacted = 1;
+            break;
+        }
+    }
+    if (impacted){
+        final_state = flight_impact(&flight);
+    }
+    else{
+        printf("Warning: Maximum number of steps reached with no impact\n");
+    }
+
+    batch->impact_states[index] = final_state;
+    batch->steps[index] = flight.steps - saved_steps;
+    gsl_rng_free(rng);
+}
+
+impact_dispersion ensemble_replay(runparams run_params, const char *path){
+    /*
+    Replays the reentry of every run of a post-burnout ensemble saved by ensemble_save, in parallel. The boost-side
+    run parameters and the reentry time step must match those of the saved campaign; the reentry-side ones (rv_type,
+    rv_maneuv, atm_error, guidance_period, lift_period and the aimpoint) may differ. A changed reentry
+    vehicle replaces the saved one after burnout (the boost keeps the payload mass of the saved vehicle), and a
+    changed atmospheric perturbation flag redraws the atmosphere of the run from its own Philox sequence. With unchanged settings the replay reproduces the impact
+    points of mc_run exactly. The impact points are written to run_params.impact_data_path in the format of mc_run
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+        path: const char *
+            path of the ensemble file
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            sample impact dispersion of the replayed runs, with the median miss distance from the mean impact
+            point as the CEP (num_flights is 0 if the ensemble could not be replayed)
+    */
+
+    run_params.traj_output = 0;
+    run_params.traj_archive = 0;
+
+    impact_dispersion dispersion = {0};
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL){
+        printf("Error: Could not open ensemble file %s\n", path);
+        return dispersion;
+    }
+    ensemble_header header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, ENSEMBLE_MAGIC, sizeof(header.magic)) != 0 || header.version != ENSEMBLE_VERSION || header.record_size != sizeof(ensemble_record)){
+        printf("Error: %s is not an ensemble file of this version\n", path);
+        fclose(file);
+        return dispersion;
+    }
+
+    double boost_params[ENSEMBLE_BOOST_PARAMS];
+    ensemble_boost_params(&run_params, boost_params);
+    if (memcmp(boost_params, header.boost_params, sizeof(boost_params)) != 0){
+        printf("Error: The boost-side run parameters or the reentry time step differ from those of the ensemble in %s\n", path);
+        fclose(file);
+        return dispersion;
+    }
+    if (run_params.rv_type != 0 && run_params.rv_type != 1){
+        printf("Error: Invalid RV type\n");
+        exit(1);
+    }
+
+    // Check the number of runs against the size of the file before allocating the records
+    long data_start = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long data_size = ftell(file) - data_start;
+    fseek(file, data_start, SEEK_SET);
+    if (header.num_runs <= 0 || data_size != (long)header.num_runs * header.record_size){
+        printf("Error: The number of runs in %s does not match its size\n", path);
+        fclose(file);
+        return dispersion;
+    }
+
+    ensemble_batch batch;
+    batch.run_params = &run_params;
+    batch.header = &header;
+    batch.records = malloc(header.num_runs * sizeof(ensemble_record));
+    batch.steps = malloc(header.num_runs * sizeof(int));
+    batch.impact_states = malloc(header.num_runs * sizeof(state));
+    if (fread(batch.records, sizeof(ensemble_record), header.num_runs, file) != (size_t)header.num_runs){
+        printf("Error: Could not read ensemble file %s\n", path);
+        fclose(file);
+        free(batch.records);
+        free(batch.steps);
+        free(batch.impact_states);
+        return dispersion;
+    }
+    fclose(file);
+
+    parallel_for(run_params.num_threads, ensemble_replay_task, &batch, header.num_runs);
+
+    // Output the impact data
+    if (run_params.impact_data_path != NULL){
+        FILE *impact_file = fopen(run_params.impact_data_path, "w");
+        if (impact_file != NULL){
+            fprintf(impact_file, "t, x, y, z, vx, vy, vz\n");
+            for (int run = 0; run < header.num_runs; run++){
+                state *impact_state = &batch.impact_states[run];
+                fprintf(impact_file, "%f, %f, %f, %f, %f, %f, %f\n", impact_state->t, impact_state->x, impact_state->y, impact_state->z, impact_state->vx, impact_state->vy, impact_state->vz);
+            }
+            fclose(impact_file);
+        }
+    }
+
+    dispersion.num_flights = header.num_runs;
+    if (header.num_runs >= 2){
+        double *impacts = malloc(3 * header.num_runs * sizeof(double));
+        for (int run = 0; run < header.num_runs; run++){
+            impacts[3*run] = batch.impact_states[run].x;
+            impacts[3*run + 1] = batch.impact_states[run].y;
+            impacts[3*run + 2] = batch.impact_states[run].z;
+        }
+        dispersion_from_impacts(&dispersion, impacts, header.num_runs);
+        free(impacts);
+    }
+
+    free(batch.records);
+    free(batch.steps);
+    free(batch.impact_states);
+
+    return dispersion;
+}
+
+#endif
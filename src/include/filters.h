@@ -1,6 +1,9 @@
 #ifndef FILTERS_H
 #define FILTERS_H
 
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include "linalg.h"
 
 typedef struct KalmanFilter{
@@ -19,6 +22,21 @@ typedef struct KalmanFilter{
     gsl_matrix *measurement_noise; // The measurement noise of the system at time t.
     gsl_matrix *kalman_gain; // The Kalman gain of the system at time t.
     gsl_vector *measured_state; // The measured state of the system at time t.
+    int sequential_update; // Flag to process the measurements one at a time when measurement_noise is diagonal.
+
+    // Workspaces allocated once so that predict and update do not touch the heap
+    gsl_vector *state_workspace; // Workspace for the propagated state (state_dim).
+    gsl_matrix *covariance_workspace; // Workspace for the propagated covariance (state_dim x state_dim).
+    gsl_matrix *gain_workspace; // Workspace for P H^T and K S (state_dim x measurement_dim).
+    gsl_matrix *measurement_workspace; // Workspace for H P (measurement_dim x state_dim).
+    gsl_vector *innovation; // The innovation z - H x (measurement_dim).
+    gsl_matrix *innovation_inverse; // The pseudoinverse of a singular innovation covariance (measurement_dim x measurement_dim).
+    gsl_matrix *innovation_factor; // Cholesky or LDL^T factor of the innovation covariance (measurement_dim x measurement_dim).
+    gsl_vector *gain_column; // Workspace for P h^T in the sequential update (state_dim).
+    gsl_matrix *svd_u; // SVD factor U of the innovation covariance (measurement_dim x measurement_dim).
+    gsl_matrix *svd_v; // SVD factor V of the innovation covariance (measurement_dim x measurement_dim).
+    gsl_vector *svd_s; // Singular values of the innovation covariance (measurement_dim).
+    gsl_vector *svd_work; // SVD workspace (measurement_dim).
 } KalmanFilter;
 
 KalmanFilter *kalman_filter_alloc(int state_dim, int measurement_dim){
@@ -48,6 +66,20 @@ KalmanFilter *kalman_filter_alloc(int state_dim, int measurement_dim){
     kf->measurement_noise = gsl_matrix_alloc(measurement_dim, measurement_dim);
     kf->kalman_gain = gsl_matrix_alloc(state_dim, measurement_dim);
     kf->measured_state = gsl_vector_alloc(measurement_dim);
+    kf->sequential_update = 1;
+
+    kf->state_workspace = gsl_vector_alloc(state_dim);
+    kf->covariance_workspace = gsl_matrix_alloc(state_dim, state_dim);
+    kf->gain_workspace = gsl_matrix_alloc(state_dim, measurement_dim);
+    kf->measurement_workspace = gsl_matrix_alloc(measurement_dim, state_dim);
+    kf->innovation = gsl_vector_alloc(measurement_dim);
+    kf->innovation_inverse = gsl_matrix_alloc(measurement_dim, measurement_dim);
+    kf->innovation_factor = gsl_matrix_alloc(measurement_dim, measurement_dim);
+    kf->gain_column = gsl_vector_alloc(state_dim);
+    kf->svd_u = gsl_matrix_alloc(measurement_dim, measurement_dim);
+    kf->svd_v = gsl_matrix_alloc(measurement_dim, measurement_dim);
+    kf->svd_s = gsl_vector_alloc(measurement_dim);
+    kf->svd_work = gsl_vector_alloc(measurement_dim);
     return kf;
 }
 
@@ -69,13 +101,26 @@ void kalman_filter_free(KalmanFilter *kf){
     gsl_matrix_free(kf->measurement_noise);
     gsl_matrix_free(kf->kalman_gain);
     gsl_vector_free(kf->measured_state);
+
+    gsl_vector_free(kf->state_workspace);
+    gsl_matrix_free(kf->covariance_workspace);
+    gsl_matrix_free(kf->gain_workspace);
+    gsl_matrix_free(kf->measurement_workspace);
+    gsl_vector_free(kf->innovation);
+    gsl_matrix_free(kf->innovation_inverse);
+    gsl_matrix_free(kf->innovation_factor);
+    gsl_vector_free(kf->gain_column);
+    gsl_matrix_free(kf->svd_u);
+    gsl_matrix_free(kf->svd_v);
+    gsl_vector_free(kf->svd_s);
+    gsl_vector_free(kf->svd_work);
     free(kf);
 
 }
 
 void kalman_filter_predict(KalmanFilter *kf){
     /* 
-    This function predicts the state of the system at time t.
+    This function predicts the state of the system at time t, in place and without allocating memory.
 
     INPUTS:
     ----------------
@@ -83,56 +128,747 @@ void kalman_filter_predict(KalmanFilter *kf){
     */
 
     // Predict the state
-    kf->predicted_state = mv_multiply(kf->dynamic_matrix, kf->predicted_state);
+    gsl_blas_dgemv(CblasNoTrans, 1.0, kf->dynamic_matrix, kf->predicted_state, 0.0, kf->state_workspace);
+    gsl_vector_memcpy(kf->predicted_state, kf->state_workspace);
 
     // Predict the covariance
-    gsl_matrix *tmp = mm_multiply(kf->dynamic_matrix, kf->predicted_covariance);
-    gsl_matrix *tmp_t = m_transpose(kf->dynamic_matrix);
-    gsl_matrix *tmp2 = mm_multiply(tmp, tmp_t);
-    kf->predicted_covariance = mm_add(tmp2, kf->process_noise);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, kf->dynamic_matrix, kf->predicted_covariance, 0.0, kf->covariance_workspace);
+    gsl_matrix_memcpy(kf->predicted_covariance, kf->process_noise);
+    gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, kf->covariance_workspace, kf->dynamic_matrix, 1.0, kf->predicted_covariance);
     
     // Increment the timestep
     kf->timestep += 1;
 
-    // Free memory
-    gsl_matrix_free(tmp);
-    gsl_matrix_free(tmp_t);
-    gsl_matrix_free(tmp2);
+}
+
+void kalman_filter_invert_innovation(KalmanFilter *kf){
+    /* 
+    This function computes the pseudoinverse of the innovation covariance in the filter workspaces.
+
+    INPUTS:
+    ----------------
+        kf (KalmanFilter *): The Kalman filter.
+    */
+
+    double rcond = 1e-10;
+
+    // Decompose S = U diag(s) V^T
+    gsl_matrix_memcpy(kf->svd_u, kf->innovation_covariance);
+    gsl_linalg_SV_decomp(kf->svd_u, kf->svd_v, kf->svd_s, kf->svd_work);
+
+    // Scale the columns of V by the inverse singular values, then S^+ = V diag(1/s) U^T
+    double cutoff = rcond * gsl_vector_max(kf->svd_s);
+    for (int j = 0; j < kf->measurement_dim; j++){
+        double s = gsl_vector_get(kf->svd_s, j);
+        gsl_vector_view column = gsl_matrix_column(kf->svd_v, j);
+        gsl_vector_scale(&column.vector, s > cutoff ? 1. / s : 0.);
+    }
+    gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, kf->svd_v, kf->svd_u, 0.0, kf->innovation_inverse);
+
+}
+
+int kalman_filter_factor_innovation(KalmanFilter *kf){
+    /* 
+    This function factors the innovation covariance, trying a Cholesky decomposition first and an LDL^T
+    decomposition if the matrix is not numerically positive definite.
+
+    INPUTS:
+    ----------------
+        kf (KalmanFilter *): The Kalman filter.
+
+    OUTPUTS:
+    ----------------
+        factorization (int): 1 for Cholesky, 2 for LDL^T, 0 if the innovation covariance is singular.
+    */
+
+    double rcond = 1e-10;
+    int factorization = 0;
+
+    // Failed factorizations are expected here, so use the factorizations that report them through their status
+    gsl_matrix_memcpy(kf->innovation_factor, kf->innovation_covariance);
+    if (m_cholesky_decomp(kf->innovation_factor) == GSL_SUCCESS){
+        factorization = 1;
+    }
+    else{
+        gsl_matrix_memcpy(kf->innovation_factor, kf->innovation_covariance);
+        if (m_ldlt_decomp(kf->innovation_factor) == GSL_SUCCESS){
+            // Reject the factor if any pivot of D is negligible
+            gsl_vector_view d = gsl_matrix_diagonal(kf->innovation_factor);
+            double d_max = fmax(gsl_vector_max(&d.vector), -gsl_vector_min(&d.vector));
+            factorization = 2;
+            for (int i = 0; i < kf->measurement_dim; i++){
+                if (!(fabs(gsl_vector_get(&d.vector, i)) > rcond * d_max)){
+                    factorization = 0;
+                }
+            }
+        }
+    }
+
+    return factorization;
+}
+
+void kalman_filter_update_joint(KalmanFilter *kf){
+    /* 
+    This function updates the state of the system at time t with all measurements at once, solving for the
+    Kalman gain with a factorization of the innovation covariance.
+
+    INPUTS:
+    ----------------
+        kf (KalmanFilter *): The Kalman filter.
+    */
+
+    // Compute the innovation covariance S = H P H^T + R
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, kf->measurement_matrix, kf->predicted_covariance, 0.0, kf->measurement_workspace);
+    gsl_matrix_memcpy(kf->innovation_covariance, kf->measurement_noise);
+    gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, kf->measurement_workspace, kf->measurement_matrix, 1.0, kf->innovation_covariance);
+
+    // P H^T = (H P)^T since P is symmetric
+    gsl_matrix_transpose_memcpy(kf->gain_workspace, kf->measurement_workspace);
+
+    // Compute the Kalman gain from S K^T = H P, falling back to the pseudoinverse if S is singular
+    int factorization = kalman_filter_factor_innovation(kf);
+    if (factorization == 0){
+        kalman_filter_invert_innovation(kf);
+        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, kf->gain_workspace, kf->innovation_inverse, 0.0, kf->kalman_gain);
+    }
+    else{
+        for (int j = 0; j < kf->state_dim; j++){
+            gsl_vector_view column = gsl_matrix_column(kf->measurement_workspace, j);
+            if (factorization == 1){
+                gsl_linalg_cholesky_svx(kf->innovation_factor, &column.vector);
+            }
+            else{
+                gsl_linalg_ldlt_svx(kf->innovation_factor, &column.vector);
+            }
+        }
+        gsl_matrix_transpose_memcpy(kf->kalman_gain, kf->measurement_workspace);
+    }
+
+    // Update the state x = x + K (z - H x)
+    gsl_vector_memcpy(kf->innovation, kf->measured_state);
+    gsl_blas_dgemv(CblasNoTrans, -1.0, kf->measurement_matrix, kf->predicted_state, 1.0, kf->innovation);
+    gsl_blas_dgemv(CblasNoTrans, 1.0, kf->kalman_gain, kf->innovation, 1.0, kf->predicted_state);
+
+    // Update the covariance P = P - K S K^T = P - (P H^T) K^T
+    gsl_blas_dgemm(CblasNoTrans, CblasTrans, -1.0, kf->gain_workspace, kf->kalman_gain, 1.0, kf->predicted_covariance);
+
+}
+
+void kalman_filter_update_sequential(KalmanFilter *kf){
+    /* 
+    This function updates the state of the system at time t one scalar measurement at a time, which is exact
+    for a diagonal measurement noise and needs no matrix inversion. Column i of the Kalman gain holds the gain
+    of the i-th scalar update, and element (i, i) of the innovation covariance its scalar innovation variance;
+    the off-diagonal elements are zeroed.
+
+    INPUTS:
+    ----------------
+        kf (KalmanFilter *): The Kalman filter.
+    */
+
+    gsl_matrix_set_zero(kf->innovation_covariance);
+    for (int i = 0; i < kf->measurement_dim; i++){
+        gsl_vector_view h = gsl_matrix_row(kf->measurement_matrix, i);
+        gsl_vector_view gain = gsl_matrix_column(kf->kalman_gain, i);
+
+        // Scalar innovation covariance s = h P h^T + r
+        gsl_blas_dgemv(CblasNoTrans, 1.0, kf->predicted_covariance, &h.vector, 0.0, kf->gain_column);
+        double s;
+        gsl_blas_ddot(&h.vector, kf->gain_column, &s);
+        s += gsl_matrix_get(kf->measurement_noise, i, i);
+        gsl_matrix_set(kf->innovation_covariance, i, i, s);
+
+        // A measurement with no uncertainty in either the state or the sensor carries no usable gain
+        if (!(s > 0)){
+            gsl_vector_set_zero(&gain.vector);
+            continue;
+        }
+
+        // Update the state with the scalar innovation z_i - h x
+        double hx;
+        gsl_blas_ddot(&h.vector, kf->predicted_state, &hx);
+        double innovation = gsl_vector_get(kf->measured_state, i) - hx;
+        gsl_vector_set(kf->innovation, i, innovation);
+        gsl_vector_memcpy(&gain.vector, kf->gain_column);
+        gsl_vector_scale(&gain.vector, 1. / s);
+        gsl_blas_daxpy(innovation, &gain.vector, kf->predicted_state);
+
+        // Update the covariance P = P - (P h^T)(P h^T)^T / s
+        gsl_blas_dger(-1. / s, kf->gain_column, kf->gain_column, kf->predicted_covariance);
+    }
 
 }
 
+int kalman_filter_noise_is_diagonal(KalmanFilter *kf){
+    /* 
+    This function checks whether the measurement noise matrix is diagonal.
+
+    INPUTS:
+    ----------------
+        kf (KalmanFilter *): The Kalman filter.
+
+    OUTPUTS:
+    ----------------
+        diagonal (int): 1 if every off-diagonal element is zero, 0 otherwise.
+    */
+
+    for (int i = 0; i < kf->measurement_dim; i++){
+        for (int j = 0; j < kf->measurement_dim; j++){
+            if (i != j && gsl_matrix_get(kf->measurement_noise, i, j) != 0){
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
 void kalman_filter_update(KalmanFilter *kf){
     /* 
-    This function updates the state of the system at time t.
+    This function updates the state of the system at time t, in place and without allocating memory.
+    Independent measurements (diagonal measurement noise) are processed sequentially as scalars when
+    sequential_update is set; otherwise the gain is solved with a Cholesky or LDL^T factorization.
 
     INPUTS:
     ----------------
         kf (KalmanFilter *): The Kalman filter.
     */
 
-    // Compute the innovation covariance
-    gsl_matrix *tmp = mm_multiply(kf->measurement_matrix, kf->predicted_covariance);
-    gsl_matrix *tmp_t = m_transpose(kf->measurement_matrix);
-    gsl_matrix *tmp2 = mm_multiply(tmp, tmp_t);
-    kf->innovation_covariance = mm_add(tmp2, kf->measurement_noise);
+    if (kf->sequential_update && kalman_filter_noise_is_diagonal(kf)){
+        kalman_filter_update_sequential(kf);
+    }
+    else{
+        kalman_filter_update_joint(kf);
+    }
+
+}
+
+typedef struct BatchKalmanFilter{
+    /* 
+    This struct defines a batch of Kalman filters that share their model matrices (for example one filter per
+    Monte Carlo run) and holds the associated data structures. Per-filter data is interleaved so that element
+    (i, j) of filter b is stored at [(i * cols + j) * batch_size + b], and every kernel loops over the batch in
+    its innermost, contiguous dimension.
+    */
+    int timestep; // The current time step t.
+    int state_dim; // The dimension of the state space.
+    int measurement_dim; // The dimension of the measurement space.
+    int batch_size; // The number of filters in the batch.
+    int sequential_update; // Flag to process the measurements one at a time when measurement_noise is diagonal.
+    gsl_matrix *dynamic_matrix; // The dynamic matrix shared by all filters.
+    gsl_matrix *process_noise; // The process noise shared by all filters.
+    gsl_matrix *measurement_matrix; // The measurement matrix shared by all filters.
+    gsl_matrix *measurement_noise; // The measurement noise shared by all filters.
+    double *predicted_state; // The predicted states (state_dim x batch_size, interleaved).
+    double *predicted_covariance; // The predicted covariances (state_dim x state_dim x batch_size, interleaved).
+    double *measured_state; // The measured states (measurement_dim x batch_size, interleaved).
+
+    // Workspaces allocated once so that predict and update do not touch the heap
+    double *state_workspace; // Workspace for the propagated states and P h^T (state_dim x batch_size).
+    double *covariance_workspace; // Workspace for F P (state_dim x state_dim x batch_size).
+    double *measurement_workspace; // Workspace for H P (measurement_dim x state_dim x batch_size).
+    double *gain_workspace; // Workspace for K^T (measurement_dim x state_dim x batch_size).
+    double *innovation_covariance; // Innovation covariances, overwritten by their Cholesky factors (measurement_dim x measurement_dim x batch_size).
+    double *innovation; // The innovations (measurement_dim x batch_size).
+    double *lane_workspace; // Per-filter scalars (batch_size).
+} BatchKalmanFilter;
+
+BatchKalmanFilter *batch_kalman_filter_alloc(int state_dim, int measurement_dim, int batch_size){
+    /* 
+    This function allocates memory for a batch of Kalman filters.
+
+    INPUTS:
+    ----------------
+        state_dim (int): The dimension of the state space.
+        measurement_dim (int): The dimension of the measurement space.
+        batch_size (int): The number of filters in the batch.
+
+    OUTPUTS:
+    ----------------
+        bkf (BatchKalmanFilter *): The batch of Kalman filters.
+    */
+
+    int n = state_dim;
+    int m = measurement_dim;
+    BatchKalmanFilter *bkf = (BatchKalmanFilter *)malloc(sizeof(BatchKalmanFilter));
+    bkf->timestep = 0;
+    bkf->state_dim = n;
+    bkf->measurement_dim = m;
+    bkf->batch_size = batch_size;
+    bkf->sequential_update = 1;
+    bkf->dynamic_matrix = gsl_matrix_alloc(n, n);
+    bkf->process_noise = gsl_matrix_alloc(n, n);
+    bkf->measurement_matrix = gsl_matrix_alloc(m, n);
+    bkf->measurement_noise = gsl_matrix_alloc(m, m);
+    bkf->predicted_state = (double *)calloc(n * batch_size, sizeof(double));
+    bkf->predicted_covariance = (double *)calloc(n * n * batch_size, sizeof(double));
+    bkf->measured_state = (double *)calloc(m * batch_size, sizeof(double));
+
+    bkf->state_workspace = (double *)malloc(n * batch_size * sizeof(double));
+    bkf->covariance_workspace = (double *)malloc(n * n * batch_size * sizeof(double));
+    bkf->measurement_workspace = (double *)malloc(m * n * batch_size * sizeof(double));
+    bkf->gain_workspace = (double *)malloc(m * n * batch_size * sizeof(double));
+    bkf->innovation_covariance = (double *)malloc(m * m * batch_size * sizeof(double));
+    bkf->innovation = (double *)malloc(m * batch_size * sizeof(double));
+    bkf->lane_workspace = (double *)malloc(batch_size * sizeof(double));
+    return bkf;
+}
+
+void batch_kalman_filter_free(BatchKalmanFilter *bkf){
+    /* 
+    This function frees the memory associated with a batch of Kalman filters.
+
+    INPUTS:
+    ----------------
+        bkf (BatchKalmanFilter *): The batch of Kalman filters.
+    */
+
+    gsl_matrix_free(bkf->dynamic_matrix);
+    gsl_matrix_free(bkf->process_noise);
+    gsl_matrix_free(bkf->measurement_matrix);
+    gsl_matrix_free(bkf->measurement_noise);
+    free(bkf->predicted_state);
+    free(bkf->predicted_covariance);
+    free(bkf->measured_state);
+
+    free(bkf->state_workspace);
+    free(bkf->covariance_workspace);
+    free(bkf->measurement_workspace);
+    free(bkf->gain_workspace);
+    free(bkf->innovation_covariance);
+    free(bkf->innovation);
+    free(bkf->lane_workspace);
+    free(bkf);
+
+}
+
+void batch_kalman_filter_set(BatchKalmanFilter *bkf, int filter, gsl_vector *state, gsl_matrix *covariance){
+    /* 
+    This function sets the state and covariance of one filter in the batch.
+
+    INPUTS:
+    ----------------
+        bkf (BatchKalmanFilter *): The batch of Kalman filters.
+        filter (int): The index of the filter in the batch.
+        state (gsl_vector *): The state (state_dim).
+        covariance (gsl_matrix *): The covariance (state_dim x state_dim).
+    */
+
+    int n = bkf->state_dim;
+    int B = bkf->batch_size;
+    for (int i = 0; i < n; i++){
+        bkf->predicted_state[i*B + filter] = gsl_vector_get(state, i);
+        for (int j = 0; j < n; j++){
+            bkf->predicted_covariance[(i*n + j)*B + filter] = gsl_matrix_get(covariance, i, j);
+        }
+    }
+}
+
+void batch_kalman_filter_get(BatchKalmanFilter *bkf, int filter, gsl_vector *state, gsl_matrix *covariance){
+    /* 
+    This function copies the state and covariance of one filter in the batch.
+
+    INPUTS:
+    ----------------
+        bkf (BatchKalmanFilter *): The batch of Kalman filters.
+        filter (int): The index of the filter in the batch.
+        state (gsl_vector *): The state (state_dim).
+        covariance (gsl_matrix *): The covariance (state_dim x state_dim).
+    */
+
+    int n = bkf->state_dim;
+    int B = bkf->batch_size;
+    for (int i = 0; i < n; i++){
+        gsl_vector_set(state, i, bkf->predicted_state[i*B + filter]);
+        for (int j = 0; j < n; j++){
+            gsl_matrix_set(covariance, i, j, bkf->predicted_covariance[(i*n + j)*B + filter]);
+        }
+    }
+}
+
+void batch_kalman_filter_set_measurement(BatchKalmanFilter *bkf, int filter, gsl_vector *measurement){
+    /* 
+    This function sets the measured state of one filter in the batch.
+
+    INPUTS:
+    ----------------
+        bkf (BatchKalmanFilter *): The batch of Kalman filters.
+        filter (int): The index of the filter in the batch.
+        measurement (gsl_vector *): The measured state (measurement_dim).
+    */
+
+    for (int i = 0; i < bkf->measurement_dim; i++){
+        bkf->measured_state[i*bkf->batch_size + filter] = gsl_vector_get(measurement, i);
+    }
+}
+
+void batch_kalman_filter_predict(BatchKalmanFilter *bkf){
+    /* 
+    This function predicts the states of all filters in the batch at time t.
+
+    INPUTS:
+    ----------------
+        bkf (BatchKalmanFilter *): The batch of Kalman filters.
+    */
+
+    int n = bkf->state_dim;
+    int B = bkf->batch_size;
+    double *x = bkf->predicted_state;
+    double *P = bkf->predicted_covariance;
+    double *x_new = bkf->state_workspace;
+    double *FP = bkf->covariance_workspace;
+
+    // Predict the states x = F x
+    for (int i = 0; i < n; i++){
+        double *out = x_new + i*B;
+        for (int b = 0; b < B; b++){
+            out[b] = 0;
+        }
+        for (int k = 0; k < n; k++){
+            double f = gsl_matrix_get(bkf->dynamic_matrix, i, k);
+            if (f == 0){
+                continue;
+            }
+            double *in = x + k*B;
+            for (int b = 0; b < B; b++){
+                out[b] += f * in[b];
+            }
+        }
+    }
+    memcpy(x, x_new, n * B * sizeof(double));
+
+    // Predict the covariances P = F P F^T + Q, skipping the structural zeros of F
+    for (int i = 0; i < n; i++){
+        for (int j = 0; j < n; j++){
+            double *out = FP + (i*n + j)*B;
+            for (int b = 0; b < B; b++){
+                out[b] = 0;
+            }
+            for (int k = 0; k < n; k++){
+                double f = gsl_matrix_get(bkf->dynamic_matrix, i, k);
+                if (f == 0){
+                    continue;
+                }
+                double *in = P + (k*n + j)*B;
+                for (int b = 0; b < B; b++){
+                    out[b] += f * in[b];
+                }
+            }
+        }
+    }
+    for (int i = 0; i < n; i++){
+        for (int j = 0; j < n; j++){
+            double q = gsl_matrix_get(bkf->process_noise, i, j);
+            double *out = P + (i*n + j)*B;
+            for (int b = 0; b < B; b++){
+                out[b] = q;
+            }
+            for (int k = 0; k < n; k++){
+                double f = gsl_matrix_get(bkf->dynamic_matrix, j, k);
+                if (f == 0){
+                    continue;
+                }
+                double *in = FP + (i*n + k)*B;
+                for (int b = 0; b < B; b++){
+                    out[b] += f * in[b];
+                }
+            }
+        }
+    }
+
+    // Increment the timestep
+    bkf->timestep += 1;
+
+}
+
+void batch_kalman_filter_update_sequential(BatchKalmanFilter *bkf){
+    /* 
+    This function updates the states of all filters one scalar measurement at a time, which is exact for a
+    diagonal measurement noise. A filter whose scalar innovation covariance is not positive skips that measurement.
+
+    INPUTS:
+    ----------------
+        bkf (BatchKalmanFilter *): The batch of Kalman filters.
+    */
+
+    int n = bkf->state_dim;
+    int B = bkf->batch_size;
+    double *x = bkf->predicted_state;
+    double *P = bkf->predicted_covariance;
+    double *Ph = bkf->state_workspace;
+    double *inv_s = bkf->lane_workspace;
 
-    // Compute the Kalman gain
-    gsl_matrix *tmp3 = m_pseudoinverse(kf->innovation_covariance);
-    gsl_matrix *tmp4 = mm_multiply(kf->predicted_covariance, tmp_t);
-    kf->kalman_gain = mm_multiply(tmp4, tmp3);
+    for (int r = 0; r < bkf->measurement_dim; r++){
+        double *y = bkf->innovation + r*B;
+        double *z = bkf->measured_state + r*B;
+
+        // P h^T and the innovation z - h x
+        for (int b = 0; b < B; b++){
+            y[b] = z[b];
+        }
+        for (int i = 0; i < n; i++){
+            double *out = Ph + i*B;
+            for (int b = 0; b < B; b++){
+                out[b] = 0;
+            }
+        }
+        for (int k = 0; k < n; k++){
+            double h = gsl_matrix_get(bkf->measurement_matrix, r, k);
+            if (h == 0){
+                continue;
+            }
+            for (int i = 0; i < n; i++){
+                double *in = P + (i*n + k)*B;
+                double *out = Ph + i*B;
+                for (int b = 0; b < B; b++){
+                    out[b] += h * in[b];
+                }
+            }
+            double *in = x + k*B;
+            for (int b = 0; b < B; b++){
+                y[b] -= h * in[b];
+            }
+        }
+
+        // s = h P h^T + r
+        double noise = gsl_matrix_get(bkf->measurement_noise, r, r);
+        for (int b = 0; b < B; b++){
+            inv_s[b] = noise;
+        }
+        for (int i = 0; i < n; i++){
+            double h = gsl_matrix_get(bkf->measurement_matrix, r, i);
+            if (h == 0){
+                continue;
+            }
+            double *in = Ph + i*B;
+            for (int b = 0; b < B; b++){
+                inv_s[b] += h * in[b];
+            }
+        }
+        for (int b = 0; b < B; b++){
+            inv_s[b] = inv_s[b] > 0 ? 1. / inv_s[b] : 0.;
+        }
+
+        // x = x + (P h^T / s) y and P = P - (P h^T)(P h^T)^T / s
+        for (int i = 0; i < n; i++){
+            double *ph_i = Ph + i*B;
+            double *x_i = x + i*B;
+            for (int b = 0; b < B; b++){
+                x_i[b] += ph_i[b] * inv_s[b] * y[b];
+            }
+            for (int j = 0; j < n; j++){
+                double *ph_j = Ph + j*B;
+                double *out = P + (i*n + j)*B;
+                for (int b = 0; b < B; b++){
+                    out[b] -= ph_i[b] * ph_j[b] * inv_s[b];
+                }
+            }
+        }
+    }
+
+}
+
+void batch_kalman_filter_update_joint(BatchKalmanFilter *bkf){
+    /* 
+    This function updates the states of all filters with all measurements at once, solving for the Kalman gains
+    with batched Cholesky factorizations of the innovation covariances. A filter whose innovation covariance is
+    not positive definite is left unchanged.
+
+    INPUTS:
+    ----------------
+        bkf (BatchKalmanFilter *): The batch of Kalman filters.
+    */
+
+    int n = bkf->state_dim;
+    int m = bkf->measurement_dim;
+    int B = bkf->batch_size;
+    double *x = bkf->predicted_state;
+    double *P = bkf->predicted_covariance;
+    double *HP = bkf->measurement_workspace;
+    double *X = bkf->gain_workspace;
+    double *S = bkf->innovation_covariance;
+    double *valid = bkf->lane_workspace;
+
+    // H P
+    for (int r = 0; r < m; r++){
+        for (int j = 0; j < n; j++){
+            double *out = HP + (r*n + j)*B;
+            for (int b = 0; b < B; b++){
+                out[b] = 0;
+            }
+            for (int k = 0; k < n; k++){
+                double h = gsl_matrix_get(bkf->measurement_matrix, r, k);
+                if (h == 0){
+                    continue;
+                }
+                double *in = P + (k*n + j)*B;
+                for (int b = 0; b < B; b++){
+                    out[b] += h * in[b];
+                }
+            }
+        }
+    }
+
+    // S = H P H^T + R
+    for (int r = 0; r < m; r++){
+        for (int c = 0; c < m; c++){
+            double *out = S + (r*m + c)*B;
+            double noise = gsl_matrix_get(bkf->measurement_noise, r, c);
+            for (int b = 0; b < B; b++){
+                out[b] = noise;
+            }
+            for (int k = 0; k < n; k++){
+                double h = gsl_matrix_get(bkf->measurement_matrix, c, k);
+                if (h == 0){
+                    continue;
+                }
+                double *in = HP + (r*n + k)*B;
+                for (int b = 0; b < B; b++){
+                    out[b] += h * in[b];
+                }
+            }
+        }
+    }
+
+    // Cholesky factors S = L L^T, stored in the lower triangle of S
+    for (int b = 0; b < B; b++){
+        valid[b] = 1;
+    }
+    for (int j = 0; j < m; j++){
+        double *d = S + (j*m + j)*B;
+        for (int k = 0; k < j; k++){
+            double *l = S + (j*m + k)*B;
+            for (int b = 0; b < B; b++){
+                d[b] -= l[b] * l[b];
+            }
+        }
+        for (int b = 0; b < B; b++){
+            valid[b] = d[b] > 0 ? valid[b] : 0;
+            d[b] = d[b] > 0 ? sqrt(d[b]) : 1;
+        }
+        for (int i = j + 1; i < m; i++){
+            double *l = S + (i*m + j)*B;
+            for (int k = 0; k < j; k++){
+                double *l_i = S + (i*m + k)*B;
+                double *l_j = S + (j*m + k)*B;
+                for (int b = 0; b < B; b++){
+                    l[b] -= l_i[b] * l_j[b];
+                }
+            }
+            for (int b = 0; b < B; b++){
+                l[b] /= d[b];
+            }
+        }
+    }
+
+    // Solve L L^T K^T = H P by forward and back substitution
+    memcpy(X, HP, m * n * B * sizeof(double));
+    for (int r = 0; r < m; r++){
+        for (int k = 0; k < r; k++){
+            double *l = S + (r*m + k)*B;
+            for (int j = 0; j < n; j++){
+                double *out = X + (r*n + j)*B;
+                double *in = X + (k*n + j)*B;
+                for (int b = 0; b < B; b++){
+                    out[b] -= l[b] * in[b];
+                }
+            }
+        }
+        double *d = S + (r*m + r)*B;
+        for (int j = 0; j < n; j++){
+            double *out = X + (r*n + j)*B;
+            for (int b = 0; b < B; b++){
+                out[b] /= d[b];
+            }
+        }
+    }
+    for (int r = m - 1; r >= 0; r--){
+        for (int k = r + 1; k < m; k++){
+            double *l = S + (k*m + r)*B;
+            for (int j = 0; j < n; j++){
+                double *out = X + (r*n + j)*B;
+                double *in = X + (k*n + j)*B;
+                for (int b = 0; b < B; b++){
+                    out[b] -= l[b] * in[b];
+                }
+            }
+        }
+        double *d = S + (r*m + r)*B;
+        for (int j = 0; j < n; j++){
+            double *out = X + (r*n + j)*B;
+            for (int b = 0; b < B; b++){
+                out[b] = out[b] / d[b] * valid[b];
+            }
+        }
+    }
+
+    // Innovation y = z - H x
+    for (int r = 0; r < m; r++){
+        double *y = bkf->innovation + r*B;
+        double *z = bkf->measured_state + r*B;
+        for (int b = 0; b < B; b++){
+            y[b] = z[b];
+        }
+        for (int k = 0; k < n; k++){
+            double h = gsl_matrix_get(bkf->measurement_matrix, r, k);
+            if (h == 0){
+                continue;
+            }
+            double *in = x + k*B;
+            for (int b = 0; b < B; b++){
+                y[b] -= h * in[b];
+            }
+        }
+    }
+
+    // x = x + K y and P = P - (H P)^T K^T
+    for (int r = 0; r < m; r++){
+        double *y = bkf->innovation + r*B;
+        for (int i = 0; i < n; i++){
+            double *k_ri = X + (r*n + i)*B;
+            double *x_i = x + i*B;
+            for (int b = 0; b < B; b++){
+                x_i[b] += k_ri[b] * y[b];
+            }
+            double *hp_ri = HP + (r*n + i)*B;
+            for (int j = 0; j < n; j++){
+                double *k_rj = X + (r*n + j)*B;
+                double *out = P + (i*n + j)*B;
+                for (int b = 0; b < B; b++){
+                    out[b] -= hp_ri[b] * k_rj[b];
+                }
+            }
+        }
+    }
+
+}
+
+void batch_kalman_filter_update(BatchKalmanFilter *bkf){
+    /* 
+    This function updates the states of all filters in the batch at time t, using the sequential scalar update
+    for a diagonal measurement noise when sequential_update is set and the batched Cholesky solve otherwise.
+
+    INPUTS:
+    ----------------
+        bkf (BatchKalmanFilter *): The batch of Kalman filters.
+    */
 
-    // Update the state
-    gsl_vector *tmp5 = mv_multiply(kf->measurement_matrix, kf->predicted_state);
-    tmp5 = vv_subtract(kf->measured_state, tmp5);
-    gsl_vector *tmp6 = mv_multiply(kf->kalman_gain, tmp5);
-    kf->predicted_state = vv_add(kf->predicted_state, tmp6);
+    int diagonal = 1;
+    for (int i = 0; i < bkf->measurement_dim; i++){
+        for (int j = 0; j < bkf->measurement_dim; j++){
+            if (i != j && gsl_matrix_get(bkf->measurement_noise, i, j) != 0){
+                diagonal = 0;
+            }
+        }
+    }
 
-    // Update the covariance
-    gsl_matrix *tmp7 = mm_multiply(kf->kalman_gain, kf->innovation_covariance);
-    tmp7 = mm_multiply(tmp7, m_transpose(kf->kalman_gain));
-    tmp7 = sm_multiply(-1, tmp7);
-    kf->predicted_covariance = mm_add(kf->predicted_covariance, tmp7);
+    if (bkf->sequential_update && diagonal){
+        batch_kalman_filter_update_sequential(bkf);
+    }
+    else{
+        batch_kalman_filter_update_joint(bkf);
+    }
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,249 @@
+#ifndef FORK_H
+#define FORK_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <gsl/gsl_rng.h>
+#include "trajectory.h"
+#include "lincov.h"
+#include "pool.h"
+
+// Define the altitude in meters of the entry interface, where forked flights diverge. Below it the atmospheric
+// perturbations of the target area take over from those of the launch area
+#define FORK_ENTRY_ALTITUDE 122e3
+
+// Define a struct to store the impact dispersion of a forked Monte Carlo campaign
+typedef struct fork_estimate{
+    impact_dispersion dispersion; // sample impact dispersion of all forks, with the median miss distance as the CEP
+    int num_prefixes; // number of prefixes (launch to entry interface)
+    int num_forks; // number of forks per prefix (entry interface to impact)
+    double prefix_steps; // mean integration steps of a prefix
+    double fork_steps; // mean integration steps of a fork
+    double speedup; // integration steps of the unforked runs over those of the forked campaign
+} fork_estimate;
+
+// Define a struct to store the inputs and outputs of a forked Monte Carlo campaign
+typedef struct fork_batch{
+    runparams *run_params; // pointer to the run parameters struct
+    uint64_t seed; // seed of the campaign
+    int num_forks; // number of forks per prefix
+    flight_snapshot *snapshots; // snapshot of each prefix at the entry interface
+    int *steps; // integration steps of each prefix, then of each fork
+    double *impacts; // impact point of each fork (3 per fork)
+} fork_batch;
+
+int flight_at_entry(flight *flight){
+    /*
+    Checks whether a flight has descended below the entry interface after burnout
+
+    INPUTS:
+    ----------
+        flight: flight *
+            pointer to the flight struct
+    OUTPUTS:
+    ----------
+        at_entry: int
+            1 if the last step ended below the entry interface on the way down, 0 otherwise
+    */
+
+    state *true_state = &flight->new_true_state;
+    if (true_state->t <= flight->vehicle->booster.total_burn_time){
+        return 0;
+    }
+
+    // Descending through the entry interface
+    double radial_velocity = true_state->x*true_state->vx + true_state->y*true_state->vy + true_state->z*true_state->vz;
+    return radial_velocity < 0 && get_altitude(true_state->x, true_state->y, true_state->z) < FORK_ENTRY_ALTITUDE;
+}
+
+void fork_prefix_task(void *context, int index){
+    /*
+    Flies the prefix of a forked campaign from launch to the entry interface and takes its snapshot (pool_task
+    interface). The prefix draws its launch-area errors exactly as the Monte Carlo run of the same index
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the fork_batch struct
+        index: int
+            index of the prefix
+    */
+
+    fork_batch *batch = (fork_batch *)context;
+    runparams *run_params = batch->run_params;
+    gsl_rng *rng = philox_alloc(batch->seed, index, PHILOX_STREAM_RUN);
+
+    vehicle vehicle;
+    if (run_params->rv_type == 0){
+        vehicle = init_mmiii_ballistic();
+    }
+    else if (run_params->rv_type == 1){
+        vehicle = init_mmiii_swerve();
+    }
+    else{
+        printf("Error: Invalid RV type\n");
+        exit(1);
+    }
+
+    state initial_state = init_true_state(run_params, rng);
+    flight flight;
+    flight_init(&flight, run_params, &initial_state, &vehicle, rng, NULL);
+    for (int i = 0; i < MAX_FLIGHT_STEPS; i++){
+        if (flight_step(&flight) || flight_at_entry(&flight)){
+            break;
+        }
+    }
+
+    flight_snapshot_take(&batch->snapshots[index], &flight);
+    batch->steps[index] = flight.steps;
+    gsl_rng_free(rng);
+}
+
+void fork_task(void *context, int index){
+    /*
+    Flies one fork of a forked campaign from the snapshot of its prefix to impact (pool_task interface). The fork
+    draws the atmospheric perturbations of the target area, the sensor noise from the entry interface on and the
+    orientation of the Coriolis correction from its own Philox sequence
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the fork_batch struct
+        index: int
+            index of the fork, prefix * num_forks + fork
+    */
+
+    fork_batch *batch = (fork_batch *)context;
+    int prefix = index / batch->num_forks;
+    gsl_rng *rng = philox_alloc(batch->seed, index, PHILOX_STREAM_FORK);
+
+    flight flight;
+    vehicle vehicle;
+    flight_snapshot_restore(&batch->snapshots[prefix], &flight, &vehicle, rng, NULL);
+    int prefix_steps = flight.steps;
+
+    // Draw the late-acting errors of the fork
+    atm_model target_atm = init_atm(batch->run_params, rng);
+    for (int i = 0; i < 4; i++){
+        flight.atm_model.pert_densities[i] = target_atm.pert_densities[i];
+        flight.atm_model.pert_zonal_winds[i] = target_atm.pert_zonal_winds[i];
+        flight.atm_model.pert_meridional_winds[i] = target_atm.pert_meridional_winds[i];
+        flight.atm_model.pert_vert_winds[i] = target_atm.pert_vert_winds[i];
+    }
+    noise_buffer_init(&flight.noise, rng);
+
+    state final_state = flight.new_true_state;
+    int impacted = 0;
+    for (int i = 0; i < MAX_FLIGHT_STEPS; i++){
+        if (flight_step(&flight)){
+            impacted = 1;
+            break;
+        }
+    }
+    if (impacted){
+        final_state = flight_impact(&flight);
+    }
+    else{
+        printf("Warning: Maximum number of steps reached with no impact\n");
+    }
+
+    batch->steps[index] = flight.steps - prefix_steps;
+    batch->impacts[3*index] = final_state.x;
+    batch->impacts[3*index + 1] = final_state.y;
+    batch->impacts[3*index + 2] = final_state.z;
+    gsl_rng_free(rng);
+}
+
+fork_estimate fork_run(runparams run_params, int num_prefixes, int num_forks){
+    /*
+    Runs a Monte Carlo campaign in which the common part of the flights is flown once. Each prefix draws the
+    launch-area errors (initial state, IMU, gravity, the atmosphere of the launch area and the sensor noise up to
+    the entry interface) and is flown in parallel from launch to the entry interface, where the whole flight state
+    (true, estimated and desired states, IMU errors, rate groups and vehicle mass) is snapshotted. Each snapshot is
+    then forked num_forks times, and each fork redraws the late-acting errors: the atmospheric perturbations of the
+    target area, the sensor noise from the entry interface on and the Coriolis orientation. The launch and target
+    areas thus get independent atmospheric perturbations, where mc_run draws one set for both. The results do not
+    depend on the number of threads
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+        num_prefixes: int
+            number of prefixes
+        num_forks: int
+            number of forks per prefix
+    OUTPUTS:
+    ----------
+        estimate: fork_estimate
+            sample impact dispersion of the num_prefixes * num_forks runs and the cost of the campaign
+    */
+
+    run_params.traj_output = 0;
+    run_params.traj_archive = 0;
+
+    gsl_rng_env_setup();
+    uint64_t seed = gsl_rng_default_seed;
+
+    fork_estimate estimate = {0};
+    estimate.num_prefixes = num_prefixes;
+    estimate.num_forks = num_forks;
+    int num_runs = num_prefixes * num_forks;
+    estimate.dispersion.num_flights = num_runs;
+    if (num_prefixes < 1 || num_runs < 2){
+        return estimate;
+    }
+
+    fork_batch batch;
+    batch.run_params = &run_params;
+    batch.seed = seed;
+    batch.num_forks = num_forks;
+    batch.snapshots = malloc(num_prefixes * sizeof(flight_snapshot));
+    batch.impacts = malloc(3 * num_runs * sizeof(double));
+
+    // Fly the prefixes, then the forks of all prefixes
+    int *prefix_steps = malloc(num_prefixes * sizeof(int));
+    int *fork_steps = malloc(num_runs * sizeof(int));
+    batch.steps = prefix_steps;
+    parallel_for(run_params.num_threads, fork_prefix_task, &batch, num_prefixes);
+    batch.steps = fork_steps;
+    parallel_for(run_params.num_threads, fork_task, &batch, num_runs);
+
+    for (int p = 0; p < num_prefixes; p++){
+        estimate.prefix_steps += (double)prefix_steps[p] / num_prefixes;
+    }
+    for (int run = 0; run < num_runs; run++){
+        estimate.fork_steps += (double)fork_steps[run] / num_runs;
+    }
+    double forked_steps = num_prefixes * estimate.prefix_steps + num_runs * estimate.fork_steps;
+    estimate.speedup = num_runs * (estimate.prefix_steps + estimate.fork_steps) / forked_steps;
+
+    dispersion_from_impacts(&estimate.dispersion, batch.impacts, num_runs);
+
+    free(prefix_steps);
+    free(fork_steps);
+    free(batch.snapshots);
+    free(batch.impacts);
+
+    return estimate;
+}
+
+void print_fork_estimate(fork_estimate *estimate){
+    /*
+    Prints the impact dispersion and the cost of a forked Monte Carlo campaign
+
+    INPUTS:
+    ----------
+        estimate: fork_estimate *
+            pointer to the forked campaign estimate struct
+    */
+
+    printf("Forked Monte Carlo (%d prefixes x %d forks)\n", estimate->num_prefixes, estimate->num_forks);
+    printf("Mean impact point: (%f, %f, %f)\n", estimate->dispersion.mean[0], estimate->dispersion.mean[1], estimate->dispersion.mean[2]);
+    printf("CEP: %f m\n", estimate->dispersion.cep);
+    printf("Integration steps: %.0f per prefix, %.0f per fork (%.2fx fewer than unforked runs)\n", estimate->prefix_steps, estimate->fork_steps, estimate->speedup);
+}
+
+#endif
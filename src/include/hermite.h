@@ -0,0 +1,305 @@
+#ifndef HERMITE_H
+#define HERMITE_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "writer.h"
+
+// Define the maximum number of trajectory rows spanned by a single Hermite segment
+#define HERMITE_MAX_SPAN 1024
+
+// Define the number of position/velocity triplets interpolated with Hermite cubics (true and estimated state)
+#define HERMITE_NUM_STATES 2
+
+// Define the row offsets of the interpolated positions and velocities (true x, y, z and est_x, est_y, est_z)
+static const int hermite_pos_fields[HERMITE_NUM_STATES] = {2, 23};
+static const int hermite_vel_fields[HERMITE_NUM_STATES] = {5, 26};
+
+// Define a struct to store the state of the Hermite knot compressor
+typedef struct hermite_compressor{
+    double tolerance; // maximum position error of the reconstruction in meters
+    double (*rows)[TRAJ_NUM_FIELDS]; // buffered rows, rows[0] is the last knot
+    int num_rows; // number of buffered rows, including the last knot
+    int first_emitted; // flag indicating that rows[0] has been emitted as a knot
+} hermite_compressor;
+
+void hermite_segment(double *row_0, double *row_1, double t, double *row){
+    /*
+    Evaluates a trajectory segment between two knots. Positions and velocities are reconstructed with cubic
+    Hermite polynomials, all other fields are linearly interpolated
+
+    INPUTS:
+    ----------
+        row_0: double *
+            knot at the start of the segment
+        row_1: double *
+            knot at the end of the segment
+        t: double
+            time at which to evaluate the segment
+        row: double *
+            array of TRAJ_NUM_FIELDS values for the reconstructed step
+    */
+
+    double dt = row_1[0] - row_0[0];
+    double s = (dt > 0) ? (t - row_0[0]) / dt : 0;
+
+    for (int j = 0; j < TRAJ_NUM_FIELDS; j++){
+        row[j] = row_0[j] + s * (row_1[j] - row_0[j]);
+    }
+    row[0] = t;
+
+    // Hermite basis functions and their derivatives with respect to s
+    double s2 = s * s;
+    double s3 = s2 * s;
+    double h00 = 2*s3 - 3*s2 + 1;
+    double h10 = s3 - 2*s2 + s;
+    double h01 = -2*s3 + 3*s2;
+    double h11 = s3 - s2;
+    double dh00 = 6*s2 - 6*s;
+    double dh10 = 3*s2 - 4*s + 1;
+    double dh01 = -6*s2 + 6*s;
+    double dh11 = 3*s2 - 2*s;
+
+    for (int k = 0; k < HERMITE_NUM_STATES; k++){
+        for (int i = 0; i < 3; i++){
+            int p = hermite_pos_fields[k] + i;
+            int v = hermite_vel_fields[k] + i;
+            row[p] = h00*row_0[p] + h10*dt*row_0[v] + h01*row_1[p] + h11*dt*row_1[v];
+            if (dt > 0){
+                row[v] = (dh00*row_0[p] + dh01*row_1[p]) / dt + dh10*row_0[v] + dh11*row_1[v];
+            }
+        }
+    }
+}
+
+void hermite_eval(double *knots, int num_knots, double t, double *row){
+    /*
+    Evaluates a Hermite-compressed trajectory at an arbitrary time, clamping to the first and last knots
+
+    INPUTS:
+    ----------
+        knots: double *
+            array of num_knots * TRAJ_NUM_FIELDS knot values, in increasing time
+        num_knots: int
+            number of knots
+        t: double
+            time at which to evaluate the trajectory
+        row: double *
+            array of TRAJ_NUM_FIELDS values for the reconstructed step
+    */
+
+    if (num_knots == 1 || t <= knots[0]){
+        memcpy(row, knots, TRAJ_NUM_FIELDS * sizeof(double));
+        return;
+    }
+    if (t >= knots[(num_knots - 1) * TRAJ_NUM_FIELDS]){
+        memcpy(row, knots + (num_knots - 1) * TRAJ_NUM_FIELDS, TRAJ_NUM_FIELDS * sizeof(double));
+        return;
+    }
+
+    // Binary search for the segment containing t
+    int lo = 0;
+    int hi = num_knots - 1;
+    while (hi - lo > 1){
+        int mid = (lo + hi) / 2;
+        if (knots[mid * TRAJ_NUM_FIELDS] <= t){
+            lo = mid;
+        }
+        else{
+            hi = mid;
+        }
+    }
+
+    hermite_segment(knots + lo * TRAJ_NUM_FIELDS, knots + hi * TRAJ_NUM_FIELDS, t, row);
+}
+
+void hermite_init(hermite_compressor *compressor, double tolerance){
+    /*
+    Initializes a Hermite knot compressor
+
+    INPUTS:
+    ----------
+        compressor: hermite_compressor *
+            pointer to the compressor
+        tolerance: double
+            maximum position error of the reconstruction in meters
+    */
+
+    compressor->tolerance = tolerance;
+    compressor->rows = malloc(HERMITE_MAX_SPAN * sizeof(*compressor->rows));
+    compressor->num_rows = 0;
+    compressor->first_emitted = 0;
+}
+
+void hermite_reset(hermite_compressor *compressor){
+    /*
+    Discards any buffered rows so that the compressor can start a new trajectory
+
+    INPUTS:
+    ----------
+        compressor: hermite_compressor *
+            pointer to the compressor
+    */
+
+    compressor->num_rows = 0;
+    compressor->first_emitted = 0;
+}
+
+void hermite_free(hermite_compressor *compressor){
+    /*
+    Frees the row buffer of a Hermite knot compressor
+
+    INPUTS:
+    ----------
+        compressor: hermite_compressor *
+            pointer to the compressor
+    */
+
+    free(compressor->rows);
+    compressor->rows = NULL;
+}
+
+int hermite_valid(hermite_compressor *compressor, int end){
+    /*
+    Checks whether a single segment from the last knot to a buffered row reproduces every row in between
+
+    INPUTS:
+    ----------
+        compressor: hermite_compressor *
+            pointer to the compressor
+        end: int
+            index of the buffered row at the end of the segment
+    OUTPUTS:
+    ----------
+        valid: int
+            flag indicating that every intermediate position is within the tolerance
+    */
+
+    double tol2 = compressor->tolerance * compressor->tolerance;
+    double *row_0 = compressor->rows[0];
+    double *row_1 = compressor->rows[end];
+    double row[TRAJ_NUM_FIELDS];
+
+    for (int i = 1; i < end; i++){
+        hermite_segment(row_0, row_1, compressor->rows[i][0], row);
+        for (int k = 0; k < HERMITE_NUM_STATES; k++){
+            int p = hermite_pos_fields[k];
+            double dx = row[p] - compressor->rows[i][p];
+            double dy = row[p+1] - compressor->rows[i][p+1];
+            double dz = row[p+2] - compressor->rows[i][p+2];
+            if (!(dx*dx + dy*dy + dz*dz <= tol2)){
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+int hermite_longest(hermite_compressor *compressor){
+    /*
+    Finds the furthest buffered row that can be reached from the last knot with a single valid segment,
+    doubling the span and then bisecting so that the cost is proportional to the segment length
+
+    INPUTS:
+    ----------
+        compressor: hermite_compressor *
+            pointer to the compressor
+    OUTPUTS:
+    ----------
+        end: int
+            index of the buffered row at the end of the longest valid segment
+    */
+
+    int last = compressor->num_rows - 1;
+    int lo = 1; // a segment to the next row has no intermediate rows and is always valid
+    int hi = last + 1;
+
+    for (int span = 2; span <= last; span *= 2){
+        if (!hermite_valid(compressor, span)){
+            hi = span;
+            break;
+        }
+        lo = span;
+    }
+    if (hi == last + 1 && lo < last){
+        if (hermite_valid(compressor, last)){
+            return last;
+        }
+        hi = last;
+    }
+
+    while (hi - lo > 1){
+        int mid = (lo + hi) / 2;
+        if (hermite_valid(compressor, mid)){
+            lo = mid;
+        }
+        else{
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+void hermite_push(hermite_compressor *compressor, double *row){
+    /*
+    Adds a trajectory row to the compressor buffer. Knots must be drained with hermite_next_knot after every push
+
+    INPUTS:
+    ----------
+        compressor: hermite_compressor *
+            pointer to the compressor
+        row: double *
+            array of TRAJ_NUM_FIELDS values for the step
+    */
+
+    memcpy(compressor->rows[compressor->num_rows], row, TRAJ_NUM_FIELDS * sizeof(double));
+    compressor->num_rows += 1;
+}
+
+int hermite_next_knot(hermite_compressor *compressor, int force, double *knot){
+    /*
+    Gets the next knot that can be emitted. A knot is emitted when the buffer is full, or for every remaining
+    segment when force is set (at flight events and at the end of the trajectory, so the last row is always a knot)
+
+    INPUTS:
+    ----------
+        compressor: hermite_compressor *
+            pointer to the compressor
+        force: int
+            flag to emit knots until the most recent row is a knot
+        knot: double *
+            array of TRAJ_NUM_FIELDS values for the emitted knot
+    OUTPUTS:
+    ----------
+        emitted: int
+            flag indicating that a knot was written to knot
+    */
+
+    if (compressor->num_rows == 0){
+        return 0;
+    }
+
+    // The first row of a trajectory is always a knot
+    if (!compressor->first_emitted){
+        compressor->first_emitted = 1;
+        memcpy(knot, compressor->rows[0], TRAJ_NUM_FIELDS * sizeof(double));
+        return 1;
+    }
+
+    if (compressor->num_rows == 1 || (!force && compressor->num_rows < HERMITE_MAX_SPAN)){
+        return 0;
+    }
+
+    // Emit the end of the longest valid segment and make it the new first row of the buffer
+    int end = hermite_longest(compressor);
+    memcpy(knot, compressor->rows[end], TRAJ_NUM_FIELDS * sizeof(double));
+    compressor->num_rows -= end;
+    memmove(compressor->rows, compressor->rows[end], compressor->num_rows * sizeof(*compressor->rows));
+
+    return 1;
+}
+
+#endif
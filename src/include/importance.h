@@ -0,0 +1,369 @@
+#ifndef IMPORTANCE_H
+#define IMPORTANCE_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <gsl/gsl_rng.h>
+#include "lincov.h"
+#include "pool.h"
+
+// Define the relative tolerance below which a direction of the impact Jacobian is dropped as linearly dependent
+#define IMPORTANCE_RANK_TOLERANCE 1e-3
+
+// Define a struct to store the tail metrics of an importance-sampled Monte Carlo campaign
+typedef struct importance_estimate{
+    double mean[3]; // weighted mean impact position in meters
+    double r50; // weighted median miss distance from the mean impact point (CEP) in meters
+    double r90; // weighted 90th percentile of the miss distance in meters
+    double r99; // weighted 99th percentile of the miss distance in meters
+    double exceedance_radius; // miss radius of the exceedance probability in meters
+    double exceedance_probability; // probability that the miss distance exceeds exceedance_radius
+    double exceedance_error; // standard error of the exceedance probability
+    double effective_samples; // effective sample size of the weights, (sum w)^2 / sum w^2
+    double scale; // standard deviation of the sampling distribution along the impact directions
+    int num_directions; // number of scaled directions in the space of the static error deviates
+    int num_flights; // number of trajectories flown
+} importance_estimate;
+
+// Define a struct to store the inputs and outputs of the trajectories of an importance-sampled campaign
+typedef struct importance_batch{
+    runparams *run_params; // pointer to the run parameters struct
+    uint64_t seed; // seed of the campaign
+    double scale; // standard deviation of the sampling distribution along the impact directions
+    double directions[3][NUM_ERROR_SOURCES]; // orthonormal impact directions in the space of the static error deviates
+    int num_directions; // number of impact directions
+    state *impact_states; // impact state of each trajectory
+    double *weights; // likelihood ratio of each trajectory
+} importance_batch;
+
+// Define a struct to store a sample value with its weight
+typedef struct weighted_value{
+    double value; // sample value
+    double weight; // nonnegative weight
+} weighted_value;
+
+int importance_directions(impact_jacobian *jacobian, const double *sigmas, double directions[3][NUM_ERROR_SOURCES]){
+    /*
+    Gets the directions in the space of the static error deviates that move the impact point to first order: the
+    rows of the impact Jacobian per standard deviation, orthonormalized. Deviates orthogonal to them do not move the
+    impact point to first order, and are sampled from their nominal distribution
+
+    INPUTS:
+    ----------
+        jacobian: impact_jacobian *
+            pointer to the impact Jacobian (see fly_jacobian)
+        sigmas: const double *
+            array of NUM_ERROR_SOURCES standard deviations in the units of the error sources
+        directions: double [3][NUM_ERROR_SOURCES]
+            array of up to 3 orthonormal directions to be filled
+    OUTPUTS:
+    ----------
+        num_directions: int
+            number of independent directions (at most 3, 2 for impact points on the Earth's surface)
+    */
+
+    double max_norm = 0;
+    for (int i = 0; i < 3; i++){
+        double norm = 0;
+        for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+            double g = jacobian->jacobian[i][source] * sigmas[source];
+            norm += g * g;
+        }
+        max_norm = fmax(max_norm, sqrt(norm));
+    }
+
+    // Modified Gram-Schmidt over the rows
+    int num_directions = 0;
+    for (int i = 0; i < 3; i++){
+        double *direction = directions[num_directions];
+        for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+            direction[source] = jacobian->jacobian[i][source] * sigmas[source];
+        }
+        for (int k = 0; k < num_directions; k++){
+            double dot = 0;
+            for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+                dot += direction[source] * directions[k][source];
+            }
+            for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+                direction[source] -= dot * directions[k][source];
+            }
+        }
+        double norm = 0;
+        for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+            norm += direction[source] * direction[source];
+        }
+        norm = sqrt(norm);
+        if (max_norm == 0 || norm <= IMPORTANCE_RANK_TOLERANCE * max_norm){
+            continue;
+        }
+        for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+            direction[source] /= norm;
+        }
+        num_directions++;
+    }
+
+    return num_directions;
+}
+
+double importance_transform(const importance_batch *batch, double *deviates){
+    /*
+    Maps standard normal deviates to a draw of the sampling distribution, by scaling their components along the
+    impact directions, and gets the likelihood ratio of the draw
+
+    INPUTS:
+    ----------
+        batch: const importance_batch *
+            pointer to the importance_batch struct
+        deviates: double *
+            array of NUM_ERROR_SOURCES standard normal deviates, replaced by the draw
+    OUTPUTS:
+    ----------
+        weight: double
+            likelihood ratio of the nominal over the sampling density at the draw
+    */
+
+    double scale = batch->scale;
+    double log_weight = 0;
+    for (int k = 0; k < batch->num_directions; k++){
+        double component = 0;
+        for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+            component += deviates[source] * batch->directions[k][source];
+        }
+        for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+            deviates[source] += (scale - 1) * component * batch->directions[k][source];
+        }
+
+        // N(0, 1) over N(0, scale^2) at the scaled component
+        double scaled = scale * component;
+        log_weight += log(scale) - 0.5 * scaled * scaled * (1 - 1 / (scale * scale));
+    }
+
+    return exp(log_weight);
+}
+
+void importance_task(void *context, int index){
+    /*
+    Flies one trajectory of an importance-sampled campaign (pool_task interface). The static error deviates are
+    drawn from the sampling distribution, the sensor noise and the Coriolis orientation from their nominal ones
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the importance_batch struct
+        index: int
+            index of the trajectory
+    */
+
+    importance_batch *batch = (importance_batch *)context;
+
+    error_sample sample;
+    draw_error_sample(batch->seed, index, PHILOX_STREAM_IMPORTANCE, &sample);
+    batch->weights[index] = importance_transform(batch, sample.deviates);
+
+    double time_error;
+    state impact_state = fly_deviates_noise(batch->run_params, sample.deviates, &sample.noise_seed, &time_error, NULL);
+    apply_coriolis(&impact_state, time_error, sample.lat, sample.lon);
+    batch->impact_states[index] = impact_state;
+}
+
+int compare_weighted_values(const void *a, const void *b){
+    /*
+    Compares two weighted values by value for qsort
+
+    INPUTS:
+    ----------
+        a: const void *
+            pointer to the first weighted value
+        b: const void *
+            pointer to the second weighted value
+    OUTPUTS:
+    ----------
+        order: int
+            -1, 0 or 1 if the first value is smaller than, equal to or larger than the second
+    */
+
+    return compare_doubles(&((const weighted_value *)a)->value, &((const weighted_value *)b)->value);
+}
+
+double weighted_quantile(const weighted_value *sorted, int num_values, double level){
+    /*
+    Gets a quantile of a weighted sample, the smallest value at which the normalized cumulative weight reaches the
+    level
+
+    INPUTS:
+    ----------
+        sorted: const weighted_value *
+            weighted values in increasing order of value
+        num_values: int
+            number of values
+        level: double
+            quantile level in (0, 1)
+    OUTPUTS:
+    ----------
+        quantile: double
+            weighted quantile
+    */
+
+    double total = 0;
+    for (int i = 0; i < num_values; i++){
+        total += sorted[i].weight;
+    }
+
+    double cumulative = 0;
+    for (int i = 0; i < num_values; i++){
+        cumulative += sorted[i].weight;
+        if (cumulative >= level * total){
+            return sorted[i].value;
+        }
+    }
+
+    return sorted[num_values - 1].value;
+}
+
+importance_estimate importance_run(runparams run_params, double scale, double exceedance_radius){
+    /*
+    Estimates the tail of the miss distance distribution by importance sampling. The static error deviates of
+    init_true_state and imu_init (and of the gravity and atmosphere models) are drawn with their components along
+    the impact directions, the rows of the impact Jacobian about the nominal flight (fly_jacobian), scaled by scale, so
+    that far misses are sampled often. Each trajectory carries the likelihood ratio of the nominal over the sampling
+    density, and the tail metrics are weighted: the weighted mean impact point, the weighted quantiles of the miss
+    distance from it (R50, R90, R99), and the probability of exceeding exceedance_radius. The likelihood ratios only
+    involve the 2 impact directions, so the effective sample size does not shrink with the number of error sources.
+    The sensor noise and the Coriolis orientation are drawn from their nominal distributions. Trajectories are
+    flown in parallel, and the impact states are written with their weights to run_params.impact_data_path
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+        scale: double
+            standard deviation of the sampling distribution along the impact directions, in nominal standard
+            deviations (1: plain Monte Carlo; above 1/sqrt(2) for finite weight variance, 2 to 3 for R99)
+        exceedance_radius: double
+            miss radius of the exceedance probability in meters
+    OUTPUTS:
+    ----------
+        estimate: importance_estimate
+            weighted tail metrics of the miss distance from the run_params.num_runs trajectories
+    */
+
+    run_params.traj_output = 0;
+    run_params.traj_archive = 0;
+
+    gsl_rng_env_setup();
+
+    importance_estimate estimate = {0};
+    int num_runs = run_params.num_runs;
+    estimate.scale = scale;
+    estimate.exceedance_radius = exceedance_radius;
+    estimate.num_flights = num_runs;
+    if (num_runs < 2 || scale <= M_SQRT1_2){
+        return estimate;
+    }
+
+    // Get the impact directions about the nominal flight, without sensor noise
+    runparams nominal_params = run_params;
+    nominal_params.gyro_noise = 0;
+    nominal_params.gnss_noise = 0;
+    impact_jacobian jacobian = fly_jacobian(&nominal_params);
+    double sigmas[NUM_ERROR_SOURCES];
+    error_source_sigmas(&run_params, sigmas);
+
+    importance_batch batch;
+    batch.run_params = &run_params;
+    batch.seed = gsl_rng_default_seed;
+    batch.scale = scale;
+    batch.num_directions = importance_directions(&jacobian, sigmas, batch.directions);
+    batch.impact_states = malloc(num_runs * sizeof(state));
+    batch.weights = malloc(num_runs * sizeof(double));
+    estimate.num_directions = batch.num_directions;
+    parallel_for(run_params.num_threads, importance_task, &batch, num_runs);
+
+    // Output the impact data with the weights
+    if (run_params.impact_data_path != NULL){
+        FILE *impact_file = fopen(run_params.impact_data_path, "w");
+        if (impact_file != NULL){
+            fprintf(impact_file, "t, x, y, z, vx, vy, vz, weight\n");
+            for (int run = 0; run < num_runs; run++){
+                state *impact_state = &batch.impact_states[run];
+                fprintf(impact_file, "%f, %f, %f, %f, %f, %f, %f, %.17g\n", impact_state->t, impact_state->x, impact_state->y, impact_state->z, impact_state->vx, impact_state->vy, impact_state->vz, batch.weights[run]);
+            }
+            fclose(impact_file);
+        }
+    }
+
+    // Weighted mean impact point and effective sample size
+    double sum_weights = 0;
+    double sum_squared_weights = 0;
+    for (int run = 0; run < num_runs; run++){
+        sum_weights += batch.weights[run];
+        sum_squared_weights += batch.weights[run] * batch.weights[run];
+    }
+    for (int run = 0; run < num_runs; run++){
+        estimate.mean[0] += batch.weights[run] * batch.impact_states[run].x / sum_weights;
+        estimate.mean[1] += batch.weights[run] * batch.impact_states[run].y / sum_weights;
+        estimate.mean[2] += batch.weights[run] * batch.impact_states[run].z / sum_weights;
+    }
+    estimate.effective_samples = sum_weights * sum_weights / sum_squared_weights;
+
+    // Miss distances from the mean impact point in the local tangent plane
+    double lon = atan2(estimate.mean[1], estimate.mean[0]);
+    double lat = atan2(estimate.mean[2], sqrt(estimate.mean[0]*estimate.mean[0] + estimate.mean[1]*estimate.mean[1]));
+    weighted_value *misses = malloc(num_runs * sizeof(weighted_value));
+    for (int run = 0; run < num_runs; run++){
+        double dx = batch.impact_states[run].x - estimate.mean[0];
+        double dy = batch.impact_states[run].y - estimate.mean[1];
+        double dz = batch.impact_states[run].z - estimate.mean[2];
+        double east = -sin(lon)*dx + cos(lon)*dy;
+        double north = -sin(lat)*cos(lon)*dx - sin(lat)*sin(lon)*dy + cos(lat)*dz;
+        misses[run].value = sqrt(east*east + north*north);
+        misses[run].weight = batch.weights[run];
+    }
+
+    // Unbiased estimate of the exceedance probability, the mean of the weighted indicators, and its standard error
+    double sum_indicators = 0;
+    double sum_squared_indicators = 0;
+    for (int run = 0; run < num_runs; run++){
+        if (misses[run].value > exceedance_radius){
+            sum_indicators += misses[run].weight;
+            sum_squared_indicators += misses[run].weight * misses[run].weight;
+        }
+    }
+    estimate.exceedance_probability = sum_indicators / num_runs;
+    double variance = (sum_squared_indicators / num_runs - estimate.exceedance_probability * estimate.exceedance_probability) * num_runs / (num_runs - 1);
+    estimate.exceedance_error = sqrt(fmax(variance, 0) / num_runs);
+
+    // Weighted quantiles of the miss distance
+    qsort(misses, num_runs, sizeof(weighted_value), compare_weighted_values);
+    estimate.r50 = weighted_quantile(misses, num_runs, 0.5);
+    estimate.r90 = weighted_quantile(misses, num_runs, 0.9);
+    estimate.r99 = weighted_quantile(misses, num_runs, 0.99);
+
+    free(misses);
+    free(batch.impact_states);
+    free(batch.weights);
+
+    return estimate;
+}
+
+void print_importance_estimate(importance_estimate *estimate){
+    /*
+    Prints the tail metrics of an importance-sampled Monte Carlo campaign
+
+    INPUTS:
+    ----------
+        estimate: importance_estimate *
+            pointer to the importance sampling estimate struct
+    */
+
+    printf("Importance sampling (%d trajectories, scale %.2f along %d directions, %.0f effective samples)\n", estimate->num_flights, estimate->scale, estimate->num_directions, estimate->effective_samples);
+    printf("Mean impact point: (%f, %f, %f)\n", estimate->mean[0], estimate->mean[1], estimate->mean[2]);
+    printf("R50 (CEP): %f m\n", estimate->r50);
+    printf("R90: %f m\n", estimate->r90);
+    printf("R99: %f m\n", estimate->r99);
+    printf("P(miss > %.1f m): %g +/- %g\n", estimate->exceedance_radius, estimate->exceedance_probability, estimate->exceedance_error);
+}
+
+#endif
@@ -1,10 +1,15 @@
 #ifndef LINALG_H
 #define LINALG_H
 
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_linalg.h>
 #include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
 
 void print_matrix(gsl_matrix *A){
     /*
@@ -280,4 +285,503 @@ gsl_matrix *m_pseudoinverse(gsl_matrix *A){
 
     return A_pinv;
 }
-#endif 
\ No newline at end of file
+
+// Define whether the calling thread expects GSL errors and reads them from the return status (see linalg_error_handler)
+static _Thread_local int linalg_errors_expected = 0;
+static pthread_once_t linalg_error_handler_once = PTHREAD_ONCE_INIT;
+
+void linalg_error_handler(const char *reason, const char *file, int line, int gsl_errno){
+    /*
+    This function is the GSL error handler of the process, installed once by linalg_install_error_handler. It
+    returns silently on a thread that expects errors, and otherwise reports the error and aborts as the default
+    GSL handler does.
+
+    INPUTS:
+    ----------------
+        reason (const char *): The description of the error.
+        file (const char *): The source file of the error.
+        line (int): The line of the error.
+        gsl_errno (int): The GSL error code.
+    */
+
+    if (linalg_errors_expected){
+        return;
+    }
+    fprintf(stderr, "gsl: %s:%d: ERROR: %s\n", file, line, reason);
+    fprintf(stderr, "Default GSL error handler invoked.\n");
+    abort();
+}
+
+void linalg_install_error_handler(void){
+    /*
+    This function installs linalg_error_handler as the GSL error handler of the process (pthread_once interface).
+    */
+
+    gsl_set_error_handler(linalg_error_handler);
+}
+
+int m_cholesky_decomp(gsl_matrix *A){
+    /*
+    This function computes the Cholesky factor A = L L^T of a symmetric positive definite matrix in place with
+    gsl_linalg_cholesky_decomp1, so that the factor can be used with gsl_linalg_cholesky_svx. A matrix that is not
+    positive definite is reported through the return status only: the error handler is installed once for the
+    process, and only the calling thread is marked as expecting the error.
+
+    INPUTS:
+    ----------------
+        A (gsl_matrix *): The symmetric matrix, overwritten by its factor.
+
+    OUTPUTS:
+    ----------------
+        status (int): GSL_SUCCESS on success, a GSL error code if the matrix is not numerically positive definite.
+    */
+
+    pthread_once(&linalg_error_handler_once, linalg_install_error_handler);
+    linalg_errors_expected = 1;
+    int status = gsl_linalg_cholesky_decomp1(A);
+    linalg_errors_expected = 0;
+
+    return status;
+}
+
+int m_ldlt_decomp(gsl_matrix *A){
+    /*
+    This function computes the factorization A = L D L^T of a symmetric matrix in place with
+    gsl_linalg_ldlt_decomp, so that the factor can be used with gsl_linalg_ldlt_svx. A zero pivot is reported
+    through the return status only, as in m_cholesky_decomp, and so is a non-finite pivot.
+
+    INPUTS:
+    ----------------
+        A (gsl_matrix *): The symmetric matrix, overwritten by its factor.
+
+    OUTPUTS:
+    ----------------
+        status (int): GSL_SUCCESS on success, a GSL error code if a pivot of D is zero or not finite.
+    */
+
+    pthread_once(&linalg_error_handler_once, linalg_install_error_handler);
+    linalg_errors_expected = 1;
+    int status = gsl_linalg_ldlt_decomp(A);
+    linalg_errors_expected = 0;
+    if (status != GSL_SUCCESS){
+        return status;
+    }
+
+    for (int i = 0; i < A->size1; i++){
+        double d = gsl_matrix_get(A, i, i);
+        if (d == 0 || !isfinite(d)){
+            return GSL_EDOM;
+        }
+    }
+
+    return GSL_SUCCESS;
+}
+
+// Define the initial capacity in bytes of a thread's scratch arena
+#define LINALG_ARENA_CAPACITY 65536
+
+// Define a struct to store a bump arena for temporary matrices and vectors
+typedef struct linalg_arena{
+    char *data; // current chunk
+    size_t capacity; // size of the current chunk in bytes
+    size_t offset; // bytes used in the current chunk
+    size_t used; // bytes used since the last reset, across all chunks
+    void **retired; // chunks filled since the last reset, kept alive until the next reset
+    int num_retired; // number of retired chunks
+} linalg_arena;
+
+// Define the scratch arena of the calling thread, allocated on first use
+static _Thread_local linalg_arena *linalg_scratch = NULL;
+
+linalg_arena *linalg_arena_alloc(size_t capacity){
+    /*
+    This function allocates a bump arena.
+
+    INPUTS:
+    ----------------
+        capacity (size_t): The initial capacity in bytes.
+
+    OUTPUTS:
+    ----------------
+        arena (linalg_arena *): The arena.
+
+    */
+
+    linalg_arena *arena = (linalg_arena *)malloc(sizeof(linalg_arena));
+    arena->data = (char *)malloc(capacity);
+    arena->capacity = capacity;
+    arena->offset = 0;
+    arena->used = 0;
+    arena->retired = NULL;
+    arena->num_retired = 0;
+    return arena;
+}
+
+void *linalg_arena_push(linalg_arena *arena, size_t size){
+    /*
+    This function reserves memory in a bump arena. When the current chunk is full it is retired and a chunk at
+    least twice as large is started, so that the arena reaches a steady size after the first few resets.
+
+    INPUTS:
+    ----------------
+        arena (linalg_arena *): The arena.
+        size (size_t): The number of bytes to reserve.
+
+    OUTPUTS:
+    ----------------
+        ptr (void *): Pointer to the reserved memory, aligned to 32 bytes.
+
+    */
+
+    // malloc only guarantees 16-byte alignment, so align the address rather than the offset
+    size = (size + 31) & ~(size_t)31;
+    size_t padding = (32 - ((size_t)(arena->data + arena->offset) & 31)) & 31;
+    if (arena->offset + padding + size > arena->capacity){
+        arena->retired = (void **)realloc(arena->retired, (arena->num_retired + 1) * sizeof(void *));
+        arena->retired[arena->num_retired++] = arena->data;
+        arena->capacity = 2 * arena->capacity > size + 32 ? 2 * arena->capacity : size + 32;
+        arena->data = (char *)malloc(arena->capacity);
+        arena->offset = 0;
+        padding = (32 - ((size_t)arena->data & 31)) & 31;
+    }
+
+    arena->offset += padding;
+    void *ptr = arena->data + arena->offset;
+    arena->offset += size;
+    arena->used += padding + size;
+    return ptr;
+}
+
+void linalg_arena_reset(linalg_arena *arena){
+    /*
+    This function releases everything reserved in a bump arena. Retired chunks are freed, and the current chunk
+    is replaced by one large enough for everything reserved since the last reset.
+
+    INPUTS:
+    ----------------
+        arena (linalg_arena *): The arena.
+
+    */
+
+    if (arena->num_retired > 0){
+        for (int i = 0; i < arena->num_retired; i++){
+            free(arena->retired[i]);
+        }
+        free(arena->retired);
+        arena->retired = NULL;
+        arena->num_retired = 0;
+        if (arena->capacity < 2 * arena->used){
+            free(arena->data);
+            arena->capacity = 2 * arena->used;
+            arena->data = (char *)malloc(arena->capacity);
+        }
+    }
+    arena->offset = 0;
+    arena->used = 0;
+}
+
+void linalg_arena_free(linalg_arena *arena){
+    /*
+    This function frees a bump arena and everything reserved in it.
+
+    INPUTS:
+    ----------------
+        arena (linalg_arena *): The arena.
+
+    */
+
+    linalg_arena_reset(arena);
+    free(arena->data);
+    free(arena);
+}
+
+gsl_matrix *arena_matrix_alloc(linalg_arena *arena, size_t n1, size_t n2){
+    /*
+    This function returns a matrix whose header and data live in a bump arena. It must not be passed to
+    gsl_matrix_free and is released by the next reset of the arena.
+
+    INPUTS:
+    ----------------
+        arena (linalg_arena *): The arena.
+        n1 (size_t): The number of rows.
+        n2 (size_t): The number of columns.
+
+    OUTPUTS:
+    ----------------
+        A (gsl_matrix *): The matrix.
+
+    */
+
+    gsl_matrix *A = (gsl_matrix *)linalg_arena_push(arena, sizeof(gsl_matrix));
+    A->size1 = n1;
+    A->size2 = n2;
+    A->tda = n2;
+    A->data = (double *)linalg_arena_push(arena, n1 * n2 * sizeof(double));
+    A->block = NULL;
+    A->owner = 0;
+    return A;
+}
+
+gsl_vector *arena_vector_alloc(linalg_arena *arena, size_t n){
+    /*
+    This function returns a vector whose header and data live in a bump arena. It must not be passed to
+    gsl_vector_free and is released by the next reset of the arena.
+
+    INPUTS:
+    ----------------
+        arena (linalg_arena *): The arena.
+        n (size_t): The number of elements.
+
+    OUTPUTS:
+    ----------------
+        v (gsl_vector *): The vector.
+
+    */
+
+    gsl_vector *v = (gsl_vector *)linalg_arena_push(arena, sizeof(gsl_vector));
+    v->size = n;
+    v->stride = 1;
+    v->data = (double *)linalg_arena_push(arena, n * sizeof(double));
+    v->block = NULL;
+    v->owner = 0;
+    return v;
+}
+
+linalg_arena *linalg_scratch_arena(void){
+    /*
+    This function returns the scratch arena of the calling thread, allocating it on first use.
+
+    OUTPUTS:
+    ----------------
+        arena (linalg_arena *): The scratch arena.
+
+    */
+
+    if (linalg_scratch == NULL){
+        linalg_scratch = linalg_arena_alloc(LINALG_ARENA_CAPACITY);
+    }
+    return linalg_scratch;
+}
+
+void linalg_scratch_reset(void){
+    /*
+    This function releases every temporary returned by the *_scratch helpers on the calling thread. It is meant
+    to be called once per time step by the owner of the time loop.
+
+    */
+
+    if (linalg_scratch != NULL){
+        linalg_arena_reset(linalg_scratch);
+    }
+}
+
+void linalg_scratch_free(void){
+    /*
+    This function frees the scratch arena of the calling thread, for example before a worker thread exits.
+
+    */
+
+    if (linalg_scratch != NULL){
+        linalg_arena_free(linalg_scratch);
+        linalg_scratch = NULL;
+    }
+}
+
+gsl_matrix *m_transpose_scratch(gsl_matrix *A){
+    /*
+    This function returns the transpose of a matrix, drawn from the scratch arena of the calling thread.
+
+    INPUTS:
+    ----------------
+        A (gsl_matrix *): The matrix to be transposed.
+
+    OUTPUTS:
+    ----------------
+        A_t (gsl_matrix *): The transpose of A, valid until the next linalg_scratch_reset.
+
+    */
+
+    gsl_matrix *A_t = arena_matrix_alloc(linalg_scratch_arena(), A->size2, A->size1);
+    gsl_matrix_transpose_memcpy(A_t, A);
+    return A_t;
+}
+
+gsl_matrix *mm_multiply_scratch(gsl_matrix *A, gsl_matrix *B){
+    /*
+    This function returns the product of two matrices, drawn from the scratch arena of the calling thread.
+
+    INPUTS:
+    ----------------
+        A (gsl_matrix *): The first matrix.
+        B (gsl_matrix *): The second matrix.
+
+    OUTPUTS:
+    ----------------
+        C (gsl_matrix *): The product of A and B, valid until the next linalg_scratch_reset.
+
+    */
+
+    gsl_matrix *C = arena_matrix_alloc(linalg_scratch_arena(), A->size1, B->size2);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, A, B, 0.0, C);
+    return C;
+}
+
+gsl_vector *mv_multiply_scratch(gsl_matrix *A, gsl_vector *v){
+    /*
+    This function returns the product of a matrix and a vector, drawn from the scratch arena of the calling thread.
+
+    INPUTS:
+    ----------------
+        A (gsl_matrix *): The matrix.
+        v (gsl_vector *): The vector.
+
+    OUTPUTS:
+    ----------------
+        w (gsl_vector *): The product of A and v, valid until the next linalg_scratch_reset.
+
+    */
+
+    gsl_vector *w = arena_vector_alloc(linalg_scratch_arena(), A->size1);
+    gsl_blas_dgemv(CblasNoTrans, 1.0, A, v, 0.0, w);
+    return w;
+}
+
+gsl_matrix *sm_multiply_scratch(double s, gsl_matrix *A){
+    /*
+    This function returns the product of a scalar and a matrix, drawn from the scratch arena of the calling thread.
+
+    INPUTS:
+    ----------------
+        s (double): The scalar.
+        A (gsl_matrix *): The matrix.
+
+    OUTPUTS:
+    ----------------
+        B (gsl_matrix *): The product of s and A, valid until the next linalg_scratch_reset.
+
+    */
+
+    gsl_matrix *B = arena_matrix_alloc(linalg_scratch_arena(), A->size1, A->size2);
+    gsl_matrix_memcpy(B, A);
+    gsl_matrix_scale(B, s);
+    return B;
+}
+
+gsl_matrix *mm_add_scratch(gsl_matrix *A, gsl_matrix *B){
+    /*
+    This function returns the sum of two matrices, drawn from the scratch arena of the calling thread.
+
+    INPUTS:
+    ----------------
+        A (gsl_matrix *): The first matrix.
+        B (gsl_matrix *): The second matrix.
+
+    OUTPUTS:
+    ----------------
+        C (gsl_matrix *): The sum of A and B, valid until the next linalg_scratch_reset.
+
+    */
+
+    gsl_matrix *C = arena_matrix_alloc(linalg_scratch_arena(), A->size1, A->size2);
+    gsl_matrix_memcpy(C, A);
+    gsl_matrix_add(C, B);
+    return C;
+}
+
+gsl_vector *vv_subtract_scratch(gsl_vector *v, gsl_vector *w){
+    /*
+    This function returns the difference of two vectors, drawn from the scratch arena of the calling thread.
+
+    INPUTS:
+    ----------------
+        v (gsl_vector *): The first vector.
+        w (gsl_vector *): The second vector.
+
+    OUTPUTS:
+    ----------------
+        u (gsl_vector): The difference of v and w, valid until the next linalg_scratch_reset.
+
+    */
+
+    gsl_vector *u = arena_vector_alloc(linalg_scratch_arena(), v->size);
+    gsl_vector_memcpy(u, v);
+    gsl_vector_sub(u, w);
+    return u;
+}
+
+gsl_vector *vv_add_scratch(gsl_vector *v, gsl_vector *w){
+    /*
+    This function returns the sum of two vectors, drawn from the scratch arena of the calling thread.
+
+    INPUTS:
+    ----------------
+        v (gsl_vector *): The first vector.
+        w (gsl_vector *): The second vector.
+
+    OUTPUTS:
+    ----------------
+        u (gsl_vector): The sum of v and w, valid until the next linalg_scratch_reset.
+
+    */
+
+    gsl_vector *u = arena_vector_alloc(linalg_scratch_arena(), v->size);
+    gsl_vector_memcpy(u, v);
+    gsl_vector_add(u, w);
+    return u;
+}
+
+gsl_matrix *m_pseudoinverse_scratch(gsl_matrix *A){
+    /*
+    This function returns the pseudoinverse of a matrix, drawn from the scratch arena of the calling thread.
+    Unlike m_pseudoinverse, A is left unchanged.
+
+    INPUTS:
+    ----------------
+        A (gsl_matrix *): The matrix.
+
+    OUTPUTS:
+    ----------------
+        A_pinv (gsl_matrix *): The pseudoinverse of A, valid until the next linalg_scratch_reset.
+
+    */
+
+    linalg_arena *arena = linalg_scratch_arena();
+    double rcond = 1e-10;
+    int was_swapped = A->size2 > A->size1;
+    size_t n = was_swapped ? A->size2 : A->size1;
+    size_t m = was_swapped ? A->size1 : A->size2;
+
+    /* libgsl SVD can only handle the case m <= n, so decompose A^T = U S V^T when A is wide */
+    gsl_matrix *U = arena_matrix_alloc(arena, n, m);
+    if (was_swapped){
+        gsl_matrix_transpose_memcpy(U, A);
+    }
+    else{
+        gsl_matrix_memcpy(U, A);
+    }
+    gsl_matrix *V = arena_matrix_alloc(arena, m, m);
+    gsl_vector *s = arena_vector_alloc(arena, m);
+    gsl_vector *work = arena_vector_alloc(arena, m);
+    gsl_linalg_SV_decomp(U, V, s, work);
+
+    /* scale the columns of U by the inverse singular values above the cutoff */
+    double cutoff = rcond * gsl_vector_max(s);
+    for (size_t j = 0; j < m; j++){
+        double x = gsl_vector_get(s, j) > cutoff ? 1. / gsl_vector_get(s, j) : 0.;
+        gsl_vector_view column = gsl_matrix_column(U, j);
+        gsl_vector_scale(&column.vector, x);
+    }
+
+    /* A^+ = V S^+ U^T, or U S^+ V^T when A was transposed */
+    gsl_matrix *A_pinv = arena_matrix_alloc(arena, A->size2, A->size1);
+    if (was_swapped){
+        gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1., U, V, 0., A_pinv);
+    }
+    else{
+        gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1., V, U, 0., A_pinv);
+    }
+
+    return A_pinv;
+}
+
+#endif
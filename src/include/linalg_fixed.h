@@ -0,0 +1,184 @@
+#ifndef LINALG_FIXED_H
+#define LINALG_FIXED_H
+
+#include <math.h>
+#include <string.h>
+#include "linalg.h"
+
+/*
+Fixed-size, stack-allocated matrix and vector kernels for the small dimensions used by the filter and frame math.
+
+Each dimension N gets the types matN and vecN (row-major, 32-byte aligned) and the functions below. The loop bounds
+are compile-time constants and the innermost loops run over contiguous rows, so the compiler fully unrolls and
+vectorizes them without any heap allocation or BLAS dispatch.
+
+    matN_multiply(A, B, C): C = A B
+    matN_transpose_multiply(A, B, C): C = A^T B
+    matN_multiply_transpose(A, B, C): C = A B^T
+    matN_vector_multiply(A, x, y): y = A x
+    matN_symmetric_update(A, P, Q, C): C = A P A^T + Q for symmetric P and Q (C is exactly symmetric)
+    matN_cholesky(A, L): lower Cholesky factor of a symmetric positive definite A, returns 0 on success
+    matN_solve(A, B, X): solves A X = B for a symmetric positive definite A, returns 0 on success
+    matN_from_gsl(A, M) / matN_to_gsl(M, A): copies to and from a gsl_matrix of matching size
+    matN_view(M): gsl_matrix view of M for use with the gsl_matrix API without copying
+
+C may not alias A or B in the multiply functions; X may alias B in matN_solve.
+*/
+
+#define DEFINE_FIXED_MATRIX(N) \
+\
+typedef struct mat##N{ \
+    _Alignas(32) double data[N][N]; \
+} mat##N; \
+\
+typedef struct vec##N{ \
+    _Alignas(32) double data[N]; \
+} vec##N; \
+\
+void mat##N##_multiply(const mat##N *A, const mat##N *B, mat##N *C){ \
+    for (int i = 0; i < N; i++){ \
+        double row[N] = {0}; \
+        for (int k = 0; k < N; k++){ \
+            double a = A->data[i][k]; \
+            for (int j = 0; j < N; j++){ \
+                row[j] += a * B->data[k][j]; \
+            } \
+        } \
+        memcpy(C->data[i], row, sizeof(row)); \
+    } \
+} \
+\
+void mat##N##_transpose_multiply(const mat##N *A, const mat##N *B, mat##N *C){ \
+    for (int i = 0; i < N; i++){ \
+        double row[N] = {0}; \
+        for (int k = 0; k < N; k++){ \
+            double a = A->data[k][i]; \
+            for (int j = 0; j < N; j++){ \
+                row[j] += a * B->data[k][j]; \
+            } \
+        } \
+        memcpy(C->data[i], row, sizeof(row)); \
+    } \
+} \
+\
+void mat##N##_multiply_transpose(const mat##N *A, const mat##N *B, mat##N *C){ \
+    for (int i = 0; i < N; i++){ \
+        for (int j = 0; j < N; j++){ \
+            double sum = 0; \
+            for (int k = 0; k < N; k++){ \
+                sum += A->data[i][k] * B->data[j][k]; \
+            } \
+            C->data[i][j] = sum; \
+        } \
+    } \
+} \
+\
+void mat##N##_vector_multiply(const mat##N *A, const vec##N *x, vec##N *y){ \
+    double out[N]; \
+    for (int i = 0; i < N; i++){ \
+        double sum = 0; \
+        for (int k = 0; k < N; k++){ \
+            sum += A->data[i][k] * x->data[k]; \
+        } \
+        out[i] = sum; \
+    } \
+    memcpy(y->data, out, sizeof(out)); \
+} \
+\
+void mat##N##_symmetric_update(const mat##N *A, const mat##N *P, const mat##N *Q, mat##N *C){ \
+    mat##N AP; \
+    mat##N##_multiply(A, P, &AP); \
+    for (int i = 0; i < N; i++){ \
+        for (int j = i; j < N; j++){ \
+            double sum = Q->data[i][j]; \
+            for (int k = 0; k < N; k++){ \
+                sum += AP.data[i][k] * A->data[j][k]; \
+            } \
+            C->data[i][j] = sum; \
+            C->data[j][i] = sum; \
+        } \
+    } \
+} \
+\
+int mat##N##_cholesky(const mat##N *A, mat##N *L){ \
+    memset(L, 0, sizeof(*L)); \
+    for (int j = 0; j < N; j++){ \
+        double d = A->data[j][j]; \
+        for (int k = 0; k < j; k++){ \
+            d -= L->data[j][k] * L->data[j][k]; \
+        } \
+        if (!(d > 0)){ \
+            return -1; \
+        } \
+        L->data[j][j] = sqrt(d); \
+        for (int i = j + 1; i < N; i++){ \
+            double sum = A->data[i][j]; \
+            for (int k = 0; k < j; k++){ \
+                sum -= L->data[i][k] * L->data[j][k]; \
+            } \
+            L->data[i][j] = sum / L->data[j][j]; \
+        } \
+    } \
+    return 0; \
+} \
+\
+int mat##N##_solve(const mat##N *A, const mat##N *B, mat##N *X){ \
+    mat##N L; \
+    if (mat##N##_cholesky(A, &L) != 0){ \
+        return -1; \
+    } \
+    if (X != B){ \
+        *X = *B; \
+    } \
+    /* Forward substitution L Y = B, one row of right-hand sides at a time */ \
+    for (int i = 0; i < N; i++){ \
+        for (int k = 0; k < i; k++){ \
+            for (int j = 0; j < N; j++){ \
+                X->data[i][j] -= L.data[i][k] * X->data[k][j]; \
+            } \
+        } \
+        for (int j = 0; j < N; j++){ \
+            X->data[i][j] /= L.data[i][i]; \
+        } \
+    } \
+    /* Back substitution L^T X = Y */ \
+    for (int i = N - 1; i >= 0; i--){ \
+        for (int k = i + 1; k < N; k++){ \
+            for (int j = 0; j < N; j++){ \
+                X->data[i][j] -= L.data[k][i] * X->data[k][j]; \
+            } \
+        } \
+        for (int j = 0; j < N; j++){ \
+            X->data[i][j] /= L.data[i][i]; \
+        } \
+    } \
+    return 0; \
+} \
+\
+void mat##N##_from_gsl(const gsl_matrix *A, mat##N *M){ \
+    for (int i = 0; i < N; i++){ \
+        for (int j = 0; j < N; j++){ \
+            M->data[i][j] = gsl_matrix_get(A, i, j); \
+        } \
+    } \
+} \
+\
+void mat##N##_to_gsl(const mat##N *M, gsl_matrix *A){ \
+    for (int i = 0; i < N; i++){ \
+        for (int j = 0; j < N; j++){ \
+            gsl_matrix_set(A, i, j, M->data[i][j]); \
+        } \
+    } \
+} \
+\
+gsl_matrix_view mat##N##_view(mat##N *M){ \
+    return gsl_matrix_view_array(&M->data[0][0], N, N); \
+}
+
+// Define the fixed-size kernels for position/velocity/attitude blocks (3), position-velocity states (6), and
+// position-velocity-acceleration states (9)
+DEFINE_FIXED_MATRIX(3)
+DEFINE_FIXED_MATRIX(6)
+DEFINE_FIXED_MATRIX(9)
+
+#endif
@@ -0,0 +1,721 @@
+#ifndef LINCOV_H
+#define LINCOV_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include "trajectory.h"
+#include "pool.h"
+
+// Define the indices of the static error sources, the errors drawn once per run. The first nine follow the order of
+// the deviates of init_true_state_from_deviates, and the atmospheric perturbations of layer i (density, zonal,
+// meridional and vertical wind) are at ERROR_ATM + 4 i
+#define ERROR_INITIAL_X 0
+#define ERROR_INITIAL_Y 1
+#define ERROR_INITIAL_Z 2
+#define ERROR_INITIAL_ROT 3
+#define ERROR_INITIAL_THETA_LAT 4
+#define ERROR_INITIAL_THETA_LONG 5
+#define ERROR_INITIAL_VX 6
+#define ERROR_INITIAL_VY 7
+#define ERROR_INITIAL_VZ 8
+#define ERROR_ACC_SCALE_X 9
+#define ERROR_ACC_SCALE_Y 10
+#define ERROR_ACC_SCALE_Z 11
+#define ERROR_GYRO_BIAS_LAT 12
+#define ERROR_GYRO_BIAS_LONG 13
+#define ERROR_GEOID_HEIGHT 14
+#define ERROR_EST_GEOID_HEIGHT 15
+#define ERROR_ATM 16
+#define NUM_ERROR_SOURCES 32
+
+// Define the perturbation of each error source in standard deviations used for the finite-difference sensitivities.
+// A full standard deviation keeps the impact differences well above the round-off of the integration
+#define LINCOV_STEP 1.0
+
+// Define the number of quadrature points used to evaluate the CEP of an elliptical Gaussian
+#define CEP_QUADRATURE_POINTS 256
+
+// Define a struct to store the dispersion statistics of the impact point
+typedef struct impact_dispersion{
+    double mean[3]; // mean impact position in meters
+    double covariance[3][3]; // impact position covariance in m^2
+    double local_covariance[2][2]; // east-north covariance in the local tangent plane at the mean impact point in m^2
+    double cep; // circular error probable about the mean impact point in meters
+    int num_flights; // number of trajectories flown
+} impact_dispersion;
+
+// Define a struct to store the random inputs of one trajectory flown from given deviates
+typedef struct error_sample{
+    double deviates[NUM_ERROR_SOURCES]; // standard normal deviates of the static error sources
+    uint64_t noise_seed; // seed of the sensor noise
+    double lat; // latitude of the Coriolis correction in radians
+    double lon; // longitude of the Coriolis correction in radians
+} error_sample;
+
+// Define a struct to store the nominal impact point and its sensitivities to the active static error sources
+typedef struct impact_jacobian{
+    double impact[3]; // nominal impact position in meters (relative to the estimated impact point for rv_maneuv = 2)
+    double time_error; // nominal impact time error (true minus estimated impact time) in seconds
+    double jacobian[3][NUM_ERROR_SOURCES]; // derivatives of the impact position per unit of each error source
+    double time_jacobian[NUM_ERROR_SOURCES]; // derivatives of the impact time error per unit of each error source
+    double curvature[3][NUM_ERROR_SOURCES]; // second derivatives of the impact position per unit squared
+    double time_curvature[NUM_ERROR_SOURCES]; // second derivatives of the impact time error per unit squared
+    int num_flights; // number of trajectories flown
+} impact_jacobian;
+
+void error_source_sigmas(runparams *run_params, double *sigmas){
+    /*
+    Gets the standard deviations of the static error sources in their physical units, zero for inactive sources
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        sigmas: double *
+            array of NUM_ERROR_SOURCES standard deviations to be filled
+    */
+
+    // The gravity and atmosphere models hold their own standard deviations
+    gsl_rng *rng = philox_alloc(0, 0, PHILOX_STREAM_RUN);
+    grav grav = init_grav(run_params, rng);
+    atm_model atm_model = init_atm(run_params, rng);
+    gsl_rng_free(rng);
+
+    sigmas[ERROR_INITIAL_X] = run_params->initial_x_error;
+    sigmas[ERROR_INITIAL_Y] = run_params->initial_pos_error;
+    sigmas[ERROR_INITIAL_Z] = run_params->initial_pos_error;
+    sigmas[ERROR_INITIAL_ROT] = run_params->initial_angle_error;
+    sigmas[ERROR_INITIAL_THETA_LAT] = run_params->initial_angle_error;
+    sigmas[ERROR_INITIAL_THETA_LONG] = run_params->initial_angle_error;
+    sigmas[ERROR_INITIAL_VX] = run_params->initial_vel_error;
+    sigmas[ERROR_INITIAL_VY] = run_params->initial_vel_error;
+    sigmas[ERROR_INITIAL_VZ] = run_params->initial_vel_error;
+    sigmas[ERROR_ACC_SCALE_X] = run_params->acc_scale_stability;
+    sigmas[ERROR_ACC_SCALE_Y] = run_params->acc_scale_stability;
+    sigmas[ERROR_ACC_SCALE_Z] = run_params->acc_scale_stability;
+    sigmas[ERROR_GYRO_BIAS_LAT] = run_params->gyro_bias_stability;
+    sigmas[ERROR_GYRO_BIAS_LONG] = run_params->gyro_bias_stability;
+    sigmas[ERROR_GEOID_HEIGHT] = (run_params->grav_error != 0) ? grav.geoid_height_std : 0;
+    sigmas[ERROR_EST_GEOID_HEIGHT] = sigmas[ERROR_GEOID_HEIGHT];
+    for (int i = 0; i < 4; i++){
+        sigmas[ERROR_ATM + 4*i] = atm_model.std_densities[i];
+        sigmas[ERROR_ATM + 4*i + 1] = atm_model.std_winds[i];
+        sigmas[ERROR_ATM + 4*i + 2] = atm_model.std_winds[i];
+        sigmas[ERROR_ATM + 4*i + 3] = atm_model.std_vert_winds[i];
+    }
+}
+
+void flight_set_deviates(flight *flight, const double *deviates){
+    /*
+    Replaces the static errors of the sensor, gravity and atmosphere models drawn by flight_init with given
+    standard normal deviates. The initial state errors are set by init_true_state_from_deviates
+
+    INPUTS:
+    ----------
+        flight: flight *
+            pointer to a flight struct initialized with flight_init
+        deviates: const double *
+            array of NUM_ERROR_SOURCES standard normal deviates
+    */
+
+    flight->imu.acc_scale_x = flight->imu.acc_scale_stability * deviates[ERROR_ACC_SCALE_X];
+    flight->imu.acc_scale_y = flight->imu.acc_scale_stability * deviates[ERROR_ACC_SCALE_Y];
+    flight->imu.acc_scale_z = flight->imu.acc_scale_stability * deviates[ERROR_ACC_SCALE_Z];
+    flight->imu.gyro_bias_lat = flight->imu.gyro_bias_stability * deviates[ERROR_GYRO_BIAS_LAT];
+    flight->imu.gyro_bias_long = flight->imu.gyro_bias_stability * deviates[ERROR_GYRO_BIAS_LONG];
+
+    // The navigation gravity model draws its own geoid height error
+    if (flight->run_params->grav_error != 0){
+        flight->true_grav.geoid_height_error = flight->true_grav.geoid_height_std * deviates[ERROR_GEOID_HEIGHT];
+        flight->est_grav.geoid_height_error = flight->est_grav.geoid_height_std * deviates[ERROR_EST_GEOID_HEIGHT];
+    }
+
+    atm_model *atm_model = &flight->atm_model;
+    for (int i = 0; i < 4; i++){
+        atm_model->pert_densities[i] = atm_model->std_densities[i] * deviates[ERROR_ATM + 4*i];
+        atm_model->pert_zonal_winds[i] = atm_model->std_winds[i] * deviates[ERROR_ATM + 4*i + 1];
+        atm_model->pert_meridional_winds[i] = atm_model->std_winds[i] * deviates[ERROR_ATM + 4*i + 2];
+        atm_model->pert_vert_winds[i] = atm_model->std_vert_winds[i] * deviates[ERROR_ATM + 4*i + 3];
+    }
+}
+
+state fly_deviates_noise(runparams *run_params, const double *deviates, const uint64_t *noise_seed, double *time_error, int *steps){
+    /*
+    Flies a deterministic trajectory with the static errors set to given standard normal deviates. All other random
+    numbers come from a fixed Philox sequence, so that trajectories flown with different deviates differ only
+    through the deviates and, if a noise seed is given, through the sensor noise
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        deviates: const double *
+            array of NUM_ERROR_SOURCES standard normal deviates
+        noise_seed: const uint64_t *
+            pointer to the seed of the sensor noise (NULL for the noise of the fixed sequence)
+        time_error: double *
+            set to the impact time error (true minus estimated impact time) in seconds
+        steps: int *
+            set to the number of integration steps taken (NULL if not needed)
+    OUTPUTS:
+    ----------
+        impact_state: state
+            true state at impact before the Coriolis correction (relative to the estimated impact point for
+            rv_maneuv = 2)
+    */
+
+    gsl_rng *rng = philox_alloc(0, 0, PHILOX_STREAM_RUN);
+
+    // Initialize the vehicle
+    vehicle vehicle;
+    if (run_params->rv_type == 0){
+        vehicle = init_mmiii_ballistic();
+    }
+    else if (run_params->rv_type == 1){
+        vehicle = init_mmiii_swerve();
+    }
+    else{
+        printf("Error: Invalid RV type\n");
+        exit(1);
+    }
+
+    state initial_state = init_true_state_from_deviates(run_params, deviates);
+
+    flight flight;
+    flight_init(&flight, run_params, &initial_state, &vehicle, rng, NULL);
+    flight_set_deviates(&flight, deviates);
+    if (noise_seed != NULL){
+        noise_buffer_seed(&flight.noise, *noise_seed);
+    }
+
+    for (int i = 0; i < MAX_FLIGHT_STEPS; i++){
+        if (flight_step(&flight)){
+            break;
+        }
+    }
+    gsl_rng_free(rng);
+    if (steps != NULL){
+        *steps = flight.steps;
+    }
+
+    if (!flight.impacted){
+        printf("Warning: Maximum number of steps reached with no impact\n");
+        *time_error = 0;
+        return flight.new_true_state;
+    }
+
+    state impact_state = flight.true_impact_state;
+    *time_error = flight.true_impact_state.t - flight.est_impact_state.t;
+    if (run_params->rv_maneuv == 2){
+        impact_state.x = impact_state.x - flight.est_impact_state.x;
+        impact_state.y = impact_state.y - flight.est_impact_state.y;
+        impact_state.z = impact_state.z - flight.est_impact_state.z;
+    }
+
+    return impact_state;
+}
+
+state fly_deviates(runparams *run_params, const double *deviates, double *time_error){
+    /*
+    Flies a deterministic trajectory with the static errors set to given standard normal deviates and the sensor
+    noise of the fixed Philox sequence (see fly_deviates_noise)
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        deviates: const double *
+            array of NUM_ERROR_SOURCES standard normal deviates
+        time_error: double *
+            set to the impact time error (true minus estimated impact time) in seconds
+    OUTPUTS:
+    ----------
+        impact_state: state
+            true state at impact before the Coriolis correction (relative to the estimated impact point for
+            rv_maneuv = 2)
+    */
+
+    return fly_deviates_noise(run_params, deviates, NULL, time_error, NULL);
+}
+
+void draw_error_sample(uint64_t seed, int row, uint32_t stream, error_sample *sample){
+    /*
+    Draws the random inputs of one trajectory from its own Philox sequence
+
+    INPUTS:
+    ----------
+        seed: uint64_t
+            seed of the analysis
+        row: int
+            index of the trajectory in its stream
+        stream: uint32_t
+            id of the Philox stream of the analysis (see philox.h)
+        sample: error_sample *
+            pointer to the sample to be filled
+    */
+
+    gsl_rng *rng = philox_alloc(seed, row, stream);
+    for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+        sample->deviates[source] = gsl_ran_gaussian(rng, 1);
+    }
+    // Draw the two halves in separate statements, so that their order does not depend on the compiler
+    uint64_t hi = gsl_rng_get(rng);
+    uint64_t lo = gsl_rng_get(rng);
+    sample->noise_seed = (hi << 32) ^ lo;
+    sample->lat = gsl_ran_flat(rng, -M_PI/2, M_PI/2);
+    sample->lon = gsl_ran_flat(rng, -M_PI, M_PI);
+    gsl_rng_free(rng);
+}
+
+double cep_from_covariance(double var_east, double var_north, double cov_east_north){
+    /*
+    Calculates the circular error probable of a zero-mean bivariate Gaussian, the radius containing half of the
+    distribution. The probability inside a circle of radius r is a single integral over the polar angle, evaluated
+    with the trapezoidal rule (exponentially accurate for a periodic integrand), and r is found by bisection
+
+    INPUTS:
+    ----------
+        var_east: double
+            variance of the east component in m^2
+        var_north: double
+            variance of the north component in m^2
+        cov_east_north: double
+            covariance of the east and north components in m^2
+    OUTPUTS:
+    ----------
+        cep: double
+            circular error probable in meters
+    */
+
+    // Get the principal standard deviations
+    double mean_var = 0.5 * (var_east + var_north);
+    double diff_var = sqrt(0.25 * (var_east - var_north) * (var_east - var_north) + cov_east_north * cov_east_north);
+    double sigma_1 = sqrt(fmax(mean_var + diff_var, 0));
+    double sigma_2 = sqrt(fmax(mean_var - diff_var, 0));
+
+    if (sigma_1 == 0){
+        return 0;
+    }
+    if (sigma_2 < 1e-9 * sigma_1){
+        // Degenerate (one-dimensional) distribution: median of |N(0, sigma_1^2)|
+        return 0.674489750196082 * sigma_1;
+    }
+
+    // The CEP lies between the medians of the one-dimensional and circular distributions of sigma_1
+    double r_low = 0.674489750196082 * sigma_1;
+    double r_high = 1.177410022515475 * sigma_1;
+    for (int iter = 0; iter < 60; iter++){
+        double r = 0.5 * (r_low + r_high);
+
+        // P(R < r) = 1 / (2 pi sigma_1 sigma_2) int (1 - exp(-r^2 q / 2)) / q dphi, q = cos^2 / sigma_1^2 + sin^2 / sigma_2^2
+        double sum = 0;
+        for (int k = 0; k < CEP_QUADRATURE_POINTS; k++){
+            double phi = M_PI * k / CEP_QUADRATURE_POINTS;
+            double c = cos(phi);
+            double s = sin(phi);
+            double q = c*c / (sigma_1*sigma_1) + s*s / (sigma_2*sigma_2);
+            sum += (1 - exp(-0.5 * r*r * q)) / q;
+        }
+        double probability = sum / (CEP_QUADRATURE_POINTS * sigma_1 * sigma_2);
+
+        if (probability < 0.5){
+            r_low = r;
+        }
+        else{
+            r_high = r;
+        }
+    }
+
+    return 0.5 * (r_low + r_high);
+}
+
+void dispersion_local_covariance(impact_dispersion *dispersion){
+    /*
+    Projects the impact covariance onto the east and north axes of the local tangent plane at the mean impact point
+
+    INPUTS:
+    ----------
+        dispersion: impact_dispersion *
+            pointer to the impact dispersion struct, with the mean and covariance set
+    */
+
+    double lon = atan2(dispersion->mean[1], dispersion->mean[0]);
+    double lat = atan2(dispersion->mean[2], sqrt(dispersion->mean[0]*dispersion->mean[0] + dispersion->mean[1]*dispersion->mean[1]));
+    double axes[2][3] = {
+        {-sin(lon), cos(lon), 0},
+        {-sin(lat)*cos(lon), -sin(lat)*sin(lon), cos(lat)}
+    };
+
+    for (int a = 0; a < 2; a++){
+        for (int b = 0; b < 2; b++){
+            double sum = 0;
+            for (int i = 0; i < 3; i++){
+                for (int j = 0; j < 3; j++){
+                    sum += axes[a][i] * dispersion->covariance[i][j] * axes[b][j];
+                }
+            }
+            dispersion->local_covariance[a][b] = sum;
+        }
+    }
+}
+
+// Define a struct to store the inputs and outputs of a batch of deterministic trajectories
+typedef struct deviates_batch{
+    runparams *run_params; // pointer to the run parameters struct
+    const double *deviates; // NUM_ERROR_SOURCES deviates per trajectory
+    state *impact_states; // impact state of each trajectory
+    double *time_errors; // impact time error of each trajectory
+} deviates_batch;
+
+void fly_deviates_task(void *context, int index){
+    /*
+    Flies one trajectory of a batch (pool_task interface)
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the deviates_batch struct
+        index: int
+            index of the trajectory
+    */
+
+    deviates_batch *batch = (deviates_batch *)context;
+    batch->impact_states[index] = fly_deviates(batch->run_params, &batch->deviates[index * NUM_ERROR_SOURCES], &batch->time_errors[index]);
+}
+
+void fly_deviates_batch(runparams *run_params, const double *deviates, int num_flights, state *impact_states, double *time_errors){
+    /*
+    Flies a batch of deterministic trajectories in parallel on run_params->num_threads threads. The results do not
+    depend on the number of threads
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        deviates: const double *
+            NUM_ERROR_SOURCES standard normal deviates per trajectory (row-major, num_flights rows)
+        num_flights: int
+            number of trajectories
+        impact_states: state *
+            array of num_flights impact states to be filled (see fly_deviates)
+        time_errors: double *
+            array of num_flights impact time errors to be filled
+    */
+
+    deviates_batch batch = {run_params, deviates, impact_states, time_errors};
+    parallel_for(run_params->num_threads, fly_deviates_task, &batch, num_flights);
+}
+
+void dispersion_finish(impact_dispersion *dispersion, double mean_time_error, double var_time_error){
+    /*
+    Adds the Coriolis correction to an impact covariance estimated without it, and derives the local covariance
+    and the CEP. The correction v cos(lat) dt u(lat, lon) has zero mean and, for a latitude uniform in
+    [-pi/2, pi/2] and a longitude uniform in [-pi, pi], the covariance v^2 E[dt^2] diag(3/16, 3/16, 1/8)
+
+    INPUTS:
+    ----------
+        dispersion: impact_dispersion *
+            pointer to the impact dispersion struct, with the mean and covariance set
+        mean_time_error: double
+            mean impact time error in seconds
+        var_time_error: double
+            variance of the impact time error in s^2
+    */
+
+    double coriolis_var = CORIOLIS_SPEED * CORIOLIS_SPEED * (mean_time_error * mean_time_error + var_time_error);
+    dispersion->covariance[0][0] += coriolis_var * 3.0 / 16.0;
+    dispersion->covariance[1][1] += coriolis_var * 3.0 / 16.0;
+    dispersion->covariance[2][2] += coriolis_var / 8.0;
+
+    dispersion_local_covariance(dispersion);
+    dispersion->cep = cep_from_covariance(dispersion->local_covariance[0][0], dispersion->local_covariance[1][1], dispersion->local_covariance[0][1]);
+}
+
+int active_error_sources(runparams *run_params, int *sources){
+    /*
+    Lists the active static error sources, those with a nonzero standard deviation
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        sources: int *
+            array of up to NUM_ERROR_SOURCES indices to be filled
+    OUTPUTS:
+    ----------
+        num_active: int
+            number of active sources
+    */
+
+    double sigmas[NUM_ERROR_SOURCES];
+    error_source_sigmas(run_params, sigmas);
+
+    int num_active = 0;
+    for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+        if (sigmas[source] != 0){
+            sources[num_active++] = source;
+        }
+    }
+
+    return num_active;
+}
+
+impact_jacobian fly_jacobian(runparams *run_params){
+    /*
+    Linearizes the impact point about the nominal trajectory with central differences in each active static error
+    source, stepped by LINCOV_STEP standard deviations (two flights per source, flown in parallel with the nominal
+    flight). The derivatives are taken per unit of each error source, so that other standard deviations can be
+    mapped through them without new flights (see jacobian_dispersion). Inactive sources have zero derivatives.
+    Sensor noise (gyro_noise, gnss_noise) is a process noise that is not linearized and is left out
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+    OUTPUTS:
+    ----------
+        jacobian: impact_jacobian
+            nominal impact point and impact time error, and their first and second derivatives
+    */
+
+    // Fly without sensor noise or trajectory output
+    runparams params = *run_params;
+    params.traj_output = 0;
+    params.traj_archive = 0;
+    params.gyro_noise = 0;
+    params.gnss_noise = 0;
+
+    double sigmas[NUM_ERROR_SOURCES];
+    error_source_sigmas(&params, sigmas);
+    int sources[NUM_ERROR_SOURCES];
+    int num_active = active_error_sources(&params, sources);
+
+    // The nominal trajectory, then the trajectories stepped up and down in each active source
+    int num_flights = 1 + 2 * num_active;
+    double *deviates = calloc(num_flights * NUM_ERROR_SOURCES, sizeof(double));
+    for (int k = 0; k < num_active; k++){
+        deviates[(1 + 2*k) * NUM_ERROR_SOURCES + sources[k]] = LINCOV_STEP;
+        deviates[(2 + 2*k) * NUM_ERROR_SOURCES + sources[k]] = -LINCOV_STEP;
+    }
+    state *impact_states = malloc(num_flights * sizeof(state));
+    double *time_errors = malloc(num_flights * sizeof(double));
+    fly_deviates_batch(&params, deviates, num_flights, impact_states, time_errors);
+
+    impact_jacobian jacobian = {0};
+    jacobian.num_flights = num_flights;
+    jacobian.impact[0] = impact_states[0].x;
+    jacobian.impact[1] = impact_states[0].y;
+    jacobian.impact[2] = impact_states[0].z;
+    jacobian.time_error = time_errors[0];
+
+    for (int k = 0; k < num_active; k++){
+        int source = sources[k];
+        state *plus = &impact_states[1 + 2*k];
+        state *minus = &impact_states[2 + 2*k];
+
+        // Differences in the units of the source
+        double step = LINCOV_STEP * sigmas[source];
+        double impact_plus[3] = {plus->x, plus->y, plus->z};
+        double impact_minus[3] = {minus->x, minus->y, minus->z};
+        for (int i = 0; i < 3; i++){
+            jacobian.jacobian[i][source] = (impact_plus[i] - impact_minus[i]) / (2 * step);
+            jacobian.curvature[i][source] = (impact_plus[i] + impact_minus[i] - 2 * jacobian.impact[i]) / (step * step);
+        }
+        double time_plus = time_errors[1 + 2*k];
+        double time_minus = time_errors[2 + 2*k];
+        jacobian.time_jacobian[source] = (time_plus - time_minus) / (2 * step);
+        jacobian.time_curvature[source] = (time_plus + time_minus - 2 * jacobian.time_error) / (step * step);
+    }
+
+    free(deviates);
+    free(impact_states);
+    free(time_errors);
+
+    return jacobian;
+}
+
+impact_dispersion jacobian_dispersion(impact_jacobian *jacobian, const double *sigmas){
+    /*
+    Maps the standard deviations of the static error sources through the impact Jacobian, J diag(sigma^2) J^T, with
+    the second-order shift of the mean impact point from the curvatures, and adds the Coriolis correction. Changing
+    the standard deviations of the active sources only needs this product, not new flights
+
+    INPUTS:
+    ----------
+        jacobian: impact_jacobian *
+            pointer to the impact Jacobian (see fly_jacobian)
+        sigmas: const double *
+            array of NUM_ERROR_SOURCES standard deviations in the units of the error sources
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            impact dispersion, with the CEP of the Gaussian approximation about the mean impact point
+    */
+
+    impact_dispersion dispersion = {0};
+    dispersion.num_flights = jacobian->num_flights;
+    double mean_time_error = jacobian->time_error;
+    double var_time_error = 0;
+    for (int i = 0; i < 3; i++){
+        dispersion.mean[i] = jacobian->impact[i];
+    }
+
+    for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+        double var = sigmas[source] * sigmas[source];
+        for (int i = 0; i < 3; i++){
+            dispersion.mean[i] += 0.5 * var * jacobian->curvature[i][source];
+            for (int j = 0; j < 3; j++){
+                dispersion.covariance[i][j] += var * jacobian->jacobian[i][source] * jacobian->jacobian[j][source];
+            }
+        }
+        mean_time_error += 0.5 * var * jacobian->time_curvature[source];
+        var_time_error += var * jacobian->time_jacobian[source] * jacobian->time_jacobian[source];
+    }
+
+    dispersion_finish(&dispersion, mean_time_error, var_time_error);
+
+    return dispersion;
+}
+
+impact_dispersion lincov_run(runparams run_params){
+    /*
+    Estimates the impact dispersion by linear covariance analysis. The impact point is linearized about the nominal
+    trajectory with central differences in each active static error source (see fly_jacobian), and the standard
+    deviations of the run parameters are mapped through the sensitivities. The curvature of the central differences
+    gives the second-order shift of the mean impact point. The randomly oriented Coriolis correction is added
+    analytically from the impact time error variance. Sensor noise (gyro_noise, gnss_noise) is a process noise that
+    is not linearized and is left out of the estimate
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            impact dispersion, with the CEP of the Gaussian approximation about the mean impact point
+    */
+
+    impact_jacobian jacobian = fly_jacobian(&run_params);
+    double sigmas[NUM_ERROR_SOURCES];
+    error_source_sigmas(&run_params, sigmas);
+
+    return jacobian_dispersion(&jacobian, sigmas);
+}
+
+int compare_doubles(const void *a, const void *b){
+    /*
+    Compares two doubles for qsort
+
+    INPUTS:
+    ----------
+        a: const void *
+            pointer to the first double
+        b: const void *
+            pointer to the second double
+    OUTPUTS:
+    ----------
+        order: int
+            -1, 0 or 1 if the first double is smaller than, equal to or larger than the second
+    */
+
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+void dispersion_from_impacts(impact_dispersion *dispersion, const double *impacts, int num_runs){
+    /*
+    Gets the sample dispersion statistics of a set of impact points
+
+    INPUTS:
+    ----------
+        dispersion: impact_dispersion *
+            pointer to the impact dispersion struct, with the mean and covariance zeroed
+        impacts: const double *
+            impact points (3 per run)
+        num_runs: int
+            number of impact points, at least 2
+    */
+
+    // Get the sample mean and covariance
+    for (int run = 0; run < num_runs; run++){
+        for (int i = 0; i < 3; i++){
+            dispersion->mean[i] += impacts[3*run + i] / num_runs;
+        }
+    }
+    for (int run = 0; run < num_runs; run++){
+        for (int i = 0; i < 3; i++){
+            for (int j = 0; j < 3; j++){
+                dispersion->covariance[i][j] += (impacts[3*run + i] - dispersion->mean[i]) * (impacts[3*run + j] - dispersion->mean[j]) / (num_runs - 1);
+            }
+        }
+    }
+    dispersion_local_covariance(dispersion);
+
+    // Get the median miss distance from the mean impact point in the local tangent plane
+    double lon = atan2(dispersion->mean[1], dispersion->mean[0]);
+    double lat = atan2(dispersion->mean[2], sqrt(dispersion->mean[0]*dispersion->mean[0] + dispersion->mean[1]*dispersion->mean[1]));
+    double *miss_distances = malloc(num_runs * sizeof(double));
+    for (int run = 0; run < num_runs; run++){
+        double dx = impacts[3*run] - dispersion->mean[0];
+        double dy = impacts[3*run + 1] - dispersion->mean[1];
+        double dz = impacts[3*run + 2] - dispersion->mean[2];
+        double east = -sin(lon)*dx + cos(lon)*dy;
+        double north = -sin(lat)*cos(lon)*dx - sin(lat)*sin(lon)*dy + cos(lat)*dz;
+        miss_distances[run] = sqrt(east*east + north*north);
+    }
+    qsort(miss_distances, num_runs, sizeof(double), compare_doubles);
+    dispersion->cep = (num_runs % 2 == 1) ? miss_distances[num_runs / 2] : 0.5 * (miss_distances[num_runs / 2 - 1] + miss_distances[num_runs / 2]);
+
+    free(miss_distances);
+}
+
+impact_dispersion mc_dispersion(runparams run_params, int num_runs){
+    /*
+    Estimates the impact dispersion from Monte Carlo runs (the runs of mc_run for the same GSL_RNG_SEED), to
+    cross-check lincov_run
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+        num_runs: int
+            number of Monte Carlo runs
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            sample impact dispersion, with the sample median miss distance from the mean impact point as the CEP
+    */
+
+    run_params.traj_output = 0;
+    run_params.traj_archive = 0;
+
+    gsl_rng_env_setup();
+    uint64_t seed = gsl_rng_default_seed;
+
+    impact_dispersion dispersion = {0};
+    dispersion.num_flights = num_runs;
+    if (num_runs < 2){
+        return dispersion;
+    }
+
+    double *impacts = malloc(3 * num_runs * sizeof(double));
+    for (int run = 0; run < num_runs; run++){
+        state final_state = mc_single_run(&run_params, seed, run, NULL);
+        impacts[3*run] = final_state.x;
+        impacts[3*run + 1] = final_state.y;
+        impacts[3*run + 2] = final_state.z;
+    }
+
+    dispersion_from_impacts(&dispersion, impacts, num_runs);
+    free(impacts);
+
+    return dispersion;
+}
+
+#endif
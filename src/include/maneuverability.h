@@ -159,15 +159,17 @@ void update_lift(state *state, cart_vector *a_command, atm_cond *atm_cond, vehic
         vehicle: vehicle *
             pointer to the vehicle struct
         time_step: double
-            time step for the simulation
+            time since the last lift update in seconds (the lift rate-group interval)
     */
 
     // Calculate the time constant of the vehicle
     double time_constant = rv_time_constant(vehicle, state, atm_cond);
 
-    state->ax_lift = state->ax_lift + (a_command->x - state->ax_lift) * time_step / time_constant;
-    state->ay_lift = state->ay_lift + (a_command->y - state->ay_lift) * time_step / time_constant;
-    state->az_lift = state->az_lift + (a_command->z - state->az_lift) * time_step / time_constant;
+    // Exact first-order lag over the interval, which cannot overshoot the command however long the interval
+    double lag_fraction = 1 - exp(-time_step / time_constant);
+    state->ax_lift = state->ax_lift + (a_command->x - state->ax_lift) * lag_fraction;
+    state->ay_lift = state->ay_lift + (a_command->y - state->ay_lift) * lag_fraction;
+    state->az_lift = state->az_lift + (a_command->z - state->az_lift) * lag_fraction;
 
     double velocity = sqrt(state->vx*state->vx + state->vy*state->vy + state->vz*state->vz);
     double a_exec_mag = sqrt(state->ax_lift*state->ax_lift + state->ay_lift*state->ay_lift + state->az_lift*state->az_lift);
@@ -0,0 +1,378 @@
+#ifndef MLMC_H
+#define MLMC_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "lincov.h"
+#include "pool.h"
+
+// Define the hierarchy of the multilevel Monte Carlo: level l integrates the reentry with the time step
+// time_step_reentry * MLMC_REFINEMENT^(num_levels - 1 - l), so that the finest level is the step of the run parameters
+#define MLMC_MAX_LEVELS 8
+#define MLMC_REFINEMENT 2
+
+// Define the number of samples per level used to estimate the level variances before the samples are allocated,
+// the maximum number of samples per level, and the maximum number of allocation rounds
+#define MLMC_WARMUP 16
+#define MLMC_MAX_SAMPLES 100000
+#define MLMC_MAX_ITERATIONS 10
+
+// Define the quantities estimated by the multilevel Monte Carlo: the offset of the impact point from the nominal
+// impact point at the time step of the level, its second moments, and the miss distance from the aimpoint
+#define MLMC_Q_OFFSET 0 // x, y and z offsets
+#define MLMC_Q_MOMENT 3 // xx, xy, xz, yy, yz and zz products of the offsets
+#define MLMC_Q_MISS 9
+#define MLMC_NUM_QUANTITIES 10
+
+// Define a struct to store the multilevel Monte Carlo estimate of the impact dispersion
+typedef struct mlmc_estimate{
+    impact_dispersion dispersion; // impact dispersion at the finest time step, with the CEP of the Gaussian approximation
+    double mean_miss; // mean miss distance from the aimpoint in the local tangent plane in meters
+    double mean_error; // root mean square statistical error of the mean impact point in meters
+    double miss_error; // statistical error (standard deviation) of the mean miss distance in meters
+    int num_levels; // number of levels
+    double time_steps[MLMC_MAX_LEVELS]; // reentry time step of each level in seconds
+    int num_samples[MLMC_MAX_LEVELS]; // number of samples of each level
+    double variances[MLMC_MAX_LEVELS]; // variance of the impact point correction of each level (trace) in m^2
+    double costs[MLMC_MAX_LEVELS]; // mean integration steps per sample of each level (both flights of a pair)
+    double total_steps; // integration steps of all flights
+    double mc_steps; // integration steps of a single-level Monte Carlo at the finest step with the same mean_error
+} mlmc_estimate;
+
+// Define a struct to store the inputs and outputs of a batch of multilevel Monte Carlo samples
+typedef struct mlmc_batch{
+    runparams *run_params; // pointer to the run parameters struct
+    uint64_t seed; // seed of the analysis
+    int num_levels; // number of levels
+    const int *levels; // level of each sample
+    const int *samples; // index of each sample within its level
+    double references[MLMC_MAX_LEVELS][3]; // nominal impact point of each level
+    double aim_offset[3]; // aimpoint (the origin for rv_maneuv = 2) relative to the nominal impact point of the finest level
+    double axes[2][3]; // east and north axes of the local tangent plane at the aimpoint
+    double *corrections; // MLMC_NUM_QUANTITIES level corrections per sample
+    int *steps; // integration steps per sample
+} mlmc_batch;
+
+double mlmc_time_step(runparams *run_params, int num_levels, int level){
+    /*
+    Gets the reentry time step of a level of the hierarchy
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        num_levels: int
+            number of levels
+        level: int
+            index of the level (0 is the coarsest)
+    OUTPUTS:
+    ----------
+        time_step: double
+            reentry time step in seconds
+    */
+
+    return run_params->time_step_reentry * pow(MLMC_REFINEMENT, num_levels - 1 - level);
+}
+
+int mlmc_fly(mlmc_batch *batch, int level, const error_sample *sample, double *quantities){
+    /*
+    Flies the trajectory of a sample at the reentry time step of a level and evaluates the estimated quantities
+
+    INPUTS:
+    ----------
+        batch: mlmc_batch *
+            pointer to the mlmc_batch struct
+        level: int
+            index of the level
+        sample: const error_sample *
+            pointer to the random inputs of the trajectory
+        quantities: double *
+            array of MLMC_NUM_QUANTITIES quantities to be filled
+    OUTPUTS:
+    ----------
+        steps: int
+            number of integration steps taken
+    */
+
+    runparams run_params = *batch->run_params;
+    run_params.time_step_reentry = mlmc_time_step(batch->run_params, batch->num_levels, level);
+
+    double time_error;
+    int steps;
+    state impact_state = fly_deviates_noise(&run_params, sample->deviates, &sample->noise_seed, &time_error, &steps);
+    apply_coriolis(&impact_state, time_error, sample->lat, sample->lon);
+
+    // The quantities of every level are taken about its own nominal impact point, so that the corrections do not
+    // carry the time step bias of the coarse levels. The miss distance is that of the finest level
+    double impact[3] = {impact_state.x, impact_state.y, impact_state.z};
+    double offset[3];
+    double miss[3];
+    for (int i = 0; i < 3; i++){
+        offset[i] = impact[i] - batch->references[level][i];
+        miss[i] = offset[i] - batch->aim_offset[i];
+        quantities[MLMC_Q_OFFSET + i] = offset[i];
+    }
+    int q = MLMC_Q_MOMENT;
+    for (int i = 0; i < 3; i++){
+        for (int j = i; j < 3; j++){
+            quantities[q++] = offset[i] * offset[j];
+        }
+    }
+    double east = batch->axes[0][0]*miss[0] + batch->axes[0][1]*miss[1] + batch->axes[0][2]*miss[2];
+    double north = batch->axes[1][0]*miss[0] + batch->axes[1][1]*miss[1] + batch->axes[1][2]*miss[2];
+    quantities[MLMC_Q_MISS] = sqrt(east*east + north*north);
+
+    return steps;
+}
+
+void mlmc_task(void *context, int index){
+    /*
+    Flies one sample of a multilevel Monte Carlo batch (pool_task interface). A sample of level l > 0 is a coupled
+    pair: the same random inputs are flown at the time steps of levels l and l - 1, and the difference of the
+    quantities is the level correction. A sample of level 0 is a single flight
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the mlmc_batch struct
+        index: int
+            index of the sample in the batch
+    */
+
+    mlmc_batch *batch = (mlmc_batch *)context;
+    int level = batch->levels[index];
+
+    error_sample sample;
+    draw_error_sample(batch->seed, batch->samples[index], PHILOX_STREAM_MLMC + level, &sample);
+
+    double *corrections = &batch->corrections[index * MLMC_NUM_QUANTITIES];
+    batch->steps[index] = mlmc_fly(batch, level, &sample, corrections);
+    if (level > 0){
+        double coarse[MLMC_NUM_QUANTITIES];
+        batch->steps[index] += mlmc_fly(batch, level - 1, &sample, coarse);
+        for (int q = 0; q < MLMC_NUM_QUANTITIES; q++){
+            corrections[q] -= coarse[q];
+        }
+    }
+}
+
+mlmc_estimate mlmc_run(runparams run_params, int num_levels, double tolerance){
+    /*
+    Estimates the impact dispersion at the reentry time step of the run parameters by multilevel Monte Carlo
+    (Giles, 2008). Many samples are flown at the coarsest time step, and each finer level adds the mean correction
+    of fewer coupled fine and coarse pairs, which share their static errors, sensor noise seed and Coriolis
+    orientation, so the corrections have a small variance. The telescoping sum of the level means is an unbiased
+    estimate at the finest step. After MLMC_WARMUP samples per level, the samples are allocated in proportion to
+    sqrt(V_l / C_l) from the measured correction variances V_l and costs C_l (integration steps) until the mean
+    impact point reaches the requested statistical error. All samples are flown in parallel on
+    run_params.num_threads threads and the results do not depend on the number of threads. The sensor noise is
+    drawn per sensor update, so it is closely coupled between levels only when the update periods are multiples of
+    both time steps; otherwise the estimate stays unbiased but the corrections have a larger variance
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+        num_levels: int
+            number of levels, from 1 (plain Monte Carlo) to MLMC_MAX_LEVELS
+        tolerance: double
+            requested root mean square statistical error of the mean impact point in meters
+    OUTPUTS:
+    ----------
+        estimate: mlmc_estimate
+            impact dispersion, mean miss distance and the samples, variances and costs of the levels
+    */
+
+    run_params.traj_output = 0;
+    run_params.traj_archive = 0;
+
+    gsl_rng_env_setup();
+    uint64_t seed = gsl_rng_default_seed;
+
+    mlmc_estimate estimate = {0};
+    if (num_levels < 1){
+        num_levels = 1;
+    }
+    if (num_levels > MLMC_MAX_LEVELS){
+        num_levels = MLMC_MAX_LEVELS;
+    }
+    estimate.num_levels = num_levels;
+
+    mlmc_batch batch = {0};
+    batch.run_params = &run_params;
+    batch.seed = seed;
+    batch.num_levels = num_levels;
+
+    // Fly the nominal trajectory of each level, the reference of its quantities. The steps of the finest one are
+    // the cost of a single flight at the finest time step
+    double nominal_deviates[NUM_ERROR_SOURCES] = {0};
+    double nominal_time_error;
+    int fine_steps = 0;
+    for (int l = 0; l < num_levels; l++){
+        runparams level_params = run_params;
+        level_params.time_step_reentry = mlmc_time_step(&run_params, num_levels, l);
+        state nominal = fly_deviates_noise(&level_params, nominal_deviates, NULL, &nominal_time_error, &fine_steps);
+        batch.references[l][0] = nominal.x;
+        batch.references[l][1] = nominal.y;
+        batch.references[l][2] = nominal.z;
+    }
+
+    // Miss distances are measured in the local tangent plane at the aimpoint
+    double aimpoint[3] = {0, 0, 0};
+    if (run_params.rv_maneuv != 2){
+        aimpoint[0] = run_params.x_aim;
+        aimpoint[1] = run_params.y_aim;
+        aimpoint[2] = run_params.z_aim;
+    }
+    for (int i = 0; i < 3; i++){
+        batch.aim_offset[i] = aimpoint[i] - batch.references[num_levels - 1][i];
+    }
+    double aim_lon = atan2(run_params.y_aim, run_params.x_aim);
+    double aim_lat = atan2(run_params.z_aim, sqrt(run_params.x_aim*run_params.x_aim + run_params.y_aim*run_params.y_aim));
+    batch.axes[0][0] = -sin(aim_lon);
+    batch.axes[0][1] = cos(aim_lon);
+    batch.axes[0][2] = 0;
+    batch.axes[1][0] = -sin(aim_lat)*cos(aim_lon);
+    batch.axes[1][1] = -sin(aim_lat)*sin(aim_lon);
+    batch.axes[1][2] = cos(aim_lat);
+
+    // Running sums of the corrections, their squares and the costs of each level
+    double sums[MLMC_MAX_LEVELS][MLMC_NUM_QUANTITIES] = {{0}};
+    double sums_sq[MLMC_MAX_LEVELS][MLMC_NUM_QUANTITIES] = {{0}};
+    double step_sums[MLMC_MAX_LEVELS] = {0};
+    int num_samples[MLMC_MAX_LEVELS] = {0};
+    int targets[MLMC_MAX_LEVELS];
+    for (int l = 0; l < num_levels; l++){
+        targets[l] = MLMC_WARMUP;
+        estimate.time_steps[l] = mlmc_time_step(&run_params, num_levels, l);
+    }
+
+    for (int iter = 0; iter < MLMC_MAX_ITERATIONS; iter++){
+        // Fly the missing samples of every level in one batch
+        int num_new = 0;
+        for (int l = 0; l < num_levels; l++){
+            num_new += targets[l] - num_samples[l];
+        }
+        if (num_new == 0){
+            break;
+        }
+
+        int *levels = malloc(num_new * sizeof(int));
+        int *samples = malloc(num_new * sizeof(int));
+        int k = 0;
+        for (int l = num_levels - 1; l >= 0; l--){
+            // The expensive fine levels first, so that the cheap samples fill the tail of the batch
+            for (int s = num_samples[l]; s < targets[l]; s++){
+                levels[k] = l;
+                samples[k] = s;
+                k++;
+            }
+        }
+        batch.levels = levels;
+        batch.samples = samples;
+        batch.corrections = malloc(num_new * MLMC_NUM_QUANTITIES * sizeof(double));
+        batch.steps = malloc(num_new * sizeof(int));
+        parallel_for(run_params.num_threads, mlmc_task, &batch, num_new);
+
+        // Accumulate in batch order, independent of the number of threads
+        for (k = 0; k < num_new; k++){
+            int l = levels[k];
+            for (int q = 0; q < MLMC_NUM_QUANTITIES; q++){
+                double correction = batch.corrections[k * MLMC_NUM_QUANTITIES + q];
+                sums[l][q] += correction;
+                sums_sq[l][q] += correction * correction;
+            }
+            step_sums[l] += batch.steps[k];
+            num_samples[l]++;
+        }
+
+        free(levels);
+        free(samples);
+        free(batch.corrections);
+        free(batch.steps);
+
+        // Allocate the samples from the variances and costs of the levels
+        double sum_sqrt_vc = 0;
+        for (int l = 0; l < num_levels; l++){
+            double variance = 0;
+            for (int i = 0; i < 3; i++){
+                double mean = sums[l][MLMC_Q_OFFSET + i] / num_samples[l];
+                variance += (sums_sq[l][MLMC_Q_OFFSET + i] - num_samples[l] * mean * mean) / (num_samples[l] - 1);
+            }
+            estimate.variances[l] = fmax(variance, 0);
+            estimate.costs[l] = step_sums[l] / num_samples[l];
+            sum_sqrt_vc += sqrt(estimate.variances[l] * estimate.costs[l]);
+        }
+        if (tolerance <= 0){
+            break;
+        }
+        for (int l = 0; l < num_levels; l++){
+            double optimal = ceil(sqrt(estimate.variances[l] / estimate.costs[l]) * sum_sqrt_vc / (tolerance * tolerance));
+            if (optimal > MLMC_MAX_SAMPLES){
+                optimal = MLMC_MAX_SAMPLES;
+            }
+            if (optimal > targets[l]){
+                targets[l] = (int)optimal;
+            }
+        }
+    }
+
+    // Combine the levels
+    double means[MLMC_NUM_QUANTITIES] = {0};
+    double mean_var = 0;
+    double miss_var = 0;
+    for (int l = 0; l < num_levels; l++){
+        for (int q = 0; q < MLMC_NUM_QUANTITIES; q++){
+            means[q] += sums[l][q] / num_samples[l];
+        }
+        double miss_mean = sums[l][MLMC_Q_MISS] / num_samples[l];
+        miss_var += fmax((sums_sq[l][MLMC_Q_MISS] - num_samples[l] * miss_mean * miss_mean) / (num_samples[l] - 1), 0) / num_samples[l];
+        mean_var += estimate.variances[l] / num_samples[l];
+        estimate.num_samples[l] = num_samples[l];
+        estimate.total_steps += step_sums[l];
+        estimate.dispersion.num_flights += (l > 0) ? 2 * num_samples[l] : num_samples[l];
+    }
+    estimate.mean_error = sqrt(mean_var);
+    estimate.miss_error = sqrt(miss_var);
+    estimate.mean_miss = means[MLMC_Q_MISS];
+    estimate.mc_steps = (mean_var > 0) ? estimate.variances[0] / mean_var * fine_steps : 0;
+
+    int q = MLMC_Q_MOMENT;
+    for (int i = 0; i < 3; i++){
+        estimate.dispersion.mean[i] = batch.references[num_levels - 1][i] + means[MLMC_Q_OFFSET + i];
+        for (int j = i; j < 3; j++){
+            double covariance = means[q++] - means[MLMC_Q_OFFSET + i] * means[MLMC_Q_OFFSET + j];
+            estimate.dispersion.covariance[i][j] = covariance;
+            estimate.dispersion.covariance[j][i] = covariance;
+        }
+    }
+    dispersion_local_covariance(&estimate.dispersion);
+    estimate.dispersion.cep = cep_from_covariance(estimate.dispersion.local_covariance[0][0], estimate.dispersion.local_covariance[1][1], estimate.dispersion.local_covariance[0][1]);
+
+    return estimate;
+}
+
+void print_mlmc_estimate(mlmc_estimate *estimate){
+    /*
+    Prints the multilevel Monte Carlo estimate and the samples, variances and costs of its levels
+
+    INPUTS:
+    ----------
+        estimate: mlmc_estimate *
+            pointer to the multilevel Monte Carlo estimate struct
+    */
+
+    printf("Multilevel Monte Carlo (%d levels, %d trajectories)\n", estimate->num_levels, estimate->dispersion.num_flights);
+    printf("  %5s %12s %10s %14s %12s\n", "Level", "Time step", "Samples", "Variance", "Steps");
+    for (int l = 0; l < estimate->num_levels; l++){
+        printf("  %5d %12g %10d %14g %12.0f\n", l, estimate->time_steps[l], estimate->num_samples[l], estimate->variances[l], estimate->costs[l]);
+    }
+    printf("Mean impact point: (%f, %f, %f) +/- %g m\n", estimate->dispersion.mean[0], estimate->dispersion.mean[1], estimate->dispersion.mean[2], estimate->mean_error);
+    printf("Mean miss distance: %f +/- %g m\n", estimate->mean_miss, estimate->miss_error);
+    printf("CEP: %f m\n", estimate->dispersion.cep);
+    printf("Integration steps: %.0f (single-level Monte Carlo: %.0f)\n", estimate->total_steps, estimate->mc_steps);
+}
+
+#endif
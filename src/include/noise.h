@@ -0,0 +1,245 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <gsl/gsl_rng.h>
+
+// Define the number of standard normal samples generated per block
+#define NOISE_BLOCK_SIZE 1024
+
+// Define the number of layers, the tail start, and the layer area of the normal ziggurat (Marsaglia and Tsang, 2000)
+#define NOISE_ZIG_LAYERS 128
+#define NOISE_ZIG_R 3.442619855899
+#define NOISE_ZIG_V 9.91256303526217e-3
+
+// Define the ziggurat tables shared by all noise buffers, built once by noise_zig_init
+static double noise_zig_x[NOISE_ZIG_LAYERS + 1]; // layer edges, noise_zig_x[0] is the base strip width V / f(R)
+static double noise_zig_ratio[NOISE_ZIG_LAYERS]; // noise_zig_x[i + 1] / noise_zig_x[i]
+static pthread_once_t noise_zig_once = PTHREAD_ONCE_INIT;
+
+// Define a struct to store a block of pre-generated standard normal samples
+typedef struct noise_buffer{
+    uint64_t state[4]; // xoshiro256++ generator state
+    int next; // index of the next unused sample
+    double normals[NOISE_BLOCK_SIZE]; // block of standard normal samples
+} noise_buffer;
+
+uint64_t noise_splitmix64(uint64_t *seed){
+    /*
+    Advances a splitmix64 sequence, used to expand a single seed into the generator state
+
+    INPUTS:
+    ----------
+        seed: uint64_t *
+            pointer to the splitmix64 state
+    OUTPUTS:
+    ----------
+        value: uint64_t
+            next value of the sequence
+    */
+
+    uint64_t z = (*seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void noise_zig_init(void){
+    /*
+    Builds the ziggurat layer tables
+    */
+
+    double f = exp(-0.5 * NOISE_ZIG_R * NOISE_ZIG_R);
+    noise_zig_x[0] = NOISE_ZIG_V / f;
+    noise_zig_x[1] = NOISE_ZIG_R;
+    noise_zig_x[NOISE_ZIG_LAYERS] = 0;
+    for (int i = 2; i < NOISE_ZIG_LAYERS; i++){
+        noise_zig_x[i] = sqrt(-2 * log(NOISE_ZIG_V / noise_zig_x[i - 1] + f));
+        f = exp(-0.5 * noise_zig_x[i] * noise_zig_x[i]);
+    }
+    for (int i = 0; i < NOISE_ZIG_LAYERS; i++){
+        noise_zig_ratio[i] = noise_zig_x[i + 1] / noise_zig_x[i];
+    }
+}
+
+static inline uint64_t noise_next(uint64_t *s){
+    /*
+    Advances the xoshiro256++ generator, whose low bits are as good as its high bits
+
+    INPUTS:
+    ----------
+        s: uint64_t *
+            pointer to the four-word generator state
+    OUTPUTS:
+    ----------
+        value: uint64_t
+            next 64-bit output
+    */
+
+    uint64_t sum = s[0] + s[3];
+    uint64_t result = ((sum << 23) | (sum >> 41)) + s[0];
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return result;
+}
+
+static inline double noise_uniform_pos(uint64_t *s){
+    /*
+    Draws a uniform double in (0, 1)
+
+    INPUTS:
+    ----------
+        s: uint64_t *
+            pointer to the four-word generator state
+    OUTPUTS:
+    ----------
+        u: double
+            uniform sample
+    */
+
+    return ((double)(noise_next(s) >> 11) + 0.5) * 0x1.0p-53;
+}
+
+__attribute__((noinline)) double noise_zig_slow(uint64_t *s, double u, int layer){
+    /*
+    Handles a ziggurat draw that falls outside the rectangle of its layer, by sampling the tail for the
+    base strip or by rejection against the density for the wedges, and redrawing until a sample is accepted
+
+    INPUTS:
+    ----------
+        s: uint64_t *
+            pointer to the four-word generator state
+        u: double
+            uniform sample in (-1, 1) of the rejected draw
+        layer: int
+            layer index of the rejected draw
+    OUTPUTS:
+    ----------
+        sample: double
+            standard normal sample
+    */
+
+    while (1){
+        if (layer == 0){
+            // Tail beyond R (Marsaglia, 1964)
+            double x, y;
+            do{
+                x = log(noise_uniform_pos(s)) / NOISE_ZIG_R;
+                y = log(noise_uniform_pos(s));
+            } while (-2 * y < x * x);
+            return (u < 0) ? x - NOISE_ZIG_R : NOISE_ZIG_R - x;
+        }
+
+        double x = u * noise_zig_x[layer];
+        double f_0 = exp(-0.5 * (noise_zig_x[layer] * noise_zig_x[layer] - x * x));
+        double f_1 = exp(-0.5 * (noise_zig_x[layer + 1] * noise_zig_x[layer + 1] - x * x));
+        if (f_1 + noise_uniform_pos(s) * (f_0 - f_1) < 1.0){
+            return x;
+        }
+
+        uint64_t bits = noise_next(s);
+        u = 2 * ((double)(bits >> 11) * 0x1.0p-53) - 1;
+        layer = bits & (NOISE_ZIG_LAYERS - 1);
+        if (fabs(u) < noise_zig_ratio[layer]){
+            return u * noise_zig_x[layer];
+        }
+    }
+}
+
+void noise_buffer_seed(noise_buffer *noise, uint64_t seed){
+    /*
+    Seeds the noise buffer generator and discards any buffered samples
+
+    INPUTS:
+    ----------
+        noise: noise_buffer *
+            pointer to the noise buffer
+        seed: uint64_t
+            seed of the generator
+    */
+
+    pthread_once(&noise_zig_once, noise_zig_init);
+    for (int i = 0; i < 4; i++){
+        noise->state[i] = noise_splitmix64(&seed);
+    }
+    noise->next = NOISE_BLOCK_SIZE;
+}
+
+void noise_buffer_init(noise_buffer *noise, gsl_rng *rng){
+    /*
+    Initializes a noise buffer with a seed drawn from a GSL generator, so that runs stay reproducible under
+    GSL_RNG_SEED. Samples are generated lazily on the first draw
+
+    INPUTS:
+    ----------
+        noise: noise_buffer *
+            pointer to the noise buffer
+        rng: gsl_rng *
+            pointer to the random number generator used for the seed
+    */
+
+    // Draw the two halves in separate statements, so that their order does not depend on the compiler
+    uint64_t hi = gsl_rng_get(rng);
+    uint64_t lo = gsl_rng_get(rng);
+    uint64_t seed = (hi << 32) ^ lo;
+    noise_buffer_seed(noise, seed);
+}
+
+void noise_buffer_refill(noise_buffer *noise){
+    /*
+    Generates a new block of standard normal samples with the ziggurat method. Each sample takes one 64-bit
+    draw (7 bits for the layer, 53 bits for the abscissa) and a table comparison; the roughly 1% of draws
+    that need exp or log are handled out of line so the block loop stays branch-light
+
+    INPUTS:
+    ----------
+        noise: noise_buffer *
+            pointer to the noise buffer
+    */
+
+    uint64_t *s = noise->state;
+    for (int i = 0; i < NOISE_BLOCK_SIZE; i++){
+        uint64_t bits = noise_next(s);
+        double u = 2 * ((double)(bits >> 11) * 0x1.0p-53) - 1;
+        int layer = bits & (NOISE_ZIG_LAYERS - 1);
+        if (fabs(u) < noise_zig_ratio[layer]){
+            noise->normals[i] = u * noise_zig_x[layer];
+        }
+        else{
+            noise->normals[i] = noise_zig_slow(s, u, layer);
+        }
+    }
+
+    noise->next = 0;
+}
+
+static inline double noise_gaussian(noise_buffer *noise, double sigma){
+    /*
+    Draws a Gaussian sample from the noise buffer, refilling the buffer when it is exhausted
+
+    INPUTS:
+    ----------
+        noise: noise_buffer *
+            pointer to the noise buffer
+        sigma: double
+            standard deviation of the sample
+    OUTPUTS:
+    ----------
+        sample: double
+            Gaussian sample with zero mean and standard deviation sigma
+    */
+
+    if (noise->next == NOISE_BLOCK_SIZE){
+        noise_buffer_refill(noise);
+    }
+    return sigma * noise->normals[noise->next++];
+}
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <stdint.h>
+#include <gsl/gsl_rng.h>
+
+// Define the Philox4x32-10 multipliers and key increments (Salmon et al., 2011)
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+#define PHILOX_ROUNDS 10
+
+// Define the stream ids of the independent random sequences of a Monte Carlo run
+#define PHILOX_STREAM_RUN 0 // initial conditions, error models and sensor noise of the run
+#define PHILOX_STREAM_SOBOL_A 1 // first sample matrix of the Sobol sensitivity analysis
+#define PHILOX_STREAM_SOBOL_B 2 // second sample matrix of the Sobol sensitivity analysis
+#define PHILOX_STREAM_BOOTSTRAP 3 // bootstrap resampling of the Sobol sensitivity analysis
+#define PHILOX_STREAM_MLMC 4 // samples of level l of the multilevel Monte Carlo are on stream PHILOX_STREAM_MLMC + l (l < 8)
+#define PHILOX_STREAM_FORK 12 // late-acting errors of the forks of a forked Monte Carlo campaign
+#define PHILOX_STREAM_REPLAY 13 // atmosphere of the reentry replayed from a post-burnout ensemble with another perturbation flag
+#define PHILOX_STREAM_IMPORTANCE 14 // static error deviates, sensor noise and Coriolis orientation of an importance-sampled campaign
+#define PHILOX_STREAM_SURROGATE 15 // design and validation runs of the response surface
+#define PHILOX_STREAM_SURROGATE_EVAL 16 // samples of the response surface
+
+// Define a struct to store the state of a Philox4x32-10 generator
+typedef struct philox_state{
+    uint32_t key[2]; // 64-bit key (seed)
+    uint32_t counter[4]; // 128-bit counter: block position (words 0-1), run index (word 2), stream id (word 3)
+    uint32_t output[4]; // output of the current block
+    int index; // index of the next unused output word
+} philox_state;
+
+void philox4x32(const uint32_t *counter, const uint32_t *key, uint32_t *output){
+    /*
+    Evaluates the Philox4x32-10 bijection of a counter under a key
+
+    INPUTS:
+    ----------
+        counter: const uint32_t *
+            four-word counter
+        key: const uint32_t *
+            two-word key
+        output: uint32_t *
+            four-word random output
+    */
+
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (int round = 0; round < PHILOX_ROUNDS; round++){
+        uint64_t product_0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t product_1 = (uint64_t)PHILOX_M1 * c2;
+        uint32_t n0 = (uint32_t)(product_1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(product_0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)product_1;
+        c3 = (uint32_t)product_0;
+        c0 = n0;
+        c2 = n2;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    output[0] = c0;
+    output[1] = c1;
+    output[2] = c2;
+    output[3] = c3;
+}
+
+static void philox_set(void *vstate, unsigned long seed){
+    /*
+    Seeds the generator, keeping run 0 and stream 0 (gsl_rng_type interface)
+
+    INPUTS:
+    ----------
+        vstate: void *
+            pointer to the generator state
+        seed: unsigned long
+            seed of the generator
+    */
+
+    philox_state *state = (philox_state *)vstate;
+    state->key[0] = (uint32_t)seed;
+    state->key[1] = (uint32_t)((uint64_t)seed >> 32);
+    for (int i = 0; i < 4; i++){
+        state->counter[i] = 0;
+    }
+    state->index = 4;
+}
+
+static unsigned long philox_get(void *vstate){
+    /*
+    Returns the next 32-bit output, evaluating a new block every four outputs (gsl_rng_type interface)
+
+    INPUTS:
+    ----------
+        vstate: void *
+            pointer to the generator state
+    OUTPUTS:
+    ----------
+        value: unsigned long
+            random integer in [0, 2^32 - 1]
+    */
+
+    philox_state *state = (philox_state *)vstate;
+    if (state->index == 4){
+        philox4x32(state->counter, state->key, state->output);
+        state->index = 0;
+        // Advance the 64-bit block position, leaving the run and stream words untouched
+        if (++state->counter[0] == 0){
+            state->counter[1]++;
+        }
+    }
+    return state->output[state->index++];
+}
+
+static double philox_get_double(void *vstate){
+    /*
+    Returns the next output as a uniform double in [0, 1) (gsl_rng_type interface)
+
+    INPUTS:
+    ----------
+        vstate: void *
+            pointer to the generator state
+    OUTPUTS:
+    ----------
+        value: double
+            uniform random number
+    */
+
+    return philox_get(vstate) / 4294967296.0;
+}
+
+static const gsl_rng_type philox4x32_type = {
+    "philox4x32", // name
+    0xffffffffUL, // max
+    0, // min
+    sizeof(philox_state),
+    &philox_set,
+    &philox_get,
+    &philox_get_double
+};
+
+// Define the Philox generator type for use with gsl_rng_alloc
+const gsl_rng_type *gsl_rng_philox4x32 = &philox4x32_type;
+
+void philox_set_stream(gsl_rng *rng, uint64_t seed, uint32_t run, uint32_t stream){
+    /*
+    Positions a Philox generator at the start of the sequence keyed by (seed, run, stream). Every run and
+    stream has its own sequence of 2^64 blocks, so any run can be re-simulated in isolation
+
+    INPUTS:
+    ----------
+        rng: gsl_rng *
+            pointer to a generator allocated with gsl_rng_philox4x32
+        seed: uint64_t
+            seed of the Monte Carlo simulation
+        run: uint32_t
+            index of the Monte Carlo run
+        stream: uint32_t
+            id of the random sequence within the run
+    */
+
+    philox_set(rng->state, seed);
+    philox_state *state = (philox_state *)rng->state;
+    state->counter[2] = run;
+    state->counter[3] = stream;
+}
+
+gsl_rng *philox_alloc(uint64_t seed, uint32_t run, uint32_t stream){
+    /*
+    Allocates a Philox generator positioned at the start of the sequence keyed by (seed, run, stream)
+
+    INPUTS:
+    ----------
+        seed: uint64_t
+            seed of the Monte Carlo simulation
+        run: uint32_t
+            index of the Monte Carlo run
+        stream: uint32_t
+            id of the random sequence within the run
+    OUTPUTS:
+    ----------
+        rng: gsl_rng *
+            pointer to the generator, to be released with gsl_rng_free
+    */
+
+    gsl_rng *rng = gsl_rng_alloc(gsl_rng_philox4x32);
+    philox_set_stream(rng, seed, run, stream);
+    return rng;
+}
+
+#endif
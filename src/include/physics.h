@@ -129,6 +129,37 @@ void update_drag(vehicle *vehicle, atm_cond *atm_cond, state *state){
     return;
 }
 
+int get_stage(vehicle *vehicle, double t){
+    /*
+    Gets the index of the booster stage that is burning at a given time
+
+    INPUTS:
+    ----------
+        vehicle: vehicle *
+            pointer to the vehicle struct
+        t: double
+            time since launch in seconds
+    OUTPUTS:
+    ----------
+        stage: int
+            index of the burning stage, or the number of stages after burnout
+    */
+
+    if (t > vehicle->booster.total_burn_time){
+        return vehicle->booster.num_stages;
+    }
+
+    int stage = 0;
+    if (t > vehicle->booster.burn_time[0]){
+        stage = 1;
+    }
+    if (t > vehicle->booster.burn_time[0] + vehicle->booster.burn_time[1]){
+        stage = 2;
+    }
+
+    return stage;
+}
+
 void update_thrust(vehicle *vehicle, state *state){
     /*
     Updates the thrust acceleration components
@@ -150,13 +181,7 @@ void update_thrust(vehicle *vehicle, state *state){
     }
     
     // Get the current stage
-    int stage = 0;
-    if (state->t > vehicle->booster.burn_time[0]){
-        stage = 1;
-    }
-    if (state->t > vehicle->booster.burn_time[0] + vehicle->booster.burn_time[1]){
-        stage = 2;
-    }
+    int stage = get_stage(vehicle, state->t);
 
     // Calculate the thrust acceleration components
     a_thrust_mag = vehicle->booster.isp0[stage] * vehicle->booster.fuel_burn_rate[stage] / vehicle->current_mass;
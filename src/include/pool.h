@@ -0,0 +1,670 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// Define whether threads can be pinned to processors (Linux with _GNU_SOURCE, see scripts/compile.sh)
+#if defined(__linux__) && defined(CPU_SETSIZE)
+#define POOL_AFFINITY 1
+#else
+#define POOL_AFFINITY 0
+#endif
+
+// Define the maximum number of NUMA nodes read from /sys/devices/system/node
+#define POOL_MAX_NODES 64
+
+// Define the fraction of its remaining range that a thread claims at once (1 / POOL_CHUNK_DIVISOR)
+#define POOL_CHUNK_DIVISOR 4
+
+// Define the signature of a parallel loop body, called once for each index of the loop
+typedef void (*pool_task)(void *context, int index);
+
+// Define a struct to store the range of iterations held by one thread of a loop
+typedef struct pool_range{
+    pthread_mutex_t lock; // protects the range
+    int begin; // next iteration, claimed by the owning thread from the front
+    int end; // end of the range, stolen by the other threads from the back
+} pool_range;
+
+// Define a struct to store the work done by one thread during the last loop of a pool
+typedef struct pool_worker_stats{
+    int tasks; // number of iterations run
+    int chunks; // number of chunks claimed
+    int steals; // number of ranges stolen from other threads
+    double busy_time; // time spent in the body of the loop in seconds
+    int cpu; // processor the thread is pinned to (-1 if not pinned)
+    int node; // NUMA node of that processor (-1 if not pinned)
+} pool_worker_stats;
+
+// Define a struct to store a pool of worker threads that share the iterations of parallel loops
+typedef struct worker_pool{
+    int num_threads; // number of threads running a loop, including the calling thread
+    pthread_t *threads; // worker threads (num_threads - 1)
+    pthread_mutex_t lock; // protects the loop description and the counters below
+    pthread_cond_t work_ready; // signals a new loop (or shutdown) to the workers
+    pthread_cond_t work_done; // signals the end of a loop to the calling thread
+
+    pool_task task; // body of the current loop
+    void *context; // context passed to the body
+    int num_tasks; // number of iterations of the current loop
+    pool_range *ranges; // range of iterations held by each thread (index 0: calling thread)
+    pool_worker_stats *stats; // work done by each thread during the last loop
+    double loop_time; // wall-clock time of the last loop in seconds
+    atomic_int next_worker; // index given to the next worker thread that starts
+    int generation; // number of loops started, so each worker joins each loop once
+    int active_workers; // workers that have not finished the current loop
+    int shutdown; // 1 once the pool is being freed
+
+    int pin_threads; // 1 if each thread is pinned to one processor
+    int *cpus; // processor of each thread (-1 if not pinned)
+    int num_cpus; // number of configured processors
+    int *cpu_nodes; // NUMA node of each configured processor
+    int num_nodes; // number of NUMA nodes
+#if POOL_AFFINITY
+    cpu_set_t caller_affinity; // affinity of the calling thread before it was pinned
+#endif
+} worker_pool;
+
+int pool_default_threads(void){
+    /*
+    Gets the default number of threads, one per online processor
+
+    OUTPUTS:
+    ----------
+        num_threads: int
+            number of threads
+    */
+
+    long num_procs = sysconf(_SC_NPROCESSORS_ONLN);
+    return (num_procs > 0) ? (int)num_procs : 1;
+}
+
+void pool_parse_cpulist(const char *list, int *cpu_nodes, int num_cpus, int node){
+    /*
+    Assigns the processors of a Linux CPU list (such as "0-3,8-11") to a NUMA node
+
+    INPUTS:
+    ----------
+        list: const char *
+            CPU list of the node
+        cpu_nodes: int *
+            NUMA node of each processor, updated for the processors of the list
+        num_cpus: int
+            number of entries of cpu_nodes
+        node: int
+            index of the node
+    */
+
+    const char *c = list;
+    while (*c != '\0'){
+        char *next;
+        long first = strtol(c, &next, 10);
+        if (next == c){
+            break;
+        }
+        long last = first;
+        c = next;
+        if (*c == '-'){
+            last = strtol(c + 1, &next, 10);
+            c = next;
+        }
+        for (long cpu = first; cpu <= last; cpu++){
+            if (cpu >= 0 && cpu < num_cpus){
+                cpu_nodes[cpu] = node;
+            }
+        }
+        if (*c == ','){
+            c++;
+        }
+        else{
+            break;
+        }
+    }
+}
+
+int pool_read_nodes(int *cpu_nodes, int num_cpus){
+    /*
+    Reads the NUMA node of each processor from /sys/devices/system/node. Processors default to node 0, so a
+    machine without NUMA information has a single node
+
+    INPUTS:
+    ----------
+        cpu_nodes: int *
+            array of num_cpus entries to be filled with the NUMA node of each processor
+        num_cpus: int
+            number of processors
+    OUTPUTS:
+    ----------
+        num_nodes: int
+            number of NUMA nodes (1 + the highest node index found)
+    */
+
+    for (int cpu = 0; cpu < num_cpus; cpu++){
+        cpu_nodes[cpu] = 0;
+    }
+
+    int num_nodes = 1;
+    for (int node = 0; node < POOL_MAX_NODES; node++){
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *file = fopen(path, "r");
+        if (file == NULL){
+            continue;
+        }
+        char list[4096];
+        if (fgets(list, sizeof(list), file) != NULL){
+            pool_parse_cpulist(list, cpu_nodes, num_cpus, node);
+            num_nodes = node + 1;
+        }
+        fclose(file);
+    }
+
+    return num_nodes;
+}
+
+int pool_current_node(worker_pool *pool){
+    /*
+    Gets the NUMA node of the processor running the calling thread
+
+    INPUTS:
+    ----------
+        pool: worker_pool *
+            pointer to the worker pool
+    OUTPUTS:
+    ----------
+        node: int
+            index of the NUMA node (0 if unknown)
+    */
+
+#if POOL_AFFINITY
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && cpu < pool->num_cpus){
+        return pool->cpu_nodes[cpu];
+    }
+#endif
+    return 0;
+}
+
+void pool_assign_cpus(worker_pool *pool){
+    /*
+    Assigns a processor to each thread of a pinned pool. The processors allowed to the process are taken in turn
+    from each NUMA node, so that the threads spread over the nodes and their memory bandwidth, and threads beyond
+    the number of processors wrap around
+
+    INPUTS:
+    ----------
+        pool: worker_pool *
+            pointer to the worker pool, whose cpus are filled
+    */
+
+    for (int i = 0; i < pool->num_threads; i++){
+        pool->cpus[i] = -1;
+    }
+
+#if POOL_AFFINITY
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+        return;
+    }
+
+    // Order the allowed processors by their rank within their node, then by node
+    int *order = malloc(pool->num_cpus * sizeof(int));
+    int *rank = calloc(pool->num_nodes, sizeof(int));
+    int *cpu_rank = malloc(pool->num_cpus * sizeof(int));
+    int num_allowed = 0;
+    for (int cpu = 0; cpu < pool->num_cpus && cpu < CPU_SETSIZE; cpu++){
+        if (CPU_ISSET(cpu, &allowed)){
+            cpu_rank[cpu] = rank[pool->cpu_nodes[cpu]]++;
+            order[num_allowed++] = cpu;
+        }
+    }
+    for (int i = 1; i < num_allowed; i++){
+        int cpu = order[i];
+        int j = i;
+        while (j > 0 && (cpu_rank[order[j - 1]] > cpu_rank[cpu] || (cpu_rank[order[j - 1]] == cpu_rank[cpu] && pool->cpu_nodes[order[j - 1]] > pool->cpu_nodes[cpu]))){
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = cpu;
+    }
+
+    for (int i = 0; i < pool->num_threads && num_allowed > 0; i++){
+        pool->cpus[i] = order[i % num_allowed];
+    }
+
+    free(order);
+    free(rank);
+    free(cpu_rank);
+#endif
+}
+
+void pool_pin(worker_pool *pool, int worker){
+    /*
+    Pins the calling thread to the processor assigned to a thread of the pool. Memory that the thread touches
+    first is then placed on the NUMA node of that processor, and stays local since the thread no longer migrates
+
+    INPUTS:
+    ----------
+        pool: worker_pool *
+            pointer to the worker pool
+        worker: int
+            index of the thread
+    */
+
+#if POOL_AFFINITY
+    if (pool->cpus[worker] >= 0){
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(pool->cpus[worker], &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+#endif
+}
+
+double pool_clock(void){
+    /*
+    Gets the time of a monotonic clock
+
+    OUTPUTS:
+    ----------
+        time: double
+            time in seconds
+    */
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + 1e-9 * now.tv_nsec;
+}
+
+int pool_steal(worker_pool *pool, int worker){
+    /*
+    Moves the back half of the largest range left in the current loop to the empty range of a thread
+
+    INPUTS:
+    ----------
+        pool: worker_pool *
+            pointer to the worker pool
+        worker: int
+            index of the stealing thread
+    OUTPUTS:
+    ----------
+        stolen: int
+            1 if a range was stolen, 0 if no iteration is left unclaimed
+    */
+
+    while (1){
+        // Find the thread with the most iterations left
+        int victim = -1;
+        int most = 0;
+        for (int k = 1; k < pool->num_threads; k++){
+            int other = (worker + k) % pool->num_threads;
+            pthread_mutex_lock(&pool->ranges[other].lock);
+            int remaining = pool->ranges[other].end - pool->ranges[other].begin;
+            pthread_mutex_unlock(&pool->ranges[other].lock);
+            if (remaining > most){
+                most = remaining;
+                victim = other;
+            }
+        }
+        if (victim < 0){
+            return 0;
+        }
+
+        // Take the back half of its range, unless its owner has claimed the rest in the meantime
+        pool_range *range = &pool->ranges[victim];
+        pthread_mutex_lock(&range->lock);
+        int take = (range->end - range->begin + 1) / 2;
+        int end = range->end;
+        range->end -= take;
+        pthread_mutex_unlock(&range->lock);
+
+        if (take > 0){
+            pool_range *own = &pool->ranges[worker];
+            pthread_mutex_lock(&own->lock);
+            own->begin = end - take;
+            own->end = end;
+            pthread_mutex_unlock(&own->lock);
+            return 1;
+        }
+    }
+}
+
+void pool_drain(worker_pool *pool, int worker, pool_task task, void *context){
+    /*
+    Runs iterations of the current loop on one thread until none is left unclaimed. The thread claims chunks of
+    a fixed fraction of its own range from the front, so chunks shrink as the range empties, and once its range
+    is empty it steals from the thread with the most iterations left
+
+    INPUTS:
+    ----------
+        pool: worker_pool *
+            pointer to the worker pool
+        worker: int
+            index of the thread
+        task: pool_task
+            body of the loop
+        context: void *
+            context passed to the body
+    */
+
+    pool_range *own = &pool->ranges[worker];
+    pool_worker_stats *stats = &pool->stats[worker];
+    while (1){
+        pthread_mutex_lock(&own->lock);
+        int begin = own->begin;
+        int chunk = (own->end - own->begin) / POOL_CHUNK_DIVISOR;
+        if (chunk < 1){
+            chunk = (own->end > own->begin) ? 1 : 0;
+        }
+        own->begin += chunk;
+        pthread_mutex_unlock(&own->lock);
+
+        if (chunk == 0){
+            if (!pool_steal(pool, worker)){
+                break;
+            }
+            stats->steals++;
+            continue;
+        }
+
+        double start = pool_clock();
+        for (int index = begin; index < begin + chunk; index++){
+            task(context, index);
+        }
+        stats->busy_time += pool_clock() - start;
+        stats->tasks += chunk;
+        stats->chunks++;
+    }
+}
+
+void *pool_worker(void *arg){
+    /*
+    Runs on each worker thread: waits for a loop, claims its iterations, and reports when it is done
+
+    INPUTS:
+    ----------
+        arg: void *
+            pointer to the worker pool
+    */
+
+    worker_pool *pool = (worker_pool *)arg;
+    int worker = 1 + atomic_fetch_add(&pool->next_worker, 1);
+    int generation = 0;
+    if (pool->pin_threads){
+        pool_pin(pool, worker);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    while (1){
+        while (!pool->shutdown && pool->generation == generation){
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutdown){
+            break;
+        }
+        generation = pool->generation;
+        pool_task task = pool->task;
+        void *context = pool->context;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool_drain(pool, worker, task, context);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active_workers == 0){
+            pthread_cond_signal(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+void pool_init_pinned(worker_pool *pool, int num_threads, int pin_threads){
+    /*
+    Initializes a worker pool and starts its threads, optionally pinning each thread (the calling thread
+    included, until pool_free) to its own processor, spread over the NUMA nodes (see pool_assign_cpus)
+
+    INPUTS:
+    ----------
+        pool: worker_pool *
+            pointer to the worker pool
+        num_threads: int
+            number of threads running each loop, including the calling thread (0: one per online processor)
+        pin_threads: int
+            1 to pin the threads to processors, 0 to let the scheduler place them
+    */
+
+    if (num_threads <= 0){
+        num_threads = pool_default_threads();
+    }
+
+    pool->num_threads = num_threads;
+    pool->task = NULL;
+    pool->context = NULL;
+    pool->num_tasks = 0;
+    pool->loop_time = 0;
+    atomic_init(&pool->next_worker, 0);
+    pool->generation = 0;
+    pool->active_workers = 0;
+    pool->shutdown = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    pool->ranges = malloc(num_threads * sizeof(pool_range));
+    pool->stats = calloc(num_threads, sizeof(pool_worker_stats));
+    for (int i = 0; i < num_threads; i++){
+        pthread_mutex_init(&pool->ranges[i].lock, NULL);
+        pool->ranges[i].begin = 0;
+        pool->ranges[i].end = 0;
+    }
+
+    long num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+    pool->num_cpus = (num_cpus > 0) ? (int)num_cpus : 1;
+    pool->cpu_nodes = malloc(pool->num_cpus * sizeof(int));
+    pool->num_nodes = pool_read_nodes(pool->cpu_nodes, pool->num_cpus);
+    pool->cpus = malloc(num_threads * sizeof(int));
+    pool->pin_threads = (pin_threads && POOL_AFFINITY);
+    if (pool->pin_threads){
+        pool_assign_cpus(pool);
+#if POOL_AFFINITY
+        sched_getaffinity(0, sizeof(pool->caller_affinity), &pool->caller_affinity);
+#endif
+        pool_pin(pool, 0);
+    }
+    else{
+        for (int i = 0; i < num_threads; i++){
+            pool->cpus[i] = -1;
+        }
+    }
+
+    pool->threads = malloc((num_threads > 1 ? num_threads - 1 : 1) * sizeof(pthread_t));
+    for (int i = 0; i < num_threads - 1; i++){
+        pthread_create(&pool->threads[i], NULL, pool_worker, pool);
+    }
+}
+
+void pool_init(worker_pool *pool, int num_threads){
+    /*
+    Initializes a worker pool and starts its threads, which are not pinned to processors
+
+    INPUTS:
+    ----------
+        pool: worker_pool *
+            pointer to the worker pool
+        num_threads: int
+            number of threads running each loop, including the calling thread (0: one per online processor)
+    */
+
+    pool_init_pinned(pool, num_threads, 0);
+}
+
+void pool_run(worker_pool *pool, pool_task task, void *context, int num_tasks){
+    /*
+    Runs a parallel loop on the pool, calling task(context, i) once for each i in [0, num_tasks). The calling
+    thread takes part in the loop, and the function returns once every iteration has completed. Each thread
+    starts with an equal contiguous range of iterations and steals from the others once its own is done, so
+    uneven iterations balance across the threads (see pool_drain). The work of each thread is kept in pool->stats
+
+    INPUTS:
+    ----------
+        pool: worker_pool *
+            pointer to the worker pool
+        task: pool_task
+            body of the loop
+        context: void *
+            context passed to the body
+        num_tasks: int
+            number of iterations
+    */
+
+    double start = pool_clock();
+    for (int i = 0; i < pool->num_threads; i++){
+        pool_worker_stats empty = {0};
+        empty.cpu = pool->cpus[i];
+        empty.node = (pool->cpus[i] >= 0 && pool->cpus[i] < pool->num_cpus) ? pool->cpu_nodes[pool->cpus[i]] : -1;
+        pool->stats[i] = empty;
+    }
+
+    if (pool->num_threads == 1 || num_tasks <= 1){
+        for (int i = 0; i < num_tasks; i++){
+            task(context, i);
+        }
+        pool->loop_time = pool_clock() - start;
+        pool->stats[0].tasks = num_tasks;
+        pool->stats[0].chunks = (num_tasks > 0) ? 1 : 0;
+        pool->stats[0].busy_time = pool->loop_time;
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->num_tasks = num_tasks;
+    for (int i = 0; i < pool->num_threads; i++){
+        pool->ranges[i].begin = (int)((long)num_tasks * i / pool->num_threads);
+        pool->ranges[i].end = (int)((long)num_tasks * (i + 1) / pool->num_threads);
+    }
+    pool->active_workers = pool->num_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_drain(pool, 0, task, context);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active_workers > 0){
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pool->loop_time = pool_clock() - start;
+}
+
+void pool_free(worker_pool *pool){
+    /*
+    Stops the threads of a worker pool and releases its resources
+
+    INPUTS:
+    ----------
+        pool: worker_pool *
+            pointer to the worker pool
+    */
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->num_threads - 1; i++){
+        pthread_join(pool->threads[i], NULL);
+    }
+    free(pool->threads);
+
+    for (int i = 0; i < pool->num_threads; i++){
+        pthread_mutex_destroy(&pool->ranges[i].lock);
+    }
+    free(pool->ranges);
+    free(pool->stats);
+    free(pool->cpus);
+    free(pool->cpu_nodes);
+
+    // Give the calling thread back its processors
+#if POOL_AFFINITY
+    if (pool->pin_threads){
+        sched_setaffinity(0, sizeof(pool->caller_affinity), &pool->caller_affinity);
+    }
+#endif
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->work_done);
+}
+
+void print_pool_stats(worker_pool *pool){
+    /*
+    Prints the work done by each thread during the last loop of a worker pool, with its utilization (busy time
+    over the wall-clock time of the loop)
+
+    INPUTS:
+    ----------
+        pool: worker_pool *
+            pointer to the worker pool
+    */
+
+    int num_tasks = 0;
+    double busy_time = 0;
+    for (int i = 0; i < pool->num_threads; i++){
+        num_tasks += pool->stats[i].tasks;
+        busy_time += pool->stats[i].busy_time;
+    }
+    double utilization = (pool->loop_time > 0) ? busy_time / (pool->loop_time * pool->num_threads) : 0;
+    printf("Loop of %d iterations on %d threads: %f s, utilization: %.1f%%\n", num_tasks, pool->num_threads, pool->loop_time, 100 * utilization);
+    for (int i = 0; i < pool->num_threads; i++){
+        pool_worker_stats *stats = &pool->stats[i];
+        double worker_utilization = (pool->loop_time > 0) ? stats->busy_time / pool->loop_time : 0;
+        if (stats->cpu >= 0){
+            printf("  Thread %d (processor %d, node %d): %d iterations in %d chunks, %d steals, utilization: %.1f%%\n", i, stats->cpu, stats->node, stats->tasks, stats->chunks, stats->steals, 100 * worker_utilization);
+        }
+        else{
+            printf("  Thread %d: %d iterations in %d chunks, %d steals, utilization: %.1f%%\n", i, stats->tasks, stats->chunks, stats->steals, 100 * worker_utilization);
+        }
+    }
+}
+
+void parallel_for(int num_threads, pool_task task, void *context, int num_tasks){
+    /*
+    Runs a single parallel loop on a temporary worker pool
+
+    INPUTS:
+    ----------
+        num_threads: int
+            number of threads (0: one per online processor)
+        task: pool_task
+            body of the loop
+        context: void *
+            context passed to the body
+        num_tasks: int
+            number of iterations
+    */
+
+    // Do not start more threads than iterations
+    if (num_threads <= 0){
+        num_threads = pool_default_threads();
+    }
+    if (num_threads > num_tasks){
+        num_threads = (num_tasks > 0) ? num_tasks : 1;
+    }
+
+    worker_pool pool;
+    pool_init(&pool, num_threads);
+    pool_run(&pool, task, context, num_tasks);
+    pool_free(&pool);
+}
+
+#endif
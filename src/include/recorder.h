@@ -0,0 +1,490 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "utils.h"
+#include "writer.h"
+#include "hermite.h"
+
+// Define the flight events that are always recorded, regardless of the sampling policy
+#define TRAJ_EVENT_NONE 0
+#define TRAJ_EVENT_LAUNCH 1 // initial state
+#define TRAJ_EVENT_STAGING 2 // first step after a stage separation
+#define TRAJ_EVENT_BURNOUT 4 // first step after the final stage burns out
+#define TRAJ_EVENT_REENTRY 8 // first step of the reentry time step
+#define TRAJ_EVENT_IMPACT 16 // final (impact) state
+
+// Define a struct to store one entry of the trajectory archive index
+typedef struct archive_entry{
+    int64_t run_id; // index of the run (-1 for the header entry)
+    int64_t offset; // offset of the first row of the run in the data file, in rows (archive stride for the header entry)
+    int64_t num_rows; // number of rows stored for the run (TRAJ_NUM_FIELDS for the header entry)
+} archive_entry;
+
+// Define a struct to store a growable in-memory trajectory buffer
+typedef struct traj_buffer{
+    double *rows; // row-major array of num_rows * TRAJ_NUM_FIELDS values
+    long num_rows; // number of rows stored
+    long capacity; // number of rows allocated
+} traj_buffer;
+
+// Define a struct to store the trajectory recorder for a Monte Carlo campaign
+typedef struct traj_recorder{
+    runparams *run_params; // pointer to the run parameters struct
+    int run_id; // index of the run currently being recorded
+    traj_writer *text_writer; // writer for the text trajectory file (NULL if not written for this run)
+    traj_writer *archive_writer; // writer for the archive data file (NULL if the archive is disabled)
+    FILE *index_file; // archive index file stream
+    int archive_run; // flag indicating that the current run is archived
+    long run_offset; // offset of the current run in the data file, in rows
+    long step_count; // number of integration steps offered to the recorder in the current run
+    double next_time; // time of the next sample when recording at a fixed cadence
+    hermite_compressor *hermite; // Hermite knot compressor (NULL if rows are stored uncompressed)
+    traj_buffer *buffer; // in-memory trajectory buffer (NULL if not used)
+} traj_recorder;
+
+traj_buffer *traj_buffer_alloc(long capacity){
+    /*
+    Allocates an in-memory trajectory buffer
+
+    INPUTS:
+    ----------
+        capacity: long
+            number of rows to allocate up front
+    OUTPUTS:
+    ----------
+        buffer: traj_buffer *
+            pointer to the trajectory buffer, to be released with traj_buffer_free
+    */
+
+    if (capacity < 1){
+        capacity = 1;
+    }
+
+    traj_buffer *buffer = (traj_buffer *)malloc(sizeof(traj_buffer));
+    buffer->rows = (double *)malloc(capacity * TRAJ_NUM_FIELDS * sizeof(double));
+    buffer->num_rows = 0;
+    buffer->capacity = capacity;
+
+    return buffer;
+}
+
+void traj_buffer_push(traj_buffer *buffer, double *row){
+    /*
+    Appends a row to a trajectory buffer, doubling its capacity when it is full
+
+    INPUTS:
+    ----------
+        buffer: traj_buffer *
+            pointer to the trajectory buffer
+        row: double *
+            array of TRAJ_NUM_FIELDS values for the row
+    */
+
+    if (buffer->num_rows == buffer->capacity){
+        buffer->capacity *= 2;
+        buffer->rows = (double *)realloc(buffer->rows, buffer->capacity * TRAJ_NUM_FIELDS * sizeof(double));
+    }
+
+    memcpy(buffer->rows + buffer->num_rows * TRAJ_NUM_FIELDS, row, TRAJ_NUM_FIELDS * sizeof(double));
+    buffer->num_rows += 1;
+}
+
+void traj_buffer_free(traj_buffer *buffer){
+    /*
+    Releases a trajectory buffer and its rows
+
+    INPUTS:
+    ----------
+        buffer: traj_buffer *
+            pointer to the trajectory buffer
+    */
+
+    if (buffer == NULL){
+        return;
+    }
+    free(buffer->rows);
+    free(buffer);
+}
+
+void archive_file_path(char *path, int length, char *archive_path, char *extension){
+    /*
+    Builds the path to one of the archive files
+
+    INPUTS:
+    ----------
+        path: char *
+            buffer for the resulting path
+        length: int
+            length of the path buffer
+        archive_path: char *
+            path prefix of the trajectory archive
+        extension: char *
+            file extension, including the leading dot
+    */
+
+    snprintf(path, length, "%s%s", archive_path, extension);
+}
+
+void recorder_init(traj_recorder *recorder, runparams *run_params){
+    /*
+    Initializes a trajectory recorder, truncating the trajectory archive if it is enabled
+
+    INPUTS:
+    ----------
+        recorder: traj_recorder *
+            pointer to the trajectory recorder
+        run_params: runparams *
+            pointer to the run parameters struct
+    */
+
+    recorder->run_params = run_params;
+    recorder->run_id = -1;
+    recorder->text_writer = NULL;
+    recorder->archive_writer = NULL;
+    recorder->index_file = NULL;
+    recorder->archive_run = 0;
+    recorder->run_offset = 0;
+    recorder->step_count = 0;
+    recorder->next_time = 0;
+    recorder->hermite = NULL;
+    recorder->buffer = NULL;
+
+    if (run_params->traj_hermite_tol > 0){
+        recorder->hermite = (hermite_compressor *)malloc(sizeof(hermite_compressor));
+        hermite_init(recorder->hermite, run_params->traj_hermite_tol);
+    }
+
+    if (run_params->traj_archive > 0){
+        char path[1024];
+        archive_file_path(path, sizeof(path), run_params->archive_path, ".bin");
+        FILE *data_file = fopen(path, "wb");
+        archive_file_path(path, sizeof(path), run_params->archive_path, ".idx");
+        recorder->index_file = fopen(path, "w+b");
+        if (data_file == NULL || recorder->index_file == NULL){
+            printf("Error: Could not open trajectory archive %s\n", run_params->archive_path);
+            exit(1);
+        }
+
+        // The header entry records the archive stride and the row width
+        archive_entry header = {-1, run_params->traj_archive, TRAJ_NUM_FIELDS};
+        fwrite(&header, sizeof(archive_entry), 1, recorder->index_file);
+
+        recorder->archive_writer = traj_writer_start(data_file, 1);
+    }
+}
+
+int recorder_text_run(runparams *run_params, int run_id){
+    /*
+    Checks whether a run of a Monte Carlo campaign is written to the text trajectory file, which only keeps a single
+    trajectory: the last run of the campaign
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        run_id: int
+            index of the run
+    OUTPUTS:
+    ----------
+        recorded: int
+            1 if the run is written to the text file, 0 otherwise
+    */
+
+    return run_params->traj_output == 1 && run_id == run_params->num_runs - 1;
+}
+
+int recorder_archive_run(runparams *run_params, int run_id){
+    /*
+    Checks whether a run of a Monte Carlo campaign is written to the trajectory archive, which keeps every
+    traj_archive-th run
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        run_id: int
+            index of the run
+    OUTPUTS:
+    ----------
+        recorded: int
+            1 if the run is archived, 0 otherwise
+    */
+
+    return run_params->traj_archive > 0 && run_id % run_params->traj_archive == 0;
+}
+
+int recorder_records_run(runparams *run_params, int run_id){
+    /*
+    Checks whether a run of a Monte Carlo campaign is written to the text trajectory file or the trajectory archive
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        run_id: int
+            index of the run
+    OUTPUTS:
+    ----------
+        recorded: int
+            1 if the run is recorded, 0 otherwise
+    */
+
+    return recorder_text_run(run_params, run_id) || recorder_archive_run(run_params, run_id);
+}
+
+void recorder_begin_run(traj_recorder *recorder, int run_id){
+    /*
+    Prepares the recorder for a new run
+
+    INPUTS:
+    ----------
+        recorder: traj_recorder *
+            pointer to the trajectory recorder
+        run_id: int
+            index of the run
+    */
+
+    recorder->run_id = run_id;
+    recorder->step_count = 0;
+    recorder->next_time = -INFINITY;
+    if (recorder->hermite != NULL){
+        hermite_reset(recorder->hermite);
+        recorder->hermite->tolerance = recorder->run_params->traj_hermite_tol;
+    }
+
+    // Use the same predicates as recorder_records_run, which picks the runs flown with a recorder
+    if (recorder_text_run(recorder->run_params, run_id)){
+        recorder->text_writer = traj_writer_open(recorder->run_params->trajectory_path, TRAJ_HEADER);
+    }
+    recorder->archive_run = recorder_archive_run(recorder->run_params, run_id);
+    if (recorder->archive_run){
+        recorder->run_offset = recorder->archive_writer->num_rows;
+    }
+}
+
+int recorder_sample(traj_recorder *recorder, double t, int events){
+    /*
+    Applies the sampling policy to one step of the current run. Steps with an event are always recorded;
+    otherwise a step is recorded at the fixed cadence if traj_cadence is set, or every traj_decimation steps
+
+    INPUTS:
+    ----------
+        recorder: traj_recorder *
+            pointer to the trajectory recorder
+        t: double
+            time of the step in seconds
+        events: int
+            bitwise OR of the TRAJ_EVENT flags for the step
+    OUTPUTS:
+    ----------
+        record: int
+            flag indicating that the step should be recorded
+    */
+
+    long step = recorder->step_count++;
+
+    // Skip the policy entirely if nothing is being written for this run
+    if (recorder->text_writer == NULL && !recorder->archive_run && recorder->buffer == NULL){
+        return 0;
+    }
+
+    int record = (events != TRAJ_EVENT_NONE);
+    double cadence = recorder->run_params->traj_cadence;
+    if (cadence > 0){
+        // Allow for round-off in the accumulated time so that samples do not slip by a step
+        double tolerance = 1e-6 * cadence;
+        if (t + tolerance >= recorder->next_time){
+            record = 1;
+        }
+        if (record){
+            recorder->next_time = (floor((t + tolerance) / cadence) + 1) * cadence;
+        }
+    }
+    else if (recorder->run_params->traj_decimation <= 1 || step % recorder->run_params->traj_decimation == 0){
+        record = 1;
+    }
+
+    return record;
+}
+
+void recorder_write(traj_recorder *recorder, double *row){
+    /*
+    Writes one row of the current run to the text file, the archive and the in-memory buffer
+
+    INPUTS:
+    ----------
+        recorder: traj_recorder *
+            pointer to the trajectory recorder
+        row: double *
+            array of TRAJ_NUM_FIELDS values for the row
+    */
+
+    if (recorder->text_writer != NULL){
+        traj_writer_push(recorder->text_writer, row);
+    }
+    if (recorder->archive_run){
+        traj_writer_push(recorder->archive_writer, row);
+    }
+    if (recorder->buffer != NULL){
+        traj_buffer_push(recorder->buffer, row);
+    }
+}
+
+void recorder_step(traj_recorder *recorder, double *row, int events){
+    /*
+    Records one step of the current run, keeping only the Hermite knots if compression is enabled
+
+    INPUTS:
+    ----------
+        recorder: traj_recorder *
+            pointer to the trajectory recorder
+        row: double *
+            array of TRAJ_NUM_FIELDS values for the step
+        events: int
+            bitwise OR of the TRAJ_EVENT flags for the step, which are always stored as knots
+    */
+
+    if (recorder->hermite == NULL || recorder->hermite->tolerance <= 0){
+        recorder_write(recorder, row);
+        return;
+    }
+
+    double knot[TRAJ_NUM_FIELDS];
+    hermite_push(recorder->hermite, row);
+    while (hermite_next_knot(recorder->hermite, events != TRAJ_EVENT_NONE, knot)){
+        recorder_write(recorder, knot);
+    }
+}
+
+void recorder_end_run(traj_recorder *recorder){
+    /*
+    Finishes the current run, closing the text file and writing the archive index entry
+
+    INPUTS:
+    ----------
+        recorder: traj_recorder *
+            pointer to the trajectory recorder
+    */
+
+    // Flush the remaining knots so that the last recorded step is always a knot
+    if (recorder->hermite != NULL){
+        double knot[TRAJ_NUM_FIELDS];
+        while (hermite_next_knot(recorder->hermite, 1, knot)){
+            recorder_write(recorder, knot);
+        }
+    }
+
+    if (recorder->text_writer != NULL){
+        traj_writer_close(recorder->text_writer);
+        recorder->text_writer = NULL;
+    }
+
+    if (recorder->archive_run){
+        // Each archived run owns a fixed slot in the index, so a lookup is a single seek
+        archive_entry entry;
+        entry.run_id = recorder->run_id;
+        entry.offset = recorder->run_offset;
+        entry.num_rows = recorder->archive_writer->num_rows - recorder->run_offset;
+
+        long slot = 1 + recorder->run_id / recorder->run_params->traj_archive;
+        fseek(recorder->index_file, slot * sizeof(archive_entry), SEEK_SET);
+        fwrite(&entry, sizeof(archive_entry), 1, recorder->index_file);
+        recorder->archive_run = 0;
+    }
+}
+
+void recorder_free(traj_recorder *recorder){
+    /*
+    Flushes and closes all files held by the recorder
+
+    INPUTS:
+    ----------
+        recorder: traj_recorder *
+            pointer to the trajectory recorder
+    */
+
+    if (recorder->text_writer != NULL){
+        traj_writer_close(recorder->text_writer);
+        recorder->text_writer = NULL;
+    }
+    if (recorder->archive_writer != NULL){
+        traj_writer_close(recorder->archive_writer);
+        recorder->archive_writer = NULL;
+    }
+    if (recorder->index_file != NULL){
+        fclose(recorder->index_file);
+        recorder->index_file = NULL;
+    }
+    if (recorder->hermite != NULL){
+        hermite_free(recorder->hermite);
+        free(recorder->hermite);
+        recorder->hermite = NULL;
+    }
+}
+
+double *load_archived_trajectory(char *archive_path, int run_id, int *num_rows){
+    /*
+    Loads the trajectory of a single run from the trajectory archive
+
+    INPUTS:
+    ----------
+        archive_path: char *
+            path prefix of the trajectory archive
+        run_id: int
+            index of the run to load
+        num_rows: int *
+            pointer to the number of rows loaded
+
+    OUTPUTS:
+    ----------
+        rows: double *
+            array of num_rows * TRAJ_NUM_FIELDS values (to be freed by the caller), or NULL if the run is not archived
+    */
+
+    *num_rows = 0;
+    char path[1024];
+    archive_file_path(path, sizeof(path), archive_path, ".idx");
+    FILE *index_file = fopen(path, "rb");
+    if (index_file == NULL){
+        return NULL;
+    }
+
+    // Read the header to get the archive stride, then seek straight to the run's slot
+    archive_entry header, entry;
+    if (fread(&header, sizeof(archive_entry), 1, index_file) != 1 || header.run_id != -1 || header.num_rows != TRAJ_NUM_FIELDS || run_id % header.offset != 0){
+        fclose(index_file);
+        return NULL;
+    }
+    long slot = 1 + run_id / header.offset;
+    fseek(index_file, slot * sizeof(archive_entry), SEEK_SET);
+    int found = fread(&entry, sizeof(archive_entry), 1, index_file) == 1 && entry.run_id == run_id && entry.num_rows > 0;
+    fclose(index_file);
+    if (!found){
+        return NULL;
+    }
+
+    archive_file_path(path, sizeof(path), archive_path, ".bin");
+    FILE *data_file = fopen(path, "rb");
+    if (data_file == NULL){
+        return NULL;
+    }
+    double *rows = (double *)malloc(entry.num_rows * TRAJ_NUM_FIELDS * sizeof(double));
+    fseek(data_file, entry.offset * TRAJ_NUM_FIELDS * sizeof(double), SEEK_SET);
+    if (fread(rows, sizeof(double) * TRAJ_NUM_FIELDS, entry.num_rows, data_file) != (size_t)entry.num_rows){
+        free(rows);
+        rows = NULL;
+    }
+    else{
+        *num_rows = entry.num_rows;
+    }
+    fclose(data_file);
+
+    return rows;
+}
+
+#endif
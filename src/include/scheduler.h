@@ -0,0 +1,63 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <math.h>
+
+// Define a struct to store a rate group, a set of models evaluated together at a common update period
+typedef struct rate_group{
+    double period; // update period in seconds (0: every integration step)
+    double next_time; // time at which the group is next due
+} rate_group;
+
+void rate_group_init(rate_group *group, double period){
+    /*
+    Initializes a rate group, which is due at the first integration step
+
+    INPUTS:
+    ----------
+        group: rate_group *
+            pointer to the rate group
+        period: double
+            update period in seconds (0: every integration step)
+    */
+
+    group->period = period;
+    group->next_time = -INFINITY;
+}
+
+double rate_group_due(rate_group *group, double t, double time_step){
+    /*
+    Checks whether a rate group is due at the current integration step and, if so, schedules its next
+    evaluation. Between evaluations the outputs of the group's models are held (zero-order hold). Periods
+    are best chosen as multiples of the integration step; a period shorter than the step means every step
+
+    INPUTS:
+    ----------
+        group: rate_group *
+            pointer to the rate group
+        t: double
+            current time in seconds
+        time_step: double
+            current integration time step in seconds
+    OUTPUTS:
+    ----------
+        interval: double
+            time in seconds covered by this evaluation (0 if the group is not due)
+    */
+
+    if (group->period <= 0){
+        return time_step;
+    }
+
+    // Allow for the rounding of the accumulated time
+    if (t < group->next_time - 1e-6 * time_step){
+        return 0;
+    }
+
+    double interval = (group->period > time_step) ? group->period : time_step;
+    group->next_time = t + interval;
+
+    return interval;
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "utils.h"
 #include "trajectory.h"
+#include "noise.h"
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 
@@ -25,6 +26,13 @@ typedef struct imu{
     double gyro_error_lat; // Gyro error in the latitude direction (rad/s, defined recursively)
     double gyro_error_long; // Gyro error in the longitude direction (rad/s, defined recursively)
 
+    // Outputs of the last measurement, held between measurements
+    double meas_theta_long; // Measured longitudinal thrust angle (rad)
+    double meas_theta_lat; // Measured latitudinal thrust angle (rad)
+    double meas_ax; // Measured specific force along x (m/s^2)
+    double meas_ay; // Measured specific force along y (m/s^2)
+    double meas_az; // Measured specific force along z (m/s^2)
+
 } imu;
 
 imu imu_init(runparams *run_params, state *initial_state, gsl_rng *rng){
@@ -61,11 +69,17 @@ imu imu_init(runparams *run_params, state *initial_state, gsl_rng *rng){
     imu.gyro_error_lat = initial_state->initial_theta_lat_pert;
     imu.gyro_error_long = initial_state->initial_theta_long_pert;
 
+    imu.meas_theta_long = 0;
+    imu.meas_theta_lat = 0;
+    imu.meas_ax = 0;
+    imu.meas_ay = 0;
+    imu.meas_az = 0;
+
     return imu;
 
 }
 
-void imu_measurement(imu *imu, state *true_state, state *est_state, vehicle *vehicle, gsl_rng *rng){
+void imu_measurement(imu *imu, state *true_state, state *est_state, vehicle *vehicle){
     /*
     Simulates an accelerometer measurement
 
@@ -79,8 +93,6 @@ void imu_measurement(imu *imu, state *true_state, state *est_state, vehicle *veh
             pointer to the estimated state of the vehicle
         vehicle: vehicle *
             pointer to the vehicle struct
-        rng: gsl_rng *
-            pointer to the random number generator
     */
 
     // Gyroscope measurements
@@ -95,25 +107,58 @@ void imu_measurement(imu *imu, state *true_state, state *est_state, vehicle *veh
     est_state->ay_total = a_measurable_y * (1 + imu->acc_scale_y) - a_measurable_x * imu->gyro_error_long + a_measurable_z * imu->gyro_error_long * imu->gyro_error_lat + est_state->ay_grav;
     est_state->az_total = a_measurable_z * (1 + imu->acc_scale_z) + a_measurable_x * imu->gyro_error_lat + est_state->az_grav;
 
+    // Store the outputs for imu_hold
+    imu->meas_theta_long = est_state->theta_long;
+    imu->meas_theta_lat = est_state->theta_lat;
+    imu->meas_ax = est_state->ax_total - est_state->ax_grav;
+    imu->meas_ay = est_state->ay_total - est_state->ay_grav;
+    imu->meas_az = est_state->az_total - est_state->az_grav;
+
+}
+
+void imu_hold(imu *imu, state *est_state){
+    /*
+    Applies the outputs of the last IMU measurement to the estimated state (zero-order hold between
+    measurements). The measured specific force is held and the current estimated gravity is added back
+
+    INPUTS:
+    ----------
+        imu: imu *
+            pointer to the inertial measurement unit struct
+        est_state: state *
+            pointer to the estimated state of the vehicle
+    */
+
+    est_state->theta_long = imu->meas_theta_long;
+    est_state->theta_lat = imu->meas_theta_lat;
+    est_state->ax_total = imu->meas_ax + est_state->ax_grav;
+    est_state->ay_total = imu->meas_ay + est_state->ay_grav;
+    est_state->az_total = imu->meas_az + est_state->az_grav;
+
 }
 
-void update_imu(imu *imu, double time_step, gsl_rng *rng){
+void update_imu(imu *imu, double interval, double time_step, noise_buffer *noise){
     /*
-    Updates the accelerometer parameters
+    Updates the accelerometer parameters over an update interval of the IMU rate group. The gyro noise of one
+    integration step has a standard deviation of gyro_noise * time_step, so the interval draws the sum of the
+    interval / time_step steps it spans, with a standard deviation of gyro_noise * sqrt(time_step * interval)
 
     INPUTS:
     ----------
         imu: imu *
             pointer to the accelerometer struct
+        interval: double
+            time since the last update in seconds
         time_step: double
             time step for the simulation
-        rng: gsl_rng *
-            pointer to the random number generator
+        noise: noise_buffer *
+            pointer to the Gaussian noise buffer
     */
 
-    // Update the gyro error by recursively adding noise and bias drift
-    imu->gyro_error_long = imu->gyro_error_long + (imu->gyro_noise * gsl_ran_gaussian(rng, 1) + imu->gyro_bias_long) * time_step;
-    imu->gyro_error_lat = imu->gyro_error_lat + (imu->gyro_noise * gsl_ran_gaussian(rng, 1) + imu->gyro_bias_lat) * time_step;
+    // Update the gyro error by recursively adding noise and bias drift (the noise scale is 1 for a single step)
+    double noise_scale = sqrt(time_step / interval);
+    imu->gyro_error_long = imu->gyro_error_long + (imu->gyro_noise * noise_gaussian(noise, 1) * noise_scale + imu->gyro_bias_long) * interval;
+    imu->gyro_error_lat = imu->gyro_error_lat + (imu->gyro_noise * noise_gaussian(noise, 1) * noise_scale + imu->gyro_bias_lat) * interval;
 
 }
 
@@ -144,7 +189,7 @@ gnss gnss_init(runparams *run_params){
     return gnss;
 }
 
-void gnss_measurement(gnss *gnss, state *true_state, state *est_state, gsl_rng *rng){
+void gnss_measurement(gnss *gnss, state *true_state, state *est_state, noise_buffer *noise){
     /*
     Simulates a gnss measurement
 
@@ -156,8 +201,8 @@ void gnss_measurement(gnss *gnss, state *true_state, state *est_state, gsl_rng *
             pointer to the true state of the vehicle
         est_state: state *
             pointer to the estimated state of the vehicle
-        rng: gsl_rng *
-            pointer to the random number generator
+        noise: noise_buffer *
+            pointer to the Gaussian noise buffer
 
     OUTPUTS:
     ----------
@@ -166,9 +211,9 @@ void gnss_measurement(gnss *gnss, state *true_state, state *est_state, gsl_rng *
     */
 
     // Position measurements
-    est_state->x = true_state->x + gnss->noise * gsl_ran_gaussian(rng, 1);
-    est_state->y = true_state->y + gnss->noise * gsl_ran_gaussian(rng, 1);
-    est_state->z = true_state->z + gnss->noise * gsl_ran_gaussian(rng, 1);
+    est_state->x = true_state->x + gnss->noise * noise_gaussian(noise, 1);
+    est_state->y = true_state->y + gnss->noise * noise_gaussian(noise, 1);
+    est_state->z = true_state->z + gnss->noise * noise_gaussian(noise, 1);
 
 }
 
@@ -0,0 +1,396 @@
+#ifndef SOBOL_H
+#define SOBOL_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include "lincov.h"
+#include "pool.h"
+
+// Define the factors of the Sobol sensitivity analysis: the random inputs controlled by each error field of the run
+// parameters, the sensor noise (gyro_noise and gnss_noise share one noise sequence), and the random heading and
+// latitude of the Coriolis correction
+#define SOBOL_FACTOR_INITIAL_X 0
+#define SOBOL_FACTOR_INITIAL_POS 1
+#define SOBOL_FACTOR_INITIAL_VEL 2
+#define SOBOL_FACTOR_INITIAL_ANGLE 3
+#define SOBOL_FACTOR_ACC_SCALE 4
+#define SOBOL_FACTOR_GYRO_BIAS 5
+#define SOBOL_FACTOR_GRAV 6
+#define SOBOL_FACTOR_ATM 7
+#define SOBOL_FACTOR_NOISE 8
+#define SOBOL_FACTOR_CORIOLIS 9
+#define SOBOL_NUM_FACTORS 10
+
+// Define the outputs of the Sobol sensitivity analysis: the east and north components of the impact point and the
+// miss distance, in the local tangent plane at the mean impact point
+#define SOBOL_OUTPUT_EAST 0
+#define SOBOL_OUTPUT_NORTH 1
+#define SOBOL_OUTPUT_MISS 2
+#define SOBOL_NUM_OUTPUTS 3
+
+// Define the number of bootstrap resamples and the level of the confidence intervals of the indices
+#define SOBOL_BOOTSTRAP 500
+#define SOBOL_CONFIDENCE 0.95
+
+// Define a struct to store the Sobol indices of the impact point
+typedef struct sobol_indices{
+    double first_order[SOBOL_NUM_OUTPUTS][SOBOL_NUM_FACTORS]; // first-order indices (Saltelli 2010)
+    double first_order_ci[SOBOL_NUM_OUTPUTS][SOBOL_NUM_FACTORS][2]; // bootstrap confidence intervals of the first-order indices
+    double total[SOBOL_NUM_OUTPUTS][SOBOL_NUM_FACTORS]; // total indices (Jansen 1999)
+    double total_ci[SOBOL_NUM_OUTPUTS][SOBOL_NUM_FACTORS][2]; // bootstrap confidence intervals of the total indices
+    double variance[SOBOL_NUM_OUTPUTS]; // variance of each output
+    int active[SOBOL_NUM_FACTORS]; // 1 if the factor has a nonzero standard deviation, 0 otherwise (indices left at zero)
+    int num_samples; // number of rows of the sample matrices
+    int num_flights; // number of trajectories flown, (number of active factors + 2) * num_samples
+} sobol_indices;
+
+// Define the names of the factors, after the run parameters that control them
+const char *sobol_factor_names[SOBOL_NUM_FACTORS] = {
+    "initial_x_error",
+    "initial_pos_error",
+    "initial_vel_error",
+    "initial_angle_error",
+    "acc_scale_stability",
+    "gyro_bias_stability",
+    "grav_error",
+    "atm_error",
+    "gyro_noise/gnss_noise",
+    "coriolis",
+};
+
+int sobol_factor(int source){
+    /*
+    Gets the factor that a static error source belongs to
+
+    INPUTS:
+    ----------
+        source: int
+            index of the static error source
+    OUTPUTS:
+    ----------
+        factor: int
+            index of the factor
+    */
+
+    if (source == ERROR_INITIAL_X){
+        return SOBOL_FACTOR_INITIAL_X;
+    }
+    if (source <= ERROR_INITIAL_Z){
+        return SOBOL_FACTOR_INITIAL_POS;
+    }
+    if (source <= ERROR_INITIAL_THETA_LONG){
+        return SOBOL_FACTOR_INITIAL_ANGLE;
+    }
+    if (source <= ERROR_INITIAL_VZ){
+        return SOBOL_FACTOR_INITIAL_VEL;
+    }
+    if (source <= ERROR_ACC_SCALE_Z){
+        return SOBOL_FACTOR_ACC_SCALE;
+    }
+    if (source <= ERROR_GYRO_BIAS_LONG){
+        return SOBOL_FACTOR_GYRO_BIAS;
+    }
+    if (source <= ERROR_EST_GEOID_HEIGHT){
+        return SOBOL_FACTOR_GRAV;
+    }
+    return SOBOL_FACTOR_ATM;
+}
+
+error_sample sobol_cross_sample(const error_sample *a, const error_sample *b, int factor){
+    /*
+    Builds a row of a cross sample matrix: the row of A with the inputs of one factor taken from the row of B
+
+    INPUTS:
+    ----------
+        a: const error_sample *
+            pointer to the row of the first sample matrix
+        b: const error_sample *
+            pointer to the row of the second sample matrix
+        factor: int
+            index of the factor taken from B
+    OUTPUTS:
+    ----------
+        sample: error_sample
+            row of the cross sample matrix
+    */
+
+    error_sample sample = *a;
+    if (factor == SOBOL_FACTOR_NOISE){
+        sample.noise_seed = b->noise_seed;
+    }
+    else if (factor == SOBOL_FACTOR_CORIOLIS){
+        sample.lat = b->lat;
+        sample.lon = b->lon;
+    }
+    else{
+        for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+            if (sobol_factor(source) == factor){
+                sample.deviates[source] = b->deviates[source];
+            }
+        }
+    }
+
+    return sample;
+}
+
+// Define a struct to store the inputs and outputs of the trajectories of a Sobol sensitivity analysis
+typedef struct sobol_batch{
+    runparams *run_params; // pointer to the run parameters struct
+    const error_sample *a; // rows of the first sample matrix
+    const error_sample *b; // rows of the second sample matrix
+    const int *factors; // active factors, one cross sample matrix each
+    int num_samples; // number of rows of each matrix
+    double *impacts; // impact point of each trajectory (3 per trajectory)
+} sobol_batch;
+
+void sobol_task(void *context, int index){
+    /*
+    Flies one trajectory of a Sobol sensitivity analysis (pool_task interface). Trajectories are ordered by matrix,
+    A, then B, then the cross matrix of each active factor
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the sobol_batch struct
+        index: int
+            index of the trajectory
+    */
+
+    sobol_batch *batch = (sobol_batch *)context;
+    int matrix = index / batch->num_samples;
+    int row = index % batch->num_samples;
+
+    error_sample sample;
+    if (matrix == 0){
+        sample = batch->a[row];
+    }
+    else if (matrix == 1){
+        sample = batch->b[row];
+    }
+    else{
+        sample = sobol_cross_sample(&batch->a[row], &batch->b[row], batch->factors[matrix - 2]);
+    }
+
+    double time_error;
+    state impact_state = fly_deviates_noise(batch->run_params, sample.deviates, &sample.noise_seed, &time_error, NULL);
+    apply_coriolis(&impact_state, time_error, sample.lat, sample.lon);
+
+    batch->impacts[3*index] = impact_state.x;
+    batch->impacts[3*index + 1] = impact_state.y;
+    batch->impacts[3*index + 2] = impact_state.z;
+}
+
+void sobol_estimate(const double *f_a, const double *f_b, const double *f_ab, const int *rows, int num_samples, double *first_order, double *total, double *variance){
+    /*
+    Estimates the first-order (Saltelli 2010) and total (Jansen 1999) indices of one factor from the outputs of the
+    A, B and cross sample matrices, over a given selection of rows. The outputs of B are centered in the first-order
+    estimator, which leaves it unbiased and reduces its variance for outputs with a large mean (the miss distance)
+
+    INPUTS:
+    ----------
+        f_a: const double *
+            outputs of the rows of A
+        f_b: const double *
+            outputs of the rows of B
+        f_ab: const double *
+            outputs of the rows of the cross matrix of the factor
+        rows: const int *
+            array of num_samples row indices (with repetitions for a bootstrap resample)
+        num_samples: int
+            number of rows
+        first_order: double *
+            set to the first-order index
+        total: double *
+            set to the total index
+        variance: double *
+            set to the output variance over the rows of A and B
+    */
+
+    // Output variance over both independent matrices
+    double mean = 0;
+    for (int k = 0; k < num_samples; k++){
+        mean += f_a[rows[k]] + f_b[rows[k]];
+    }
+    mean /= 2 * num_samples;
+    double var = 0;
+    for (int k = 0; k < num_samples; k++){
+        var += (f_a[rows[k]] - mean) * (f_a[rows[k]] - mean) + (f_b[rows[k]] - mean) * (f_b[rows[k]] - mean);
+    }
+    var /= 2 * num_samples - 1;
+
+    double first_sum = 0;
+    double total_sum = 0;
+    for (int k = 0; k < num_samples; k++){
+        int j = rows[k];
+        first_sum += (f_b[j] - mean) * (f_ab[j] - f_a[j]);
+        total_sum += (f_a[j] - f_ab[j]) * (f_a[j] - f_ab[j]);
+    }
+
+    *variance = var;
+    *first_order = (var > 0) ? first_sum / num_samples / var : 0;
+    *total = (var > 0) ? 0.5 * total_sum / num_samples / var : 0;
+}
+
+sobol_indices sobol_run(runparams run_params, int num_samples){
+    /*
+    Estimates the first-order and total Sobol indices of the impact point for each error field of the run
+    parameters. Two independent sample matrices A and B of num_samples rows are drawn, and for each active factor a
+    cross matrix takes that factor's inputs from B and all others from A. All indices reuse the same A and B
+    trajectories, so the analysis flies (n + 2) num_samples trajectories for n active factors, in parallel on
+    run_params.num_threads threads. Confidence intervals are bootstrap percentiles over the rows
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+        num_samples: int
+            number of rows of the sample matrices
+    OUTPUTS:
+    ----------
+        indices: sobol_indices
+            Sobol indices of the east and north impact components and of the miss distance
+    */
+
+    run_params.traj_output = 0;
+    run_params.traj_archive = 0;
+
+    gsl_rng_env_setup();
+    uint64_t seed = gsl_rng_default_seed;
+
+    sobol_indices indices = {0};
+    indices.num_samples = num_samples;
+    if (num_samples < 2){
+        return indices;
+    }
+
+    // Get the active factors
+    double sigmas[NUM_ERROR_SOURCES];
+    error_source_sigmas(&run_params, sigmas);
+    for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+        if (sigmas[source] != 0){
+            indices.active[sobol_factor(source)] = 1;
+        }
+    }
+    indices.active[SOBOL_FACTOR_NOISE] = (run_params.gyro_noise != 0 || run_params.gnss_noise != 0);
+    indices.active[SOBOL_FACTOR_CORIOLIS] = 1;
+    int factors[SOBOL_NUM_FACTORS];
+    int num_active = 0;
+    for (int factor = 0; factor < SOBOL_NUM_FACTORS; factor++){
+        if (indices.active[factor]){
+            factors[num_active++] = factor;
+        }
+    }
+
+    // Draw the sample matrices and fly the trajectories
+    error_sample *a = malloc(num_samples * sizeof(error_sample));
+    error_sample *b = malloc(num_samples * sizeof(error_sample));
+    for (int row = 0; row < num_samples; row++){
+        draw_error_sample(seed, row, PHILOX_STREAM_SOBOL_A, &a[row]);
+        draw_error_sample(seed, row, PHILOX_STREAM_SOBOL_B, &b[row]);
+    }
+    int num_flights = (num_active + 2) * num_samples;
+    indices.num_flights = num_flights;
+    double *impacts = malloc(3 * num_flights * sizeof(double));
+    sobol_batch batch = {&run_params, a, b, factors, num_samples, impacts};
+    parallel_for(run_params.num_threads, sobol_task, &batch, num_flights);
+
+    // Project the impact points onto the local tangent plane at the mean impact point of A and B
+    double mean[3] = {0, 0, 0};
+    for (int f = 0; f < 2 * num_samples; f++){
+        for (int i = 0; i < 3; i++){
+            mean[i] += impacts[3*f + i] / (2 * num_samples);
+        }
+    }
+    double lon = atan2(mean[1], mean[0]);
+    double lat = atan2(mean[2], sqrt(mean[0]*mean[0] + mean[1]*mean[1]));
+    double *outputs = malloc(SOBOL_NUM_OUTPUTS * num_flights * sizeof(double));
+    for (int f = 0; f < num_flights; f++){
+        double dx = impacts[3*f] - mean[0];
+        double dy = impacts[3*f + 1] - mean[1];
+        double dz = impacts[3*f + 2] - mean[2];
+        double east = -sin(lon)*dx + cos(lon)*dy;
+        double north = -sin(lat)*cos(lon)*dx - sin(lat)*sin(lon)*dy + cos(lat)*dz;
+        outputs[SOBOL_OUTPUT_EAST * num_flights + f] = east;
+        outputs[SOBOL_OUTPUT_NORTH * num_flights + f] = north;
+        outputs[SOBOL_OUTPUT_MISS * num_flights + f] = sqrt(east*east + north*north);
+    }
+
+    // Point estimates over all rows, then bootstrap resamples of the rows
+    int *rows = malloc(num_samples * sizeof(int));
+    double *first_boot = malloc(SOBOL_BOOTSTRAP * sizeof(double));
+    double *total_boot = malloc(SOBOL_BOOTSTRAP * sizeof(double));
+    gsl_rng *rng = philox_alloc(seed, 0, PHILOX_STREAM_BOOTSTRAP);
+    int low = (int)floor(0.5 * (1 - SOBOL_CONFIDENCE) * SOBOL_BOOTSTRAP);
+    int high = (int)ceil(0.5 * (1 + SOBOL_CONFIDENCE) * SOBOL_BOOTSTRAP) - 1;
+
+    for (int o = 0; o < SOBOL_NUM_OUTPUTS; o++){
+        const double *f_a = &outputs[o * num_flights];
+        const double *f_b = &outputs[o * num_flights + num_samples];
+        for (int k = 0; k < num_active; k++){
+            int factor = factors[k];
+            const double *f_ab = &outputs[o * num_flights + (2 + k) * num_samples];
+
+            for (int j = 0; j < num_samples; j++){
+                rows[j] = j;
+            }
+            sobol_estimate(f_a, f_b, f_ab, rows, num_samples, &indices.first_order[o][factor], &indices.total[o][factor], &indices.variance[o]);
+
+            double variance;
+            for (int r = 0; r < SOBOL_BOOTSTRAP; r++){
+                for (int j = 0; j < num_samples; j++){
+                    rows[j] = (int)gsl_rng_uniform_int(rng, num_samples);
+                }
+                sobol_estimate(f_a, f_b, f_ab, rows, num_samples, &first_boot[r], &total_boot[r], &variance);
+            }
+            qsort(first_boot, SOBOL_BOOTSTRAP, sizeof(double), compare_doubles);
+            qsort(total_boot, SOBOL_BOOTSTRAP, sizeof(double), compare_doubles);
+            indices.first_order_ci[o][factor][0] = first_boot[low];
+            indices.first_order_ci[o][factor][1] = first_boot[high];
+            indices.total_ci[o][factor][0] = total_boot[low];
+            indices.total_ci[o][factor][1] = total_boot[high];
+        }
+    }
+
+    gsl_rng_free(rng);
+    free(rows);
+    free(first_boot);
+    free(total_boot);
+    free(outputs);
+    free(impacts);
+    free(a);
+    free(b);
+
+    return indices;
+}
+
+void print_sobol_indices(sobol_indices *indices){
+    /*
+    Prints the Sobol indices of the active factors with their confidence intervals
+
+    INPUTS:
+    ----------
+        indices: sobol_indices *
+            pointer to the Sobol indices struct
+    */
+
+    const char *output_names[SOBOL_NUM_OUTPUTS] = {"East", "North", "Miss distance"};
+
+    printf("Sobol indices (%d samples, %d trajectories, %.0f%% confidence intervals)\n", indices->num_samples, indices->num_flights, 100 * SOBOL_CONFIDENCE);
+    for (int o = 0; o < SOBOL_NUM_OUTPUTS; o++){
+        printf("%s (variance %g m^2):\n", output_names[o], indices->variance[o]);
+        for (int factor = 0; factor < SOBOL_NUM_FACTORS; factor++){
+            if (!indices->active[factor]){
+                continue;
+            }
+            printf("  %-22s first order %7.3f [%7.3f, %7.3f]  total %7.3f [%7.3f, %7.3f]\n", sobol_factor_names[factor],
+                indices->first_order[o][factor], indices->first_order_ci[o][factor][0], indices->first_order_ci[o][factor][1],
+                indices->total[o][factor], indices->total_ci[o][factor][0], indices->total_ci[o][factor][1]);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef SURROGATE_H
+#define SURROGATE_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+#include "linalg.h"
+#include "lincov.h"
+#include "sobol.h"
+
+// Define the error fields of the run parameters that the surrogate is a function of, indexed as the factors of the
+// Sobol sensitivity analysis (initial_x_error to atm_error)
+#define SURROGATE_NUM_FIELDS SOBOL_FACTOR_NOISE
+
+// Define the outputs of the surrogate: the impact offsets from the nominal impact point and the impact time error
+#define SURROGATE_OUTPUT_X 0
+#define SURROGATE_OUTPUT_Y 1
+#define SURROGATE_OUTPUT_Z 2
+#define SURROGATE_OUTPUT_TIME 3
+#define SURROGATE_NUM_OUTPUTS 4
+
+// Define the maximum number of terms of the quadratic response surface: constant, linear, square and cross terms
+#define SURROGATE_MAX_TERMS (1 + 2*NUM_ERROR_SOURCES + NUM_ERROR_SOURCES*(NUM_ERROR_SOURCES - 1)/2)
+
+// Define the relative ridge added to the normal equations of the fit, for numerical conditioning only
+#define SURROGATE_RIDGE 1e-10
+
+// Define a struct to store a quadratic response surface of the impact point over the static error sources
+typedef struct response_surface{
+    int sources[NUM_ERROR_SOURCES]; // active static error sources, the variables of the surface
+    int num_sources; // number of active sources
+    int num_terms; // number of terms, 0 if the surface could not be fitted
+    double nominal[3]; // nominal impact position in meters
+    double nominal_time_error; // nominal impact time error in seconds
+    double coefficients[SURROGATE_NUM_OUTPUTS][SURROGATE_MAX_TERMS]; // coefficients of the terms for each output
+    double design_scale; // standard deviation of the design deviates, in nominal standard deviations
+    int num_design; // number of design runs
+    int num_validation; // number of held-out validation runs
+    double validation_rms[2]; // RMS east and north error of the surface on the held-out runs in meters
+    double validation_spread[2]; // RMS east and north offset of the held-out runs from their mean in meters
+    uint64_t seed; // seed of the design and of the evaluation samples
+} response_surface;
+
+void surrogate_terms(const response_surface *surrogate, const double *variables, double *terms){
+    /*
+    Evaluates the terms of the quadratic response surface: 1, then u_i, then u_i^2, then u_i u_j for i < j
+
+    INPUTS:
+    ----------
+        surrogate: const response_surface *
+            pointer to the response surface struct
+        variables: const double *
+            value of each active source, in nominal standard deviations
+        terms: double *
+            array of surrogate->num_terms terms to be filled
+    */
+
+    int n = surrogate->num_sources;
+    int t = 0;
+    terms[t++] = 1;
+    for (int i = 0; i < n; i++){
+        terms[t++] = variables[i];
+    }
+    for (int i = 0; i < n; i++){
+        terms[t++] = variables[i] * variables[i];
+    }
+    for (int i = 0; i < n; i++){
+        for (int j = i + 1; j < n; j++){
+            terms[t++] = variables[i] * variables[j];
+        }
+    }
+}
+
+void surrogate_eval(const response_surface *surrogate, const double *variables, double *outputs){
+    /*
+    Evaluates the response surface
+
+    INPUTS:
+    ----------
+        surrogate: const response_surface *
+            pointer to the response surface struct
+        variables: const double *
+            value of each active source, in nominal standard deviations
+        outputs: double *
+            array of SURROGATE_NUM_OUTPUTS outputs to be filled: the impact offsets from the nominal impact point in
+            meters and the impact time error in seconds
+    */
+
+    double terms[SURROGATE_MAX_TERMS];
+    surrogate_terms(surrogate, variables, terms);
+    for (int o = 0; o < SURROGATE_NUM_OUTPUTS; o++){
+        outputs[o] = 0;
+        for (int t = 0; t < surrogate->num_terms; t++){
+            outputs[o] += surrogate->coefficients[o][t] * terms[t];
+        }
+    }
+}
+
+void surrogate_local_axes(const double *position, double *east, double *north){
+    /*
+    Gets the east and north unit vectors of the local tangent plane at a position
+
+    INPUTS:
+    ----------
+        position: const double *
+            ECEF position in meters
+        east: double *
+            east unit vector to be filled
+        north: double *
+            north unit vector to be filled
+    */
+
+    double lon = atan2(position[1], position[0]);
+    double lat = atan2(position[2], sqrt(position[0]*position[0] + position[1]*position[1]));
+    east[0] = -sin(lon);
+    east[1] = cos(lon);
+    east[2] = 0;
+    north[0] = -sin(lat)*cos(lon);
+    north[1] = -sin(lat)*sin(lon);
+    north[2] = cos(lat);
+}
+
+response_surface surrogate_fit(runparams run_params, int num_design, int num_validation, double design_scale){
+    /*
+    Fits a quadratic response surface of the impact point and impact time error over the active static error sources
+    (the error fields initial_x_error to atm_error) from a design of Monte Carlo runs, and measures its error on
+    held-out runs. The design and validation deviates are drawn from N(0, design_scale^2) per source, so that the
+    surface covers error fields up to about design_scale times their values in run_params; sweeps beyond that
+    extrapolate. The runs are flown in parallel without sensor noise, as in lincov_run. The fit is a least-squares
+    solution of the normal equations by Cholesky decomposition, and needs at least as many design runs as terms,
+    1 + 2n + n(n - 1)/2 for n active sources
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+        num_design: int
+            number of design runs
+        num_validation: int
+            number of held-out validation runs
+        design_scale: double
+            standard deviation of the design deviates, in nominal standard deviations
+    OUTPUTS:
+    ----------
+        surrogate: response_surface
+            fitted response surface with its held-out validation error (num_terms is 0 if it could not be fitted)
+    */
+
+    run_params.traj_output = 0;
+    run_params.traj_archive = 0;
+    run_params.gyro_noise = 0;
+    run_params.gnss_noise = 0;
+
+    gsl_rng_env_setup();
+
+    response_surface surrogate = {0};
+    surrogate.seed = gsl_rng_default_seed;
+    surrogate.design_scale = design_scale;
+    surrogate.num_design = num_design;
+    surrogate.num_validation = num_validation;
+    surrogate.num_sources = active_error_sources(&run_params, surrogate.sources);
+    int n = surrogate.num_sources;
+    int num_terms = 1 + 2*n + n*(n - 1)/2;
+    if (num_design < num_terms){
+        printf("Error: A quadratic response surface over %d error sources needs at least %d design runs\n", n, num_terms);
+        return surrogate;
+    }
+
+    // Draw the design and validation runs, after the nominal run
+    int num_flights = 1 + num_design + num_validation;
+    double *deviates = calloc(num_flights * NUM_ERROR_SOURCES, sizeof(double));
+    for (int f = 1; f < num_flights; f++){
+        gsl_rng *rng = philox_alloc(surrogate.seed, f - 1, PHILOX_STREAM_SURROGATE);
+        for (int k = 0; k < n; k++){
+            deviates[f * NUM_ERROR_SOURCES + surrogate.sources[k]] = gsl_ran_gaussian(rng, design_scale);
+        }
+        gsl_rng_free(rng);
+    }
+    state *impact_states = malloc(num_flights * sizeof(state));
+    double *time_errors = malloc(num_flights * sizeof(double));
+    fly_deviates_batch(&run_params, deviates, num_flights, impact_states, time_errors);
+
+    surrogate.nominal[0] = impact_states[0].x;
+    surrogate.nominal[1] = impact_states[0].y;
+    surrogate.nominal[2] = impact_states[0].z;
+    surrogate.nominal_time_error = time_errors[0];
+
+    // Build the normal equations of the design runs
+    gsl_matrix *design = gsl_matrix_alloc(num_design, num_terms);
+    gsl_matrix *responses = gsl_matrix_alloc(num_design, SURROGATE_NUM_OUTPUTS);
+    surrogate.num_terms = num_terms;
+    double variables[NUM_ERROR_SOURCES];
+    double terms[SURROGATE_MAX_TERMS];
+    for (int r = 0; r < num_design; r++){
+        int f = 1 + r;
+        for (int k = 0; k < n; k++){
+            variables[k] = deviates[f * NUM_ERROR_SOURCES + surrogate.sources[k]];
+        }
+        surrogate_terms(&surrogate, variables, terms);
+        for (int t = 0; t < num_terms; t++){
+            gsl_matrix_set(design, r, t, terms[t]);
+        }
+        gsl_matrix_set(responses, r, SURROGATE_OUTPUT_X, impact_states[f].x - surrogate.nominal[0]);
+        gsl_matrix_set(responses, r, SURROGATE_OUTPUT_Y, impact_states[f].y - surrogate.nominal[1]);
+        gsl_matrix_set(responses, r, SURROGATE_OUTPUT_Z, impact_states[f].z - surrogate.nominal[2]);
+        gsl_matrix_set(responses, r, SURROGATE_OUTPUT_TIME, time_errors[f] - surrogate.nominal_time_error);
+    }
+    gsl_matrix *normal = gsl_matrix_alloc(num_terms, num_terms);
+    gsl_matrix *rhs = gsl_matrix_alloc(num_terms, SURROGATE_NUM_OUTPUTS);
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, design, design, 0.0, normal);
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, design, responses, 0.0, rhs);
+    double trace = 0;
+    for (int t = 0; t < num_terms; t++){
+        trace += gsl_matrix_get(normal, t, t);
+    }
+    for (int t = 0; t < num_terms; t++){
+        gsl_matrix_set(normal, t, t, gsl_matrix_get(normal, t, t) + SURROGATE_RIDGE * trace / num_terms);
+    }
+
+    // A failed factorization is reported through the returned surface
+    if (m_cholesky_decomp(normal) != GSL_SUCCESS){
+        printf("Error: The design runs do not determine the response surface\n");
+        surrogate.num_terms = 0;
+    }
+    else{
+        for (int o = 0; o < SURROGATE_NUM_OUTPUTS; o++){
+            gsl_vector_view column = gsl_matrix_column(rhs, o);
+            gsl_linalg_cholesky_svx(normal, &column.vector);
+            for (int t = 0; t < num_terms; t++){
+                surrogate.coefficients[o][t] = gsl_vector_get(&column.vector, t);
+            }
+        }
+    }
+
+    // Measure the east and north error of the surface on the held-out runs
+    if (surrogate.num_terms > 0 && num_validation > 0){
+        double east_axis[3];
+        double north_axis[3];
+        surrogate_local_axes(surrogate.nominal, east_axis, north_axis);
+        double *offsets = malloc(2 * num_validation * sizeof(double));
+        double mean[2] = {0, 0};
+        double squared_errors[2] = {0, 0};
+        for (int r = 0; r < num_validation; r++){
+            int f = 1 + num_design + r;
+            for (int k = 0; k < n; k++){
+                variables[k] = deviates[f * NUM_ERROR_SOURCES + surrogate.sources[k]];
+            }
+            double outputs[SURROGATE_NUM_OUTPUTS];
+            surrogate_eval(&surrogate, variables, outputs);
+            double offset[3] = {impact_states[f].x - surrogate.nominal[0], impact_states[f].y - surrogate.nominal[1], impact_states[f].z - surrogate.nominal[2]};
+            double error[3] = {outputs[0] - offset[0], outputs[1] - offset[1], outputs[2] - offset[2]};
+            offsets[2*r] = east_axis[0]*offset[0] + east_axis[1]*offset[1] + east_axis[2]*offset[2];
+            offsets[2*r + 1] = north_axis[0]*offset[0] + north_axis[1]*offset[1] + north_axis[2]*offset[2];
+            double east_error = east_axis[0]*error[0] + east_axis[1]*error[1] + east_axis[2]*error[2];
+            double north_error = north_axis[0]*error[0] + north_axis[1]*error[1] + north_axis[2]*error[2];
+            squared_errors[0] += east_error * east_error;
+            squared_errors[1] += north_error * north_error;
+            mean[0] += offsets[2*r] / num_validation;
+            mean[1] += offsets[2*r + 1] / num_validation;
+        }
+        for (int i = 0; i < 2; i++){
+            surrogate.validation_rms[i] = sqrt(squared_errors[i] / num_validation);
+            double spread = 0;
+            for (int r = 0; r < num_validation; r++){
+                spread += (offsets[2*r + i] - mean[i]) * (offsets[2*r + i] - mean[i]) / num_validation;
+            }
+            surrogate.validation_spread[i] = sqrt(spread);
+        }
+        free(offsets);
+    }
+
+    gsl_matrix_free(design);
+    gsl_matrix_free(responses);
+    gsl_matrix_free(normal);
+    gsl_matrix_free(rhs);
+    free(deviates);
+    free(impact_states);
+    free(time_errors);
+
+    return surrogate;
+}
+
+impact_dispersion surrogate_dispersion(response_surface *surrogate, const double *multipliers, int num_samples){
+    /*
+    Estimates the impact dispersion with the error fields scaled by given multipliers from samples of the response
+    surface instead of trajectories, for dense sensitivity sweeps. Each sample draws the static error deviates,
+    scales them by the multiplier of their error field, evaluates the surface and applies the Coriolis correction of
+    a random orientation. Fields that were zero when the surface was fitted stay zero. The samples come from a fixed
+    Philox sequence, so that sweep points differ only through the multipliers
+
+    INPUTS:
+    ----------
+        surrogate: response_surface *
+            pointer to the fitted response surface
+        multipliers: const double *
+            array of SURROGATE_NUM_FIELDS multipliers of the error fields, indexed as the Sobol factors
+            (initial_x_error, initial_pos_error, initial_vel_error, initial_angle_error, acc_scale_stability,
+            gyro_bias_stability, grav_error, atm_error)
+        num_samples: int
+            number of samples of the surface
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            sample impact dispersion, with the sample median miss distance from the mean impact point as the CEP
+            (num_flights is the number of samples, no trajectory is flown)
+    */
+
+    impact_dispersion dispersion = {0};
+    dispersion.num_flights = num_samples;
+    if (surrogate->num_terms == 0 || num_samples < 2){
+        return dispersion;
+    }
+
+    double *impacts = malloc(3 * num_samples * sizeof(double));
+    double variables[NUM_ERROR_SOURCES];
+    double outputs[SURROGATE_NUM_OUTPUTS];
+    for (int s = 0; s < num_samples; s++){
+        error_sample sample;
+        draw_error_sample(surrogate->seed, s, PHILOX_STREAM_SURROGATE_EVAL, &sample);
+        for (int k = 0; k < surrogate->num_sources; k++){
+            int source = surrogate->sources[k];
+            variables[k] = multipliers[sobol_factor(source)] * sample.deviates[source];
+        }
+        surrogate_eval(surrogate, variables, outputs);
+
+        state impact_state = {0};
+        impact_state.x = surrogate->nominal[0] + outputs[SURROGATE_OUTPUT_X];
+        impact_state.y = surrogate->nominal[1] + outputs[SURROGATE_OUTPUT_Y];
+        impact_state.z = surrogate->nominal[2] + outputs[SURROGATE_OUTPUT_Z];
+        apply_coriolis(&impact_state, surrogate->nominal_time_error + outputs[SURROGATE_OUTPUT_TIME], sample.lat, sample.lon);
+        impacts[3*s] = impact_state.x;
+        impacts[3*s + 1] = impact_state.y;
+        impacts[3*s + 2] = impact_state.z;
+    }
+
+    dispersion_from_impacts(&dispersion, impacts, num_samples);
+    free(impacts);
+
+    return dispersion;
+}
+
+void print_response_surface(response_surface *surrogate){
+    /*
+    Prints the size of a response surface and its held-out validation error
+
+    INPUTS:
+    ----------
+        surrogate: response_surface *
+            pointer to the response surface struct
+    */
+
+    printf("Quadratic response surface (%d error sources, %d terms, %d design runs at %.1f sigma)\n", surrogate->num_sources, surrogate->num_terms, surrogate->num_design, surrogate->design_scale);
+    printf("Nominal impact point: (%f, %f, %f)\n", surrogate->nominal[0], surrogate->nominal[1], surrogate->nominal[2]);
+    printf("Held-out RMS error (%d runs): east %f m, north %f m (spread east %f m, north %f m)\n", surrogate->num_validation, surrogate->validation_rms[0], surrogate->validation_rms[1], surrogate->validation_spread[0], surrogate->validation_spread[1]);
+}
+
+#endif
@@ -10,12 +10,28 @@
 #include "physics.h"
 #include "sensors.h"
 #include "maneuverability.h"
+#include "recorder.h"
+#include "philox.h"
+#include "scheduler.h"
+#include "pool.h"
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 
 // Define a constant upper limit for the number of Monte Carlo runs
 #define MAX_RUNS 1000
 
+// Define the typical time in seconds flown at the reentry time step, used to pre-size trajectory buffers
+#define EXPECTED_REENTRY_TIME 400
+
+// Define the number of standard normal deviates drawn for the initial state errors
+#define INITIAL_STATE_DEVIATES 9
+
+// Define the maximum number of integration steps of a flight
+#define MAX_FLIGHT_STEPS 100000
+
+// Define the rotation speed of the Earth's surface at the equator in m/s, used by the Coriolis correction of the impact point
+#define CORIOLIS_SPEED 464
+
 // Define a struct to store impact data
 typedef struct impact_data{
     // Impact data
@@ -23,16 +39,35 @@ typedef struct impact_data{
 
 } impact_data;
 
-state init_true_state(runparams *run_params, gsl_rng *rng){
+// Define a struct to store the impact state of one run, as kept in the results of a NUMA node
+typedef struct mc_result{
+    int run; // index of the run
+    state impact_state; // impact state of the run
+} mc_result;
+
+// Define a struct to store the inputs and outputs of the parallel runs of mc_run
+typedef struct mc_batch{
+    runparams *run_params; // pointer to the run parameters struct
+    uint64_t seed; // seed of the Monte Carlo simulation
+    const vehicle *profile; // shared vehicle profile of the runs
+    const int *runs; // indices of the runs flown in parallel
+    worker_pool *pool; // worker pool flying the runs
+    int num_nodes; // number of result buffers, one per NUMA node if the threads are pinned and one otherwise
+    mc_result **node_results; // results of the runs flown on each NUMA node, first touched by that node
+    atomic_int *node_counts; // number of results of each NUMA node
+} mc_batch;
+
+state init_true_state_from_deviates(runparams *run_params, const double *deviates){
     /*
-    Initializes a true state struct at the launch site with zero velocity and acceleration
+    Initializes a true state struct at the launch site from given standard normal deviates of the initial errors
 
     INPUTS:
     ----------
         run_params: runparams *
             pointer to the run parameters struct
-        rng: gsl_rng *
-            pointer to the random number generator
+        deviates: const double *
+            nine standard normal deviates of the x, y and z position errors, the rotation, latitude and
+            longitude angle errors, and the x, y and z velocity errors
 
     OUTPUTS:
     ----------
@@ -42,20 +77,20 @@ state init_true_state(runparams *run_params, gsl_rng *rng){
 
     state state;
     state.t = 0;
-    state.x = 6371e3 + run_params->initial_x_error * gsl_ran_gaussian(rng, 1);
-    state.y = run_params->initial_pos_error * gsl_ran_gaussian(rng, 1);
-    state.z = run_params->initial_pos_error * gsl_ran_gaussian(rng, 1);
+    state.x = 6371e3 + run_params->initial_x_error * deviates[0];
+    state.y = run_params->initial_pos_error * deviates[1];
+    state.z = run_params->initial_pos_error * deviates[2];
 
-    double initial_rot_pert = run_params->initial_angle_error * gsl_ran_gaussian(rng, 1);
+    double initial_rot_pert = run_params->initial_angle_error * deviates[3];
 
-    state.initial_theta_lat_pert = run_params->initial_angle_error * gsl_ran_gaussian(rng, 1) + run_params->theta_long * initial_rot_pert - fabs(run_params->theta_lat * initial_rot_pert);
-    state.initial_theta_long_pert = run_params->initial_angle_error * gsl_ran_gaussian(rng, 1) - run_params->theta_lat * initial_rot_pert - fabs(run_params->theta_long * initial_rot_pert);
+    state.initial_theta_lat_pert = run_params->initial_angle_error * deviates[4] + run_params->theta_long * initial_rot_pert - fabs(run_params->theta_lat * initial_rot_pert);
+    state.initial_theta_long_pert = run_params->initial_angle_error * deviates[5] - run_params->theta_lat * initial_rot_pert - fabs(run_params->theta_long * initial_rot_pert);
     state.theta_long = run_params->theta_long + state.initial_theta_long_pert;
     state.theta_lat = run_params->theta_lat + state.initial_theta_lat_pert;
 
-    state.vx = run_params->initial_vel_error * gsl_ran_gaussian(rng, 1);
-    state.vy = run_params->initial_vel_error * gsl_ran_gaussian(rng, 1);
-    state.vz = run_params->initial_vel_error * gsl_ran_gaussian(rng, 1);
+    state.vx = run_params->initial_vel_error * deviates[6];
+    state.vy = run_params->initial_vel_error * deviates[7];
+    state.vz = run_params->initial_vel_error * deviates[8];
     state.ax_grav = 0;
     state.ay_grav = 0;
     state.az_grav = 0;
@@ -75,6 +110,31 @@ state init_true_state(runparams *run_params, gsl_rng *rng){
     return state;
 }
 
+state init_true_state(runparams *run_params, gsl_rng *rng){
+    /*
+    Initializes a true state struct at the launch site with zero velocity and acceleration
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        rng: gsl_rng *
+            pointer to the random number generator
+
+    OUTPUTS:
+    ----------
+        state: state
+            initial state of the vehicle
+    */
+
+    double deviates[INITIAL_STATE_DEVIATES];
+    for (int i = 0; i < INITIAL_STATE_DEVIATES; i++){
+        deviates[i] = gsl_ran_gaussian(rng, 1);
+    }
+
+    return init_true_state_from_deviates(run_params, deviates);
+}
+
 state init_est_state(runparams *run_params){
     /*
     Initializes an estimated state struct at the launch site with zero velocity and acceleration
@@ -194,12 +254,112 @@ void output_impact(FILE *impact_file, impact_data *impact_data, int num_runs){
     
 }
 
-state fly(runparams *run_params, state *initial_state, vehicle *vehicle, gsl_rng *rng){
+void traj_row(double *row, double current_mass, state *true_state, state *est_state){
     /*
-    Function that simulates the flight of a vehicle, updating the state of the vehicle at each time step
-    
+    Packs the true and estimated states into a single row of trajectory output
+
+    INPUTS:
+    ----------
+        row: double *
+            array of TRAJ_NUM_FIELDS values to be filled
+        current_mass: double
+            current mass of the vehicle in kg
+        true_state: state *
+            pointer to the true state of the vehicle
+        est_state: state *
+            pointer to the estimated state of the vehicle
+    */
+
+    row[0] = true_state->t;
+    row[1] = current_mass;
+    row[2] = true_state->x;
+    row[3] = true_state->y;
+    row[4] = true_state->z;
+    row[5] = true_state->vx;
+    row[6] = true_state->vy;
+    row[7] = true_state->vz;
+    row[8] = true_state->ax_grav;
+    row[9] = true_state->ay_grav;
+    row[10] = true_state->az_grav;
+    row[11] = true_state->ax_drag;
+    row[12] = true_state->ay_drag;
+    row[13] = true_state->az_drag;
+    row[14] = true_state->ax_lift;
+    row[15] = true_state->ay_lift;
+    row[16] = true_state->az_lift;
+    row[17] = true_state->ax_thrust;
+    row[18] = true_state->ay_thrust;
+    row[19] = true_state->az_thrust;
+    row[20] = true_state->ax_total;
+    row[21] = true_state->ay_total;
+    row[22] = true_state->az_total;
+    row[23] = est_state->x;
+    row[24] = est_state->y;
+    row[25] = est_state->z;
+    row[26] = est_state->vx;
+    row[27] = est_state->vy;
+    row[28] = est_state->vz;
+    row[29] = est_state->ax_grav;
+    row[30] = est_state->ay_grav;
+    row[31] = est_state->az_grav;
+    row[32] = est_state->ax_drag;
+    row[33] = est_state->ay_drag;
+    row[34] = est_state->az_drag;
+    row[35] = est_state->ax_lift;
+    row[36] = est_state->ay_lift;
+    row[37] = est_state->az_lift;
+    row[38] = est_state->ax_thrust;
+    row[39] = est_state->ay_thrust;
+    row[40] = est_state->az_thrust;
+    row[41] = est_state->ax_total;
+    row[42] = est_state->ay_total;
+    row[43] = est_state->az_total;
+}
+
+// Define a struct to store a flight in progress, so that it can be advanced one integration step at a time
+typedef struct flight{
+    runparams *run_params; // pointer to the run parameters struct
+    vehicle *vehicle; // pointer to the vehicle struct
+    gsl_rng *rng; // pointer to the random number generator
+    traj_recorder *recorder; // pointer to the trajectory recorder (NULL for no trajectory output)
+
+    // Environment and sensor models
+    grav true_grav;
+    grav est_grav;
+    atm_model atm_model;
+    imu imu;
+    gnss gnss;
+    noise_buffer noise;
+
+    // Rate groups of the sensor, guidance and lift models, and the acceleration command held between guidance updates
+    rate_group imu_group;
+    rate_group gnss_group;
+    rate_group guidance_group;
+    rate_group lift_group;
+    cart_vector a_command;
+
+    // True, estimated and desired states at the start and end of the current step
+    state old_true_state;
+    state new_true_state;
+    state old_est_state;
+    state new_est_state;
+    state old_des_state;
+    state new_des_state;
+
+    int steps; // number of integration steps taken
+    int impacted; // 1 once the vehicle has impacted the Earth, 0 otherwise
+    state true_impact_state; // true state interpolated to impact, before the Coriolis correction
+    state est_impact_state; // estimated state interpolated to impact
+} flight;
+
+void flight_init(flight *flight, runparams *run_params, state *initial_state, vehicle *vehicle, gsl_rng *rng, traj_recorder *recorder){
+    /*
+    Initializes a flight at its initial state, drawing the error models of the run
+
     INPUTS:
     ----------
+        flight: flight *
+            pointer to the flight struct
         run_params: runparams *
             pointer to the run parameters struct
         initial_state: state *
@@ -208,185 +368,372 @@ state fly(runparams *run_params, state *initial_state, vehicle *vehicle, gsl_rng
             pointer to the vehicle struct
         rng: gsl_rng *
             pointer to the random number generator
-
-    OUTPUTS:
-    ----------
-        final_state: state
-            final state of the vehicle (impact point)
+        recorder: traj_recorder *
+            pointer to the trajectory recorder for this run (NULL for no trajectory output)
     */
 
-    // Initialize the variables and structures
-    int max_steps = 100000;
+    flight->run_params = run_params;
+    flight->vehicle = vehicle;
+    flight->rng = rng;
+    flight->recorder = recorder;
 
-    grav true_grav = init_grav(run_params, rng);
-    grav est_grav = init_grav(run_params, rng);
-    est_grav.perturb_flag = 0;
+    flight->true_grav = init_grav(run_params, rng);
+    flight->est_grav = init_grav(run_params, rng);
+    flight->est_grav.perturb_flag = 0;
 
-    atm_model atm_model = init_atm(run_params, rng);
-    
-    state old_true_state = *initial_state;
-    state new_true_state = *initial_state;
+    flight->atm_model = init_atm(run_params, rng);
 
-    state old_est_state = init_est_state(run_params);
-    state new_est_state = init_est_state(run_params);
-    state old_des_state = init_est_state(run_params);
-    state new_des_state = init_est_state(run_params);
+    flight->old_true_state = *initial_state;
+    flight->new_true_state = *initial_state;
+
+    flight->old_est_state = init_est_state(run_params);
+    flight->new_est_state = init_est_state(run_params);
+    flight->old_des_state = init_est_state(run_params);
+    flight->new_des_state = init_est_state(run_params);
 
-    int traj_output = run_params->traj_output;
-    double time_step;
     // Initialize the IMU
-    imu imu = imu_init(run_params, initial_state, rng);
+    flight->imu = imu_init(run_params, initial_state, rng);
 
     // Initialize the GNSS
-    gnss gnss = gnss_init(run_params);
+    flight->gnss = gnss_init(run_params);
+
+    // Initialize the block-generated sensor noise
+    noise_buffer_init(&flight->noise, rng);
+
+    // Initialize the rate groups of the sensor, guidance and lift models
+    rate_group_init(&flight->imu_group, run_params->imu_period);
+    rate_group_init(&flight->gnss_group, run_params->gnss_period);
+    rate_group_init(&flight->guidance_group, run_params->guidance_period);
+    rate_group_init(&flight->lift_group, run_params->lift_period);
+    flight->a_command = (cart_vector){0, 0, 0};
+
+    flight->steps = 0;
+    flight->impacted = 0;
+
+    // Record the initial state
+    if (recorder != NULL && recorder_sample(recorder, flight->old_true_state.t, TRAJ_EVENT_LAUNCH)){
+        double traj_data[TRAJ_NUM_FIELDS];
+        traj_row(traj_data, vehicle->current_mass, &flight->old_true_state, &flight->old_est_state);
+        recorder_step(recorder, traj_data, TRAJ_EVENT_LAUNCH);
+    }
+}
 
-    // Create a .txt file to store the trajectory data
-    FILE *traj_file;
-    if (traj_output == 1){
-        traj_file = fopen(run_params->trajectory_path, "w");
-        fprintf(traj_file, "t, current_mass, x, y, z, vx, vy, vz, ax_grav, ay_grav, az_grav, ax_drag, ay_drag, az_drag, ax_lift, ay_lift, az_lift, ax_thrust, ay_thrust, az_thrust, ax_total, ay_total, az_total, est_x, est_y, est_z, est_vx, est_vy, est_vz, est_ax_grav, est_ay_grav, est_az_grav, est_ax_drag, est_ay_drag, est_az_drag, est_ax_lift, est_ay_lift, est_az_lift, est_ax_thrust, est_ay_thrust, est_az_thrust, est_ax_total, est_ay_total, est_az_total \n");
-        // Write the initial state to the trajectory file
-        fprintf(traj_file, "%f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f\n", old_true_state.t, vehicle->current_mass, old_true_state.x, old_true_state.y, old_true_state.z, old_true_state.vx, old_true_state.vy, old_true_state.vz, old_true_state.ax_grav, old_true_state.ay_grav, old_true_state.az_grav, old_true_state.ax_drag, old_true_state.ay_drag, old_true_state.az_drag, old_true_state.ax_lift, old_true_state.ay_lift, old_true_state.az_lift, old_true_state.ax_thrust, old_true_state.ay_thrust, old_true_state.az_thrust, old_true_state.ax_total, old_true_state.ay_total, old_true_state.az_total, old_est_state.x, old_est_state.y, old_est_state.z, old_est_state.vx, old_est_state.vy, old_est_state.vz, old_est_state.ax_grav, old_est_state.ay_grav, old_est_state.az_grav, old_est_state.ax_drag, old_est_state.ay_drag, old_est_state.az_drag, old_est_state.ax_lift, old_est_state.ay_lift, old_est_state.az_lift, old_est_state.ax_thrust, old_est_state.ay_thrust, old_est_state.az_thrust, old_est_state.ax_total, old_est_state.ay_total, old_est_state.az_total);
+int flight_step(flight *flight){
+    /*
+    Advances a flight by one integration step. On impact, the true and estimated states are interpolated to the
+    impact point and stored in the flight struct, and the flight is not advanced any further
+
+    INPUTS:
+    ----------
+        flight: flight *
+            pointer to the flight struct
+    OUTPUTS:
+    ----------
+        impacted: int
+            1 if the vehicle has impacted the Earth, 0 otherwise
+    */
+
+    if (flight->impacted){
+        return 1;
     }
 
-    // Begin the integration loop
-    for (int i = 0; i < max_steps; i++){
-        // Get the atmospheric conditions
-        double old_altitude = get_altitude(old_true_state.x, old_true_state.y, old_true_state.z);
-
-        atm_cond true_atm_cond = get_atm_cond(old_altitude, &atm_model, run_params);
-        atm_cond est_atm_cond = get_exp_atm_cond(old_altitude, &atm_model);
-        // if during boost or outside atmosphere, dt = main time step, else dt = reentry time step
-        if (old_true_state.t < vehicle->booster.total_burn_time || old_altitude > 1e6){
-            time_step = run_params->time_step_main;
-        }
-        else{
-            time_step = run_params->time_step_reentry;
+    runparams *run_params = flight->run_params;
+    vehicle *vehicle = flight->vehicle;
+    state *old_true_state = &flight->old_true_state;
+    state *new_true_state = &flight->new_true_state;
+    state *old_est_state = &flight->old_est_state;
+    state *new_est_state = &flight->new_est_state;
+    state *old_des_state = &flight->old_des_state;
+    state *new_des_state = &flight->new_des_state;
+
+    // Get the atmospheric conditions
+    double old_altitude = get_altitude(old_true_state->x, old_true_state->y, old_true_state->z);
+
+    atm_cond true_atm_cond = get_atm_cond(old_altitude, &flight->atm_model, run_params);
+    atm_cond est_atm_cond = get_exp_atm_cond(old_altitude, &flight->atm_model);
+    // if during boost or outside atmosphere, dt = main time step, else dt = reentry time step
+    double time_step;
+    int reentry_step = !(old_true_state->t < vehicle->booster.total_burn_time || old_altitude > 1e6);
+    if (!reentry_step){
+        time_step = run_params->time_step_main;
+    }
+    else{
+        time_step = run_params->time_step_reentry;
+    }
+    // Update the thrust of the vehicle
+    update_thrust(vehicle, new_true_state);
+    update_thrust(vehicle, new_est_state);
+    update_thrust(vehicle, new_des_state);
+    // Update the gravity acceleration components
+    update_gravity(&flight->true_grav, new_true_state);
+    update_gravity(&flight->est_grav, new_est_state);
+    update_gravity(&flight->true_grav, new_des_state);
+
+    // Update the drag acceleration components
+    update_drag(vehicle, &true_atm_cond, new_true_state);
+    update_drag(vehicle, &est_atm_cond, new_est_state);
+    update_drag(vehicle, &est_atm_cond, new_des_state);
+
+    // If maneuverable RV, use proportional navigation during reentry
+    if (run_params->rv_maneuv == 1 && old_true_state->t > vehicle->booster.total_burn_time && get_altitude(new_true_state->x, new_true_state->y, new_true_state->z) < 1e6){
+        // Get the acceleration command, held between guidance updates
+        if (rate_group_due(&flight->guidance_group, old_true_state->t, time_step) > 0){
+            flight->a_command = prop_nav(run_params, new_est_state);
         }
-        // Update the thrust of the vehicle
-        update_thrust(vehicle, &new_true_state);
-        update_thrust(vehicle, &new_est_state);
-        update_thrust(vehicle, &new_des_state);
-        // Update the gravity acceleration components
-        update_gravity(&true_grav, &new_true_state);
-        update_gravity(&est_grav, &new_est_state);
-        update_gravity(&true_grav, &new_des_state);
-
-        // Update the drag acceleration components
-        update_drag(vehicle, &true_atm_cond, &new_true_state);
-        update_drag(vehicle, &est_atm_cond, &new_est_state);
-        update_drag(vehicle, &est_atm_cond, &new_des_state);
-
-        // If maneuverable RV, use proportional navigation during reentry
-        if (run_params->rv_maneuv == 1 && old_true_state.t > vehicle->booster.total_burn_time && get_altitude(new_true_state.x, new_true_state.y, new_true_state.z) < 1e6){
-            // Get the acceleration command
-            cart_vector a_command = prop_nav(run_params, &new_est_state);
-            
-            // Update the lift acceleration components
-            update_lift(&new_true_state, &a_command, &true_atm_cond, vehicle, time_step);
-            update_lift(&new_est_state, &a_command, &est_atm_cond, vehicle, time_step);
+
+        // Update the lift acceleration components, held between lift updates
+        double lift_interval = rate_group_due(&flight->lift_group, old_true_state->t, time_step);
+        if (lift_interval > 0){
+            update_lift(new_true_state, &flight->a_command, &true_atm_cond, vehicle, lift_interval);
+            update_lift(new_est_state, &flight->a_command, &est_atm_cond, vehicle, lift_interval);
         }
+    }
 
-        // Calculate the total acceleration components
-        new_true_state.ax_total = new_true_state.ax_grav + new_true_state.ax_drag + new_true_state.ax_lift + new_true_state.ax_thrust;
-        new_true_state.ay_total = new_true_state.ay_grav + new_true_state.ay_drag + new_true_state.ay_lift + new_true_state.ay_thrust;
-        new_true_state.az_total = new_true_state.az_grav + new_true_state.az_drag + new_true_state.az_lift + new_true_state.az_thrust;
-        new_est_state.ax_total = new_est_state.ax_grav + new_est_state.ax_drag + new_est_state.ax_lift + new_est_state.ax_thrust;
-        new_est_state.ay_total = new_est_state.ay_grav + new_est_state.ay_drag + new_est_state.ay_lift + new_est_state.ay_thrust;
-        new_est_state.az_total = new_est_state.az_grav + new_est_state.az_drag + new_est_state.az_lift + new_est_state.az_thrust;
-        new_des_state.ax_total = new_des_state.ax_grav + new_des_state.ax_drag + new_des_state.ax_lift + new_des_state.ax_thrust;
-        new_des_state.ay_total = new_des_state.ay_grav + new_des_state.ay_drag + new_des_state.ay_lift + new_des_state.ay_thrust;
-        new_des_state.az_total = new_des_state.az_grav + new_des_state.az_drag + new_des_state.az_lift + new_des_state.az_thrust;
-
-        double a_drag = sqrt(new_true_state.ax_drag*new_true_state.ax_drag + new_true_state.ay_drag*new_true_state.ay_drag + new_true_state.az_drag*new_true_state.az_drag);
-        if (run_params->ins_nav == 1){
+    // Calculate the total acceleration components
+    new_true_state->ax_total = new_true_state->ax_grav + new_true_state->ax_drag + new_true_state->ax_lift + new_true_state->ax_thrust;
+    new_true_state->ay_total = new_true_state->ay_grav + new_true_state->ay_drag + new_true_state->ay_lift + new_true_state->ay_thrust;
+    new_true_state->az_total = new_true_state->az_grav + new_true_state->az_drag + new_true_state->az_lift + new_true_state->az_thrust;
+    new_est_state->ax_total = new_est_state->ax_grav + new_est_state->ax_drag + new_est_state->ax_lift + new_est_state->ax_thrust;
+    new_est_state->ay_total = new_est_state->ay_grav + new_est_state->ay_drag + new_est_state->ay_lift + new_est_state->ay_thrust;
+    new_est_state->az_total = new_est_state->az_grav + new_est_state->az_drag + new_est_state->az_lift + new_est_state->az_thrust;
+    new_des_state->ax_total = new_des_state->ax_grav + new_des_state->ax_drag + new_des_state->ax_lift + new_des_state->ax_thrust;
+    new_des_state->ay_total = new_des_state->ay_grav + new_des_state->ay_drag + new_des_state->ay_lift + new_des_state->ay_thrust;
+    new_des_state->az_total = new_des_state->az_grav + new_des_state->az_drag + new_des_state->az_lift + new_des_state->az_thrust;
+
+    double a_drag = sqrt(new_true_state->ax_drag*new_true_state->ax_drag + new_true_state->ay_drag*new_true_state->ay_drag + new_true_state->az_drag*new_true_state->az_drag);
+    if (run_params->ins_nav == 1){
+        double imu_interval = rate_group_due(&flight->imu_group, old_true_state->t, time_step);
+        if (imu_interval > 0){
             // INS Measurement
-            imu_measurement(&imu, &new_true_state, &new_est_state, vehicle, rng);
+            imu_measurement(&flight->imu, new_true_state, new_est_state, vehicle);
 
             if (run_params->rv_maneuv == 0 ){ 
-                update_imu(&imu, time_step, rng);
+                update_imu(&flight->imu, imu_interval, time_step, &flight->noise);
             }
-            else if (a_drag > 1e-3 || old_true_state.t < vehicle->booster.total_burn_time){
-                update_imu(&imu, time_step, rng);
+            else if (a_drag > 1e-3 || old_true_state->t < vehicle->booster.total_burn_time){
+                update_imu(&flight->imu, imu_interval, time_step, &flight->noise);
             }
         }
-
-        if (run_params->gnss_nav == 1){
-            // GNSS Measurement
-            gnss_measurement(&gnss, &new_true_state, &new_est_state, rng);
+        else{
+            // Hold the last INS measurement
+            imu_hold(&flight->imu, new_est_state);
         }
+    }
 
-        if  (new_true_state.t == (vehicle->booster.total_burn_time) ){
-            // Perform a perfect maneuver if before burnout
+    if (run_params->gnss_nav == 1 && rate_group_due(&flight->gnss_group, old_true_state->t, time_step) > 0){
+        // GNSS Measurement, the estimate is propagated between fixes
+        gnss_measurement(&flight->gnss, new_true_state, new_est_state, &flight->noise);
+    }
 
-            new_true_state = perfect_maneuv(&new_true_state, &new_est_state, &new_des_state);
-            imu.gyro_error_lat = 0;
-            imu.gyro_error_long = 0;
+    if  (new_true_state->t == (vehicle->booster.total_burn_time) ){
+        // Perform a perfect maneuver if before burnout
 
-        }
-    
-        // Perform a Runge-Kutta step
-        rk4step(&new_true_state, time_step);
-        rk4step(&new_est_state, time_step);
-        rk4step(&new_des_state, time_step);
-        // Update the mass of the vehicle
-        update_mass(vehicle, new_true_state.t);
-
-        // Check if the vehicle has impacted the Earth
-        double new_altitude = get_altitude(new_true_state.x, new_true_state.y, new_true_state.z);
-        if (new_altitude < 0){
-            state true_final_state = impact_linterp(&old_true_state, &new_true_state);
-            state est_final_state = impact_linterp(&old_est_state, &new_est_state);
-            state des_final_state = impact_linterp(&old_des_state, &new_des_state);
-
-            // Add coriolis effect based on the latitude and the impact time error
-            double lat = gsl_ran_flat(rng, -M_PI/2, M_PI/2);
-            double lon = gsl_ran_flat(rng, -M_PI, M_PI);
-            double time_error = true_final_state.t - est_final_state.t;
-            double rot_speed = 464 * cos(lat);
-            // printf("Impact time error: %f\n", time_error);
-            double coriolis = rot_speed * time_error;
-
-            // based on the coriolis effect, update the final state x and y
-            // This might seem like a bug, but I promise it's just clever
-            // This replicates flying in a random direction, not just along the equator
-            true_final_state.x = true_final_state.x - coriolis * sin(lon)*cos(lat);
-            true_final_state.y = true_final_state.y + coriolis * cos(lon)*cos(lat);
-            true_final_state.z = true_final_state.z + coriolis * sin(lat);
-            if (run_params->rv_maneuv == 2){
-                // If perfect rv maneuver, update the final position
-                true_final_state.x = true_final_state.x - est_final_state.x;
-                true_final_state.y = true_final_state.y - est_final_state.y;
-                true_final_state.z = true_final_state.z - est_final_state.z;
-            }
-            if (traj_output == 1){
-                // Write the final state to the trajectory file
-                fprintf(traj_file, "%f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f\n", true_final_state.t, vehicle->current_mass, true_final_state.x, true_final_state.y, true_final_state.z, true_final_state.vx, true_final_state.vy, true_final_state.vz, true_final_state.ax_grav, true_final_state.ay_grav, true_final_state.az_grav, true_final_state.ax_drag, true_final_state.ay_drag, true_final_state.az_drag, true_final_state.ax_lift, true_final_state.ay_lift, true_final_state.az_lift, true_final_state.ax_thrust, true_final_state.ay_thrust, true_final_state.az_thrust, true_final_state.ax_total, true_final_state.ay_total, true_final_state.az_total, est_final_state.x, est_final_state.y, est_final_state.z, est_final_state.vx, est_final_state.vy, est_final_state.vz, est_final_state.ax_grav, est_final_state.ay_grav, est_final_state.az_grav, est_final_state.ax_drag, est_final_state.ay_drag, est_final_state.az_drag, est_final_state.ax_lift, est_final_state.ay_lift, est_final_state.az_lift, est_final_state.ax_thrust, est_final_state.ay_thrust, est_final_state.az_thrust, est_final_state.ax_total, est_final_state.ay_total, est_final_state.az_total);
-                fclose(traj_file);
-            }
+        *new_true_state = perfect_maneuv(new_true_state, new_est_state, new_des_state);
+        flight->imu.gyro_error_lat = 0;
+        flight->imu.gyro_error_long = 0;
 
-            return true_final_state;
-        }
+    }
+
+    // Perform a Runge-Kutta step
+    rk4step(new_true_state, time_step);
+    rk4step(new_est_state, time_step);
+    rk4step(new_des_state, time_step);
+    // Update the mass of the vehicle
+    update_mass(vehicle, new_true_state->t);
+    flight->steps++;
+
+    // Check if the vehicle has impacted the Earth
+    double new_altitude = get_altitude(new_true_state->x, new_true_state->y, new_true_state->z);
+    if (new_altitude < 0){
+        flight->true_impact_state = impact_linterp(old_true_state, new_true_state);
+        flight->est_impact_state = impact_linterp(old_est_state, new_est_state);
+        flight->impacted = 1;
+
+        return 1;
+    }
 
-        // output the trajectory data
-        if (traj_output == 1){
-            fprintf(traj_file, "%f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f\n", new_true_state.t, vehicle->current_mass, new_true_state.x, new_true_state.y, new_true_state.z, new_true_state.vx, new_true_state.vy, new_true_state.vz, new_true_state.ax_grav, new_true_state.ay_grav, new_true_state.az_grav, new_true_state.ax_drag, new_true_state.ay_drag, new_true_state.az_drag, new_true_state.ax_lift, new_true_state.ay_lift, new_true_state.az_lift, new_true_state.ax_thrust, new_true_state.ay_thrust, new_true_state.az_thrust, new_true_state.ax_total, new_true_state.ay_total, new_true_state.az_total, new_est_state.x, new_est_state.y, new_est_state.z, new_est_state.vx, new_est_state.vy, new_est_state.vz, new_est_state.ax_grav, new_est_state.ay_grav, new_est_state.az_grav, new_est_state.ax_drag, new_est_state.ay_drag, new_est_state.az_drag, new_est_state.ax_lift, new_est_state.ay_lift, new_est_state.az_lift, new_est_state.ax_thrust, new_est_state.ay_thrust, new_est_state.az_thrust, new_est_state.ax_total, new_est_state.ay_total, new_est_state.az_total);
+    // output the trajectory data, flagging the phase changes so they are always recorded
+    if (flight->recorder != NULL){
+        int events = TRAJ_EVENT_NONE;
+        int old_stage = get_stage(vehicle, old_true_state->t);
+        int new_stage = get_stage(vehicle, new_true_state->t);
+        if (new_stage != old_stage){
+            events |= (new_stage == vehicle->booster.num_stages) ? TRAJ_EVENT_BURNOUT : TRAJ_EVENT_STAGING;
         }
+        if (!reentry_step && !(new_true_state->t < vehicle->booster.total_burn_time || new_altitude > 1e6)){
+            events |= TRAJ_EVENT_REENTRY;
+        }
+        if (recorder_sample(flight->recorder, new_true_state->t, events)){
+            double traj_data[TRAJ_NUM_FIELDS];
+            traj_row(traj_data, vehicle->current_mass, new_true_state, new_est_state);
+            recorder_step(flight->recorder, traj_data, events);
+        }
+    }
+
+    // Update the old state
+    *old_true_state = *new_true_state;
+    *old_est_state = *new_est_state;
+    *old_des_state = *new_des_state;
 
-        // Update the old state
-        old_true_state = new_true_state;
-        old_est_state = new_est_state;
-        old_des_state = new_des_state;
+    return 0;
+}
+
+// Define a struct to store a snapshot of a flight in progress, from which any number of flights can be continued
+typedef struct flight_snapshot{
+    flight flight; // true, estimated and desired states, error models, sensor noise and rate groups
+    vehicle vehicle; // vehicle parameters and current mass
+} flight_snapshot;
+
+void flight_snapshot_take(flight_snapshot *snapshot, flight *flight){
+    /*
+    Takes a snapshot of a flight in progress. The random number generator and the trajectory recorder are not part
+    of the snapshot, they are given to each flight continued from it
+
+    INPUTS:
+    ----------
+        snapshot: flight_snapshot *
+            pointer to the snapshot to be filled
+        flight: flight *
+            pointer to the flight struct
+    */
+
+    snapshot->flight = *flight;
+    snapshot->vehicle = *flight->vehicle;
+    snapshot->flight.vehicle = NULL;
+    snapshot->flight.rng = NULL;
+    snapshot->flight.recorder = NULL;
+}
+
+void flight_snapshot_restore(const flight_snapshot *snapshot, flight *flight, vehicle *vehicle, gsl_rng *rng, traj_recorder *recorder){
+    /*
+    Continues a flight from a snapshot. The continued flight advances exactly as the flight the snapshot was taken
+    from, given a random number generator in the same state
+
+    INPUTS:
+    ----------
+        snapshot: const flight_snapshot *
+            pointer to the snapshot
+        flight: flight *
+            pointer to the flight struct to be filled
+        vehicle: vehicle *
+            pointer to the vehicle struct of the continued flight, filled from the snapshot
+        rng: gsl_rng *
+            pointer to the random number generator of the continued flight
+        recorder: traj_recorder *
+            pointer to the trajectory recorder of the continued flight (NULL for no trajectory output)
+    */
+
+    *flight = snapshot->flight;
+    *vehicle = snapshot->vehicle;
+    flight->vehicle = vehicle;
+    flight->rng = rng;
+    flight->recorder = recorder;
+}
+
+void apply_coriolis(state *final_state, double time_error, double lat, double lon){
+    /*
+    Applies the Coriolis correction of an impact time error to an impact point, for a flight at a given latitude
+    and heading
+
+    INPUTS:
+    ----------
+        final_state: state *
+            pointer to the impact state, updated in place
+        time_error: double
+            impact time error (true minus estimated impact time) in seconds
+        lat: double
+            latitude in radians, in [-pi/2, pi/2]
+        lon: double
+            longitude in radians, in [-pi, pi]
+    */
+
+    double rot_speed = CORIOLIS_SPEED * cos(lat);
+    // printf("Impact time error: %f\n", time_error);
+    double coriolis = rot_speed * time_error;
+
+    // based on the coriolis effect, update the final state x and y
+    // This might seem like a bug, but I promise it's just clever
+    // This replicates flying in a random direction, not just along the equator
+    final_state->x = final_state->x - coriolis * sin(lon)*cos(lat);
+    final_state->y = final_state->y + coriolis * cos(lon)*cos(lat);
+    final_state->z = final_state->z + coriolis * sin(lat);
+}
+
+state flight_impact(flight *flight){
+    /*
+    Completes an impacted flight, applying the Coriolis correction of the impact time error to the impact point
+    and recording the final state
+
+    INPUTS:
+    ----------
+        flight: flight *
+            pointer to the flight struct
+    OUTPUTS:
+    ----------
+        final_state: state
+            final state of the vehicle (impact point)
+    */
+
+    state true_final_state = flight->true_impact_state;
+    state est_final_state = flight->est_impact_state;
+
+    // Add coriolis effect based on the latitude and the impact time error
+    double lat = gsl_ran_flat(flight->rng, -M_PI/2, M_PI/2);
+    double lon = gsl_ran_flat(flight->rng, -M_PI, M_PI);
+    double time_error = true_final_state.t - est_final_state.t;
+    apply_coriolis(&true_final_state, time_error, lat, lon);
+    if (flight->run_params->rv_maneuv == 2){
+        // If perfect rv maneuver, update the final position
+        true_final_state.x = true_final_state.x - est_final_state.x;
+        true_final_state.y = true_final_state.y - est_final_state.y;
+        true_final_state.z = true_final_state.z - est_final_state.z;
     }
+    if (flight->recorder != NULL && recorder_sample(flight->recorder, true_final_state.t, TRAJ_EVENT_IMPACT)){
+        // Record the final state
+        double traj_data[TRAJ_NUM_FIELDS];
+        traj_row(traj_data, flight->vehicle->current_mass, &true_final_state, &est_final_state);
+        recorder_step(flight->recorder, traj_data, TRAJ_EVENT_IMPACT);
+    }
+
+    return true_final_state;
+}
+
+state fly(runparams *run_params, state *initial_state, vehicle *vehicle, gsl_rng *rng, traj_recorder *recorder){
+    /*
+    Function that simulates the flight of a vehicle, updating the state of the vehicle at each time step
     
-    printf("Warning: Maximum number of steps reached with no impact\n");
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        initial_state: state *
+            pointer to the initial state of the vehicle
+        vehicle: vehicle *
+            pointer to the vehicle struct
+        rng: gsl_rng *
+            pointer to the random number generator
+        recorder: traj_recorder *
+            pointer to the trajectory recorder for this run (NULL for no trajectory output)
 
-    // Close the trajectory file
-    if (traj_output == 1){
-        fclose(traj_file);
+    OUTPUTS:
+    ----------
+        final_state: state
+            final state of the vehicle (impact point)
+    */
+
+    flight flight;
+    flight_init(&flight, run_params, initial_state, vehicle, rng, recorder);
+
+    // Begin the integration loop
+    for (int i = 0; i < MAX_FLIGHT_STEPS; i++){
+        if (flight_step(&flight)){
+            return flight_impact(&flight);
+        }
     }
+    
+    printf("Warning: Maximum number of steps reached with no impact\n");
 
-    return new_true_state;
+    return flight.new_true_state;
 }
 
 cart_vector update_aimpoint(runparams run_params, double thrust_angle_long){
@@ -410,6 +757,7 @@ cart_vector update_aimpoint(runparams run_params, double thrust_angle_long){
     runparams run_params_temp = run_params;
     // Set output to zero
     run_params_temp.traj_output = 0;
+    run_params_temp.traj_archive = 0;
     run_params_temp.rv_maneuv = 0;
     run_params_temp.gnss_nav = 0;
     run_params_temp.ins_nav = 0;
@@ -449,7 +797,7 @@ cart_vector update_aimpoint(runparams run_params, double thrust_angle_long){
     initial_state.theta_long = thrust_angle_long;
 
     // Call the fly function to get the final state
-    state final_state = fly(&run_params_temp, &initial_state, &vehicle, rng);
+    state final_state = fly(&run_params_temp, &initial_state, &vehicle, rng, NULL);
 
     // Update the aimpoint based on the final state
     aimpoint.x = final_state.x;
@@ -459,9 +807,188 @@ cart_vector update_aimpoint(runparams run_params, double thrust_angle_long){
     return aimpoint;
 }
 
+long expected_traj_rows(runparams *run_params, vehicle *vehicle){
+    /*
+    Estimates the number of trajectory rows recorded for a single flight, used to pre-size trajectory buffers
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        vehicle: vehicle *
+            pointer to the vehicle struct
+    OUTPUTS:
+    ----------
+        expected_rows: long
+            estimated number of rows
+    */
+
+    // Boost at the main time step, then a reentry phase of the order of EXPECTED_REENTRY_TIME
+    double boost_time = vehicle->booster.total_burn_time;
+    long expected_steps = (long)(boost_time / run_params->time_step_main + EXPECTED_REENTRY_TIME / run_params->time_step_reentry);
+    if (run_params->traj_cadence > 0){
+        expected_steps = (long)((boost_time + EXPECTED_REENTRY_TIME) / run_params->traj_cadence);
+    }
+    else if (run_params->traj_decimation > 1){
+        expected_steps /= run_params->traj_decimation;
+    }
+
+    return expected_steps + 16;
+}
+
+state mc_vehicle_run(runparams *run_params, uint64_t seed, int run, const vehicle *profile, traj_recorder *recorder){
+    /*
+    Simulates a single Monte Carlo run of a given vehicle profile, which is copied so that it can be shared
+    between runs (see mc_single_run)
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        seed: uint64_t
+            seed of the Monte Carlo simulation (GSL_RNG_SEED in mc_run)
+        run: int
+            index of the Monte Carlo run
+        profile: const vehicle *
+            pointer to the vehicle profile of the run parameters
+        recorder: traj_recorder *
+            pointer to the trajectory recorder (NULL for no trajectory output)
+    OUTPUTS:
+    ----------
+        final_state: state
+            final state of the vehicle (impact point)
+    */
+
+    gsl_rng *rng = philox_alloc(seed, run, PHILOX_STREAM_RUN);
+    vehicle vehicle = *profile;
+
+    state initial_true_state = init_true_state(run_params, rng);
+
+    if (recorder != NULL){
+        recorder_begin_run(recorder, run);
+    }
+    state final_state = fly(run_params, &initial_true_state, &vehicle, rng, recorder);
+    if (recorder != NULL){
+        recorder_end_run(recorder);
+    }
+
+    gsl_rng_free(rng);
+
+    return final_state;
+}
+
+state mc_single_run(runparams *run_params, uint64_t seed, int run, traj_recorder *recorder){
+    /*
+    Simulates a single Monte Carlo run. Its random numbers come from the Philox sequence keyed by (seed, run),
+    so the run does not depend on any other run and can be re-simulated in isolation
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+        seed: uint64_t
+            seed of the Monte Carlo simulation (GSL_RNG_SEED in mc_run)
+        run: int
+            index of the Monte Carlo run
+        recorder: traj_recorder *
+            pointer to the trajectory recorder (NULL for no trajectory output)
+    OUTPUTS:
+    ----------
+        final_state: state
+            final state of the vehicle (impact point)
+    */
+
+    // Initialize the vehicle
+    vehicle vehicle;
+    if (run_params->rv_type == 0){
+        vehicle = init_mmiii_ballistic();
+    }
+    else if (run_params->rv_type == 1){
+        vehicle = init_mmiii_swerve();
+    }
+    else{
+        printf("Error: Invalid RV type\n");
+        exit(1);
+    }
+
+    return mc_vehicle_run(run_params, seed, run, &vehicle, recorder);
+}
+
+traj_buffer *fly_trajectory(runparams run_params, int run, long expected_rows){
+    /*
+    Flies a single Monte Carlo run and returns its trajectory in memory instead of writing trajectory files
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+        run: int
+            index of the Monte Carlo run to fly, which reproduces that run of mc_run
+        expected_rows: long
+            number of rows to pre-allocate (0 to estimate from the run parameters)
+    OUTPUTS:
+    ----------
+        buffer: traj_buffer *
+            pointer to the recorded trajectory, to be released with traj_buffer_free
+    */
+
+    // The trajectory is only kept in memory
+    run_params.num_runs = 1;
+    run_params.traj_output = 0;
+    run_params.traj_archive = 0;
+
+    // Get the seed of the Monte Carlo simulation
+    gsl_rng_env_setup();
+
+    if (expected_rows <= 0){
+        vehicle vehicle = (run_params.rv_type == 1) ? init_mmiii_swerve() : init_mmiii_ballistic();
+        expected_rows = expected_traj_rows(&run_params, &vehicle);
+    }
+
+    // Record the flight into the buffer
+    traj_recorder recorder;
+    recorder_init(&recorder, &run_params);
+    recorder.buffer = traj_buffer_alloc(expected_rows);
+
+    mc_single_run(&run_params, gsl_rng_default_seed, run, &recorder);
+
+    traj_buffer *buffer = recorder.buffer;
+    recorder_free(&recorder);
+
+    return buffer;
+}
+
+void mc_task(void *context, int index){
+    /*
+    Flies one unrecorded run of a Monte Carlo simulation (pool_task interface)
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the mc_batch struct
+        index: int
+            index of the run in the list of unrecorded runs
+    */
+
+    mc_batch *batch = (mc_batch *)context;
+    int run = batch->runs[index];
+    state impact_state = mc_vehicle_run(batch->run_params, batch->seed, run, batch->profile, NULL);
+
+    // Keep the result on the node of the thread, merged into the impact data after the loop
+    int node = (batch->num_nodes > 1) ? pool_current_node(batch->pool) : 0;
+    int slot = atomic_fetch_add(&batch->node_counts[node], 1);
+    batch->node_results[node][slot].run = run;
+    batch->node_results[node][slot].impact_state = impact_state;
+}
+
 void mc_run(runparams run_params){
     /*
-    Function that runs a Monte Carlo simulation of the vehicle flight
+    Function that runs a Monte Carlo simulation of the vehicle flight. The runs are flown in parallel on
+    run_params.num_threads threads, whose work stealing balances runs of uneven length, and the work of each
+    thread is printed at the end. With run_params.pin_threads, each thread is pinned to a processor, so the
+    state, random number generator and filter workspaces that a run allocates stay on its NUMA node, and the
+    results are gathered per node before they are merged. Runs written to the trajectory file or archive are
+    flown afterwards on the calling thread, in order, so the output does not depend on the number of threads
     
     INPUTS:
     ----------
@@ -493,31 +1020,76 @@ void mc_run(runparams run_params){
     impact_file = fopen(run_params.impact_data_path, "w");
     fprintf(impact_file, "t, x, y, z, vx, vy, vz\n");
     
-    // Initialize the random number generator
-    const gsl_rng_type *T;
-    gsl_rng *rng;
+    // Get the seed of the Monte Carlo simulation, each run draws from its own Philox sequence
     gsl_rng_env_setup();
-    T = gsl_rng_default;
-    rng = gsl_rng_alloc(T);
+    uint64_t seed = gsl_rng_default_seed;
+
+    // Initialize the vehicle profile shared by the runs
+    vehicle vehicle;
+    if (run_params.rv_type == 0){
+        vehicle = init_mmiii_ballistic();
+    }
+    else if (run_params.rv_type == 1){
+        vehicle = init_mmiii_swerve();
+    }
+    else{
+        printf("Error: Invalid RV type\n");
+        exit(1);
+    }
 
-    // Run the Monte Carlo simulation
+    // Fly the unrecorded runs in parallel
+    int *runs = malloc((num_runs > 0 ? num_runs : 1) * sizeof(int));
+    int num_parallel = 0;
     for (int i = 0; i < num_runs; i++){
-        vehicle vehicle;
-        if (run_params.rv_type == 0){
-            vehicle = init_mmiii_ballistic();
+        if (!recorder_records_run(&run_params, i)){
+            runs[num_parallel++] = i;
         }
-        else if (run_params.rv_type == 1){
-            vehicle = init_mmiii_swerve();
+    }
+    worker_pool pool;
+    pool_init_pinned(&pool, run_params.num_threads, run_params.pin_threads);
+
+    // Pinned threads get one result buffer per node. The buffers are not touched before the runs, so each page is
+    // placed on the node that writes it
+    mc_batch batch;
+    batch.run_params = &run_params;
+    batch.seed = seed;
+    batch.profile = &vehicle;
+    batch.runs = runs;
+    batch.pool = &pool;
+    batch.num_nodes = pool.pin_threads ? pool.num_nodes : 1;
+    batch.node_results = malloc(batch.num_nodes * sizeof(mc_result *));
+    batch.node_counts = malloc(batch.num_nodes * sizeof(atomic_int));
+    for (int node = 0; node < batch.num_nodes; node++){
+        batch.node_results[node] = malloc((num_parallel > 0 ? num_parallel : 1) * sizeof(mc_result));
+        atomic_init(&batch.node_counts[node], 0);
+    }
+
+    pool_run(&pool, mc_task, &batch, num_parallel);
+    print_pool_stats(&pool);
+
+    // Merge the results of the nodes
+    for (int node = 0; node < batch.num_nodes; node++){
+        int count = atomic_load(&batch.node_counts[node]);
+        for (int k = 0; k < count; k++){
+            mc_result *result = &batch.node_results[node][k];
+            impact_data.impact_states[result->run] = result->impact_state;
         }
-        else{
-            printf("Error: Invalid RV type\n");
-            exit(1);
+        free(batch.node_results[node]);
+    }
+    free(batch.node_results);
+    free(batch.node_counts);
+    pool_free(&pool);
+    free(runs);
+
+    // Fly the recorded runs in order with the trajectory recorder
+    traj_recorder recorder;
+    recorder_init(&recorder, &run_params);
+    for (int i = 0; i < num_runs; i++){
+        if (recorder_records_run(&run_params, i)){
+            impact_data.impact_states[i] = mc_vehicle_run(&run_params, seed, i, &vehicle, &recorder);
         }
-        state initial_true_state = init_true_state(&run_params, rng);
-        
-        impact_data.impact_states[i] = fly(&run_params, &initial_true_state, &vehicle, rng);
-
     }
+    recorder_free(&recorder);
 
     // Output the impact data
     output_impact(impact_file, &impact_data, num_runs);
@@ -0,0 +1,97 @@
+#ifndef UNSCENTED_H
+#define UNSCENTED_H
+
+#include <math.h>
+#include <stdlib.h>
+#include "lincov.h"
+
+// Define the parameters of the scaled unscented transform (Julier, 2002): alpha sets the spread of the sigma
+// points, beta = 2 matches the kurtosis of Gaussian inputs, and kappa is the secondary scaling
+#define UNSCENTED_ALPHA 1.0
+#define UNSCENTED_BETA 2.0
+#define UNSCENTED_KAPPA 0.0
+
+impact_dispersion unscented_run(runparams run_params){
+    /*
+    Estimates the impact dispersion with the unscented transform. For n active static error sources, 2n + 1
+    deterministic sigma-point trajectories are flown in parallel (the nominal and one up and one down along each
+    source) and the impact mean and covariance are reconstructed from their weighted statistics, which captures
+    the mild nonlinearity that the linear covariance analysis misses. The Coriolis correction is added analytically
+    and sensor noise is left out, as in lincov_run
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            run parameters struct
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            impact dispersion, with the CEP of the Gaussian approximation about the mean impact point
+    */
+
+    // Fly without sensor noise or trajectory output
+    run_params.traj_output = 0;
+    run_params.traj_archive = 0;
+    run_params.gyro_noise = 0;
+    run_params.gnss_noise = 0;
+
+    int sources[NUM_ERROR_SOURCES];
+    int n = active_error_sources(&run_params, sources);
+
+    // Get the sigma point spread and weights
+    double lambda = UNSCENTED_ALPHA * UNSCENTED_ALPHA * (n + UNSCENTED_KAPPA) - n;
+    double spread = sqrt(n + lambda);
+    int num_flights = 2 * n + 1;
+    double *mean_weights = malloc(num_flights * sizeof(double));
+    double *cov_weights = malloc(num_flights * sizeof(double));
+    mean_weights[0] = (n > 0) ? lambda / (n + lambda) : 1;
+    cov_weights[0] = mean_weights[0] + (1 - UNSCENTED_ALPHA * UNSCENTED_ALPHA + UNSCENTED_BETA);
+    for (int i = 1; i < num_flights; i++){
+        mean_weights[i] = 0.5 / (n + lambda);
+        cov_weights[i] = mean_weights[i];
+    }
+
+    // Sigma points along each active source, in standard deviations
+    double *deviates = calloc(num_flights * NUM_ERROR_SOURCES, sizeof(double));
+    for (int k = 0; k < n; k++){
+        deviates[(1 + 2*k) * NUM_ERROR_SOURCES + sources[k]] = spread;
+        deviates[(2 + 2*k) * NUM_ERROR_SOURCES + sources[k]] = -spread;
+    }
+    state *impact_states = malloc(num_flights * sizeof(state));
+    double *time_errors = malloc(num_flights * sizeof(double));
+    fly_deviates_batch(&run_params, deviates, num_flights, impact_states, time_errors);
+
+    // Reconstruct the mean and covariance of the impact point and of the impact time error
+    impact_dispersion dispersion = {0};
+    dispersion.num_flights = num_flights;
+    double mean_time_error = 0;
+    for (int p = 0; p < num_flights; p++){
+        dispersion.mean[0] += mean_weights[p] * impact_states[p].x;
+        dispersion.mean[1] += mean_weights[p] * impact_states[p].y;
+        dispersion.mean[2] += mean_weights[p] * impact_states[p].z;
+        mean_time_error += mean_weights[p] * time_errors[p];
+    }
+
+    double var_time_error = 0;
+    for (int p = 0; p < num_flights; p++){
+        double offset[3] = {impact_states[p].x - dispersion.mean[0], impact_states[p].y - dispersion.mean[1], impact_states[p].z - dispersion.mean[2]};
+        for (int i = 0; i < 3; i++){
+            for (int j = 0; j < 3; j++){
+                dispersion.covariance[i][j] += cov_weights[p] * offset[i] * offset[j];
+            }
+        }
+        var_time_error += cov_weights[p] * (time_errors[p] - mean_time_error) * (time_errors[p] - mean_time_error);
+    }
+
+    dispersion_finish(&dispersion, mean_time_error, var_time_error);
+
+    free(mean_weights);
+    free(cov_weights);
+    free(deviates);
+    free(impact_states);
+    free(time_errors);
+
+    return dispersion;
+}
+
+#endif
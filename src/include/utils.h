@@ -9,10 +9,17 @@ typedef struct runparams{
     char *output_path; // path to the output directory
     char *impact_data_path; // path to the impact data file
     char *trajectory_path; // path to the trajectory data file
+    char *archive_path; // path prefix of the trajectory archive files (.bin data, .idx index)
     int num_runs; // number of Monte Carlo runs
+    int num_threads; // number of worker threads for parallel runs (0: one per online processor)
+    int pin_threads; // flag to pin the Monte Carlo worker threads to processors, spread over the NUMA nodes
     double time_step_main; // time step in seconds during boost and outside the atmosphere
     double time_step_reentry; // time step in seconds during reentry
     int traj_output; // flag to output trajectory data
+    int traj_archive; // archive the trajectory of every k-th run (0: no archive)
+    int traj_decimation; // record every k-th integration step (0 or 1: every step)
+    double traj_cadence; // record at a fixed cadence in seconds, overriding traj_decimation (0: off)
+    double traj_hermite_tol; // position error bound in meters for Hermite knot compression of recorded steps (0: off)
     double x_aim; // target x-coordinate in meters
     double y_aim; // target y-coordinate in meters
     double z_aim; // target z-coordinate in meters
@@ -24,6 +31,10 @@ typedef struct runparams{
     int gnss_nav; // flag to include GNSS navigation
     int ins_nav; // flag to include INS navigation
     int rv_maneuv; // flag to include guidance during the reentry phase
+    double imu_period; // IMU update period in seconds (0: every integration step)
+    double gnss_period; // GNSS update period in seconds (0: every integration step)
+    double guidance_period; // reentry guidance update period in seconds (0: every integration step)
+    double lift_period; // lift force model update period in seconds (0: every integration step)
 
     int rv_type; // reentry vehicle type (0: ballistic, 1: maneuverable)
 
@@ -147,10 +158,17 @@ void print_config(runparams *run_params){
     printf("Output path: %s\n", run_params->output_path);
     printf("Impact data path: %s\n", run_params->impact_data_path);
     printf("Trajectory path: %s\n", run_params->trajectory_path);
+    printf("Trajectory archive path: %s\n", run_params->archive_path);
     printf("Number of Monte Carlo runs: %d\n", run_params->num_runs);
+    printf("Number of threads: %d\n", run_params->num_threads);
+    printf("Pin threads: %d\n", run_params->pin_threads);
     printf("Time step: %f\n", run_params->time_step_main);
     printf("Reentry time step: %f\n", run_params->time_step_reentry);
     printf("Trajectory output: %d\n", run_params->traj_output);
+    printf("Trajectory archive stride: %d\n", run_params->traj_archive);
+    printf("Trajectory decimation: %d\n", run_params->traj_decimation);
+    printf("Trajectory cadence: %f\n", run_params->traj_cadence);
+    printf("Trajectory Hermite tolerance: %f\n", run_params->traj_hermite_tol);
     printf("Target x-coordinate: %f\n", run_params->x_aim);
     printf("Target y-coordinate: %f\n", run_params->y_aim);
     printf("Target z-coordinate: %f\n", run_params->z_aim);
@@ -162,6 +180,10 @@ void print_config(runparams *run_params){
     printf("GNSS navigation: %d\n", run_params->gnss_nav);
     printf("INS navigation: %d\n", run_params->ins_nav);
     printf("Reentry phase guidance: %d\n", run_params->rv_maneuv);
+    printf("IMU period: %f\n", run_params->imu_period);
+    printf("GNSS period: %f\n", run_params->gnss_period);
+    printf("Guidance period: %f\n", run_params->guidance_period);
+    printf("Lift period: %f\n", run_params->lift_period);
 
     printf("Reentry vehicle type: %d\n", run_params->rv_type);
 
@@ -0,0 +1,288 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+// Define the number of trajectory steps held in each output block
+#define TRAJ_BLOCK_SIZE 1024
+
+// Define the number of values written for each trajectory step
+#define TRAJ_NUM_FIELDS 44
+
+// Define the header line of the trajectory file
+#define TRAJ_HEADER "t, current_mass, x, y, z, vx, vy, vz, ax_grav, ay_grav, az_grav, ax_drag, ay_drag, az_drag, ax_lift, ay_lift, az_lift, ax_thrust, ay_thrust, az_thrust, ax_total, ay_total, az_total, est_x, est_y, est_z, est_vx, est_vy, est_vz, est_ax_grav, est_ay_grav, est_az_grav, est_ax_drag, est_ay_drag, est_az_drag, est_ax_lift, est_ay_lift, est_az_lift, est_ax_thrust, est_ay_thrust, est_az_thrust, est_ax_total, est_ay_total, est_az_total \n"
+
+// Define a struct to store a fixed-size block of trajectory steps
+typedef struct traj_block{
+    int num_steps; // number of steps currently stored in the block
+    double steps[TRAJ_BLOCK_SIZE][TRAJ_NUM_FIELDS]; // step data
+} traj_block;
+
+// Define a struct to store an asynchronous trajectory writer
+typedef struct traj_writer{
+    FILE *file; // output file stream, owned by the writer thread once started
+    int binary; // flag to write raw doubles instead of comma-separated text
+    traj_block *blocks; // two blocks, one filled by fly() while the other is written
+    atomic_long head; // number of blocks published by the producer
+    atomic_long tail; // number of blocks written out by the consumer
+    atomic_int done; // flag set by the producer when no more blocks will be published
+    pthread_t thread; // background writer thread
+    int fill; // number of steps in the block currently being filled by the producer
+    long num_rows; // number of rows pushed by the producer
+} traj_writer;
+
+int format_traj_value(char *buffer, double value){
+    /*
+    Formats a value exactly as printf's "%f" would, using integer arithmetic on the common path
+
+    INPUTS:
+    ----------
+        buffer: char *
+            pointer to a buffer with room for at least 32 characters
+        value: double
+            value to be formatted
+
+    OUTPUTS:
+    ----------
+        length: int
+            number of characters written, excluding the terminating null
+    */
+
+    double scaled = value * 1e6;
+    double rounded = nearbyint(scaled);
+
+    // Below 1e13 the product is within 0.001 of the exact decimal value, so only values near a rounding tie
+    // (and large or non-finite values) need printf
+    if (!(fabs(scaled) < 1e13) || fabs(scaled - rounded) > 0.49){
+        return sprintf(buffer, "%f", value);
+    }
+
+    long long digits = llabs((long long)rounded);
+    char reversed[24];
+    int num_digits = 0;
+    while (digits > 0 || num_digits < 7){
+        reversed[num_digits++] = '0' + digits % 10;
+        digits /= 10;
+    }
+
+    int length = 0;
+    if (signbit(value)){
+        buffer[length++] = '-';
+    }
+    while (num_digits > 6){
+        buffer[length++] = reversed[--num_digits];
+    }
+    buffer[length++] = '.';
+    while (num_digits > 0){
+        buffer[length++] = reversed[--num_digits];
+    }
+    buffer[length] = '\0';
+
+    return length;
+}
+
+void write_traj_block(FILE *file, traj_block *block){
+    /*
+    Formats a block of trajectory steps as comma-separated text
+
+    INPUTS:
+    ----------
+        file: FILE *
+            pointer to the output file stream
+        block: traj_block *
+            pointer to the block to be written
+    */
+
+    char line[TRAJ_NUM_FIELDS * 34 + 2];
+
+    for (int i = 0; i < block->num_steps; i++){
+        int length = 0;
+        for (int j = 0; j < TRAJ_NUM_FIELDS; j++){
+            if (j > 0){
+                line[length++] = ',';
+                line[length++] = ' ';
+            }
+            length += format_traj_value(line + length, block->steps[i][j]);
+        }
+        line[length++] = '\n';
+        fwrite(line, 1, length, file);
+    }
+}
+
+void *traj_writer_thread(void *arg){
+    /*
+    Background thread that drains published blocks to the output file
+
+    INPUTS:
+    ----------
+        arg: void *
+            pointer to the trajectory writer
+    */
+
+    traj_writer *writer = (traj_writer *)arg;
+    struct timespec idle = {0, 100000};
+
+    while (1){
+        long tail = atomic_load_explicit(&writer->tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&writer->head, memory_order_acquire)){
+            // Exit once the producer has finished and every block has been written
+            if (atomic_load_explicit(&writer->done, memory_order_acquire) && tail == atomic_load_explicit(&writer->head, memory_order_acquire)){
+                break;
+            }
+            nanosleep(&idle, NULL);
+            continue;
+        }
+
+        traj_block *block = &writer->blocks[tail % 2];
+        if (writer->binary == 1){
+            fwrite(block->steps, sizeof(double) * TRAJ_NUM_FIELDS, block->num_steps, writer->file);
+        }
+        else{
+            write_traj_block(writer->file, block);
+        }
+
+        // Hand the block back to the producer
+        atomic_store_explicit(&writer->tail, tail + 1, memory_order_release);
+    }
+
+    return NULL;
+}
+
+traj_writer *traj_writer_start(FILE *file, int binary){
+    /*
+    Starts a background writer thread on an open file stream
+
+    INPUTS:
+    ----------
+        file: FILE *
+            pointer to the output file stream, which is closed by traj_writer_close
+        binary: int
+            flag to write raw doubles (1) or comma-separated text (0)
+
+    OUTPUTS:
+    ----------
+        writer: traj_writer *
+            pointer to the trajectory writer
+    */
+
+    traj_writer *writer = (traj_writer *)malloc(sizeof(traj_writer));
+    writer->file = file;
+    writer->binary = binary;
+    writer->blocks = (traj_block *)malloc(2 * sizeof(traj_block));
+    atomic_init(&writer->head, 0);
+    atomic_init(&writer->tail, 0);
+    atomic_init(&writer->done, 0);
+    writer->fill = 0;
+    writer->num_rows = 0;
+
+    pthread_create(&writer->thread, NULL, traj_writer_thread, writer);
+
+    return writer;
+}
+
+traj_writer *traj_writer_open(char *path, char *header){
+    /*
+    Opens a text trajectory file and starts the background writer thread
+
+    INPUTS:
+    ----------
+        path: char *
+            path to the trajectory file
+        header: char *
+            header line written at the top of the file
+
+    OUTPUTS:
+    ----------
+        writer: traj_writer *
+            pointer to the trajectory writer, or NULL if the file could not be opened
+    */
+
+    FILE *file = fopen(path, "w");
+    if (file == NULL){
+        printf("Error: Could not open trajectory file %s\n", path);
+        return NULL;
+    }
+    fprintf(file, "%s", header);
+
+    return traj_writer_start(file, 0);
+}
+
+void traj_writer_publish(traj_writer *writer){
+    /*
+    Publishes the block currently being filled to the writer thread
+
+    INPUTS:
+    ----------
+        writer: traj_writer *
+            pointer to the trajectory writer
+    */
+
+    long head = atomic_load_explicit(&writer->head, memory_order_relaxed);
+    writer->blocks[head % 2].num_steps = writer->fill;
+    writer->fill = 0;
+    atomic_store_explicit(&writer->head, head + 1, memory_order_release);
+}
+
+void traj_writer_push(traj_writer *writer, double *row){
+    /*
+    Copies one trajectory step into the current block, publishing the block when it is full
+
+    INPUTS:
+    ----------
+        writer: traj_writer *
+            pointer to the trajectory writer
+        row: double *
+            array of TRAJ_NUM_FIELDS values for the step
+    */
+
+    long head = atomic_load_explicit(&writer->head, memory_order_relaxed);
+    traj_block *block = &writer->blocks[head % 2];
+
+    if (writer->fill == 0){
+        // Both blocks are in flight only if the writer thread has fallen a full block behind
+        while (head - atomic_load_explicit(&writer->tail, memory_order_acquire) >= 2){
+            sched_yield();
+        }
+    }
+
+    double *step = block->steps[writer->fill];
+    for (int j = 0; j < TRAJ_NUM_FIELDS; j++){
+        step[j] = row[j];
+    }
+    writer->fill += 1;
+    writer->num_rows += 1;
+
+    if (writer->fill == TRAJ_BLOCK_SIZE){
+        traj_writer_publish(writer);
+    }
+}
+
+void traj_writer_close(traj_writer *writer){
+    /*
+    Flushes any partially filled block, stops the writer thread, and closes the file
+
+    INPUTS:
+    ----------
+        writer: traj_writer *
+            pointer to the trajectory writer
+    */
+
+    if (writer->fill > 0){
+        traj_writer_publish(writer);
+    }
+
+    atomic_store_explicit(&writer->done, 1, memory_order_release);
+    pthread_join(writer->thread, NULL);
+
+    fclose(writer->file);
+    free(writer->blocks);
+    free(writer);
+}
+
+#endif
@@ -3,4 +3,13 @@
 #include "include/gravity.h"
 #include "include/atmosphere.h"
 #include "include/physics.h"
-#include "include/trajectory.h"
\ No newline at end of file
+#include "include/trajectory.h"
+#include "include/lincov.h"
+#include "include/unscented.h"
+#include "include/sobol.h"
+#include "include/mlmc.h"
+#include "include/fork.h"
+#include "include/ensemble.h"
+#include "include/importance.h"
+#include "include/surrogate.h"
+#include "include/batch.h"
\ No newline at end of file
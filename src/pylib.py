@@ -13,10 +13,17 @@ class runparams(Structure):
         ("output_path", c_char_p),
         ("impact_data_path", c_char_p),
         ("trajectory_path", c_char_p),
+        ("archive_path", c_char_p),
         ("num_runs", c_int),
+        ("num_threads", c_int),
+        ("pin_threads", c_int),
         ("time_step_main", c_double),
         ("time_step_reentry", c_double),
         ("traj_output", c_int),
+        ("traj_archive", c_int),
+        ("traj_decimation", c_int),
+        ("traj_cadence", c_double),
+        ("traj_hermite_tol", c_double),
         ("x_aim", c_double),
         ("y_aim", c_double),
         ("z_aim", c_double),
@@ -28,6 +35,10 @@ class runparams(Structure):
         ("gnss_nav", c_int),
         ("ins_nav", c_int),
         ("rv_maneuv", c_int),
+        ("imu_period", c_double),
+        ("gnss_period", c_double),
+        ("guidance_period", c_double),
+        ("lift_period", c_double),
 
         ("rv_type", c_int), # 0 for ballistic, 1 for maneuverable
 
@@ -41,12 +52,133 @@ class runparams(Structure):
         ("gnss_noise", c_double),
     ]
 
+class traj_buffer(Structure):
+    _fields_ = [
+        ("rows", POINTER(c_double)),
+        ("num_rows", c_long),
+        ("capacity", c_long),
+    ]
+
 class cart_vector(Structure):
     _fields_ = [
         ("x", c_double),
         ("y", c_double),
         ("z", c_double),
     ]
+
+class impact_dispersion(Structure):
+    _fields_ = [
+        ("mean", c_double * 3),
+        ("covariance", (c_double * 3) * 3),
+        ("local_covariance", (c_double * 2) * 2),
+        ("cep", c_double),
+        ("num_flights", c_int),
+    ]
+
+# Number of static error sources (NUM_ERROR_SOURCES in lincov.h)
+NUM_ERROR_SOURCES = 32
+
+class impact_jacobian(Structure):
+    _fields_ = [
+        ("impact", c_double * 3),
+        ("time_error", c_double),
+        ("jacobian", (c_double * NUM_ERROR_SOURCES) * 3),
+        ("time_jacobian", c_double * NUM_ERROR_SOURCES),
+        ("curvature", (c_double * NUM_ERROR_SOURCES) * 3),
+        ("time_curvature", c_double * NUM_ERROR_SOURCES),
+        ("num_flights", c_int),
+    ]
+
+# Maximum number of terms of the quadratic response surface (SURROGATE_MAX_TERMS in surrogate.h)
+SURROGATE_MAX_TERMS = 1 + 2*NUM_ERROR_SOURCES + NUM_ERROR_SOURCES*(NUM_ERROR_SOURCES - 1)//2
+
+class response_surface(Structure):
+    _fields_ = [
+        ("sources", c_int * NUM_ERROR_SOURCES),
+        ("num_sources", c_int),
+        ("num_terms", c_int),
+        ("nominal", c_double * 3),
+        ("nominal_time_error", c_double),
+        ("coefficients", (c_double * SURROGATE_MAX_TERMS) * 4),
+        ("design_scale", c_double),
+        ("num_design", c_int),
+        ("num_validation", c_int),
+        ("validation_rms", c_double * 2),
+        ("validation_spread", c_double * 2),
+        ("seed", c_uint64),
+    ]
+
+# Maximum number of levels of the multilevel Monte Carlo (MLMC_MAX_LEVELS in mlmc.h)
+MLMC_MAX_LEVELS = 8
+
+class mlmc_estimate(Structure):
+    _fields_ = [
+        ("dispersion", impact_dispersion),
+        ("mean_miss", c_double),
+        ("mean_error", c_double),
+        ("miss_error", c_double),
+        ("num_levels", c_int),
+        ("time_steps", c_double * MLMC_MAX_LEVELS),
+        ("num_samples", c_int * MLMC_MAX_LEVELS),
+        ("variances", c_double * MLMC_MAX_LEVELS),
+        ("costs", c_double * MLMC_MAX_LEVELS),
+        ("total_steps", c_double),
+        ("mc_steps", c_double),
+    ]
+
+class fork_estimate(Structure):
+    _fields_ = [
+        ("dispersion", impact_dispersion),
+        ("num_prefixes", c_int),
+        ("num_forks", c_int),
+        ("prefix_steps", c_double),
+        ("fork_steps", c_double),
+        ("speedup", c_double),
+    ]
+
+class importance_estimate(Structure):
+    _fields_ = [
+        ("mean", c_double * 3),
+        ("r50", c_double),
+        ("r90", c_double),
+        ("r99", c_double),
+        ("exceedance_radius", c_double),
+        ("exceedance_probability", c_double),
+        ("exceedance_error", c_double),
+        ("effective_samples", c_double),
+        ("scale", c_double),
+        ("num_directions", c_int),
+        ("num_flights", c_int),
+    ]
+
+class batch_stats(Structure):
+    _fields_ = [
+        ("num_scenarios", c_int),
+        ("num_runs", c_int),
+        ("num_nominals", c_int),
+        ("num_vehicles", c_int),
+        ("num_threads", c_int),
+        ("wall_time", c_double),
+        ("busy_time", c_double),
+        ("utilization", c_double),
+    ]
+
+# Factors and outputs of the Sobol sensitivity analysis (sobol.h)
+SOBOL_FACTORS = ["initial_x_error", "initial_pos_error", "initial_vel_error", "initial_angle_error", "acc_scale_stability",
+                 "gyro_bias_stability", "grav_error", "atm_error", "gyro_noise/gnss_noise", "coriolis"]
+SOBOL_OUTPUTS = ["east", "north", "miss"]
+
+class sobol_indices(Structure):
+    _fields_ = [
+        ("first_order", (c_double * len(SOBOL_FACTORS)) * len(SOBOL_OUTPUTS)),
+        ("first_order_ci", ((c_double * 2) * len(SOBOL_FACTORS)) * len(SOBOL_OUTPUTS)),
+        ("total", (c_double * len(SOBOL_FACTORS)) * len(SOBOL_OUTPUTS)),
+        ("total_ci", ((c_double * 2) * len(SOBOL_FACTORS)) * len(SOBOL_OUTPUTS)),
+        ("variance", c_double * len(SOBOL_OUTPUTS)),
+        ("active", c_int * len(SOBOL_FACTORS)),
+        ("num_samples", c_int),
+        ("num_flights", c_int),
+    ]
     
 def read_config(run_name):
     """
@@ -78,11 +210,18 @@ def read_config(run_name):
     run_params.output_path = c_char_p(config['RUN']['output_path'].encode('utf-8'))
     run_params.impact_data_path = run_params.output_path + b"/" + run_params.run_name + b"/impact_data.txt"
     run_params.trajectory_path = run_params.output_path + b"/" + run_params.run_name + b"/trajectory.txt"
+    run_params.archive_path = run_params.output_path + b"/" + run_params.run_name + b"/trajectory_archive"
 
     run_params.num_runs = c_int(int(config['RUN']['num_runs']))
+    run_params.num_threads = c_int(int(config['RUN']['num_threads']))
+    run_params.pin_threads = c_int(int(config['RUN']['pin_threads']))
     run_params.time_step_main = c_double(float(config['RUN']['time_step_main']))
     run_params.time_step_reentry = c_double(float(config['RUN']['time_step_reentry']))
     run_params.traj_output = c_int(int(config['RUN']['traj_output']))
+    run_params.traj_archive = c_int(int(config['RUN']['traj_archive']))
+    run_params.traj_decimation = c_int(int(config['RUN']['traj_decimation']))
+    run_params.traj_cadence = c_double(float(config['RUN']['traj_cadence']))
+    run_params.traj_hermite_tol = c_double(float(config['RUN']['traj_hermite_tol']))
     run_params.x_aim = c_double(float(config['RUN']['x_aim']))
     run_params.y_aim = c_double(float(config['RUN']['y_aim']))
     run_params.z_aim = c_double(float(config['RUN']['z_aim']))
@@ -95,6 +234,10 @@ def read_config(run_name):
     run_params.gnss_nav = c_int(int(config['FLIGHT']['gnss_nav']))
     run_params.ins_nav = c_int(int(config['FLIGHT']['ins_nav']))
     run_params.rv_maneuv = c_int(int(config['FLIGHT']['rv_maneuv']))
+    run_params.imu_period = c_double(float(config['FLIGHT']['imu_period']))
+    run_params.gnss_period = c_double(float(config['FLIGHT']['gnss_period']))
+    run_params.guidance_period = c_double(float(config['FLIGHT']['guidance_period']))
+    run_params.lift_period = c_double(float(config['FLIGHT']['lift_period']))
 
     # set the vehicle parameters
     run_params.rv_type = c_int(int(config['VEHICLE']['rv_type']))
@@ -111,6 +254,106 @@ def read_config(run_name):
 
     return run_params
 
+def load_trajectory(run_params, run_id):
+    """
+    Function to load the trajectory of a single run from the trajectory archive.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+        run_id: int
+            The index of the Monte Carlo run.
+    OUTPUTS:
+    ----------
+        trajectory: numpy.ndarray
+            The trajectory data with one row per step, in the column order of trajectory.txt,
+            or None if the run was not archived.
+    """
+    archive_path = run_params.archive_path.decode('utf-8')
+
+    # The first index entry holds the archive stride and the number of fields per row
+    header = np.fromfile(archive_path + ".idx", dtype=np.int64, count=3)
+    stride, num_fields = header[1], header[2]
+    if stride <= 0 or run_id % stride != 0:
+        return None
+
+    # Each archived run owns a fixed slot in the index, so only its entry is read
+    entry = np.fromfile(archive_path + ".idx", dtype=np.int64, count=3, offset=(1 + run_id // stride) * 24)
+    if len(entry) < 3:
+        return None
+    entry_run_id, offset, num_rows = entry
+    if entry_run_id != run_id or num_rows <= 0:
+        return None
+
+    trajectory = np.fromfile(archive_path + ".bin", dtype=np.float64, count=num_rows*num_fields, offset=offset*num_fields*8)
+
+    return trajectory.reshape(num_rows, num_fields)
+
+def fly_trajectory(run_params, run=0, expected_rows=0):
+    """
+    Function to fly a single trajectory and view it as a numpy array without writing or copying it.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+        run: int
+            The index of the Monte Carlo run to fly, which reproduces that run of mc_run for the same GSL_RNG_SEED.
+        expected_rows: int
+            The number of rows to pre-allocate (0 to estimate from the run parameters).
+    OUTPUTS:
+    ----------
+        buffer: POINTER(traj_buffer)
+            The C trajectory buffer, which must be released with release_trajectory.
+        trajectory: numpy.ndarray
+            A view of the trajectory with one row per recorded step, in the column order of trajectory.txt.
+            The view is only valid until the buffer is released.
+    """
+    pytraj.fly_trajectory.restype = POINTER(traj_buffer)
+    buffer = pytraj.fly_trajectory(run_params, c_int(run), c_long(expected_rows))
+
+    # Wrap the C rows in a numpy array through the buffer protocol, without copying
+    num_rows = buffer.contents.num_rows
+    trajectory = np.ctypeslib.as_array(buffer.contents.rows, shape=(num_rows, 44))
+
+    return buffer, trajectory
+
+def release_trajectory(buffer):
+    """
+    Function to release a trajectory buffer returned by fly_trajectory.
+
+    INPUTS:
+    ----------
+        buffer: POINTER(traj_buffer)
+            The C trajectory buffer.
+    """
+    pytraj.traj_buffer_free(buffer)
+
+def eval_trajectory(knots, times):
+    """
+    Function to evaluate a Hermite-compressed trajectory at arbitrary times.
+
+    INPUTS:
+    ----------
+        knots: numpy.ndarray
+            The trajectory knots, e.g. from load_trajectory with traj_hermite_tol > 0.
+        times: numpy.ndarray
+            The times at which to evaluate the trajectory.
+    OUTPUTS:
+    ----------
+        trajectory: numpy.ndarray
+            The reconstructed trajectory with one row per time, in the column order of trajectory.txt.
+    """
+    knots = np.ascontiguousarray(knots, dtype=np.float64)
+    times = np.atleast_1d(np.asarray(times, dtype=np.float64))
+    trajectory = np.empty((len(times), knots.shape[1]))
+
+    for i, t in enumerate(times):
+        pytraj.hermite_eval(knots.ctypes.data_as(POINTER(c_double)), c_int(len(knots)), c_double(t), trajectory[i].ctypes.data_as(POINTER(c_double)))
+
+    return trajectory
+
 def get_cep(impact_data, run_params):
     """
     Function to calculate the circular error probable (CEP) from the impact data.
@@ -149,6 +392,431 @@ def get_cep(impact_data, run_params):
 
     return cep
 
+def get_weighted_percentile(impact_data, run_params, percentile):
+    """
+    Function to calculate a percentile of the miss distance from the aimpoint from weighted impact data, as written
+    by importance_run (the weight is the last column).
+
+    INPUTS:
+    ----------
+        impact_data: numpy.ndarray
+            The impact data with a weight column.
+        run_params: runparams
+            The run parameters.
+        percentile: double
+            The percentile (50 for the CEP).
+    OUTPUTS:
+    ----------
+        miss_percentile: double
+            The weighted percentile of the miss distance.
+    """
+    # get longitude and latitude of aimpoint
+    aimpoint_lon = np.arctan2(run_params.y_aim, run_params.x_aim)
+    aimpoint_lat = np.arctan2(run_params.z_aim, np.sqrt(run_params.x_aim**2 + run_params.y_aim**2))
+
+    # get vector relative to aimpoint
+    impact_x = impact_data[:,1] - run_params.x_aim
+    impact_y = impact_data[:,2] - run_params.y_aim
+    impact_z = impact_data[:,3] - run_params.z_aim
+    weights = impact_data[:,-1]
+
+    # convert impact data to local tangent plane coordinates
+    impact_x_local = -np.sin(aimpoint_lon)*impact_x + np.cos(aimpoint_lon)*impact_y
+    impact_y_local = -np.sin(aimpoint_lat)*np.cos(aimpoint_lon)*impact_x - np.sin(aimpoint_lat)*np.sin(aimpoint_lon)*impact_y + np.cos(aimpoint_lat)*impact_z
+
+    # get the smallest miss distance at which the normalized cumulative weight reaches the percentile
+    miss_distance = np.sqrt(impact_x_local**2 + impact_y_local**2)
+    order = np.argsort(miss_distance)
+    cumulative_weight = np.cumsum(weights[order]) / np.sum(weights)
+    index = min(np.searchsorted(cumulative_weight, percentile / 100), len(order) - 1)
+
+    return miss_distance[order[index]]
+
+def lincov_run(run_params):
+    """
+    Function to estimate the impact dispersion by linear covariance analysis, from the sensitivities of the impact
+    point to each static error source along the nominal trajectory. Sensor noise (gyro_noise, gnss_noise) is left out.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            The mean impact point, the impact covariance (ECEF and local east-north), and the CEP about the mean
+            impact point.
+    """
+    pytraj.lincov_run.restype = impact_dispersion
+
+    return pytraj.lincov_run(run_params)
+
+def unscented_run(run_params):
+    """
+    Function to estimate the impact dispersion with the unscented transform, from 2n + 1 sigma-point trajectories
+    flown in parallel for n active static error sources. Sensor noise (gyro_noise, gnss_noise) is left out.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            The mean impact point, the impact covariance (ECEF and local east-north), and the CEP about the mean
+            impact point.
+    """
+    pytraj.unscented_run.restype = impact_dispersion
+
+    return pytraj.unscented_run(run_params)
+
+def error_source_sigmas(run_params):
+    """
+    Function to get the standard deviations of the static error sources in their physical units (zero for inactive
+    sources), in the order of the error source indices of lincov.h.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+    OUTPUTS:
+    ----------
+        sigmas: np.ndarray
+            The NUM_ERROR_SOURCES standard deviations.
+    """
+    sigmas = (c_double * NUM_ERROR_SOURCES)()
+    pytraj.error_source_sigmas(byref(run_params), sigmas)
+
+    return np.array(sigmas)
+
+def fly_jacobian(run_params):
+    """
+    Function to linearize the impact point about the nominal trajectory with central differences in each active
+    static error source, from 2n + 1 trajectories flown in parallel. Sensor noise (gyro_noise, gnss_noise) is left out.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+    OUTPUTS:
+    ----------
+        jacobian: impact_jacobian
+            The nominal impact point and impact time error, and their first and second derivatives per unit of each
+            error source (zero for inactive sources).
+    """
+    pytraj.fly_jacobian.restype = impact_jacobian
+
+    return pytraj.fly_jacobian(byref(run_params))
+
+def jacobian_dispersion(jacobian, sigmas):
+    """
+    Function to map standard deviations of the static error sources through an impact Jacobian. Sweeping the
+    standard deviations only needs this product, not new trajectories.
+
+    INPUTS:
+    ----------
+        jacobian: impact_jacobian
+            The impact Jacobian returned by fly_jacobian.
+        sigmas: array_like
+            The NUM_ERROR_SOURCES standard deviations (see error_source_sigmas).
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            The mean impact point, the impact covariance (ECEF and local east-north), and the CEP about the mean
+            impact point.
+    """
+    pytraj.jacobian_dispersion.restype = impact_dispersion
+    sigmas = (c_double * NUM_ERROR_SOURCES)(*sigmas)
+
+    return pytraj.jacobian_dispersion(byref(jacobian), sigmas)
+
+def sobol_run(run_params, num_samples):
+    """
+    Function to estimate the first-order and total Sobol indices of the impact point for each error field of the run
+    parameters (SOBOL_FACTORS), from (n + 2) * num_samples trajectories flown in parallel for n active factors.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+        num_samples: int
+            The number of rows of the two sample matrices.
+    OUTPUTS:
+    ----------
+        indices: sobol_indices
+            The first-order and total indices of the east and north impact components and of the miss distance
+            (SOBOL_OUTPUTS), with bootstrap 95% confidence intervals.
+    """
+    pytraj.sobol_run.restype = sobol_indices
+
+    return pytraj.sobol_run(run_params, c_int(num_samples))
+
+def print_sobol_indices(indices):
+    """
+    Function to print the Sobol indices of the active factors with their confidence intervals.
+
+    INPUTS:
+    ----------
+        indices: sobol_indices
+            The Sobol indices returned by sobol_run.
+    """
+    pytraj.print_sobol_indices(byref(indices))
+
+def mlmc_run(run_params, num_levels, tolerance):
+    """
+    Function to estimate the impact dispersion and the mean miss distance at the reentry time step of the run
+    parameters by multilevel Monte Carlo over coarser reentry time steps (each level doubles the step).
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+        num_levels: int
+            The number of levels, from 1 (single-level Monte Carlo) to MLMC_MAX_LEVELS.
+        tolerance: float
+            The requested root mean square statistical error of the mean impact point in meters.
+    OUTPUTS:
+    ----------
+        estimate: mlmc_estimate
+            The impact dispersion, the mean miss distance from the aimpoint with their statistical errors, and the
+            samples, correction variances and costs of the levels.
+    """
+    pytraj.mlmc_run.restype = mlmc_estimate
+
+    return pytraj.mlmc_run(run_params, c_int(num_levels), c_double(tolerance))
+
+def print_mlmc_estimate(estimate):
+    """
+    Function to print a multilevel Monte Carlo estimate and its levels.
+
+    INPUTS:
+    ----------
+        estimate: mlmc_estimate
+            The estimate returned by mlmc_run.
+    """
+    pytraj.print_mlmc_estimate(byref(estimate))
+
+def fork_run(run_params, num_prefixes, num_forks):
+    """
+    Function to run a forked Monte Carlo campaign: num_prefixes flights are flown from launch to the entry interface
+    and each is continued num_forks times with new target-area atmospheric perturbations, sensor noise and Coriolis
+    orientation.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+        num_prefixes: int
+            The number of prefixes.
+        num_forks: int
+            The number of forks per prefix.
+    OUTPUTS:
+    ----------
+        estimate: fork_estimate
+            The sample impact dispersion of the num_prefixes * num_forks runs, the integration steps per prefix and
+            per fork, and the speedup over unforked runs.
+    """
+    pytraj.fork_run.restype = fork_estimate
+
+    return pytraj.fork_run(run_params, c_int(num_prefixes), c_int(num_forks))
+
+def ensemble_save(run_params, path):
+    """
+    Function to fly the boost phase of the num_runs Monte Carlo runs and save the post-burnout ensemble (flight states,
+    IMU errors, vehicle mass and random number generator states) to a binary file.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+        path: str
+            The path of the ensemble file.
+    OUTPUTS:
+    ----------
+        num_runs: int
+            The number of runs saved, -1 if the file could not be written.
+    """
+    pytraj.ensemble_save.restype = c_int
+
+    return pytraj.ensemble_save(run_params, c_char_p(path.encode('utf-8')))
+
+def ensemble_replay(run_params, path):
+    """
+    Function to replay the reentry of a post-burnout ensemble saved by ensemble_save, with the reentry-side settings
+    (rv_type, rv_maneuv, atm_error, guidance_period, lift_period and the aimpoint) of run_params.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters, with the boost-side settings and reentry time step of the saved campaign.
+        path: str
+            The path of the ensemble file.
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            The sample impact dispersion of the replayed runs (num_flights is 0 if the ensemble could not be replayed).
+    """
+    pytraj.ensemble_replay.restype = impact_dispersion
+
+    return pytraj.ensemble_replay(run_params, c_char_p(path.encode('utf-8')))
+
+def importance_run(run_params, scale, exceedance_radius):
+    """
+    Function to estimate the tail of the miss distance distribution by importance sampling: the static errors are
+    drawn with their components along the impact directions scaled by scale, and each run is weighted by its
+    likelihood ratio.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+        scale: double
+            The standard deviation of the sampling distribution along the impact directions, in nominal standard
+            deviations (1 for plain Monte Carlo, 2 to 3 for R99).
+        exceedance_radius: double
+            The miss radius of the exceedance probability in meters.
+    OUTPUTS:
+    ----------
+        estimate: importance_estimate
+            The weighted mean impact point, the weighted R50, R90 and R99 miss distances from it, the probability of
+            exceeding exceedance_radius with its standard error, and the effective sample size.
+    """
+    pytraj.importance_run.restype = importance_estimate
+
+    return pytraj.importance_run(run_params, c_double(scale), c_double(exceedance_radius))
+
+def print_importance_estimate(estimate):
+    """
+    Function to print the tail metrics of an importance-sampled campaign.
+
+    INPUTS:
+    ----------
+        estimate: importance_estimate
+            The estimate returned by importance_run.
+    """
+    pytraj.print_importance_estimate(byref(estimate))
+
+def surrogate_fit(run_params, num_design, num_validation, design_scale):
+    """
+    Function to fit a quadratic response surface of the impact point over the static error sources from a design of
+    Monte Carlo runs, with its error measured on held-out runs.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+        num_design: int
+            The number of design runs, at least the number of terms 1 + 2n + n(n - 1)/2 for n active sources.
+        num_validation: int
+            The number of held-out validation runs.
+        design_scale: double
+            The standard deviation of the design deviates, in nominal standard deviations (the multiplier of the
+            sweep points to be evaluated).
+    OUTPUTS:
+    ----------
+        surrogate: response_surface
+            The fitted response surface, with the held-out RMS east and north errors (num_terms is 0 if it could not
+            be fitted).
+    """
+    pytraj.surrogate_fit.restype = response_surface
+
+    return pytraj.surrogate_fit(run_params, c_int(num_design), c_int(num_validation), c_double(design_scale))
+
+def surrogate_dispersion(surrogate, multipliers, num_samples):
+    """
+    Function to estimate the impact dispersion from samples of a response surface, with the error fields scaled by
+    multipliers.
+
+    INPUTS:
+    ----------
+        surrogate: response_surface
+            The surface returned by surrogate_fit.
+        multipliers: dict
+            The multiplier of each error field, by name (initial_x_error to atm_error, see SOBOL_FACTORS); fields
+            that are left out keep a multiplier of 1.
+        num_samples: int
+            The number of samples of the surface.
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            The sample impact dispersion, with the median miss distance from the mean impact point as the CEP.
+    """
+    fields = SOBOL_FACTORS[:SOBOL_FACTORS.index("gyro_noise/gnss_noise")]
+    values = (c_double * len(fields))(*[multipliers.get(field, 1.0) for field in fields])
+    pytraj.surrogate_dispersion.restype = impact_dispersion
+
+    return pytraj.surrogate_dispersion(byref(surrogate), values, c_int(num_samples))
+
+def print_response_surface(surrogate):
+    """
+    Function to print the size of a response surface and its held-out validation error.
+
+    INPUTS:
+    ----------
+        surrogate: response_surface
+            The surface returned by surrogate_fit.
+    """
+    pytraj.print_response_surface(byref(surrogate))
+
+def batch_run(scenarios, num_threads=0):
+    """
+    Function to run the Monte Carlo simulations of several scenarios on one worker pool, sharing the nominal
+    trajectories and vehicle profiles of the scenarios that share them. Each scenario gets the aimpoint of
+    update_aimpoint and writes the impact data of mc_run (no trajectory output).
+
+    INPUTS:
+    ----------
+        scenarios: list of runparams
+            The run parameters of each scenario, whose aimpoints are updated.
+        num_threads: int
+            The number of threads of the pool (0 for one per online processor).
+    OUTPUTS:
+    ----------
+        stats: batch_stats
+            The numbers of runs, nominal trajectories and vehicle profiles, and the utilization of the threads.
+    """
+    array = (runparams * len(scenarios))(*scenarios)
+    pytraj.batch_run.restype = batch_stats
+
+    stats = pytraj.batch_run(array, c_int(len(scenarios)), c_int(num_threads))
+    for run_params, updated in zip(scenarios, array):
+        run_params.x_aim = updated.x_aim
+        run_params.y_aim = updated.y_aim
+        run_params.z_aim = updated.z_aim
+
+    return stats
+
+def print_batch_stats(stats):
+    """
+    Function to print the statistics of a batch of scenarios.
+
+    INPUTS:
+    ----------
+        stats: batch_stats
+            The statistics returned by batch_run.
+    """
+    pytraj.print_batch_stats(byref(stats))
+
+def mc_dispersion(run_params, num_runs):
+    """
+    Function to estimate the impact dispersion from Monte Carlo runs, to cross-check lincov_run.
+
+    INPUTS:
+    ----------
+        run_params: runparams
+            The run parameters.
+        num_runs: int
+            The number of Monte Carlo runs.
+    OUTPUTS:
+    ----------
+        dispersion: impact_dispersion
+            The sample mean impact point, the sample impact covariance (ECEF and local east-north), and the median
+            miss distance from the mean impact point.
+    """
+    pytraj.mc_dispersion.restype = impact_dispersion
+
+    return pytraj.mc_dispersion(run_params, c_int(num_runs))
+
 def update_aimpoint(run_params, config_path):
     """
     Function to update the aimpoint based on the current run parameters.
@@ -0,0 +1,72 @@
+import sys
+import os
+import time
+import platform
+from ctypes import *
+import pandas as pd
+
+# Specify the input file name (without the extension), run_0 by default
+config_file = sys.argv[1] if len(sys.argv) > 1 else "run_0"
+
+# Check for the existence of the input file
+config_path = f"./input/{config_file}.toml"
+if not os.path.isfile(config_path):
+    print(f"Error: The input file {config_file}.toml does not exist.")
+    sys.exit()
+
+# Import the necessary functions from the Python library
+sys.path.append('.')
+from src.pylib import *
+so_file = "./build/libPyTraj.so"
+pytraj = CDLL(so_file)
+
+# Code block to measure the scaling of mc_run from one thread to all processors, with and without pinning
+if __name__ == "__main__":
+    # Read the configuration file (read_config creates the output directory)
+    print("Reading configuration file " + config_file + ".toml...")
+    run_params = read_config(config_file)
+    print("Configuration file read.")
+
+    aimpoint = update_aimpoint(run_params, config_path)
+    print(f"Aimpoint: ({aimpoint.x}, {aimpoint.y}, {aimpoint.z})")
+
+    # Thread counts: powers of two up to the number of processors, and all processors
+    num_procs = os.cpu_count()
+    thread_counts = sorted(set([2**i for i in range(num_procs.bit_length()) if 2**i <= num_procs] + [num_procs]))
+    print('Thread counts: ', thread_counts)
+
+    scaling_data = pd.DataFrame(columns=["num_threads", "pin_threads", "wall_time", "speedup", "efficiency"])
+
+    for pin_threads in [0, 1]:
+        for num_threads in thread_counts:
+            run_params.num_threads = num_threads
+            run_params.pin_threads = pin_threads
+
+            start = time.perf_counter()
+            pytraj.mc_run(run_params)
+            wall_time = time.perf_counter() - start
+
+            # Speedup and efficiency relative to one unpinned thread
+            if num_threads == 1 and pin_threads == 0:
+                serial_time = wall_time
+            speedup = serial_time / wall_time
+            scaling_data.loc[len(scaling_data)] = [num_threads, pin_threads, wall_time, speedup, speedup / num_threads]
+
+    # save the scaling data to a csv file
+    scaling_data.to_csv(f"./output/{config_file}/scaling_data.csv", index=False)
+
+    # print the scaling data
+    print(scaling_data)
+
+    # Append the table to scaling_results.md next to this script, with the machine it was measured on
+    node_dir = "/sys/devices/system/node"
+    num_nodes = len([node for node in os.listdir(node_dir) if node.startswith("node")]) if os.path.isdir(node_dir) else 1
+    results_path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "scaling_results.md")
+    with open(results_path, "a") as results_file:
+        results_file.write(f"\n## {platform.node()}: {config_file}, {run_params.num_runs} runs\n\n")
+        results_file.write(f"{platform.processor() or platform.machine()}, {num_procs} processors on {num_nodes} NUMA nodes, {time.strftime('%Y-%m-%d')}\n\n")
+        results_file.write("| threads | pinned | wall time (s) | speedup | efficiency |\n")
+        results_file.write("|---|---|---|---|---|\n")
+        for row in scaling_data.itertuples():
+            results_file.write(f"| {int(row.num_threads)} | {int(row.pin_threads)} | {row.wall_time:.2f} | {row.speedup:.2f} | {row.efficiency:.2f} |\n")
+    print("Scaling results appended to " + results_path)
@@ -0,0 +1,76 @@
+import sys
+import os
+from ctypes import *
+import numpy as np
+import pandas as pd
+
+# Specify the input file name (without the extension)
+config_file = "run_2"
+
+# Check for the existence of the input file
+config_path = f"./input/{config_file}.toml"
+if not os.path.isfile(config_path):
+    print(f"Error: The input file {config_file}.toml does not exist.")
+    sys.exit()
+
+# Check for the existence of the output directory
+if not os.path.isdir(f"./output/{config_file}"):
+    # Create the output directory if it does not exist
+    os.makedirs(f"./output/{config_file}")
+
+# Import the necessary functions from the Python library
+sys.path.append('.')
+from src.pylib import *
+so_file = "./build/libPyTraj.so"
+pytraj = CDLL(so_file)
+
+# Error fields of the sweep, as in sensitivity_ins.py (sensor noise is not a variable of the surrogate)
+sweep_fields = ["initial_pos_error", "initial_vel_error", "initial_angle_error", "acc_scale_stability", "gyro_bias_stability"]
+
+# Code block to evaluate the sensitivity sweep from a response surface instead of a Monte Carlo campaign per point
+if __name__ == "__main__":
+    # Read the configuration file
+    print("Reading configuration file " + config_file + ".toml...")
+    run_params = read_config(config_file)
+    print("Configuration file read.")
+
+    aimpoint = update_aimpoint(run_params, config_path)
+    print(f"Aimpoint: ({aimpoint.x}, {aimpoint.y}, {aimpoint.z})")
+
+    # generate the grid points, evenly spaced on a log scale from 0.1 to 10
+    grid_points = np.logspace(-1, 1, num=7)
+    print('Grid points: ', grid_points)
+
+    # initialize the sensitivity data structure with pandas
+    sensitivity_data = pd.DataFrame(columns=sweep_fields + ["cep", "validation_error"])
+
+    for i in grid_points:
+        # fit a surface per grid point, since the residual of a surface fitted at the largest multiplier exceeds the
+        # effect of the small ones
+        surrogate = surrogate_fit(run_params, 2000, 200, i)
+        print_response_surface(surrogate)
+        if surrogate.num_terms == 0:
+            continue
+        validation_error = np.hypot(surrogate.validation_rms[0], surrogate.validation_rms[1])
+
+        for field in sweep_fields:
+            # scale one field, zero the other swept fields
+            multipliers = {other: 0.0 for other in sweep_fields}
+            multipliers[field] = i
+
+            dispersion = surrogate_dispersion(surrogate, multipliers, 10000)
+
+            # drop the point if the held-out error of the surface exceeds the cep being measured
+            print(f"Multiplier {i:.3f}, {field}: cep {dispersion.cep:.3f} m, validation error {validation_error:.3f} m")
+            if validation_error > dispersion.cep:
+                print("Dropped: the validation error exceeds the cep")
+                continue
+
+            # add the cep to the sensitivity data
+            sensitivity_data.loc[len(sensitivity_data)] = [getattr(run_params, other) * multipliers[other] for other in sweep_fields] + [dispersion.cep, validation_error]
+
+    # save the sensitivity data to a csv file
+    sensitivity_data.to_csv(f"./output/{config_file}/sensitivity_surrogate_data.csv", index=False)
+
+    # print the sensitivity data
+    print(sensitivity_data)
@@ -3,12 +3,20 @@
 import matplotlib.pyplot as plt
 import numpy as np
 
-def traj_plot(run_path):
+def traj_plot(run_path, traj_data=None):
     """
     Function to plot the trajectory of the vehicle.
+
+    INPUTS:
+    ----------
+        run_path: str
+            The output directory of the run.
+        traj_data: numpy.ndarray
+            The trajectory data, e.g. from fly_trajectory. If None, it is read from trajectory.txt.
     """
     # load the trajectory data from the .txt file, skipping the first row
-    traj_data = np.loadtxt(run_path + "trajectory.txt", delimiter = ",", skiprows=1)
+    if traj_data is None:
+        traj_data = np.loadtxt(run_path + "trajectory.txt", delimiter = ",", skiprows=1)
 
     true_t = traj_data[:,0]
     true_mass = traj_data[:,1]
@@ -0,0 +1,49 @@
+#include <tau/tau.h>
+#include "../src/include/batch.h"
+
+TEST(batch, batch_run){
+    runparams scenarios[3];
+    for (int s = 0; s < 3; s++){
+        lincov_test_params(&scenarios[s]);
+        scenarios[s].time_step_reentry = 0.1;
+        scenarios[s].num_runs = 4;
+    }
+
+    // The first two scenarios differ only in their errors and share a nominal trajectory
+    scenarios[1].initial_vel_error = 2e-3;
+    scenarios[2].rv_type = 1;
+    scenarios[0].impact_data_path = "batch_test_impact_0.txt";
+    scenarios[1].impact_data_path = "batch_test_impact_1.txt";
+    scenarios[2].impact_data_path = "batch_test_impact_2.txt";
+
+    batch_stats stats = batch_run(scenarios, 3, 4);
+    REQUIRE_EQ(stats.num_scenarios, 3);
+    REQUIRE_EQ(stats.num_runs, 12);
+    REQUIRE_EQ(stats.num_nominals, 2);
+    REQUIRE_EQ(stats.num_vehicles, 2);
+    REQUIRE_GT(stats.utilization, 0);
+
+    // Scenarios get the aimpoint of update_aimpoint
+    cart_vector aimpoint = update_aimpoint(scenarios[2], scenarios[2].theta_long);
+    REQUIRE_EQ(scenarios[2].x_aim, aimpoint.x);
+    REQUIRE_EQ(scenarios[0].x_aim, scenarios[1].x_aim);
+
+    // Each scenario reproduces its runs of mc_run
+    gsl_rng_env_setup();
+    for (int s = 0; s < 3; s++){
+        FILE *file = fopen(scenarios[s].impact_data_path, "r");
+        REQUIRE_TRUE(file != NULL);
+        char header[64];
+        REQUIRE_TRUE(fgets(header, sizeof(header), file) != NULL);
+        for (int run = 0; run < 4; run++){
+            double t, x, y, z, vx, vy, vz;
+            REQUIRE_EQ(fscanf(file, "%lf, %lf, %lf, %lf, %lf, %lf, %lf\n", &t, &x, &y, &z, &vx, &vy, &vz), 7);
+            state final_state = mc_single_run(&scenarios[s], gsl_rng_default_seed, run, NULL);
+            REQUIRE_LT(fabs(x - final_state.x), 1e-3);
+            REQUIRE_LT(fabs(y - final_state.y), 1e-3);
+            REQUIRE_LT(fabs(z - final_state.z), 1e-3);
+        }
+        fclose(file);
+        remove(scenarios[s].impact_data_path);
+    }
+}
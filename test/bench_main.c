@@ -0,0 +1,29 @@
+// Include all benchmark files here
+
+#include <stdio.h>
+#include <time.h>
+
+double bench_seconds(void){
+    /*
+    Returns a monotonic wall-clock time in seconds for benchmark timing
+    */
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+#include "writer_bench.h"
+#include "filters_bench.h"
+#include "linalg_bench.h"
+#include "noise_bench.h"
+
+int main(){
+    bench_writer();
+    bench_kalman();
+    bench_batch_kalman();
+    bench_linalg_fixed();
+    bench_noise();
+
+    return 0;
+}
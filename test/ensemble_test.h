@@ -0,0 +1,69 @@
+#include <tau/tau.h>
+#include "../src/include/ensemble.h"
+
+TEST(ensemble, save_and_replay){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.1;
+    run_params.num_runs = 20;
+    run_params.num_threads = 4;
+
+    REQUIRE_EQ(ensemble_save(run_params, "ensemble_test.bin"), 20);
+
+    // With unchanged settings the replay reproduces the Monte Carlo runs exactly
+    impact_dispersion replay = ensemble_replay(run_params, "ensemble_test.bin");
+    impact_dispersion mc = mc_dispersion(run_params, 20);
+    REQUIRE_EQ(replay.num_flights, 20);
+    REQUIRE_EQ(replay.cep, mc.cep);
+    for (int i = 0; i < 3; i++){
+        REQUIRE_EQ(replay.mean[i], mc.mean[i]);
+    }
+
+    // A changed atmospheric perturbation flag redraws the atmosphere of the reentry
+    runparams calm_params = run_params;
+    calm_params.atm_error = 0;
+    impact_dispersion calm = ensemble_replay(calm_params, "ensemble_test.bin");
+    REQUIRE_EQ(calm.num_flights, 20);
+    REQUIRE_NE(calm.cep, mc.cep);
+
+    // The first step after burnout was flown with the saved reentry time step, which a replay may not change
+    runparams fine_params = run_params;
+    fine_params.time_step_reentry = 0.05;
+    impact_dispersion fine = ensemble_replay(fine_params, "ensemble_test.bin");
+    REQUIRE_EQ(fine.num_flights, 0);
+
+    // A changed boost-side parameter invalidates the ensemble
+    runparams boost_params = run_params;
+    boost_params.gyro_bias_stability = 2e-8;
+    impact_dispersion invalid = ensemble_replay(boost_params, "ensemble_test.bin");
+    REQUIRE_EQ(invalid.num_flights, 0);
+
+    remove("ensemble_test.bin");
+}
+
+TEST(ensemble, truncated_file){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.1;
+    run_params.num_runs = 4;
+    run_params.num_threads = 2;
+    REQUIRE_EQ(ensemble_save(run_params, "ensemble_test_truncated.bin"), 4);
+
+    // Drop the last record, so that the run count of the header exceeds the records in the file
+    FILE *file = fopen("ensemble_test_truncated.bin", "rb+");
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    REQUIRE_EQ(ftruncate(fileno(file), size - sizeof(ensemble_record)), 0);
+    fclose(file);
+
+    impact_dispersion truncated = ensemble_replay(run_params, "ensemble_test_truncated.bin");
+    REQUIRE_EQ(truncated.num_flights, 0);
+    remove("ensemble_test_truncated.bin");
+}
+
+TEST(ensemble, missing_file){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    impact_dispersion missing = ensemble_replay(run_params, "ensemble_test_missing.bin");
+    REQUIRE_EQ(missing.num_flights, 0);
+}
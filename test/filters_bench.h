@@ -0,0 +1,169 @@
+#include <malloc.h>
+#include "../src/include/filters.h"
+#include "filters_reference.h"
+
+void bench_kalman_scratch_cycle(KalmanFilter *kf){
+    /*
+    The same cycle as kalman_reference_cycle written with the scratch helpers, which need no frees and
+    are released by a single linalg_scratch_reset per cycle
+    */
+
+    gsl_matrix *F_t = m_transpose_scratch(kf->dynamic_matrix);
+    gsl_matrix *H_t = m_transpose_scratch(kf->measurement_matrix);
+
+    gsl_vector *x_pred = mv_multiply_scratch(kf->dynamic_matrix, kf->predicted_state);
+    gsl_matrix *P_pred = mm_add_scratch(mm_multiply_scratch(mm_multiply_scratch(kf->dynamic_matrix, kf->predicted_covariance), F_t), kf->process_noise);
+
+    gsl_matrix *S = mm_add_scratch(mm_multiply_scratch(mm_multiply_scratch(kf->measurement_matrix, P_pred), H_t), kf->measurement_noise);
+    gsl_matrix *K = mm_multiply_scratch(mm_multiply_scratch(P_pred, H_t), m_pseudoinverse_scratch(S));
+
+    gsl_vector *y = vv_subtract_scratch(kf->measured_state, mv_multiply_scratch(kf->measurement_matrix, x_pred));
+    gsl_vector *x_new = vv_add_scratch(x_pred, mv_multiply_scratch(K, y));
+    gsl_matrix *KSK_t = mm_multiply_scratch(mm_multiply_scratch(K, S), m_transpose_scratch(K));
+    gsl_matrix *P_new = mm_add_scratch(P_pred, sm_multiply_scratch(-1, KSK_t));
+
+    gsl_vector_memcpy(kf->predicted_state, x_new);
+    gsl_matrix_memcpy(kf->predicted_covariance, P_new);
+
+    linalg_scratch_reset();
+}
+
+void bench_kalman_setup(KalmanFilter *kf){
+    /*
+    Sets up a nine-state constant-acceleration filter with three position measurements
+    */
+
+    double dt = 0.01;
+    gsl_matrix_set_identity(kf->dynamic_matrix);
+    gsl_matrix_set_zero(kf->process_noise);
+    gsl_matrix_set_zero(kf->measurement_matrix);
+    gsl_matrix_set_zero(kf->measurement_noise);
+    gsl_matrix_set_identity(kf->predicted_covariance);
+    gsl_vector_set_zero(kf->predicted_state);
+    for (int axis = 0; axis < 3; axis++){
+        gsl_matrix_set(kf->dynamic_matrix, 3*axis, 3*axis + 1, dt);
+        gsl_matrix_set(kf->dynamic_matrix, 3*axis, 3*axis + 2, 0.5*dt*dt);
+        gsl_matrix_set(kf->dynamic_matrix, 3*axis + 1, 3*axis + 2, dt);
+        for (int i = 0; i < 3; i++){
+            gsl_matrix_set(kf->process_noise, 3*axis + i, 3*axis + i, 1e-4);
+        }
+        gsl_matrix_set(kf->measurement_matrix, axis, 3*axis, 1);
+        gsl_matrix_set(kf->measurement_noise, axis, axis, 1);
+        gsl_vector_set(kf->measured_state, axis, axis);
+    }
+}
+
+void bench_kalman(void){
+    /*
+    Measures predict/update throughput of the in-place Kalman filter against the allocating helpers,
+    and the heap memory retained across the in-place cycles
+    */
+
+    int num_cycles = 200000;
+    KalmanFilter *kf = kalman_filter_alloc(9, 3);
+
+    printf("Kalman filter (9 states, 3 measurements, %d predict/update cycles)\n", num_cycles);
+
+    // Allocating helpers
+    bench_kalman_setup(kf);
+    double start = bench_seconds();
+    for (int i = 0; i < num_cycles; i++){
+        kalman_reference_cycle(kf, kf->predicted_state, kf->predicted_covariance);
+    }
+    double alloc_time = (bench_seconds() - start) / num_cycles;
+
+    // Scratch helpers, reset once per cycle
+    bench_kalman_setup(kf);
+    bench_kalman_scratch_cycle(kf);
+    struct mallinfo2 scratch_before = mallinfo2();
+    start = bench_seconds();
+    for (int i = 0; i < num_cycles; i++){
+        bench_kalman_scratch_cycle(kf);
+    }
+    double scratch_time = (bench_seconds() - start) / num_cycles;
+    struct mallinfo2 scratch_after = mallinfo2();
+
+    // In-place filter with preallocated workspaces, joint (Cholesky) and sequential scalar updates
+    double inplace_time[2];
+    long heap_growth = 0;
+    for (int sequential = 0; sequential <= 1; sequential++){
+        bench_kalman_setup(kf);
+        kf->sequential_update = sequential;
+        struct mallinfo2 before = mallinfo2();
+        start = bench_seconds();
+        for (int i = 0; i < num_cycles; i++){
+            kalman_filter_predict(kf);
+            kalman_filter_update(kf);
+        }
+        inplace_time[sequential] = (bench_seconds() - start) / num_cycles;
+        struct mallinfo2 after = mallinfo2();
+        heap_growth += (long)(after.uordblks - before.uordblks);
+    }
+
+    printf("    allocating helpers (SVD):   %8.0f ns/cycle\n", 1e9 * alloc_time);
+    printf("    scratch helpers (SVD):      %8.0f ns/cycle, heap growth %ld bytes\n", 1e9 * scratch_time, (long)(scratch_after.uordblks - scratch_before.uordblks));
+    printf("    in-place, Cholesky gain:    %8.0f ns/cycle\n", 1e9 * inplace_time[0]);
+    printf("    in-place, sequential:       %8.0f ns/cycle\n", 1e9 * inplace_time[1]);
+    printf("    heap growth (in-place):     %8ld bytes over %d cycles\n", heap_growth, 2 * num_cycles);
+
+    kalman_filter_free(kf);
+}
+
+void bench_batch_kalman(void){
+    /*
+    Measures predict/update throughput of a batch of filters against the same number of independent filters
+    */
+
+    int batch_size = 1024;
+    int num_cycles = 200;
+    KalmanFilter *kf = kalman_filter_alloc(9, 3);
+    BatchKalmanFilter *bkf = batch_kalman_filter_alloc(9, 3, batch_size);
+    KalmanFilter **kfs = malloc(batch_size * sizeof(KalmanFilter *));
+
+    bench_kalman_setup(kf);
+    gsl_matrix_memcpy(bkf->dynamic_matrix, kf->dynamic_matrix);
+    gsl_matrix_memcpy(bkf->process_noise, kf->process_noise);
+    gsl_matrix_memcpy(bkf->measurement_matrix, kf->measurement_matrix);
+    gsl_matrix_memcpy(bkf->measurement_noise, kf->measurement_noise);
+    for (int b = 0; b < batch_size; b++){
+        kfs[b] = kalman_filter_alloc(9, 3);
+        bench_kalman_setup(kfs[b]);
+        batch_kalman_filter_set(bkf, b, kf->predicted_state, kf->predicted_covariance);
+        batch_kalman_filter_set_measurement(bkf, b, kf->measured_state);
+    }
+
+    printf("Batched Kalman filter (9 states, 3 measurements, %d filters, %d cycles)\n", batch_size, num_cycles);
+
+    double time[2][2];
+    for (int sequential = 0; sequential <= 1; sequential++){
+        double start = bench_seconds();
+        for (int i = 0; i < num_cycles; i++){
+            for (int b = 0; b < batch_size; b++){
+                kfs[b]->sequential_update = sequential;
+                kalman_filter_predict(kfs[b]);
+                kalman_filter_update(kfs[b]);
+            }
+        }
+        time[sequential][0] = (bench_seconds() - start) / num_cycles / batch_size;
+
+        bkf->sequential_update = sequential;
+        start = bench_seconds();
+        for (int i = 0; i < num_cycles; i++){
+            batch_kalman_filter_predict(bkf);
+            batch_kalman_filter_update(bkf);
+        }
+        time[sequential][1] = (bench_seconds() - start) / num_cycles / batch_size;
+    }
+
+    printf("    independent, Cholesky gain: %8.0f ns/filter/cycle\n", 1e9 * time[0][0]);
+    printf("    batched, Cholesky gain:     %8.0f ns/filter/cycle\n", 1e9 * time[0][1]);
+    printf("    independent, sequential:    %8.0f ns/filter/cycle\n", 1e9 * time[1][0]);
+    printf("    batched, sequential:        %8.0f ns/filter/cycle\n", 1e9 * time[1][1]);
+
+    for (int b = 0; b < batch_size; b++){
+        kalman_filter_free(kfs[b]);
+    }
+    free(kfs);
+    batch_kalman_filter_free(bkf);
+    kalman_filter_free(kf);
+}
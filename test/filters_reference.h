@@ -0,0 +1,55 @@
+#include "../src/include/filters.h"
+
+void kalman_reference_cycle(KalmanFilter *kf, gsl_vector *x, gsl_matrix *P){
+    /*
+    Reference predict/update cycle built from the allocating linalg.h helpers, as kalman_filter_predict and
+    kalman_filter_update were before the filter workspaces (with every temporary freed). Shared by the filter
+    tests, which check the in-place filter against it, and the filter benchmark, which times it
+
+    INPUTS:
+    ----------
+        kf: KalmanFilter *
+            pointer to the filter, whose model matrices and measurement are used
+        x: gsl_vector *
+            state estimate, updated in place
+        P: gsl_matrix *
+            state covariance, updated in place
+    */
+
+    gsl_matrix *F_t = m_transpose(kf->dynamic_matrix);
+    gsl_matrix *H_t = m_transpose(kf->measurement_matrix);
+
+    gsl_vector *x_pred = mv_multiply(kf->dynamic_matrix, x);
+    gsl_matrix *FP = mm_multiply(kf->dynamic_matrix, P);
+    gsl_matrix *FPF_t = mm_multiply(FP, F_t);
+    gsl_matrix *P_pred = mm_add(FPF_t, kf->process_noise);
+
+    gsl_matrix *HP = mm_multiply(kf->measurement_matrix, P_pred);
+    gsl_matrix *HPH_t = mm_multiply(HP, H_t);
+    gsl_matrix *S = mm_add(HPH_t, kf->measurement_noise);
+    // m_pseudoinverse decomposes its argument in place, so invert a copy
+    gsl_matrix *S_copy = sm_multiply(1, S);
+    gsl_matrix *S_inv = m_pseudoinverse(S_copy);
+    gsl_matrix *PH_t = mm_multiply(P_pred, H_t);
+    gsl_matrix *K = mm_multiply(PH_t, S_inv);
+
+    gsl_vector *Hx = mv_multiply(kf->measurement_matrix, x_pred);
+    gsl_vector *y = vv_subtract(kf->measured_state, Hx);
+    gsl_vector *Ky = mv_multiply(K, y);
+    gsl_vector *x_new = vv_add(x_pred, Ky);
+
+    gsl_matrix *K_t = m_transpose(K);
+    gsl_matrix *KS = mm_multiply(K, S);
+    gsl_matrix *KSK_t = mm_multiply(KS, K_t);
+    gsl_matrix *minus_KSK_t = sm_multiply(-1, KSK_t);
+    gsl_matrix *P_new = mm_add(P_pred, minus_KSK_t);
+
+    gsl_vector_memcpy(x, x_new);
+    gsl_matrix_memcpy(P, P_new);
+
+    gsl_matrix_free(F_t); gsl_matrix_free(H_t); gsl_vector_free(x_pred); gsl_matrix_free(FP); gsl_matrix_free(FPF_t);
+    gsl_matrix_free(P_pred); gsl_matrix_free(HP); gsl_matrix_free(HPH_t); gsl_matrix_free(S); gsl_matrix_free(S_copy);
+    gsl_matrix_free(S_inv); gsl_matrix_free(PH_t); gsl_matrix_free(K); gsl_vector_free(Hx); gsl_vector_free(y);
+    gsl_vector_free(Ky); gsl_vector_free(x_new); gsl_matrix_free(K_t); gsl_matrix_free(KS); gsl_matrix_free(KSK_t);
+    gsl_matrix_free(minus_KSK_t); gsl_matrix_free(P_new);
+}
@@ -1,5 +1,6 @@
 #include <tau/tau.h>
 #include "../src/include/filters.h"
+#include "filters_reference.h"
 
 TEST(kalman, kalman_filter_alloc){
     KalmanFilter *kf = kalman_filter_alloc(2, 3);
@@ -87,4 +88,249 @@ TEST(kalman, kalman_filter_update){
     // Free memory
     kalman_filter_free(kf);
 
-}
\ No newline at end of file
+}
+
+void kalman_test_setup(KalmanFilter *kf, double dt){
+    /*
+    Sets up a constant-acceleration filter in three axes with position measurements
+    */
+
+    int n = kf->state_dim / 3;
+    gsl_matrix_set_identity(kf->dynamic_matrix);
+    gsl_matrix_set_zero(kf->process_noise);
+    gsl_matrix_set_zero(kf->measurement_matrix);
+    gsl_matrix_set_zero(kf->measurement_noise);
+    gsl_matrix_set_identity(kf->predicted_covariance);
+    for (int axis = 0; axis < 3; axis++){
+        for (int i = 0; i < n; i++){
+            for (int j = i + 1; j < n; j++){
+                gsl_matrix_set(kf->dynamic_matrix, axis*n + i, axis*n + j, pow(dt, j - i) / (j - i == 2 ? 2 : 1));
+            }
+            gsl_matrix_set(kf->process_noise, axis*n + i, axis*n + i, 1e-3 * (i + 1));
+            gsl_vector_set(kf->predicted_state, axis*n + i, axis + i);
+        }
+        gsl_matrix_set(kf->measurement_matrix, axis, axis*n, 1);
+        gsl_matrix_set(kf->measurement_noise, axis, axis, 0.5);
+    }
+}
+
+double kalman_test_cycle(int sequential_update, double noise_correlation){
+    /*
+    Runs 50 filter cycles against the helper-based reference and returns the largest state or covariance difference
+    */
+
+    // Nine-state filter with three position measurements
+    KalmanFilter *kf = kalman_filter_alloc(9, 3);
+    kalman_test_setup(kf, 0.1);
+    kf->sequential_update = sequential_update;
+    gsl_matrix_set(kf->measurement_noise, 0, 1, noise_correlation);
+    gsl_matrix_set(kf->measurement_noise, 1, 0, noise_correlation);
+
+    gsl_vector *x = gsl_vector_alloc(9);
+    gsl_matrix *P = gsl_matrix_alloc(9, 9);
+    gsl_vector_memcpy(x, kf->predicted_state);
+    gsl_matrix_memcpy(P, kf->predicted_covariance);
+
+    double max_error = 0;
+    for (int step = 0; step < 50; step++){
+        for (int i = 0; i < 3; i++){
+            gsl_vector_set(kf->measured_state, i, sin(0.1 * step + i));
+        }
+        kalman_filter_predict(kf);
+        kalman_filter_update(kf);
+        kalman_reference_cycle(kf, x, P);
+
+        for (int i = 0; i < 9; i++){
+            max_error = fmax(max_error, fabs(gsl_vector_get(kf->predicted_state, i) - gsl_vector_get(x, i)));
+            for (int j = 0; j < 9; j++){
+                max_error = fmax(max_error, fabs(gsl_matrix_get(kf->predicted_covariance, i, j) - gsl_matrix_get(P, i, j)));
+            }
+        }
+    }
+    if (kf->timestep != 50){
+        max_error = INFINITY;
+    }
+
+    gsl_vector_free(x);
+    gsl_matrix_free(P);
+    kalman_filter_free(kf);
+
+    return max_error;
+}
+
+TEST(kalman, kalman_filter_cycle){
+    // The joint (Cholesky) and sequential updates match the helper-based reference for independent measurements
+    REQUIRE_LT(kalman_test_cycle(0, 0), 1e-9);
+    REQUIRE_LT(kalman_test_cycle(1, 0), 1e-9);
+
+    // Correlated measurement noise always uses the joint update
+    REQUIRE_LT(kalman_test_cycle(1, 0.2), 1e-9);
+}
+
+TEST(kalman, kalman_filter_update_sequential){
+    // The sequential update leaves no off-diagonal innovation covariance from an earlier joint update
+    KalmanFilter *kf = kalman_filter_alloc(9, 3);
+    kalman_test_setup(kf, 0.1);
+    gsl_matrix_set(kf->measurement_noise, 0, 1, 0.2);
+    gsl_matrix_set(kf->measurement_noise, 1, 0, 0.2);
+    kalman_filter_predict(kf);
+    kalman_filter_update(kf);
+    REQUIRE_NE(gsl_matrix_get(kf->innovation_covariance, 0, 1), 0);
+
+    gsl_matrix_set(kf->measurement_noise, 0, 1, 0);
+    gsl_matrix_set(kf->measurement_noise, 1, 0, 0);
+    kf->sequential_update = 1;
+    kalman_filter_predict(kf);
+    kalman_filter_update(kf);
+    for (int i = 0; i < 3; i++){
+        for (int j = 0; j < 3; j++){
+            if (i == j){
+                REQUIRE_GT(gsl_matrix_get(kf->innovation_covariance, i, j), 0);
+            }
+            else{
+                REQUIRE_EQ(gsl_matrix_get(kf->innovation_covariance, i, j), 0);
+            }
+        }
+    }
+
+    kalman_filter_free(kf);
+}
+
+TEST(kalman, kalman_filter_factor_innovation){
+    KalmanFilter *kf = kalman_filter_alloc(2, 2);
+
+    // Positive definite
+    gsl_matrix_set(kf->innovation_covariance, 0, 0, 2);
+    gsl_matrix_set(kf->innovation_covariance, 0, 1, 1);
+    gsl_matrix_set(kf->innovation_covariance, 1, 0, 1);
+    gsl_matrix_set(kf->innovation_covariance, 1, 1, 2);
+    REQUIRE_EQ(kalman_filter_factor_innovation(kf), 1);
+
+    // Symmetric indefinite but nonsingular
+    gsl_matrix_set(kf->innovation_covariance, 1, 1, -2);
+    REQUIRE_EQ(kalman_filter_factor_innovation(kf), 2);
+
+    // Singular
+    gsl_matrix_set_zero(kf->innovation_covariance);
+    REQUIRE_EQ(kalman_filter_factor_innovation(kf), 0);
+
+    kalman_filter_free(kf);
+}
+
+TEST(kalman, kalman_filter_update_singular){
+    // With zero covariance and zero measurement noise the joint update falls back to the pseudoinverse
+    KalmanFilter *kf = kalman_filter_alloc(2, 3);
+    kf->sequential_update = 0;
+    gsl_matrix_set_identity(kf->dynamic_matrix);
+    gsl_vector_set(kf->predicted_state, 0, 1);
+    gsl_vector_set(kf->predicted_state, 1, 2);
+    gsl_matrix_set_zero(kf->process_noise);
+    gsl_matrix_set_zero(kf->predicted_covariance);
+    gsl_matrix_set_identity(kf->measurement_matrix);
+    gsl_matrix_set_zero(kf->measurement_noise);
+    gsl_vector_set(kf->measured_state, 0, 5);
+    gsl_vector_set(kf->measured_state, 1, 6);
+    gsl_vector_set(kf->measured_state, 2, 7);
+
+    kalman_filter_predict(kf);
+    kalman_filter_update(kf);
+
+    REQUIRE_EQ(gsl_vector_get(kf->predicted_state, 0), 1);
+    REQUIRE_EQ(gsl_vector_get(kf->predicted_state, 1), 2);
+
+    kalman_filter_free(kf);
+}
+
+double batch_kalman_test_cycle(int sequential_update, double noise_correlation){
+    /*
+    Runs 50 cycles of a batch of filters against independent filters and returns the largest state or covariance difference
+    */
+
+    int batch_size = 13;
+    BatchKalmanFilter *bkf = batch_kalman_filter_alloc(9, 3, batch_size);
+    bkf->sequential_update = sequential_update;
+    KalmanFilter *kfs[13];
+    gsl_vector *x = gsl_vector_alloc(9);
+    gsl_matrix *P = gsl_matrix_alloc(9, 9);
+
+    // Share the model of the first filter and give every filter its own initial state
+    for (int b = 0; b < batch_size; b++){
+        kfs[b] = kalman_filter_alloc(9, 3);
+        kalman_test_setup(kfs[b], 0.1);
+        kfs[b]->sequential_update = sequential_update;
+        gsl_matrix_set(kfs[b]->measurement_noise, 0, 1, noise_correlation);
+        gsl_matrix_set(kfs[b]->measurement_noise, 1, 0, noise_correlation);
+        gsl_vector_add_constant(kfs[b]->predicted_state, 0.1 * b);
+        gsl_matrix_set(kfs[b]->predicted_covariance, 0, 0, 1 + b);
+        batch_kalman_filter_set(bkf, b, kfs[b]->predicted_state, kfs[b]->predicted_covariance);
+    }
+    gsl_matrix_memcpy(bkf->dynamic_matrix, kfs[0]->dynamic_matrix);
+    gsl_matrix_memcpy(bkf->process_noise, kfs[0]->process_noise);
+    gsl_matrix_memcpy(bkf->measurement_matrix, kfs[0]->measurement_matrix);
+    gsl_matrix_memcpy(bkf->measurement_noise, kfs[0]->measurement_noise);
+
+    double max_error = 0;
+    for (int step = 0; step < 50; step++){
+        for (int b = 0; b < batch_size; b++){
+            for (int i = 0; i < 3; i++){
+                gsl_vector_set(kfs[b]->measured_state, i, sin(0.1 * step + i + b));
+            }
+            batch_kalman_filter_set_measurement(bkf, b, kfs[b]->measured_state);
+            kalman_filter_predict(kfs[b]);
+            kalman_filter_update(kfs[b]);
+        }
+        batch_kalman_filter_predict(bkf);
+        batch_kalman_filter_update(bkf);
+
+        for (int b = 0; b < batch_size; b++){
+            batch_kalman_filter_get(bkf, b, x, P);
+            for (int i = 0; i < 9; i++){
+                max_error = fmax(max_error, fabs(gsl_vector_get(kfs[b]->predicted_state, i) - gsl_vector_get(x, i)));
+                for (int j = 0; j < 9; j++){
+                    max_error = fmax(max_error, fabs(gsl_matrix_get(kfs[b]->predicted_covariance, i, j) - gsl_matrix_get(P, i, j)));
+                }
+            }
+        }
+    }
+    if (bkf->timestep != 50){
+        max_error = INFINITY;
+    }
+
+    for (int b = 0; b < batch_size; b++){
+        kalman_filter_free(kfs[b]);
+    }
+    gsl_vector_free(x);
+    gsl_matrix_free(P);
+    batch_kalman_filter_free(bkf);
+
+    return max_error;
+}
+
+TEST(kalman, batch_kalman_filter_cycle){
+    // Every filter in the batch matches an independent filter, for both update paths
+    REQUIRE_LT(batch_kalman_test_cycle(0, 0), 1e-9);
+    REQUIRE_LT(batch_kalman_test_cycle(1, 0), 1e-9);
+    REQUIRE_LT(batch_kalman_test_cycle(1, 0.2), 1e-9);
+}
+
+TEST(kalman, batch_kalman_filter_update_singular){
+    // A filter with a singular innovation covariance is left unchanged while the others are updated
+    BatchKalmanFilter *bkf = batch_kalman_filter_alloc(1, 1, 2);
+    bkf->sequential_update = 0;
+    gsl_matrix_set_identity(bkf->measurement_matrix);
+    gsl_matrix_set_zero(bkf->measurement_noise);
+    bkf->predicted_state[0] = 1;
+    bkf->predicted_state[1] = 1;
+    bkf->predicted_covariance[0] = 0;
+    bkf->predicted_covariance[1] = 1;
+    bkf->measured_state[0] = 3;
+    bkf->measured_state[1] = 3;
+
+    batch_kalman_filter_update(bkf);
+
+    REQUIRE_EQ(bkf->predicted_state[0], 1);
+    REQUIRE_LT(fabs(bkf->predicted_state[1] - 3), 1e-12);
+    REQUIRE_LT(fabs(bkf->predicted_covariance[1]), 1e-12);
+
+    batch_kalman_filter_free(bkf);
+}
@@ -0,0 +1,53 @@
+#include <tau/tau.h>
+#include "../src/include/fork.h"
+
+TEST(fork, flight_at_entry){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.1;
+
+    // A prefix stops on the way down through the entry interface, well before impact
+    gsl_rng *rng = philox_alloc(0, 0, PHILOX_STREAM_RUN);
+    vehicle vehicle = init_mmiii_ballistic();
+    state initial_state = init_true_state(&run_params, rng);
+    flight flight;
+    flight_init(&flight, &run_params, &initial_state, &vehicle, rng, NULL);
+    int at_entry = 0;
+    while (!flight_step(&flight)){
+        if (flight_at_entry(&flight)){
+            at_entry = 1;
+            break;
+        }
+    }
+    REQUIRE_EQ(at_entry, 1);
+    REQUIRE_EQ(flight.impacted, 0);
+    double altitude = get_altitude(flight.new_true_state.x, flight.new_true_state.y, flight.new_true_state.z);
+    REQUIRE_LT(altitude, FORK_ENTRY_ALTITUDE);
+    REQUIRE_GT(altitude, FORK_ENTRY_ALTITUDE - 1e4);
+    gsl_rng_free(rng);
+}
+
+TEST(fork, fork_run){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.1;
+
+    run_params.num_threads = 1;
+    fork_estimate serial = fork_run(run_params, 10, 10);
+    REQUIRE_EQ(serial.dispersion.num_flights, 100);
+
+    // Most of each flight is the shared prefix
+    REQUIRE_GT(serial.prefix_steps, 5 * serial.fork_steps);
+    REQUIRE_GT(serial.speedup, 4);
+
+    // The results do not depend on the number of threads
+    run_params.num_threads = 4;
+    fork_estimate parallel = fork_run(run_params, 10, 10);
+    REQUIRE_EQ(serial.dispersion.cep, parallel.dispersion.cep);
+    REQUIRE_EQ(serial.dispersion.mean[0], parallel.dispersion.mean[0]);
+
+    // The dispersion stays close to that of as many independent Monte Carlo runs
+    impact_dispersion mc = mc_dispersion(run_params, 100);
+    REQUIRE_LT(fabs(serial.dispersion.cep - mc.cep), 0.3 * mc.cep);
+    REQUIRE_LT(fabs(serial.dispersion.local_covariance[0][0] - mc.local_covariance[0][0]), 0.3 * mc.local_covariance[0][0]);
+}
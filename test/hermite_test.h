@@ -0,0 +1,101 @@
+#include <tau/tau.h>
+#include "../src/include/hermite.h"
+
+void hermite_test_row(double *row, double t){
+    // Fill a row with a cubic true position and a sinusoidal estimated position
+    for (int j = 0; j < TRAJ_NUM_FIELDS; j++){
+        row[j] = j;
+    }
+    row[0] = t;
+    for (int i = 0; i < 3; i++){
+        row[2+i] = (i + 1) * t*t*t - 4*t*t + 2*t + 6371e3;
+        row[5+i] = 3 * (i + 1) * t*t - 8*t + 2;
+        row[23+i] = 1e3 * sin(0.1 * t + i);
+        row[26+i] = 1e2 * cos(0.1 * t + i);
+    }
+}
+
+TEST(hermite, hermite_segment){
+    double row_0[TRAJ_NUM_FIELDS], row_1[TRAJ_NUM_FIELDS], row[TRAJ_NUM_FIELDS], exact[TRAJ_NUM_FIELDS];
+    hermite_test_row(row_0, 1);
+    hermite_test_row(row_1, 3);
+
+    // A cubic is reproduced exactly, including its derivative
+    hermite_segment(row_0, row_1, 2.5, row);
+    hermite_test_row(exact, 2.5);
+    REQUIRE_EQ(row[0], 2.5);
+    for (int i = 0; i < 3; i++){
+        REQUIRE_LT(fabs(row[2+i] - exact[2+i]), 1e-6);
+        REQUIRE_LT(fabs(row[5+i] - exact[5+i]), 1e-6);
+    }
+
+    // Other fields are linearly interpolated
+    REQUIRE_EQ(row[1], 1);
+    REQUIRE_EQ(row[43], 43);
+
+    // The segment passes through its knots
+    hermite_segment(row_0, row_1, 1, row);
+    REQUIRE_EQ(row[23], row_0[23]);
+    hermite_segment(row_0, row_1, 3, row);
+    REQUIRE_LT(fabs(row[23] - row_1[23]), 1e-9);
+}
+
+TEST(hermite, hermite_compress){
+    int num_steps = 20000;
+    double tolerance = 0.5;
+    double time_step = 0.01;
+
+    hermite_compressor compressor;
+    hermite_init(&compressor, tolerance);
+
+    double *knots = (double *)malloc(num_steps * TRAJ_NUM_FIELDS * sizeof(double));
+    int num_knots = 0;
+    double row[TRAJ_NUM_FIELDS];
+    for (int step = 0; step < num_steps; step++){
+        hermite_test_row(row, step * time_step);
+        hermite_push(&compressor, row);
+        // Force a knot in the middle of the trajectory, as for a flight event
+        while (hermite_next_knot(&compressor, step == num_steps / 2, knots + num_knots * TRAJ_NUM_FIELDS)){
+            num_knots++;
+        }
+    }
+    while (hermite_next_knot(&compressor, 1, knots + num_knots * TRAJ_NUM_FIELDS)){
+        num_knots++;
+    }
+    hermite_free(&compressor);
+
+    // The first, forced and last steps are knots and the trajectory is compressed
+    REQUIRE_EQ(knots[0], 0);
+    REQUIRE_EQ(knots[(num_knots - 1) * TRAJ_NUM_FIELDS], (num_steps - 1) * time_step);
+    int forced = 0;
+    for (int k = 0; k < num_knots; k++){
+        forced += (knots[k * TRAJ_NUM_FIELDS] == (num_steps / 2) * time_step);
+        if (k > 0){
+            REQUIRE_GT(knots[k * TRAJ_NUM_FIELDS], knots[(k - 1) * TRAJ_NUM_FIELDS]);
+        }
+    }
+    REQUIRE_EQ(forced, 1);
+    REQUIRE_LT(num_knots, num_steps / 50);
+
+    // Every step is reconstructed within the tolerance
+    double exact[TRAJ_NUM_FIELDS];
+    for (int step = 0; step < num_steps; step++){
+        hermite_test_row(exact, step * time_step);
+        hermite_eval(knots, num_knots, step * time_step, row);
+        for (int k = 0; k < HERMITE_NUM_STATES; k++){
+            int p = hermite_pos_fields[k];
+            double dx = row[p] - exact[p];
+            double dy = row[p+1] - exact[p+1];
+            double dz = row[p+2] - exact[p+2];
+            REQUIRE_LE(sqrt(dx*dx + dy*dy + dz*dz), tolerance);
+        }
+    }
+
+    // Times outside the trajectory are clamped to the end knots
+    hermite_eval(knots, num_knots, -1, row);
+    REQUIRE_EQ(row[0], 0);
+    hermite_eval(knots, num_knots, 1e9, row);
+    REQUIRE_EQ(row[0], (num_steps - 1) * time_step);
+
+    free(knots);
+}
@@ -0,0 +1,79 @@
+#include <tau/tau.h>
+#include "../src/include/importance.h"
+
+TEST(importance, importance_directions){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.1;
+
+    // The impact point moves within the local tangent plane, so two directions remain
+    impact_jacobian jacobian = fly_jacobian(&run_params);
+    double sigmas[NUM_ERROR_SOURCES];
+    error_source_sigmas(&run_params, sigmas);
+    importance_batch batch;
+    batch.scale = 2;
+    batch.num_directions = importance_directions(&jacobian, sigmas, batch.directions);
+    REQUIRE_EQ(batch.num_directions, 2);
+    for (int k = 0; k < 2; k++){
+        for (int l = 0; l < 2; l++){
+            double dot = 0;
+            for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+                dot += batch.directions[k][source] * batch.directions[l][source];
+            }
+            REQUIRE_LT(fabs(dot - (k == l)), 1e-12);
+        }
+    }
+
+    // Deviates orthogonal to the directions are left as drawn, with a weight of scale^2 at the origin
+    double deviates[NUM_ERROR_SOURCES] = {0};
+    double weight = importance_transform(&batch, deviates);
+    REQUIRE_LT(fabs(weight - 4), 1e-12);
+
+    // Along a direction, the component is scaled and the weight is the density ratio
+    for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+        deviates[source] = batch.directions[0][source];
+    }
+    weight = importance_transform(&batch, deviates);
+    REQUIRE_LT(fabs(deviates[0] - 2 * batch.directions[0][0]), 1e-12);
+    REQUIRE_LT(fabs(weight - 4 * exp(-0.5 * 4 * 0.75)), 1e-12);
+}
+
+TEST(importance, weighted_quantile){
+    weighted_value sorted[4] = {{1, 1}, {2, 1}, {3, 1}, {4, 1}};
+    REQUIRE_EQ(weighted_quantile(sorted, 4, 0.5), 2);
+    REQUIRE_EQ(weighted_quantile(sorted, 4, 0.99), 4);
+
+    // A heavy weight pulls the quantiles towards its value
+    sorted[2].weight = 7;
+    REQUIRE_EQ(weighted_quantile(sorted, 4, 0.5), 3);
+    REQUIRE_EQ(weighted_quantile(sorted, 4, 0.1), 1);
+}
+
+TEST(importance, importance_run){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.1;
+    run_params.num_runs = 400;
+
+    // A scale of 1 is plain Monte Carlo
+    run_params.num_threads = 1;
+    importance_estimate plain = importance_run(run_params, 1, 250);
+    REQUIRE_EQ(plain.effective_samples, 400);
+    REQUIRE_LE(plain.r50, plain.r90);
+    REQUIRE_LE(plain.r90, plain.r99);
+
+    // Sampling the tail more often lowers the error of a rare exceedance for as many runs
+    importance_estimate scaled = importance_run(run_params, 2.5, 250);
+    REQUIRE_EQ(scaled.num_directions, 2);
+    REQUIRE_GT(scaled.effective_samples, 0.2 * 400);
+    REQUIRE_GT(scaled.exceedance_probability, 0);
+    REQUIRE_LT(scaled.exceedance_error, 0.5 * plain.exceedance_error);
+    REQUIRE_LT(fabs(scaled.r50 - plain.r50), 0.2 * plain.r50);
+    REQUIRE_LT(fabs(scaled.r99 - plain.r99), 0.2 * plain.r99);
+
+    // The results do not depend on the number of threads
+    run_params.num_threads = 4;
+    importance_estimate parallel = importance_run(run_params, 2.5, 250);
+    REQUIRE_EQ(scaled.r99, parallel.r99);
+    REQUIRE_EQ(scaled.exceedance_probability, parallel.exceedance_probability);
+}
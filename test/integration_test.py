@@ -22,9 +22,18 @@ def test_read_config():
     run_params = read_config("test")
 
     assert run_params.num_runs == 2
+    assert run_params.num_threads == 0
     assert run_params.time_step_main == 1.0
     assert run_params.time_step_reentry == 0.01
     assert run_params.traj_output == 0
+    assert run_params.traj_archive == 0
+    assert run_params.traj_decimation == 1
+    assert run_params.traj_cadence == 0
+    assert run_params.imu_period == 0
+    assert run_params.gnss_period == 0
+    assert run_params.guidance_period == 0
+    assert run_params.lift_period == 0
+    assert run_params.traj_hermite_tol == 0
     assert run_params.x_aim == 6371e3
     assert run_params.y_aim == 0
     assert run_params.z_aim == 0
@@ -945,4 +954,388 @@ def test_integration_15():
 
     cep3 = get_cep(impact_data, run_params)
 
-    assert cep1 < cep2 < cep3
\ No newline at end of file
+    assert cep1 < cep2 < cep3
+
+def test_integration_16():
+    """
+    Verify that archived trajectories are indexed by run and end at the recorded impact
+    """
+
+    run_params = read_config("test")
+    run_params.num_runs = 4
+    run_params.traj_archive = 2
+    run_params.initial_pos_error = c_double(1.0)
+
+    impact_data_pointer = pytraj.mc_run(run_params)
+
+    # Read the impact data
+    run_path = "./output/test/"
+    impact_data = np.loadtxt(run_path + "impact_data.txt", delimiter = ",", skiprows=1)
+
+    for run_id in range(run_params.num_runs):
+        trajectory = load_trajectory(run_params, run_id)
+        if run_id % run_params.traj_archive != 0:
+            assert trajectory is None
+            continue
+
+        assert trajectory.shape[1] == 44
+        assert np.isclose(trajectory[-1,0], impact_data[run_id,0], atol=1e-6)
+        assert np.allclose(trajectory[-1,2:5], impact_data[run_id,1:4], atol=1e-3)
+
+
+def test_integration_17():
+    """
+    Verify that a single trajectory can be flown from Python and viewed in memory without copies
+    """
+
+    run_params = read_config("test")
+    run_params.traj_decimation = 10
+
+    buffer, trajectory = fly_trajectory(run_params)
+
+    # The array is a view of the C buffer rather than a copy
+    assert not trajectory.flags['OWNDATA']
+    assert trajectory.shape == (buffer.contents.num_rows, 44)
+    assert trajectory[0,0] == 0
+    assert np.all(np.diff(trajectory[:,0]) > 0)
+    assert np.isclose(np.sqrt(np.sum(trajectory[-1,2:5]**2)), 6371e3, atol=1e2)
+
+    release_trajectory(buffer)
+
+
+def test_integration_18():
+    """
+    Verify that a single Monte Carlo run can be reproduced in isolation
+    """
+
+    run_params = read_config("test")
+    run_params.num_runs = 4
+    run_params.initial_pos_error = c_double(10.0)
+    run_params.traj_decimation = 100
+
+    impact_data_pointer = pytraj.mc_run(run_params)
+
+    # Read the impact data
+    run_path = "./output/test/"
+    impact_data = np.loadtxt(run_path + "impact_data.txt", delimiter = ",", skiprows=1)
+
+    # Fly only the third run, whose last recorded row is its impact point
+    buffer, trajectory = fly_trajectory(run_params, run=2)
+    assert np.isclose(trajectory[-1,0], impact_data[2,0], atol=1e-6)
+    assert np.allclose(trajectory[-1,2:5], impact_data[2,1:4], atol=1e-3)
+    assert not np.allclose(trajectory[-1,2:5], impact_data[1,1:4], atol=1e-3)
+    release_trajectory(buffer)
+
+
+def test_integration_19():
+    """
+    Verify that the linear covariance CEP agrees with the Monte Carlo CEP for static errors
+    """
+
+    run_params = read_config("test")
+    run_params.rv_type = 0
+    run_params.rv_maneuv = 0
+    run_params.gnss_nav = 0
+    run_params.ins_nav = 1
+    run_params.grav_error = 1
+    run_params.atm_error = 1
+    run_params.initial_pos_error = c_double(0.1)
+    run_params.initial_vel_error = c_double(1e-3)
+    run_params.initial_angle_error = c_double(1e-6)
+    run_params.acc_scale_stability = c_double(1e-6)
+    run_params.gyro_bias_stability = c_double(1e-8)
+    run_params.gyro_noise = c_double(0)
+
+    lincov = lincov_run(run_params)
+    mc = mc_dispersion(run_params, 200)
+
+    assert lincov.num_flights < mc.num_flights
+    assert lincov.cep > 0
+    assert np.isclose(lincov.cep, mc.cep, rtol=0.2)
+    assert np.allclose(np.array(lincov.local_covariance), np.array(lincov.local_covariance).T)
+
+
+def test_integration_20():
+    """
+    Verify that the sigma-point dispersion flies 2n + 1 trajectories and agrees with the linear covariance
+    """
+
+    run_params = read_config("test")
+    run_params.rv_type = 0
+    run_params.rv_maneuv = 0
+    run_params.initial_pos_error = c_double(0.1)
+    run_params.initial_vel_error = c_double(1e-3)
+    run_params.initial_angle_error = c_double(1e-6)
+    run_params.acc_scale_stability = c_double(1e-6)
+    run_params.gyro_bias_stability = c_double(1e-8)
+    run_params.num_threads = 2
+
+    lincov = lincov_run(run_params)
+    unscented = unscented_run(run_params)
+
+    assert unscented.num_flights == lincov.num_flights
+    assert np.isclose(unscented.cep, lincov.cep, rtol=0.1)
+
+
+def test_integration_21():
+    """
+    Verify that the impact Jacobian gives the linear covariance, and that it rescales with the standard deviations
+    """
+
+    run_params = read_config("test")
+    run_params.rv_type = 0
+    run_params.rv_maneuv = 0
+    run_params.initial_pos_error = c_double(0.1)
+    run_params.initial_vel_error = c_double(1e-3)
+    run_params.initial_angle_error = c_double(1e-6)
+    run_params.acc_scale_stability = c_double(1e-6)
+    run_params.gyro_bias_stability = c_double(1e-8)
+    run_params.gyro_noise = c_double(0)
+    run_params.gnss_noise = c_double(0)
+
+    lincov = lincov_run(run_params)
+    jacobian = fly_jacobian(run_params)
+    sigmas = error_source_sigmas(run_params)
+
+    assert jacobian.num_flights == lincov.num_flights
+    assert np.isclose(jacobian_dispersion(jacobian, sigmas).cep, lincov.cep)
+    assert np.isclose(jacobian_dispersion(jacobian, 2 * sigmas).cep, 2 * lincov.cep, rtol=1e-3)
+
+
+def test_integration_22():
+    """
+    Verify that the Sobol analysis flies (n + 2) N trajectories and attributes the east dispersion to the
+    accelerometer and atmosphere errors
+    """
+
+    run_params = read_config("test")
+    run_params.rv_type = 0
+    run_params.rv_maneuv = 0
+    run_params.gnss_nav = 0
+    run_params.ins_nav = 1
+    run_params.grav_error = 1
+    run_params.atm_error = 1
+    run_params.initial_pos_error = c_double(0.1)
+    run_params.initial_vel_error = c_double(1e-3)
+    run_params.initial_angle_error = c_double(1e-6)
+    run_params.acc_scale_stability = c_double(1e-6)
+    run_params.gyro_bias_stability = c_double(1e-8)
+    run_params.gyro_noise = c_double(0)
+    run_params.gnss_noise = c_double(0)
+    run_params.num_threads = 2
+
+    indices = sobol_run(run_params, 64)
+    num_active = sum(indices.active)
+    east = SOBOL_OUTPUTS.index("east")
+
+    assert indices.num_flights == (num_active + 2) * 64
+    assert indices.total[east][SOBOL_FACTORS.index("acc_scale_stability")] > 0.2
+    assert indices.total[east][SOBOL_FACTORS.index("atm_error")] > 0.2
+    assert indices.total[east][SOBOL_FACTORS.index("initial_x_error")] == 0
+
+
+def test_integration_23():
+    """
+    Verify that the multilevel Monte Carlo flies fewer samples on the finer levels and reaches the requested error
+    """
+
+    run_params = read_config("test")
+    run_params.rv_type = 0
+    run_params.rv_maneuv = 0
+    run_params.gnss_nav = 0
+    run_params.ins_nav = 1
+    run_params.time_step_reentry = c_double(0.04)
+    run_params.initial_pos_error = c_double(0.1)
+    run_params.initial_vel_error = c_double(1e-3)
+    run_params.acc_scale_stability = c_double(1e-6)
+    run_params.num_threads = 2
+
+    estimate = mlmc_run(run_params, 3, 1.0)
+
+    assert estimate.num_levels == 3
+    assert abs(estimate.time_steps[0] - 0.16) < 1e-12
+    assert estimate.num_samples[0] > estimate.num_samples[2]
+    assert estimate.mean_error < 1.0 * 1.05
+    assert estimate.total_steps < estimate.mc_steps
+
+
+def test_integration_24():
+    """
+    Verify that the forked campaign shares the prefix of its flights
+    """
+
+    run_params = read_config("test")
+    run_params.rv_type = 0
+    run_params.rv_maneuv = 0
+    run_params.gnss_nav = 0
+    run_params.ins_nav = 1
+    run_params.atm_error = 1
+    run_params.time_step_reentry = c_double(0.1)
+    run_params.initial_pos_error = c_double(0.1)
+    run_params.num_threads = 2
+
+    estimate = fork_run(run_params, 4, 8)
+
+    assert estimate.dispersion.num_flights == 32
+    assert estimate.prefix_steps > estimate.fork_steps
+    assert estimate.speedup > 2
+    assert estimate.dispersion.cep > 0
+
+def test_integration_25():
+    """
+    Verify that a post-burnout ensemble replays the reentry of the Monte Carlo runs
+    """
+
+    run_params = read_config("test")
+    run_params.rv_type = 0
+    run_params.rv_maneuv = 0
+    run_params.gnss_nav = 0
+    run_params.ins_nav = 1
+    run_params.atm_error = 1
+    run_params.time_step_reentry = c_double(0.1)
+    run_params.initial_pos_error = c_double(0.1)
+    run_params.num_runs = 10
+    run_params.num_threads = 2
+    run_params.impact_data_path = c_char_p(b"./output/test/ensemble_impact_data.txt")
+
+    assert ensemble_save(run_params, "./output/test/ensemble.bin") == 10
+
+    replay = ensemble_replay(run_params, "./output/test/ensemble.bin")
+    mc = mc_dispersion(run_params, 10)
+    assert replay.num_flights == 10
+    assert replay.cep == mc.cep
+
+    # The reentry-side settings may change, the boost-side ones and the reentry time step may not
+    run_params.atm_error = 0
+    assert ensemble_replay(run_params, "./output/test/ensemble.bin").num_flights == 10
+    run_params.time_step_reentry = c_double(0.05)
+    assert ensemble_replay(run_params, "./output/test/ensemble.bin").num_flights == 0
+    run_params.time_step_reentry = c_double(0.1)
+    run_params.initial_pos_error = c_double(0.2)
+    assert ensemble_replay(run_params, "./output/test/ensemble.bin").num_flights == 0
+
+def test_integration_26():
+    """
+    Verify that importance sampling weights the tail of the miss distance
+    """
+
+    run_params = read_config("test")
+    run_params.rv_type = 0
+    run_params.rv_maneuv = 0
+    run_params.gnss_nav = 0
+    run_params.ins_nav = 1
+    run_params.atm_error = 1
+    run_params.time_step_reentry = c_double(0.1)
+    run_params.initial_pos_error = c_double(0.1)
+    run_params.num_runs = 50
+    run_params.num_threads = 2
+    run_params.impact_data_path = c_char_p(b"./output/test/importance_impact_data.txt")
+
+    estimate = importance_run(run_params, 2.5, 250)
+
+    assert estimate.num_flights == 50
+    assert 0 < estimate.effective_samples < 50
+    assert 0 < estimate.r50 <= estimate.r90 <= estimate.r99
+    assert 0 <= estimate.exceedance_probability < 1
+
+    # The impact data carries the weights
+    impact_data = np.loadtxt("./output/test/importance_impact_data.txt", delimiter = ",", skiprows=1)
+    assert impact_data.shape == (50, 8)
+    assert np.all(impact_data[:,7] > 0)
+
+def test_integration_27():
+    """
+    Verify that a response surface fitted from a design of runs evaluates a sensitivity sweep
+    """
+
+    run_params = read_config("test")
+    run_params.rv_type = 0
+    run_params.rv_maneuv = 0
+    run_params.gnss_nav = 0
+    run_params.ins_nav = 1
+    run_params.atm_error = 0
+    run_params.grav_error = 0
+    run_params.time_step_reentry = c_double(0.1)
+    run_params.initial_pos_error = c_double(0.1)
+    run_params.initial_vel_error = c_double(1e-3)
+    run_params.num_threads = 2
+
+    surrogate = surrogate_fit(run_params, 100, 20, 3.0)
+
+    assert surrogate.num_terms > 0
+    assert surrogate.validation_rms[0] < surrogate.validation_spread[0]
+
+    # The CEP grows with the scaled error field
+    ceps = [surrogate_dispersion(surrogate, {"initial_vel_error": i}, 1000).cep for i in np.logspace(-1, 1, 3)]
+    assert ceps[0] < ceps[1] < ceps[2]
+
+def test_integration_28():
+    """
+    Verify that a batch of scenarios reproduces the scenarios run one at a time
+    """
+
+    scenarios = []
+    for time_step_main in [1.0, 1.0, 2.0]:
+        run_params = read_config("test")
+        run_params.time_step_main = c_double(time_step_main)
+        run_params.time_step_reentry = c_double(0.1)
+        run_params.num_runs = 2
+        scenarios.append(run_params)
+    scenarios[2].impact_data_path = c_char_p(b"./output/test/batch_impact_data.txt")
+
+    stats = batch_run(scenarios, 2)
+
+    assert stats.num_scenarios == 3
+    assert stats.num_runs == 6
+    assert stats.num_nominals == 2
+    assert stats.num_vehicles == 1
+    assert scenarios[0].x_aim == scenarios[1].x_aim
+
+    # The last scenario matches mc_run
+    batch_data = np.loadtxt("./output/test/batch_impact_data.txt", delimiter = ",", skiprows=1)
+    scenarios[2].impact_data_path = c_char_p(b"./output/test/impact_data.txt")
+    update_aimpoint(scenarios[2], "./input/test.toml")
+    pytraj.mc_run(scenarios[2])
+    mc_data = np.loadtxt("./output/test/impact_data.txt", delimiter = ",", skiprows=1)
+    assert np.allclose(batch_data, mc_data)
+
+def test_integration_29():
+    """
+    Verify that the impact data of mc_run does not depend on the number of threads
+    """
+
+    run_params = read_config("test")
+    update_aimpoint(run_params, "./input/test.toml")
+    run_params.num_runs = 12
+    run_params.time_step_reentry = c_double(0.1)
+
+    run_params.num_threads = 1
+    pytraj.mc_run(run_params)
+    serial_data = np.loadtxt("./output/test/impact_data.txt", delimiter = ",", skiprows=1)
+
+    run_params.num_threads = 4
+    pytraj.mc_run(run_params)
+    parallel_data = np.loadtxt("./output/test/impact_data.txt", delimiter = ",", skiprows=1)
+
+    assert np.array_equal(serial_data, parallel_data)
+
+def test_integration_30():
+    """
+    Verify that pinning the worker threads of mc_run does not change its impact data
+    """
+
+    run_params = read_config("test")
+    update_aimpoint(run_params, "./input/test.toml")
+    run_params.num_runs = 12
+    run_params.num_threads = 4
+    run_params.time_step_reentry = c_double(0.1)
+
+    run_params.pin_threads = 0
+    pytraj.mc_run(run_params)
+    unpinned_data = np.loadtxt("./output/test/impact_data.txt", delimiter = ",", skiprows=1)
+
+    run_params.pin_threads = 1
+    pytraj.mc_run(run_params)
+    pinned_data = np.loadtxt("./output/test/impact_data.txt", delimiter = ",", skiprows=1)
+
+    assert np.array_equal(unpinned_data, pinned_data)
@@ -0,0 +1,73 @@
+#include "../src/include/linalg_fixed.h"
+
+// Define a macro that times one fixed-size kernel size against the gsl_matrix paths. Each product feeds the next
+// (X <- A X with A a cyclic permutation), so every product is computed and the values stay bounded
+#define BENCH_FIXED_MULTIPLY(N, num_products) \
+{ \
+    gsl_matrix *A = gsl_matrix_alloc(N, N); \
+    gsl_matrix *X = gsl_matrix_alloc(N, N); \
+    gsl_matrix *Y = gsl_matrix_alloc(N, N); \
+    gsl_matrix_set_zero(A); \
+    for (int i = 0; i < N; i++){ \
+        gsl_matrix_set(A, i, (i + 1) % N, 1); \
+        for (int j = 0; j < N; j++){ \
+            gsl_matrix_set(X, i, j, 1 + i - 0.5 * j); \
+        } \
+    } \
+    mat##N A_f, X_f, Y_f; \
+    mat##N##_from_gsl(A, &A_f); \
+    mat##N##_from_gsl(X, &X_f); \
+\
+    /* mm_multiply, allocating its result every call */ \
+    gsl_matrix *X_mm = sm_multiply(1, X); \
+    double start = bench_seconds(); \
+    for (long n = 0; n < num_products; n++){ \
+        gsl_matrix *D = mm_multiply(A, X_mm); \
+        gsl_matrix_free(X_mm); \
+        X_mm = D; \
+    } \
+    double mm_time = (bench_seconds() - start) / num_products; \
+    gsl_matrix_free(X_mm); \
+\
+    /* gsl_blas_dgemm into a preallocated result */ \
+    start = bench_seconds(); \
+    for (long n = 0; n < num_products; n++){ \
+        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, A, X, 0.0, Y); \
+        gsl_matrix *T = X; X = Y; Y = T; \
+    } \
+    double dgemm_time = (bench_seconds() - start) / num_products; \
+\
+    /* Fixed-size kernel */ \
+    start = bench_seconds(); \
+    for (long n = 0; n < num_products; n++){ \
+        mat##N##_multiply(&A_f, &X_f, &Y_f); \
+        X_f = Y_f; \
+    } \
+    double fixed_time = (bench_seconds() - start) / num_products; \
+\
+    /* Both paths apply the same permutation, so they must agree */ \
+    double error = 0; \
+    for (int i = 0; i < N; i++){ \
+        for (int j = 0; j < N; j++){ \
+            error += fabs(X_f.data[i][j] - gsl_matrix_get(X, i, j)); \
+        } \
+    } \
+\
+    printf("    %dx%d  mm_multiply: %7.1f ns  dgemm: %7.1f ns  mat%d_multiply: %6.1f ns  (%4.1fx vs mm_multiply)%s\n", \
+           N, N, 1e9 * mm_time, 1e9 * dgemm_time, N, 1e9 * fixed_time, mm_time / fixed_time, error == 0 ? "" : "  MISMATCH"); \
+\
+    gsl_matrix_free(A); \
+    gsl_matrix_free(X); \
+    gsl_matrix_free(Y); \
+}
+
+void bench_linalg_fixed(void){
+    /*
+    Measures the fixed-size matrix kernels against mm_multiply and a preallocated gsl_blas_dgemm
+    */
+
+    printf("Fixed-size matrix multiply (per dependent product)\n");
+    BENCH_FIXED_MULTIPLY(3, 2000000)
+    BENCH_FIXED_MULTIPLY(6, 1000000)
+    BENCH_FIXED_MULTIPLY(9, 500000)
+}
@@ -0,0 +1,118 @@
+#include <tau/tau.h>
+#include "../src/include/linalg_fixed.h"
+
+void fixed_test_fill(gsl_matrix *A, double seed){
+    // Fill a matrix with deterministic, well-scaled values
+    for (int i = 0; i < A->size1; i++){
+        for (int j = 0; j < A->size2; j++){
+            gsl_matrix_set(A, i, j, sin(seed + 1.3 * i + 0.7 * j));
+        }
+    }
+}
+
+TEST(linalg_fixed, mat9_multiply){
+    gsl_matrix *A = gsl_matrix_alloc(9, 9);
+    gsl_matrix *B = gsl_matrix_alloc(9, 9);
+    gsl_matrix *C = gsl_matrix_alloc(9, 9);
+    fixed_test_fill(A, 1);
+    fixed_test_fill(B, 2);
+
+    mat9 A_f, B_f, C_f;
+    mat9_from_gsl(A, &A_f);
+    mat9_from_gsl(B, &B_f);
+
+    // A B
+    mat9_multiply(&A_f, &B_f, &C_f);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, A, B, 0.0, C);
+    for (int i = 0; i < 9; i++){
+        for (int j = 0; j < 9; j++){
+            REQUIRE_LT(fabs(C_f.data[i][j] - gsl_matrix_get(C, i, j)), 1e-12);
+        }
+    }
+
+    // A^T B
+    mat9_transpose_multiply(&A_f, &B_f, &C_f);
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, A, B, 0.0, C);
+    for (int i = 0; i < 9; i++){
+        for (int j = 0; j < 9; j++){
+            REQUIRE_LT(fabs(C_f.data[i][j] - gsl_matrix_get(C, i, j)), 1e-12);
+        }
+    }
+
+    // A B^T, written through a gsl view of the fixed-size result
+    mat9_multiply_transpose(&A_f, &B_f, &C_f);
+    gsl_matrix_view C_view = mat9_view(&C_f);
+    gsl_blas_dgemm(CblasNoTrans, CblasTrans, -1.0, A, B, 1.0, &C_view.matrix);
+    for (int i = 0; i < 9; i++){
+        for (int j = 0; j < 9; j++){
+            REQUIRE_LT(fabs(C_f.data[i][j]), 1e-12);
+        }
+    }
+
+    gsl_matrix_free(A);
+    gsl_matrix_free(B);
+    gsl_matrix_free(C);
+}
+
+TEST(linalg_fixed, mat6_symmetric_update){
+    gsl_matrix *A = gsl_matrix_alloc(6, 6);
+    gsl_matrix *P = gsl_matrix_alloc(6, 6);
+    fixed_test_fill(A, 3);
+    gsl_matrix_set_identity(P);
+    gsl_matrix_set(P, 0, 1, 0.5);
+    gsl_matrix_set(P, 1, 0, 0.5);
+
+    mat6 A_f, P_f, Q_f, C_f;
+    mat6_from_gsl(A, &A_f);
+    mat6_from_gsl(P, &P_f);
+    memset(&Q_f, 0, sizeof(Q_f));
+    for (int i = 0; i < 6; i++){
+        Q_f.data[i][i] = 0.1;
+    }
+
+    mat6_symmetric_update(&A_f, &P_f, &Q_f, &C_f);
+
+    // Compare with A P A^T + Q through the allocating helpers
+    gsl_matrix *AP = mm_multiply(A, P);
+    gsl_matrix *A_t = m_transpose(A);
+    gsl_matrix *APA_t = mm_multiply(AP, A_t);
+    for (int i = 0; i < 6; i++){
+        for (int j = 0; j < 6; j++){
+            REQUIRE_LT(fabs(C_f.data[i][j] - gsl_matrix_get(APA_t, i, j) - Q_f.data[i][j]), 1e-12);
+            REQUIRE_EQ(C_f.data[i][j], C_f.data[j][i]);
+        }
+    }
+
+    gsl_matrix_free(A);
+    gsl_matrix_free(P);
+    gsl_matrix_free(AP);
+    gsl_matrix_free(A_t);
+    gsl_matrix_free(APA_t);
+}
+
+TEST(linalg_fixed, mat3_solve){
+    mat3 A = {{{4, 1, 0.5}, {1, 3, 0.2}, {0.5, 0.2, 2}}};
+    mat3 B = {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
+    mat3 X, AX;
+
+    // Solve in place for the inverse and check A X = I
+    REQUIRE_EQ(mat3_solve(&A, &B, &B), 0);
+    X = B;
+    mat3_multiply(&A, &X, &AX);
+    for (int i = 0; i < 3; i++){
+        for (int j = 0; j < 3; j++){
+            REQUIRE_LT(fabs(AX.data[i][j] - (i == j)), 1e-12);
+        }
+    }
+
+    // Matrix-vector product
+    vec3 x = {{1, 2, 3}};
+    vec3 y;
+    mat3_vector_multiply(&A, &x, &y);
+    REQUIRE_LT(fabs(y.data[0] - 7.5), 1e-12);
+    REQUIRE_LT(fabs(y.data[2] - 6.9), 1e-12);
+
+    // A matrix that is not positive definite is rejected
+    A.data[2][2] = -1;
+    REQUIRE_EQ(mat3_solve(&A, &B, &X), -1);
+}
@@ -294,4 +294,152 @@ TEST(linalg, m_pseudoinverse){
     gsl_matrix_free(C_pinv_test);
 
 
-}
\ No newline at end of file
+}
+
+TEST(linalg, linalg_arena){
+    linalg_arena *arena = linalg_arena_alloc(256);
+
+    // Reservations are 32-byte aligned and reused after a reset
+    void *first = linalg_arena_push(arena, 24);
+    void *second = linalg_arena_push(arena, 8);
+    REQUIRE_EQ((size_t)first % 32, 0);
+    REQUIRE_EQ((size_t)second % 32, 0);
+    REQUIRE_TRUE(first != second);
+
+    // Overflowing the chunk retires it, and the reset replaces it with one large enough for the whole step
+    for (int i = 0; i < 20; i++){
+        linalg_arena_push(arena, 100);
+    }
+    REQUIRE_GT(arena->num_retired, 0);
+    size_t used = arena->used;
+    linalg_arena_reset(arena);
+    REQUIRE_EQ(arena->num_retired, 0);
+    REQUIRE_GE(arena->capacity, used);
+    REQUIRE_EQ(arena->used, 0);
+
+    void *reused = linalg_arena_push(arena, 24);
+    char *data = arena->data;
+    for (int i = 0; i < 20; i++){
+        linalg_arena_push(arena, 100);
+    }
+    REQUIRE_EQ(arena->num_retired, 0);
+    linalg_arena_reset(arena);
+    REQUIRE_TRUE(linalg_arena_push(arena, 24) == reused);
+    REQUIRE_TRUE(arena->data == data);
+
+    linalg_arena_free(arena);
+}
+
+TEST(linalg, linalg_scratch){
+    gsl_matrix *A = gsl_matrix_alloc(2, 3);
+    gsl_matrix *B = gsl_matrix_alloc(3, 2);
+    gsl_vector *v = gsl_vector_alloc(3);
+    gsl_vector *w = gsl_vector_alloc(3);
+    for (int i = 0; i < 3; i++){
+        for (int j = 0; j < 2; j++){
+            gsl_matrix_set(A, j, i, 1 + i + 2*j);
+            gsl_matrix_set(B, i, j, 0.5 * i - j);
+        }
+        gsl_vector_set(v, i, i);
+        gsl_vector_set(w, i, 1 - i);
+    }
+
+    // Each scratch helper matches its allocating counterpart, over several resets
+    for (int step = 0; step < 3; step++){
+        gsl_matrix *pairs[6][2] = {
+            {m_transpose(A), m_transpose_scratch(A)},
+            {mm_multiply(A, B), mm_multiply_scratch(A, B)},
+            {sm_multiply(-2, A), sm_multiply_scratch(-2, A)},
+            {mm_add(A, A), mm_add_scratch(A, A)},
+            {m_pseudoinverse(sm_multiply(1, A)), m_pseudoinverse_scratch(A)},
+            {m_pseudoinverse(sm_multiply(1, B)), m_pseudoinverse_scratch(B)},
+        };
+        for (int k = 0; k < 6; k++){
+            REQUIRE_EQ(pairs[k][0]->size1, pairs[k][1]->size1);
+            REQUIRE_EQ(pairs[k][0]->size2, pairs[k][1]->size2);
+            for (int i = 0; i < pairs[k][0]->size1; i++){
+                for (int j = 0; j < pairs[k][0]->size2; j++){
+                    REQUIRE_LT(fabs(gsl_matrix_get(pairs[k][0], i, j) - gsl_matrix_get(pairs[k][1], i, j)), 1e-10);
+                }
+            }
+            gsl_matrix_free(pairs[k][0]);
+        }
+
+        gsl_vector *vectors[3][2] = {
+            {mv_multiply(A, v), mv_multiply_scratch(A, v)},
+            {vv_add(v, w), vv_add_scratch(v, w)},
+            {vv_subtract(v, w), vv_subtract_scratch(v, w)},
+        };
+        for (int k = 0; k < 3; k++){
+            REQUIRE_EQ(vectors[k][0]->size, vectors[k][1]->size);
+            for (int i = 0; i < vectors[k][0]->size; i++){
+                REQUIRE_LT(fabs(gsl_vector_get(vectors[k][0], i) - gsl_vector_get(vectors[k][1], i)), 1e-10);
+            }
+            gsl_vector_free(vectors[k][0]);
+        }
+
+        linalg_scratch_reset();
+    }
+
+    // The scratch pseudoinverse leaves its argument unchanged
+    REQUIRE_EQ(gsl_matrix_get(A, 1, 2), 5);
+
+    gsl_matrix_free(A);
+    gsl_matrix_free(B);
+    gsl_vector_free(v);
+    gsl_vector_free(w);
+    linalg_scratch_free();
+}
+
+TEST(linalg, factorization_status){
+    gsl_matrix *A = gsl_matrix_alloc(3, 3);
+    gsl_matrix *F = gsl_matrix_alloc(3, 3);
+    double values[3][3] = {{4, 2, 1}, {2, 5, 3}, {1, 3, 6}};
+    for (int i = 0; i < 3; i++){
+        for (int j = 0; j < 3; j++){
+            gsl_matrix_set(A, i, j, values[i][j]);
+        }
+    }
+
+    // The Cholesky factor reproduces A = L L^T, with L^T mirrored in the upper triangle
+    gsl_matrix_memcpy(F, A);
+    REQUIRE_EQ(m_cholesky_decomp(F), GSL_SUCCESS);
+    for (int i = 0; i < 3; i++){
+        for (int j = 0; j < 3; j++){
+            double sum = 0;
+            for (int k = 0; k <= i && k <= j; k++){
+                sum += gsl_matrix_get(F, i, k) * gsl_matrix_get(F, j, k);
+            }
+            REQUIRE_LT(fabs(sum - values[i][j]), 1e-12);
+            if (j > i){
+                REQUIRE_EQ(gsl_matrix_get(F, i, j), gsl_matrix_get(F, j, i));
+            }
+        }
+    }
+
+    // The LDL^T factor reproduces an indefinite A = L D L^T
+    gsl_matrix_set(A, 2, 2, -6);
+    values[2][2] = -6;
+    gsl_matrix_memcpy(F, A);
+    REQUIRE_NE(m_cholesky_decomp(F), GSL_SUCCESS);
+    gsl_matrix_memcpy(F, A);
+    REQUIRE_EQ(m_ldlt_decomp(F), GSL_SUCCESS);
+    for (int i = 0; i < 3; i++){
+        for (int j = 0; j < 3; j++){
+            double sum = 0;
+            for (int k = 0; k <= i && k <= j; k++){
+                double l_i = (k == i) ? 1 : gsl_matrix_get(F, i, k);
+                double l_j = (k == j) ? 1 : gsl_matrix_get(F, j, k);
+                sum += l_i * gsl_matrix_get(F, k, k) * l_j;
+            }
+            REQUIRE_LT(fabs(sum - values[i][j]), 1e-12);
+        }
+    }
+
+    // A zero pivot is reported, not raised
+    gsl_matrix_set_zero(F);
+    REQUIRE_NE(m_ldlt_decomp(F), GSL_SUCCESS);
+
+    gsl_matrix_free(A);
+    gsl_matrix_free(F);
+}
@@ -0,0 +1,147 @@
+#include <tau/tau.h>
+#include "../src/include/lincov.h"
+
+void lincov_test_params(runparams *run_params){
+    /*
+    Sets run parameters with static errors only, for the linear covariance tests
+
+    INPUTS:
+    ----------
+        run_params: runparams *
+            pointer to the run parameters struct
+    */
+
+    memset(run_params, 0, sizeof(*run_params));
+    run_params->time_step_main = 1;
+    run_params->time_step_reentry = 0.01;
+    run_params->theta_long = 1.04719755;
+    run_params->ins_nav = 1;
+    run_params->grav_error = 1;
+    run_params->atm_error = 1;
+    run_params->initial_pos_error = 0.1;
+    run_params->initial_vel_error = 1e-3;
+    run_params->initial_angle_error = 1e-6;
+    run_params->acc_scale_stability = 1e-6;
+    run_params->gyro_bias_stability = 1e-8;
+}
+
+TEST(lincov, cep_from_covariance){
+    // Circular distribution: median of the Rayleigh distribution
+    REQUIRE_LT(fabs(cep_from_covariance(1, 1, 0) - 1.1774100225), 1e-9);
+    REQUIRE_LT(fabs(cep_from_covariance(4, 4, 0) - 2 * 1.1774100225), 1e-9);
+
+    // Degenerate distribution: median of the half-normal distribution
+    REQUIRE_LT(fabs(cep_from_covariance(1, 0, 0) - 0.6744897502), 1e-9);
+    REQUIRE_EQ(cep_from_covariance(0, 0, 0), 0);
+
+    // The CEP depends only on the principal axes: [[2, 1], [1, 2]] has the eigenvalues 3 and 1
+    double rotated = cep_from_covariance(2, 2, 1);
+    double principal = cep_from_covariance(3, 1, 0);
+    REQUIRE_LT(fabs(rotated - principal), 1e-9);
+    REQUIRE_GT(principal, 0.6744897502 * sqrt(3));
+    REQUIRE_LT(principal, 1.1774100225 * sqrt(3));
+}
+
+TEST(lincov, fly_deviates){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.1;
+
+    // Trajectories with the same deviates are identical
+    double deviates[NUM_ERROR_SOURCES] = {0};
+    double time_error, time_error_again;
+    state nominal = fly_deviates(&run_params, deviates, &time_error);
+    state nominal_again = fly_deviates(&run_params, deviates, &time_error_again);
+    REQUIRE_EQ(nominal.x, nominal_again.x);
+    REQUIRE_EQ(nominal.y, nominal_again.y);
+    REQUIRE_EQ(time_error, time_error_again);
+
+    // A velocity error moves the impact point, and the opposite error moves it back by about the same distance
+    deviates[ERROR_INITIAL_VX] = 1;
+    state plus = fly_deviates(&run_params, deviates, &time_error);
+    deviates[ERROR_INITIAL_VX] = -1;
+    state minus = fly_deviates(&run_params, deviates, &time_error);
+    double miss_plus = sqrt(pow(plus.x - nominal.x, 2) + pow(plus.y - nominal.y, 2) + pow(plus.z - nominal.z, 2));
+    double miss_minus = sqrt(pow(minus.x - nominal.x, 2) + pow(minus.y - nominal.y, 2) + pow(minus.z - nominal.z, 2));
+    REQUIRE_GT(miss_plus, 0);
+    REQUIRE_LT(fabs(miss_plus - miss_minus), 0.1 * miss_plus);
+}
+
+TEST(lincov, lincov_run){
+    runparams run_params;
+    lincov_test_params(&run_params);
+
+    // Without errors only the nominal trajectory is flown
+    runparams no_errors;
+    memset(&no_errors, 0, sizeof(no_errors));
+    no_errors.time_step_main = 1;
+    no_errors.time_step_reentry = 0.1;
+    no_errors.theta_long = 1.04719755;
+    impact_dispersion nominal = lincov_run(no_errors);
+    REQUIRE_EQ(nominal.num_flights, 1);
+    REQUIRE_EQ(nominal.cep, 0);
+
+    // One nominal and two perturbed flights for each active source (the x position error is off)
+    double sigmas[NUM_ERROR_SOURCES];
+    error_source_sigmas(&run_params, sigmas);
+    int num_active = 0;
+    for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+        num_active += (sigmas[source] > 0);
+    }
+    REQUIRE_EQ(num_active, NUM_ERROR_SOURCES - 1);
+
+    impact_dispersion lincov = lincov_run(run_params);
+    REQUIRE_EQ(lincov.num_flights, 1 + 2 * num_active);
+    REQUIRE_GT(lincov.cep, 0);
+    REQUIRE_LT(fabs(lincov.local_covariance[0][1] - lincov.local_covariance[1][0]), 1e-9 * lincov.local_covariance[0][0]);
+
+    // Cross-check against Monte Carlo: the linearized dispersion agrees to within the sampling error
+    impact_dispersion mc = mc_dispersion(run_params, 200);
+    REQUIRE_EQ(mc.num_flights, 200);
+    REQUIRE_LT(fabs(lincov.cep - mc.cep), 0.2 * mc.cep);
+    REQUIRE_LT(fabs(lincov.local_covariance[0][0] - mc.local_covariance[0][0]), 0.3 * mc.local_covariance[0][0]);
+    double mean_offset = sqrt(pow(lincov.mean[0] - mc.mean[0], 2) + pow(lincov.mean[1] - mc.mean[1], 2) + pow(lincov.mean[2] - mc.mean[2], 2));
+    REQUIRE_LT(mean_offset, mc.cep);
+}
+
+TEST(lincov, fly_jacobian){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.1;
+
+    // The Jacobian is taken about the nominal trajectory, from the flights of lincov_run
+    double deviates[NUM_ERROR_SOURCES] = {0};
+    double time_error;
+    state nominal = fly_deviates(&run_params, deviates, &time_error);
+    impact_jacobian jacobian = fly_jacobian(&run_params);
+    REQUIRE_EQ(jacobian.num_flights, 1 + 2 * (NUM_ERROR_SOURCES - 1));
+    REQUIRE_EQ(jacobian.impact[0], nominal.x);
+    REQUIRE_EQ(jacobian.impact[1], nominal.y);
+    REQUIRE_EQ(jacobian.impact[2], nominal.z);
+    REQUIRE_EQ(jacobian.time_error, time_error);
+
+    // Derivatives per unit of the source, zero for the inactive x position error
+    double sigmas[NUM_ERROR_SOURCES];
+    error_source_sigmas(&run_params, sigmas);
+    deviates[ERROR_INITIAL_VX] = LINCOV_STEP;
+    state plus = fly_deviates(&run_params, deviates, &time_error);
+    deviates[ERROR_INITIAL_VX] = -LINCOV_STEP;
+    state minus = fly_deviates(&run_params, deviates, &time_error);
+    double difference = (plus.x - minus.x) / (2 * LINCOV_STEP);
+    REQUIRE_LT(fabs(sigmas[ERROR_INITIAL_VX] * jacobian.jacobian[0][ERROR_INITIAL_VX] - difference), 1e-9 * fabs(difference));
+    for (int i = 0; i < 3; i++){
+        REQUIRE_EQ(jacobian.jacobian[i][ERROR_INITIAL_X], 0);
+    }
+
+    // Mapping the standard deviations of the run parameters gives lincov_run, and other standard deviations need
+    // no new flights: doubling them all about doubles the CEP
+    impact_dispersion lincov = lincov_run(run_params);
+    impact_dispersion mapped = jacobian_dispersion(&jacobian, sigmas);
+    REQUIRE_LT(fabs(mapped.cep - lincov.cep), 1e-9 * lincov.cep);
+    for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+        sigmas[source] *= 2;
+    }
+    impact_dispersion doubled = jacobian_dispersion(&jacobian, sigmas);
+    REQUIRE_EQ(doubled.num_flights, jacobian.num_flights);
+    REQUIRE_LT(fabs(doubled.cep - 2 * lincov.cep), 1e-3 * lincov.cep);
+}
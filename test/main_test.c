@@ -10,6 +10,23 @@
 #include "guidance_test.h"
 #include "maneuverability_test.h"
 #include "linalg_test.h"
+#include "linalg_fixed_test.h"
 #include "filters_test.h"
+#include "writer_test.h"
+#include "recorder_test.h"
+#include "hermite_test.h"
+#include "noise_test.h"
+#include "philox_test.h"
+#include "scheduler_test.h"
+#include "lincov_test.h"
+#include "pool_test.h"
+#include "unscented_test.h"
+#include "sobol_test.h"
+#include "mlmc_test.h"
+#include "fork_test.h"
+#include "ensemble_test.h"
+#include "importance_test.h"
+#include "surrogate_test.h"
+#include "batch_test.h"
 
 TAU_MAIN()
\ No newline at end of file
@@ -242,4 +242,42 @@ TEST(maneuverability, update_lift){
     REQUIRE_LT(true_state.ay_lift, 1);
     REQUIRE_LT(true_state.az_lift, 1);
 
-}
\ No newline at end of file
+}
+TEST(maneuverability, update_lift_interval){
+    // A fast vehicle at low altitude has a lift time constant far below the lift rate-group interval
+    state true_state;
+    memset(&true_state, 0, sizeof(true_state));
+    true_state.x = 6371e3 + 10;
+    true_state.vx = -3000;
+
+    vehicle vehicle;
+    vehicle.rv = init_swerve_rv();
+    vehicle.booster = init_mmiii_booster();
+    vehicle.total_mass = vehicle.rv.rv_mass;
+    vehicle.current_mass = vehicle.total_mass;
+
+    atm_cond atm_cond;
+    memset(&atm_cond, 0, sizeof(atm_cond));
+    atm_cond.density = 1.225;
+
+    double time_constant = rv_time_constant(&vehicle, &true_state, &atm_cond);
+    double interval = 0.1;
+    REQUIRE_GT(interval, 3 * time_constant);
+
+    // The executed acceleration moves toward the command without overshooting it, in both directions
+    cart_vector a_command = {1, -1, 0.5};
+    true_state.ax_lift = 0;
+    true_state.ay_lift = 0;
+    true_state.az_lift = 2;
+    for (int i = 0; i < 5; i++){
+        double old_lift[3] = {true_state.ax_lift, true_state.ay_lift, true_state.az_lift};
+        update_lift(&true_state, &a_command, &atm_cond, &vehicle, interval);
+        REQUIRE_GE(true_state.ax_lift, old_lift[0]);
+        REQUIRE_LE(true_state.ax_lift, a_command.x);
+        REQUIRE_LE(true_state.ay_lift, old_lift[1]);
+        REQUIRE_GE(true_state.ay_lift, a_command.y);
+        REQUIRE_LE(true_state.az_lift, old_lift[2]);
+        REQUIRE_GE(true_state.az_lift, a_command.z);
+    }
+    REQUIRE_LT(fabs(true_state.ax_lift - a_command.x), 1e-3);
+}
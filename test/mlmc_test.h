@@ -0,0 +1,50 @@
+#include <tau/tau.h>
+#include "../src/include/mlmc.h"
+
+TEST(mlmc, mlmc_time_step){
+    // The finest level is the reentry time step of the run parameters, each coarser level doubles it
+    runparams run_params;
+    lincov_test_params(&run_params);
+    REQUIRE_EQ(mlmc_time_step(&run_params, 3, 2), run_params.time_step_reentry);
+    REQUIRE_LT(fabs(mlmc_time_step(&run_params, 3, 1) - 2 * run_params.time_step_reentry), 1e-15);
+    REQUIRE_LT(fabs(mlmc_time_step(&run_params, 3, 0) - 4 * run_params.time_step_reentry), 1e-15);
+}
+
+TEST(mlmc, mlmc_run){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.04;
+    cart_vector aimpoint = update_aimpoint(run_params, run_params.theta_long);
+    run_params.x_aim = aimpoint.x;
+    run_params.y_aim = aimpoint.y;
+    run_params.z_aim = aimpoint.z;
+
+    double tolerance = 4;
+    run_params.num_threads = 1;
+    mlmc_estimate serial = mlmc_run(run_params, 3, tolerance);
+
+    // The corrections of the coupled pairs shrink with the time step, so the fine levels need the fewest samples
+    REQUIRE_EQ(serial.num_levels, 3);
+    REQUIRE_GT(serial.variances[0], 100 * serial.variances[1]);
+    REQUIRE_GT(serial.variances[1], serial.variances[2]);
+    REQUIRE_GT(serial.num_samples[0], serial.num_samples[2]);
+    REQUIRE_GE(serial.num_samples[2], MLMC_WARMUP);
+    REQUIRE_LT(serial.mean_error, 1.05 * tolerance);
+    REQUIRE_LT(serial.total_steps, serial.mc_steps);
+
+    // The results do not depend on the number of threads
+    run_params.num_threads = 4;
+    mlmc_estimate parallel = mlmc_run(run_params, 3, tolerance);
+    REQUIRE_EQ(serial.mean_miss, parallel.mean_miss);
+    REQUIRE_EQ(serial.dispersion.cep, parallel.dispersion.cep);
+    REQUIRE_EQ(serial.num_samples[0], parallel.num_samples[0]);
+
+    // The estimate agrees with a single-level Monte Carlo at the finest time step
+    mlmc_estimate single = mlmc_run(run_params, 1, tolerance);
+    REQUIRE_EQ(single.num_levels, 1);
+    REQUIRE_LT(fabs(serial.mean_miss - single.mean_miss), 4 * sqrt(serial.miss_error * serial.miss_error + single.miss_error * single.miss_error));
+    REQUIRE_LT(fabs(serial.dispersion.cep - single.dispersion.cep), 0.1 * single.dispersion.cep);
+    for (int i = 0; i < 3; i++){
+        REQUIRE_LT(fabs(serial.dispersion.mean[i] - single.dispersion.mean[i]), 4 * tolerance);
+    }
+}
@@ -0,0 +1,34 @@
+#include <gsl/gsl_randist.h>
+#include "../src/include/noise.h"
+
+void bench_noise(void){
+    /*
+    Measures the cost of a standard normal draw from the block noise buffer against gsl_ran_gaussian
+    */
+
+    long num_samples = 20000000;
+    gsl_rng_env_setup();
+    gsl_rng *rng = gsl_rng_alloc(gsl_rng_default);
+    noise_buffer noise;
+    noise_buffer_init(&noise, rng);
+
+    printf("Gaussian noise (%ld draws)\n", num_samples);
+
+    double sum = 0;
+    double start = bench_seconds();
+    for (long i = 0; i < num_samples; i++){
+        sum += gsl_ran_gaussian(rng, 1);
+    }
+    double gsl_time = (bench_seconds() - start) / num_samples;
+
+    start = bench_seconds();
+    for (long i = 0; i < num_samples; i++){
+        sum += noise_gaussian(&noise, 1);
+    }
+    double noise_time = (bench_seconds() - start) / num_samples;
+
+    printf("    gsl_ran_gaussian:           %8.2f ns/draw\n", 1e9 * gsl_time);
+    printf("    noise_gaussian (blocks):    %8.2f ns/draw (checksum %.3f)\n", 1e9 * noise_time, sum / num_samples);
+
+    gsl_rng_free(rng);
+}
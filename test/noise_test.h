@@ -0,0 +1,55 @@
+#include <tau/tau.h>
+#include "../src/include/noise.h"
+
+TEST(noise, noise_gaussian){
+    noise_buffer noise;
+    noise_buffer_seed(&noise, 42);
+
+    // Sample moments of several blocks match a standard normal
+    int num_samples = 50 * NOISE_BLOCK_SIZE + 7;
+    double sum = 0;
+    double sum_sq = 0;
+    double sum_4 = 0;
+    for (int i = 0; i < num_samples; i++){
+        double x = noise_gaussian(&noise, 1);
+        REQUIRE_TRUE(isfinite(x));
+        sum += x;
+        sum_sq += x * x;
+        sum_4 += x * x * x * x;
+    }
+    double mean = sum / num_samples;
+    double variance = sum_sq / num_samples - mean * mean;
+    REQUIRE_LT(fabs(mean), 0.02);
+    REQUIRE_LT(fabs(variance - 1), 0.03);
+    REQUIRE_LT(fabs(sum_4 / num_samples - 3), 0.15);
+
+    // Samples scale with the standard deviation
+    noise_buffer_seed(&noise, 42);
+    double first = noise_gaussian(&noise, 1);
+    noise_buffer_seed(&noise, 42);
+    REQUIRE_EQ(noise_gaussian(&noise, 2.5), 2.5 * first);
+}
+
+TEST(noise, noise_buffer_init){
+    // The same GSL seed gives the same sequence, and a different seed a different one
+    gsl_rng *rng = gsl_rng_alloc(gsl_rng_default);
+    noise_buffer noise_0;
+    noise_buffer noise_1;
+    noise_buffer noise_2;
+    gsl_rng_set(rng, 7);
+    noise_buffer_init(&noise_0, rng);
+    gsl_rng_set(rng, 7);
+    noise_buffer_init(&noise_1, rng);
+    gsl_rng_set(rng, 8);
+    noise_buffer_init(&noise_2, rng);
+
+    int num_equal = 0;
+    for (int i = 0; i < 2 * NOISE_BLOCK_SIZE; i++){
+        double x = noise_gaussian(&noise_0, 1);
+        REQUIRE_EQ(x, noise_gaussian(&noise_1, 1));
+        num_equal += (x == noise_gaussian(&noise_2, 1));
+    }
+    REQUIRE_EQ(num_equal, 0);
+
+    gsl_rng_free(rng);
+}
@@ -0,0 +1,62 @@
+#include <tau/tau.h>
+#include "../src/include/philox.h"
+
+TEST(philox, philox4x32){
+    // Known-answer vectors of Philox4x32-10 from the Random123 distribution
+    uint32_t output[4];
+
+    uint32_t counter_0[4] = {0, 0, 0, 0};
+    uint32_t key_0[2] = {0, 0};
+    philox4x32(counter_0, key_0, output);
+    REQUIRE_EQ(output[0], 0x6627e8d5U);
+    REQUIRE_EQ(output[1], 0xe169c58dU);
+    REQUIRE_EQ(output[2], 0xbc57ac4cU);
+    REQUIRE_EQ(output[3], 0x9b00dbd8U);
+
+    uint32_t counter_1[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+    uint32_t key_1[2] = {0xa4093822, 0x299f31d0};
+    philox4x32(counter_1, key_1, output);
+    REQUIRE_EQ(output[0], 0xd16cfe09U);
+    REQUIRE_EQ(output[1], 0x94fdccebU);
+    REQUIRE_EQ(output[2], 0x5001e420U);
+    REQUIRE_EQ(output[3], 0x24126ea1U);
+}
+
+TEST(philox, philox_set_stream){
+    gsl_rng *rng_a = philox_alloc(7, 734, PHILOX_STREAM_RUN);
+    gsl_rng *rng_b = philox_alloc(7, 0, PHILOX_STREAM_RUN);
+
+    // The sequence of a run is the same whether or not earlier runs were drawn first
+    for (int i = 0; i < 1000; i++){
+        gsl_rng_get(rng_b);
+    }
+    philox_set_stream(rng_b, 7, 734, PHILOX_STREAM_RUN);
+    for (int i = 0; i < 100; i++){
+        REQUIRE_EQ(gsl_rng_get(rng_a), gsl_rng_get(rng_b));
+    }
+
+    // Other runs and streams give different sequences
+    philox_set_stream(rng_a, 7, 734, PHILOX_STREAM_RUN);
+    philox_set_stream(rng_b, 7, 735, PHILOX_STREAM_RUN);
+    gsl_rng *rng_c = philox_alloc(7, 734, PHILOX_STREAM_RUN + 1);
+    int num_equal = 0;
+    for (int i = 0; i < 100; i++){
+        unsigned long a = gsl_rng_get(rng_a);
+        num_equal += (a == gsl_rng_get(rng_b)) + (a == gsl_rng_get(rng_c));
+    }
+    REQUIRE_EQ(num_equal, 0);
+
+    // Uniform doubles are in [0, 1) with the expected mean
+    double sum = 0;
+    for (int i = 0; i < 100000; i++){
+        double u = gsl_rng_uniform(rng_a);
+        REQUIRE_GE(u, 0);
+        REQUIRE_LT(u, 1);
+        sum += u;
+    }
+    REQUIRE_LT(fabs(sum / 100000 - 0.5), 0.01);
+
+    gsl_rng_free(rng_a);
+    gsl_rng_free(rng_b);
+    gsl_rng_free(rng_c);
+}
@@ -197,6 +197,22 @@ TEST(physics, update_drag){
     
 }
 
+TEST(physics, get_stage){
+    vehicle vehicle;
+    vehicle.rv = init_ballistic_rv();
+    vehicle.booster = init_mmiii_booster();
+
+    // Check the stage boundaries
+    REQUIRE_EQ(get_stage(&vehicle, 0), 0);
+    REQUIRE_EQ(get_stage(&vehicle, vehicle.booster.burn_time[0]), 0);
+    REQUIRE_EQ(get_stage(&vehicle, vehicle.booster.burn_time[0] + 1), 1);
+    REQUIRE_EQ(get_stage(&vehicle, vehicle.booster.burn_time[0] + vehicle.booster.burn_time[1] + 1), 2);
+    REQUIRE_EQ(get_stage(&vehicle, vehicle.booster.total_burn_time), 2);
+
+    // Check that the stage index is the number of stages after burnout
+    REQUIRE_EQ(get_stage(&vehicle, vehicle.booster.total_burn_time + 1), vehicle.booster.num_stages);
+}
+
 TEST(physics, update_thrust){
     vehicle vehicle;
     vehicle.rv = init_ballistic_rv();
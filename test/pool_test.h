@@ -0,0 +1,179 @@
+#include <tau/tau.h>
+#include "../src/include/pool.h"
+
+// Define a struct to store the per-index counts of a test loop
+typedef struct pool_test_counts{
+    atomic_int counts[1000];
+    atomic_int total;
+} pool_test_counts;
+
+void pool_test_task(void *context, int index){
+    /*
+    Counts the calls of each index (pool_task interface)
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the pool_test_counts struct
+        index: int
+            index of the iteration
+    */
+
+    pool_test_counts *counts = (pool_test_counts *)context;
+    atomic_fetch_add(&counts->counts[index], 1);
+    atomic_fetch_add(&counts->total, index);
+}
+
+TEST(pool, pool_run){
+    static pool_test_counts counts;
+
+    // Every iteration runs exactly once, over several loops on the same pool
+    worker_pool pool;
+    pool_init(&pool, 4);
+    REQUIRE_EQ(pool.num_threads, 4);
+    for (int loop = 1; loop <= 3; loop++){
+        pool_run(&pool, pool_test_task, &counts, 1000);
+        int exact = 1;
+        for (int i = 0; i < 1000; i++){
+            exact &= (atomic_load(&counts.counts[i]) == loop);
+        }
+        REQUIRE_EQ(exact, 1);
+        REQUIRE_EQ(atomic_load(&counts.total), loop * 999 * 1000 / 2);
+    }
+
+    // Empty and single-iteration loops run on the calling thread
+    pool_run(&pool, pool_test_task, &counts, 0);
+    pool_run(&pool, pool_test_task, &counts, 1);
+    REQUIRE_EQ(atomic_load(&counts.counts[0]), 4);
+    REQUIRE_EQ(atomic_load(&counts.counts[1]), 3);
+    pool_free(&pool);
+
+    // A temporary pool with the default number of threads
+    parallel_for(0, pool_test_task, &counts, 1000);
+    REQUIRE_EQ(atomic_load(&counts.counts[999]), 4);
+    REQUIRE_GE(pool_default_threads(), 1);
+}
+
+// Define a struct to store the counts of a test loop whose first range waits for the other threads to steal
+typedef struct pool_test_gate{
+    pool_test_counts counts; // per-index counts of the loop
+    worker_pool *pool; // pool running the loop
+} pool_test_gate;
+
+void pool_test_gated_task(void *context, int index){
+    /*
+    Counts the calls of each index, holding the iterations of the range of the calling thread until every other
+    thread has stolen, so that the calling thread stays blocked while the others run out of work (pool_task
+    interface)
+
+    INPUTS:
+    ----------
+        context: void *
+            pointer to the pool_test_gate struct
+        index: int
+            index of the iteration
+    */
+
+    pool_test_gate *gate = (pool_test_gate *)context;
+    worker_pool *pool = gate->pool;
+    if (index < pool->num_tasks / pool->num_threads){
+        for (int i = 1; i < pool->num_threads; i++){
+            while (__atomic_load_n(&pool->stats[i].steals, __ATOMIC_RELAXED) == 0){
+                struct timespec delay = {0, 100000};
+                nanosleep(&delay, NULL);
+            }
+        }
+    }
+    pool_test_task(&gate->counts, index);
+}
+
+TEST(pool, work_stealing){
+    static pool_test_gate gate;
+
+    // The calling thread blocks on the first iteration of its range, so the others must steal the rest of it
+    worker_pool pool;
+    pool_init(&pool, 4);
+    gate.pool = &pool;
+    pool_run(&pool, pool_test_gated_task, &gate, 1000);
+    int exact = 1;
+    for (int i = 0; i < 1000; i++){
+        exact &= (atomic_load(&gate.counts.counts[i]) == 1);
+    }
+    REQUIRE_EQ(exact, 1);
+
+    int tasks = 0;
+    int chunks = 0;
+    for (int i = 0; i < 4; i++){
+        tasks += pool.stats[i].tasks;
+        chunks += pool.stats[i].chunks;
+        REQUIRE_LE(pool.stats[i].busy_time, pool.loop_time);
+    }
+    REQUIRE_EQ(tasks, 1000);
+    for (int i = 1; i < 4; i++){
+        REQUIRE_GT(pool.stats[i].steals, 0);
+    }
+
+    // Chunks shrink as a range empties, so there are more chunks than threads but fewer than iterations
+    REQUIRE_GT(chunks, 4);
+    REQUIRE_LT(chunks, 1000);
+    pool_free(&pool);
+
+    // A single-thread pool reports the whole loop on the calling thread
+    pool_init(&pool, 1);
+    pool_run(&pool, pool_test_task, &gate.counts, 10);
+    REQUIRE_EQ(pool.stats[0].tasks, 10);
+    REQUIRE_EQ(pool.stats[0].steals, 0);
+    pool_free(&pool);
+}
+
+TEST(pool, cpu_nodes){
+    int cpu_nodes[12] = {0};
+    pool_parse_cpulist("1-3,8\n", cpu_nodes, 12, 1);
+    pool_parse_cpulist("10-13", cpu_nodes, 12, 2);
+    REQUIRE_EQ(cpu_nodes[0], 0);
+    REQUIRE_EQ(cpu_nodes[1], 1);
+    REQUIRE_EQ(cpu_nodes[3], 1);
+    REQUIRE_EQ(cpu_nodes[4], 0);
+    REQUIRE_EQ(cpu_nodes[8], 1);
+    REQUIRE_EQ(cpu_nodes[10], 2);
+    REQUIRE_EQ(cpu_nodes[11], 2);
+
+    // Every processor of this machine is on a node
+    int local_nodes[1];
+    int num_nodes = pool_read_nodes(local_nodes, 1);
+    REQUIRE_GE(num_nodes, 1);
+    REQUIRE_LT(local_nodes[0], num_nodes);
+}
+
+TEST(pool, pinned){
+    static pool_test_counts counts;
+
+#if POOL_AFFINITY
+    cpu_set_t before;
+    sched_getaffinity(0, sizeof(before), &before);
+#endif
+
+    // A pinned pool runs every iteration once and reports the processor and node of each thread
+    worker_pool pool;
+    pool_init_pinned(&pool, 3, 1);
+    pool_run(&pool, pool_test_task, &counts, 1000);
+    int exact = 1;
+    for (int i = 0; i < 1000; i++){
+        exact &= (atomic_load(&counts.counts[i]) == 1);
+    }
+    REQUIRE_EQ(exact, 1);
+    for (int i = 0; i < 3; i++){
+        REQUIRE_EQ(pool.stats[i].cpu, POOL_AFFINITY ? pool.cpus[i] : -1);
+        REQUIRE_LT(pool.stats[i].node, pool.num_nodes);
+    }
+    REQUIRE_GE(pool_current_node(&pool), 0);
+    REQUIRE_LT(pool_current_node(&pool), pool.num_nodes);
+    pool_free(&pool);
+
+    // The calling thread gets its processors back
+#if POOL_AFFINITY
+    cpu_set_t after;
+    sched_getaffinity(0, sizeof(after), &after);
+    REQUIRE_EQ(CPU_EQUAL(&before, &after), 1);
+#endif
+}
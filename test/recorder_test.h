@@ -0,0 +1,168 @@
+#include <tau/tau.h>
+#include "../src/include/recorder.h"
+
+TEST(recorder, traj_archive){
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.num_runs = 7;
+    run_params.traj_output = 0;
+    run_params.traj_archive = 3;
+    run_params.archive_path = "recorder_test_archive";
+
+    // Record a campaign of runs with different lengths
+    traj_recorder recorder;
+    recorder_init(&recorder, &run_params);
+    double row[TRAJ_NUM_FIELDS];
+    for (int i = 0; i < run_params.num_runs; i++){
+        recorder_begin_run(&recorder, i);
+        for (int step = 0; step < 1000 * (i + 1); step++){
+            for (int j = 0; j < TRAJ_NUM_FIELDS; j++){
+                row[j] = 1e6 * i + step + 0.01 * j;
+            }
+            recorder_step(&recorder, row, TRAJ_EVENT_NONE);
+        }
+        recorder_end_run(&recorder);
+    }
+    recorder_free(&recorder);
+
+    // Every third run is archived and can be loaded directly
+    int num_rows;
+    for (int i = 0; i < run_params.num_runs; i += 3){
+        double *rows = load_archived_trajectory(run_params.archive_path, i, &num_rows);
+        REQUIRE_TRUE(rows != NULL);
+        REQUIRE_EQ(num_rows, 1000 * (i + 1));
+        REQUIRE_EQ(rows[0], 1e6 * i);
+        REQUIRE_EQ(rows[(num_rows - 1) * TRAJ_NUM_FIELDS], 1e6 * i + num_rows - 1);
+        REQUIRE_EQ(rows[(num_rows - 1) * TRAJ_NUM_FIELDS + TRAJ_NUM_FIELDS - 1], 1e6 * i + num_rows - 1 + 0.01 * (TRAJ_NUM_FIELDS - 1));
+        free(rows);
+    }
+
+    // Runs in between are not archived
+    REQUIRE_TRUE(load_archived_trajectory(run_params.archive_path, 4, &num_rows) == NULL);
+    REQUIRE_EQ(num_rows, 0);
+    REQUIRE_TRUE(load_archived_trajectory(run_params.archive_path, 9, &num_rows) == NULL);
+
+    remove("recorder_test_archive.bin");
+    remove("recorder_test_archive.idx");
+}
+
+TEST(recorder, traj_output_last_run){
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.num_runs = 3;
+    run_params.traj_output = 1;
+    run_params.traj_archive = 0;
+    run_params.trajectory_path = "recorder_test_trajectory.txt";
+    remove(run_params.trajectory_path);
+
+    traj_recorder recorder;
+    recorder_init(&recorder, &run_params);
+    double row[TRAJ_NUM_FIELDS];
+    for (int i = 0; i < run_params.num_runs; i++){
+        recorder_begin_run(&recorder, i);
+        // Only the last run opens the text file
+        if (i < run_params.num_runs - 1){
+            REQUIRE_TRUE(recorder.text_writer == NULL);
+        }
+        for (int j = 0; j < TRAJ_NUM_FIELDS; j++){
+            row[j] = i;
+        }
+        recorder_step(&recorder, row, TRAJ_EVENT_NONE);
+        recorder_end_run(&recorder);
+    }
+    recorder_free(&recorder);
+
+    FILE *file = fopen(run_params.trajectory_path, "r");
+    REQUIRE_TRUE(file != NULL);
+    char line[2048];
+    double t;
+    REQUIRE_TRUE(fgets(line, sizeof(line), file) != NULL);
+    REQUIRE_TRUE(fgets(line, sizeof(line), file) != NULL);
+    REQUIRE_EQ(sscanf(line, "%lf", &t), 1);
+    REQUIRE_EQ(t, run_params.num_runs - 1);
+    fclose(file);
+    remove(run_params.trajectory_path);
+}
+
+TEST(recorder, recorder_sample){
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.num_runs = 1;
+    run_params.traj_output = 0;
+    run_params.traj_archive = 1;
+    run_params.traj_decimation = 4;
+    run_params.traj_cadence = 0;
+    run_params.archive_path = "recorder_test_archive";
+
+    traj_recorder recorder;
+    recorder_init(&recorder, &run_params);
+
+    // Every fourth step is recorded, plus any step with an event
+    recorder_begin_run(&recorder, 0);
+    int num_recorded = 0;
+    for (int step = 0; step < 100; step++){
+        int events = (step == 50) ? TRAJ_EVENT_STAGING : TRAJ_EVENT_NONE;
+        int record = recorder_sample(&recorder, 0.01 * step, events);
+        REQUIRE_EQ(record, (step % 4 == 0 || step == 50));
+        num_recorded += record;
+    }
+    REQUIRE_EQ(num_recorded, 26);
+    recorder_end_run(&recorder);
+
+    // A 0.1 s cadence with a 0.01 s step records every tenth step despite round-off in the time
+    run_params.traj_cadence = 0.1;
+    recorder_begin_run(&recorder, 0);
+    double t = 0;
+    num_recorded = 0;
+    for (int step = 0; step <= 1000; step++){
+        num_recorded += recorder_sample(&recorder, t, TRAJ_EVENT_NONE);
+        t += 0.01;
+    }
+    REQUIRE_EQ(num_recorded, 101);
+    recorder_end_run(&recorder);
+    recorder_free(&recorder);
+
+    // Nothing is sampled when the run is not recorded
+    run_params.traj_archive = 0;
+    recorder_init(&recorder, &run_params);
+    recorder_begin_run(&recorder, 0);
+    REQUIRE_EQ(recorder_sample(&recorder, 0, TRAJ_EVENT_IMPACT), 0);
+    recorder_end_run(&recorder);
+    recorder_free(&recorder);
+
+    remove("recorder_test_archive.bin");
+    remove("recorder_test_archive.idx");
+}
+
+TEST(recorder, traj_buffer){
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.num_runs = 1;
+
+    // Record into an undersized buffer so that it has to grow
+    traj_recorder recorder;
+    recorder_init(&recorder, &run_params);
+    recorder.buffer = traj_buffer_alloc(10);
+
+    double row[TRAJ_NUM_FIELDS];
+    recorder_begin_run(&recorder, 0);
+    for (int step = 0; step < 1000; step++){
+        REQUIRE_EQ(recorder_sample(&recorder, step, TRAJ_EVENT_NONE), 1);
+        for (int j = 0; j < TRAJ_NUM_FIELDS; j++){
+            row[j] = step + 0.01 * j;
+        }
+        recorder_step(&recorder, row, TRAJ_EVENT_NONE);
+    }
+    recorder_end_run(&recorder);
+
+    traj_buffer *buffer = recorder.buffer;
+    recorder_free(&recorder);
+
+    REQUIRE_EQ(buffer->num_rows, 1000);
+    REQUIRE_GE(buffer->capacity, 1000);
+    for (int step = 0; step < 1000; step++){
+        REQUIRE_EQ(buffer->rows[step * TRAJ_NUM_FIELDS], step);
+        REQUIRE_EQ(buffer->rows[step * TRAJ_NUM_FIELDS + TRAJ_NUM_FIELDS - 1], step + 0.01 * (TRAJ_NUM_FIELDS - 1));
+    }
+    traj_buffer_free(buffer);
+}
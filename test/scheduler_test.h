@@ -0,0 +1,31 @@
+#include <tau/tau.h>
+#include "../src/include/scheduler.h"
+
+TEST(scheduler, rate_group_due){
+    rate_group group;
+
+    // A zero period is due at every step and covers the step
+    rate_group_init(&group, 0);
+    REQUIRE_EQ(rate_group_due(&group, 0, 0.01), 0.01);
+    REQUIRE_EQ(rate_group_due(&group, 0.01, 0.01), 0.01);
+
+    // A 0.1 s period at a 0.01 s step is due every tenth step, despite the rounding of the accumulated time
+    rate_group_init(&group, 0.1);
+    double t = 0;
+    int num_due = 0;
+    for (int i = 0; i < 1000; i++){
+        double interval = rate_group_due(&group, t, 0.01);
+        if (interval > 0){
+            REQUIRE_EQ(i % 10, 0);
+            REQUIRE_EQ(interval, 0.1);
+            num_due += 1;
+        }
+        t += 0.01;
+    }
+    REQUIRE_EQ(num_due, 100);
+
+    // A period shorter than the step is due at every step and covers the step
+    rate_group_init(&group, 0.1);
+    REQUIRE_EQ(rate_group_due(&group, 0, 1), 1);
+    REQUIRE_EQ(rate_group_due(&group, 1, 1), 1);
+}
@@ -57,6 +57,8 @@ TEST(sensors, imu_meas){
     gsl_rng_env_setup();
     T = gsl_rng_default;
     rng = gsl_rng_alloc(T);
+    noise_buffer noise;
+    noise_buffer_init(&noise, rng);
 
     // // Initialize the run parameters
     runparams run_params;
@@ -98,7 +100,7 @@ TEST(sensors, imu_meas){
     vehicle vehicle = init_mmiii_ballistic();
     
     // Check that for zero scale stability, the accelerometer errors are zero
-    imu_measurement(&imu, &true_state, &est_state, &vehicle, rng);
+    imu_measurement(&imu, &true_state, &est_state, &vehicle);
     REQUIRE_EQ(fabs(est_state.ax_total - true_state.ax_total), 0);
     REQUIRE_EQ(fabs(est_state.ay_total - true_state.ay_total), 0);
     REQUIRE_EQ(fabs(est_state.az_total - true_state.az_total), 0);
@@ -107,7 +109,7 @@ TEST(sensors, imu_meas){
     true_state.ax_total = 0;
     true_state.ay_total = 0;
     true_state.az_total = 0;
-    imu_measurement(&imu, &true_state, &est_state, &vehicle, rng);
+    imu_measurement(&imu, &true_state, &est_state, &vehicle);
     REQUIRE_EQ(est_state.ax_total, 0);
     REQUIRE_EQ(est_state.ay_total, 0);
     REQUIRE_EQ(est_state.az_total, 0);
@@ -118,7 +120,7 @@ TEST(sensors, imu_meas){
     true_state.az_total = 10;
     run_params.acc_scale_stability = 1e-3;
     imu = imu_init(&run_params, &true_state, rng);
-    imu_measurement(&imu, &true_state, &est_state, &vehicle, rng);
+    imu_measurement(&imu, &true_state, &est_state, &vehicle);
     REQUIRE_NE(est_state.ax_total, true_state.ax_total);
 
 }
@@ -130,6 +132,8 @@ TEST(sensors, imu_update){
     gsl_rng_env_setup();
     T = gsl_rng_default;
     rng = gsl_rng_alloc(T);
+    noise_buffer noise;
+    noise_buffer_init(&noise, rng);
 
     // Initialize the run parameters
     runparams run_params;
@@ -158,9 +162,9 @@ TEST(sensors, imu_update){
     true_state.initial_theta_lat_pert = 0;
 
     imu = imu_init(&run_params, &true_state, rng);
-    imu_measurement(&imu, &true_state, &est_state_0, &vehicle, rng);
-    update_imu(&imu, time_step, rng);
-    imu_measurement(&imu, &true_state, &est_state_1, &vehicle, rng);
+    imu_measurement(&imu, &true_state, &est_state_0, &vehicle);
+    update_imu(&imu, time_step, time_step, &noise);
+    imu_measurement(&imu, &true_state, &est_state_1, &vehicle);
 
     REQUIRE_EQ(est_state_0.theta_long, est_state_1.theta_long);
     REQUIRE_EQ(est_state_0.theta_lat, est_state_1.theta_lat);
@@ -169,11 +173,11 @@ TEST(sensors, imu_update){
     run_params.gyro_bias_stability = 0;
     run_params.gyro_noise = 1e-3;
     imu = imu_init(&run_params, &true_state, rng);
-    imu_measurement(&imu, &true_state, &est_state_0, &vehicle, rng);
+    imu_measurement(&imu, &true_state, &est_state_0, &vehicle);
     for (int i = 0; i < 10; i++){
-        update_imu(&imu, time_step, rng);
+        update_imu(&imu, time_step, time_step, &noise);
     }
-    imu_measurement(&imu, &true_state, &est_state_1, &vehicle, rng);
+    imu_measurement(&imu, &true_state, &est_state_1, &vehicle);
     
     REQUIRE_LT(fabs(true_state.theta_long - est_state_0.theta_long), fabs(true_state.theta_long - est_state_1.theta_long));
     REQUIRE_LT(fabs(true_state.theta_lat - est_state_0.theta_lat), fabs(true_state.theta_lat - est_state_1.theta_lat));
@@ -182,17 +186,44 @@ TEST(sensors, imu_update){
     run_params.gyro_bias_stability = 1e-3;
     run_params.gyro_noise = 0;
     imu = imu_init(&run_params, &true_state, rng);
-    imu_measurement(&imu, &true_state, &est_state_0, &vehicle, rng);
+    imu_measurement(&imu, &true_state, &est_state_0, &vehicle);
     for (int i = 0; i < 10; i++){
-        update_imu(&imu, time_step, rng);
+        update_imu(&imu, time_step, time_step, &noise);
     }
-    imu_measurement(&imu, &true_state, &est_state_1, &vehicle, rng);
+    imu_measurement(&imu, &true_state, &est_state_1, &vehicle);
 
     REQUIRE_LT(fabs(true_state.theta_long - est_state_0.theta_long), fabs(true_state.theta_long - est_state_1.theta_long));
     REQUIRE_LT(fabs(true_state.theta_lat - est_state_0.theta_lat), fabs(true_state.theta_lat - est_state_1.theta_lat));
 
 }
 
+TEST(sensors, imu_update_interval){
+    // An update over a rate-group interval spreads the gyro error as much as the single steps it spans
+    noise_buffer noise;
+    noise_buffer_seed(&noise, 12345);
+    imu imu;
+    memset(&imu, 0, sizeof(imu));
+    imu.gyro_noise = 1e-3;
+    double time_step = 0.01;
+    double interval = 0.1;
+    int num_updates = 4000;
+    double sum_squares = 0;
+    for (int i = 0; i < num_updates; i++){
+        imu.gyro_error_long = 0;
+        update_imu(&imu, interval, time_step, &noise);
+        sum_squares += imu.gyro_error_long * imu.gyro_error_long;
+    }
+    double expected = imu.gyro_noise * imu.gyro_noise * time_step * interval;
+    REQUIRE_LT(fabs(sum_squares / num_updates - expected), 0.1 * expected);
+
+    // A single step keeps the noise of one draw
+    imu.gyro_error_long = 0;
+    noise_buffer_seed(&noise, 12345);
+    update_imu(&imu, time_step, time_step, &noise);
+    noise_buffer_seed(&noise, 12345);
+    REQUIRE_EQ(imu.gyro_error_long, imu.gyro_noise * noise_gaussian(&noise, 1) * time_step);
+}
+
 TEST(sensors, gnss_init){
     // Initialize the run parameters
     runparams run_params;
@@ -210,6 +241,8 @@ TEST(sensors, gnss_meas){
     gsl_rng_env_setup();
     T = gsl_rng_default;
     rng = gsl_rng_alloc(T);
+    noise_buffer noise;
+    noise_buffer_init(&noise, rng);
 
     // Initialize the run parameters
     runparams run_params;
@@ -226,7 +259,7 @@ TEST(sensors, gnss_meas){
     true_state.z = 10;
 
     // Check that for zero gnss noise the gnss errors are zero
-    gnss_measurement(&gnss, &true_state, &est_state, rng);
+    gnss_measurement(&gnss, &true_state, &est_state, &noise);
     REQUIRE_EQ(fabs(est_state.x - true_state.x), 0);
     REQUIRE_EQ(fabs(est_state.y - true_state.y), 0);
     REQUIRE_EQ(fabs(est_state.z - true_state.z), 0);
@@ -234,7 +267,7 @@ TEST(sensors, gnss_meas){
     // Check that for non-zero gnss noise the gnss errors are non-zero
     run_params.gnss_noise = 1e-3;
     gnss = gnss_init(&run_params);
-    gnss_measurement(&gnss, &true_state, &est_state, rng);
+    gnss_measurement(&gnss, &true_state, &est_state, &noise);
     REQUIRE_NE(est_state.x, true_state.x);
     REQUIRE_NE(est_state.y, true_state.y);
     REQUIRE_NE(est_state.z, true_state.z);
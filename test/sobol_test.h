@@ -0,0 +1,62 @@
+#include <tau/tau.h>
+#include "../src/include/sobol.h"
+
+TEST(sobol, sobol_factor){
+    // Each static error source belongs to the factor of the run parameter that sets its standard deviation
+    REQUIRE_EQ(sobol_factor(ERROR_INITIAL_X), SOBOL_FACTOR_INITIAL_X);
+    REQUIRE_EQ(sobol_factor(ERROR_INITIAL_Z), SOBOL_FACTOR_INITIAL_POS);
+    REQUIRE_EQ(sobol_factor(ERROR_INITIAL_ROT), SOBOL_FACTOR_INITIAL_ANGLE);
+    REQUIRE_EQ(sobol_factor(ERROR_INITIAL_VX), SOBOL_FACTOR_INITIAL_VEL);
+    REQUIRE_EQ(sobol_factor(ERROR_ACC_SCALE_Y), SOBOL_FACTOR_ACC_SCALE);
+    REQUIRE_EQ(sobol_factor(ERROR_GYRO_BIAS_LAT), SOBOL_FACTOR_GYRO_BIAS);
+    REQUIRE_EQ(sobol_factor(ERROR_EST_GEOID_HEIGHT), SOBOL_FACTOR_GRAV);
+    REQUIRE_EQ(sobol_factor(NUM_ERROR_SOURCES - 1), SOBOL_FACTOR_ATM);
+
+    // A cross sample differs from the row of A only in the inputs of its factor
+    error_sample a, b;
+    draw_error_sample(1, 0, PHILOX_STREAM_SOBOL_A, &a);
+    draw_error_sample(1, 0, PHILOX_STREAM_SOBOL_B, &b);
+    error_sample cross = sobol_cross_sample(&a, &b, SOBOL_FACTOR_GYRO_BIAS);
+    for (int source = 0; source < NUM_ERROR_SOURCES; source++){
+        double expected = (sobol_factor(source) == SOBOL_FACTOR_GYRO_BIAS) ? b.deviates[source] : a.deviates[source];
+        REQUIRE_EQ(cross.deviates[source], expected);
+    }
+    REQUIRE_EQ(cross.noise_seed, a.noise_seed);
+    REQUIRE_EQ(cross.lat, a.lat);
+}
+
+TEST(sobol, sobol_run){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.1;
+
+    // (n + 2) N trajectories for the n active factors (the x position error and the sensor noise are off)
+    int num_samples = 64;
+    run_params.num_threads = 1;
+    sobol_indices serial = sobol_run(run_params, num_samples);
+    REQUIRE_EQ(serial.active[SOBOL_FACTOR_INITIAL_X], 0);
+    REQUIRE_EQ(serial.active[SOBOL_FACTOR_NOISE], 0);
+    REQUIRE_EQ(serial.num_flights, (SOBOL_NUM_FACTORS - 2 + 2) * num_samples);
+    REQUIRE_EQ(serial.total[SOBOL_OUTPUT_EAST][SOBOL_FACTOR_INITIAL_X], 0);
+
+    // The results do not depend on the number of threads
+    run_params.num_threads = 4;
+    sobol_indices parallel = sobol_run(run_params, num_samples);
+    REQUIRE_EQ(serial.first_order[SOBOL_OUTPUT_MISS][SOBOL_FACTOR_ATM], parallel.first_order[SOBOL_OUTPUT_MISS][SOBOL_FACTOR_ATM]);
+    REQUIRE_EQ(serial.total_ci[SOBOL_OUTPUT_EAST][SOBOL_FACTOR_ACC_SCALE][1], parallel.total_ci[SOBOL_OUTPUT_EAST][SOBOL_FACTOR_ACC_SCALE][1]);
+
+    // The confidence intervals bracket the total indices, which are bounded by one
+    for (int o = 0; o < SOBOL_NUM_OUTPUTS; o++){
+        for (int factor = 0; factor < SOBOL_NUM_FACTORS; factor++){
+            REQUIRE_GE(serial.total[o][factor], 0);
+            REQUIRE_LT(serial.total[o][factor], 1.5);
+            REQUIRE_LE(serial.total_ci[o][factor][0], serial.total[o][factor] + 1e-12);
+            REQUIRE_GE(serial.total_ci[o][factor][1], serial.total[o][factor] - 1e-12);
+        }
+    }
+
+    // The accelerometer scale factors and the atmosphere dominate the east dispersion, gravity does not contribute
+    REQUIRE_GT(serial.total[SOBOL_OUTPUT_EAST][SOBOL_FACTOR_ACC_SCALE], 0.2);
+    REQUIRE_GT(serial.total[SOBOL_OUTPUT_EAST][SOBOL_FACTOR_ATM], 0.2);
+    REQUIRE_LT(serial.total[SOBOL_OUTPUT_EAST][SOBOL_FACTOR_GRAV], 0.02);
+}
@@ -0,0 +1,59 @@
+#include <tau/tau.h>
+#include "../src/include/surrogate.h"
+
+TEST(surrogate, surrogate_terms){
+    response_surface surrogate = {0};
+    surrogate.num_sources = 3;
+    surrogate.num_terms = 10;
+    double variables[3] = {2, 3, 5};
+    double terms[10];
+    surrogate_terms(&surrogate, variables, terms);
+    double expected[10] = {1, 2, 3, 5, 4, 9, 25, 6, 10, 15};
+    for (int t = 0; t < 10; t++){
+        REQUIRE_EQ(terms[t], expected[t]);
+    }
+
+    // The surface is the dot product of the coefficients and the terms
+    surrogate.coefficients[SURROGATE_OUTPUT_X][0] = 1;
+    surrogate.coefficients[SURROGATE_OUTPUT_X][9] = 2;
+    double outputs[SURROGATE_NUM_OUTPUTS];
+    surrogate_eval(&surrogate, variables, outputs);
+    REQUIRE_EQ(outputs[SURROGATE_OUTPUT_X], 31);
+    REQUIRE_EQ(outputs[SURROGATE_OUTPUT_TIME], 0);
+}
+
+TEST(surrogate, surrogate_fit){
+    runparams run_params;
+    lincov_test_params(&run_params);
+    run_params.time_step_reentry = 0.1;
+    run_params.num_threads = 4;
+
+    // Too few design runs for the terms
+    response_surface small = surrogate_fit(run_params, 10, 0, 1);
+    REQUIRE_EQ(small.num_terms, 0);
+
+    response_surface surrogate = surrogate_fit(run_params, 600, 50, 2);
+    int n = surrogate.num_sources;
+    REQUIRE_EQ(surrogate.num_terms, 1 + 2*n + n*(n - 1)/2);
+
+    // The surface predicts held-out runs to a small fraction of their spread
+    REQUIRE_GT(surrogate.validation_spread[0], 0);
+    REQUIRE_LT(surrogate.validation_rms[0], 0.1 * surrogate.validation_spread[0]);
+
+    // At the nominal error fields the sampled dispersion matches that of the trajectories
+    double multipliers[SURROGATE_NUM_FIELDS];
+    for (int field = 0; field < SURROGATE_NUM_FIELDS; field++){
+        multipliers[field] = 1;
+    }
+    impact_dispersion dispersion = surrogate_dispersion(&surrogate, multipliers, 2000);
+    impact_dispersion mc = mc_dispersion(run_params, 200);
+    REQUIRE_EQ(dispersion.num_flights, 2000);
+    REQUIRE_LT(fabs(dispersion.cep - mc.cep), 0.15 * mc.cep);
+
+    // Zeroing every field leaves the Coriolis correction of the nominal impact time error only
+    for (int field = 0; field < SURROGATE_NUM_FIELDS; field++){
+        multipliers[field] = 0;
+    }
+    impact_dispersion nominal = surrogate_dispersion(&surrogate, multipliers, 2000);
+    REQUIRE_LT(nominal.cep, 0.2 * dispersion.cep);
+}
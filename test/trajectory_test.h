@@ -68,6 +68,10 @@ TEST(trajectory, fly){
     run_params.gnss_nav = 0;
     run_params.ins_nav = 1;
     run_params.rv_maneuv = 0;
+    run_params.imu_period = 0;
+    run_params.gnss_period = 0;
+    run_params.guidance_period = 0;
+    run_params.lift_period = 0;
     run_params.initial_x_error = 0;
     run_params.initial_pos_error = 0;
     run_params.initial_vel_error = 0;
@@ -81,7 +85,7 @@ TEST(trajectory, fly){
     initial_state.theta_long = 0;
     initial_state.x += 10;
     
-    state final_state = fly(&run_params, &initial_state, &vehicle, rng);
+    state final_state = fly(&run_params, &initial_state, &vehicle, rng, NULL);
 
     REQUIRE_LT(fabs(final_state.t - 1), 1);
     REQUIRE_LT(fabs(final_state.x - 6371e3), 1e-6);
@@ -95,7 +99,7 @@ TEST(trajectory, fly){
     initial_state.vx = 10;
     initial_state.vy = 10;
     initial_state.vz = 10;
-    final_state = fly(&run_params, &initial_state, &vehicle, rng);
+    final_state = fly(&run_params, &initial_state, &vehicle, rng, NULL);
 
     REQUIRE_LT(fabs(final_state.t - 2), 1);
 
@@ -103,7 +107,7 @@ TEST(trajectory, fly){
     vehicle = init_mmiii_ballistic();
     initial_state = init_true_state(&run_params, rng);
     initial_state.theta_long = 0;
-    final_state = fly(&run_params, &initial_state, &vehicle, rng);
+    final_state = fly(&run_params, &initial_state, &vehicle, rng, NULL);
 
     REQUIRE_GT(final_state.t, 0);
     REQUIRE_LT(fabs(final_state.x - 6371e3), 1e-6);
@@ -115,13 +119,331 @@ TEST(trajectory, fly){
     initial_state.theta_long = M_PI/4;
     run_params.traj_output = 0;
 
-    final_state = fly(&run_params, &initial_state, &vehicle, rng);
+    final_state = fly(&run_params, &initial_state, &vehicle, rng, NULL);
 
     REQUIRE_GT(final_state.t, 0);
     REQUIRE_LT(fabs(sqrt(final_state.x*final_state.x + final_state.y*final_state.y) - 6371e3), 1);
 
 }
 
+TEST(trajectory, fly_traj_sampling){
+    const gsl_rng_type *T;
+    gsl_rng *rng;
+    gsl_rng_env_setup();
+    T = gsl_rng_default;
+    rng = gsl_rng_alloc(T);
+
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.num_runs = 3;
+    run_params.traj_archive = 1;
+    run_params.archive_path = "trajectory_test_archive";
+    run_params.time_step_main = 1;
+    run_params.time_step_reentry = 0.01;
+    run_params.x_aim = 6371e3;
+    run_params.theta_long = M_PI/4;
+    run_params.ins_nav = 1;
+
+    // Fly the same trajectory with every step, every 100th step, and a 10 s cadence
+    traj_recorder recorder;
+    recorder_init(&recorder, &run_params);
+    vehicle vehicle;
+    state final_states[3];
+    for (int i = 0; i < run_params.num_runs; i++){
+        run_params.traj_decimation = (i == 1) ? 100 : 1;
+        run_params.traj_cadence = (i == 2) ? 10 : 0;
+        vehicle = init_mmiii_ballistic();
+        state initial_state = init_true_state(&run_params, rng);
+        initial_state.theta_long = M_PI/4;
+        recorder_begin_run(&recorder, i);
+        final_states[i] = fly(&run_params, &initial_state, &vehicle, rng, &recorder);
+        recorder_end_run(&recorder);
+    }
+    recorder_free(&recorder);
+
+    int num_rows[3];
+    double *rows[3];
+    for (int i = 0; i < run_params.num_runs; i++){
+        rows[i] = load_archived_trajectory(run_params.archive_path, i, &num_rows[i]);
+        REQUIRE_TRUE(rows[i] != NULL);
+
+        // The launch and impact states are always recorded
+        REQUIRE_EQ(rows[i][0], 0);
+        REQUIRE_EQ(rows[i][(num_rows[i] - 1) * TRAJ_NUM_FIELDS], final_states[i].t);
+    }
+    REQUIRE_LT(num_rows[1], num_rows[0] / 50);
+    REQUIRE_LT(num_rows[2], num_rows[0] / 50);
+
+    // Every decimated row is either on the cadence or a flight event, and staging and burnout are kept
+    int num_events = 0;
+    for (int j = 1; j < num_rows[2] - 1; j++){
+        double t = rows[2][j * TRAJ_NUM_FIELDS];
+        if (fabs(t - 10 * round(t / 10)) > 1e-3){
+            num_events++;
+        }
+    }
+    REQUIRE_GE(num_events, 3);
+    int burnout_recorded = 0;
+    for (int j = 0; j < num_rows[1]; j++){
+        double t = rows[1][j * TRAJ_NUM_FIELDS];
+        if (t > vehicle.booster.total_burn_time && t <= vehicle.booster.total_burn_time + run_params.time_step_main){
+            burnout_recorded = 1;
+        }
+    }
+    REQUIRE_TRUE(burnout_recorded);
+
+    for (int i = 0; i < run_params.num_runs; i++){
+        free(rows[i]);
+    }
+    remove("trajectory_test_archive.bin");
+    remove("trajectory_test_archive.idx");
+}
+
+TEST(trajectory, fly_traj_hermite){
+    const gsl_rng_type *T;
+    gsl_rng *rng;
+    gsl_rng_env_setup();
+    T = gsl_rng_default;
+    rng = gsl_rng_alloc(T);
+
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.num_runs = 2;
+    run_params.traj_archive = 1;
+    run_params.archive_path = "trajectory_test_archive";
+    run_params.time_step_main = 1;
+    run_params.time_step_reentry = 0.01;
+    run_params.x_aim = 6371e3;
+    run_params.theta_long = M_PI/4;
+    run_params.ins_nav = 1;
+    run_params.traj_hermite_tol = 1;
+
+    // Fly the same trajectory with every step stored, then with Hermite knots only
+    traj_recorder recorder;
+    recorder_init(&recorder, &run_params);
+    for (int i = 0; i < run_params.num_runs; i++){
+        run_params.traj_hermite_tol = (i == 1) ? 1 : 0;
+        vehicle vehicle = init_mmiii_ballistic();
+        state initial_state = init_true_state(&run_params, rng);
+        initial_state.theta_long = M_PI/4;
+        recorder_begin_run(&recorder, i);
+        fly(&run_params, &initial_state, &vehicle, rng, &recorder);
+        recorder_end_run(&recorder);
+    }
+    recorder_free(&recorder);
+
+    int num_rows, num_knots;
+    double *rows = load_archived_trajectory(run_params.archive_path, 0, &num_rows);
+    double *knots = load_archived_trajectory(run_params.archive_path, 1, &num_knots);
+    REQUIRE_TRUE(rows != NULL);
+    REQUIRE_TRUE(knots != NULL);
+    REQUIRE_LT(num_knots, num_rows / 100);
+
+    // Every step before impact is reconstructed within the tolerance (the impact point has a random coriolis term)
+    double row[TRAJ_NUM_FIELDS];
+    for (int j = 0; j < num_rows - 1; j++){
+        double *exact = rows + j * TRAJ_NUM_FIELDS;
+        hermite_eval(knots, num_knots, exact[0], row);
+        for (int k = 0; k < HERMITE_NUM_STATES; k++){
+            int p = hermite_pos_fields[k];
+            double dx = row[p] - exact[p];
+            double dy = row[p+1] - exact[p+1];
+            double dz = row[p+2] - exact[p+2];
+            REQUIRE_LE(sqrt(dx*dx + dy*dy + dz*dz), 1 + 1e-6);
+        }
+    }
+
+    free(rows);
+    free(knots);
+    remove("trajectory_test_archive.bin");
+    remove("trajectory_test_archive.idx");
+}
+
+TEST(trajectory, fly_trajectory){
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.time_step_main = 1;
+    run_params.time_step_reentry = 0.01;
+    run_params.x_aim = 6371e3;
+    run_params.theta_long = M_PI/4;
+    run_params.ins_nav = 1;
+
+    // The estimate is close enough that the buffer does not need to grow for the reference flight
+    traj_buffer *buffer = fly_trajectory(run_params, 0, 0);
+    REQUIRE_TRUE(buffer != NULL);
+    REQUIRE_GT(buffer->num_rows, 1000);
+    REQUIRE_LE(buffer->num_rows, buffer->capacity);
+    REQUIRE_LT(buffer->capacity, 2 * buffer->num_rows);
+
+    REQUIRE_EQ(buffer->rows[0], 0);
+    double *last_row = buffer->rows + (buffer->num_rows - 1) * TRAJ_NUM_FIELDS;
+    REQUIRE_LT(fabs(sqrt(last_row[2]*last_row[2] + last_row[3]*last_row[3] + last_row[4]*last_row[4]) - 6371e3), 1e2);
+    traj_buffer_free(buffer);
+
+    // Decimated output with an explicit size hint
+    run_params.traj_decimation = 100;
+    buffer = fly_trajectory(run_params, 0, 8);
+    REQUIRE_GT(buffer->num_rows, 8);
+    REQUIRE_LT(buffer->num_rows, 1000);
+    traj_buffer_free(buffer);
+}
+
+TEST(trajectory, mc_single_run){
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.time_step_main = 1;
+    run_params.time_step_reentry = 0.1;
+    run_params.x_aim = 6371e3;
+    run_params.theta_long = M_PI/4;
+    run_params.initial_pos_error = 10;
+    run_params.ins_nav = 1;
+    run_params.gyro_noise = 1e-5;
+
+    // A run depends only on the seed and its index, not on the runs simulated before it
+    state run_3 = mc_single_run(&run_params, 42, 3, NULL);
+    state run_1 = mc_single_run(&run_params, 42, 1, NULL);
+    state run_3_again = mc_single_run(&run_params, 42, 3, NULL);
+    REQUIRE_EQ(run_3.x, run_3_again.x);
+    REQUIRE_EQ(run_3.y, run_3_again.y);
+    REQUIRE_EQ(run_3.t, run_3_again.t);
+    REQUIRE_NE(run_3.y, run_1.y);
+
+    // A different seed gives a different run
+    state run_3_seed = mc_single_run(&run_params, 43, 3, NULL);
+    REQUIRE_NE(run_3.y, run_3_seed.y);
+}
+
+TEST(trajectory, flight_step){
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.time_step_main = 1;
+    run_params.time_step_reentry = 0.1;
+    run_params.x_aim = 6371e3;
+    run_params.theta_long = M_PI/4;
+    run_params.initial_pos_error = 10;
+    run_params.ins_nav = 1;
+    run_params.gyro_noise = 1e-5;
+
+    // Stepping a flight by hand reproduces fly() exactly
+    gsl_rng *rng = philox_alloc(7, 0, PHILOX_STREAM_RUN);
+    vehicle vehicle = init_mmiii_ballistic();
+    state initial_state = init_true_state(&run_params, rng);
+    state fly_state = fly(&run_params, &initial_state, &vehicle, rng, NULL);
+
+    philox_set_stream(rng, 7, 0, PHILOX_STREAM_RUN);
+    vehicle = init_mmiii_ballistic();
+    initial_state = init_true_state(&run_params, rng);
+    flight flight;
+    flight_init(&flight, &run_params, &initial_state, &vehicle, rng, NULL);
+    int steps = 0;
+    while (!flight_step(&flight)){
+        steps++;
+    }
+    REQUIRE_EQ(flight.steps, steps + 1);
+    REQUIRE_EQ(flight.impacted, 1);
+
+    // Further steps leave an impacted flight unchanged
+    REQUIRE_EQ(flight_step(&flight), 1);
+    REQUIRE_EQ(flight.steps, steps + 1);
+
+    state step_state = flight_impact(&flight);
+    REQUIRE_EQ(step_state.x, fly_state.x);
+    REQUIRE_EQ(step_state.y, fly_state.y);
+    REQUIRE_EQ(step_state.z, fly_state.z);
+    REQUIRE_EQ(step_state.t, fly_state.t);
+
+    gsl_rng_free(rng);
+}
+
+TEST(trajectory, flight_snapshot){
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.time_step_main = 1;
+    run_params.time_step_reentry = 0.1;
+    run_params.x_aim = 6371e3;
+    run_params.theta_long = M_PI/4;
+    run_params.initial_pos_error = 10;
+    run_params.ins_nav = 1;
+    run_params.atm_error = 1;
+    run_params.gyro_noise = 1e-5;
+
+    gsl_rng *rng = philox_alloc(7, 0, PHILOX_STREAM_RUN);
+    vehicle vehicle = init_mmiii_ballistic();
+    state initial_state = init_true_state(&run_params, rng);
+    state fly_state = fly(&run_params, &initial_state, &vehicle, rng, NULL);
+
+    // Snapshot the same flight after burnout, with the generator in the same state
+    philox_set_stream(rng, 7, 0, PHILOX_STREAM_RUN);
+    vehicle = init_mmiii_ballistic();
+    initial_state = init_true_state(&run_params, rng);
+    flight flight;
+    flight_init(&flight, &run_params, &initial_state, &vehicle, rng, NULL);
+    for (int i = 0; i < 500; i++){
+        flight_step(&flight);
+    }
+    REQUIRE_GT(flight.new_true_state.t, vehicle.booster.total_burn_time);
+    flight_snapshot snapshot;
+    flight_snapshot_take(&snapshot, &flight);
+    gsl_rng *fork_rng = gsl_rng_clone(rng);
+    double snapshot_mass = vehicle.current_mass;
+
+    // Finishing the original flight leaves the snapshot untouched
+    while (!flight_step(&flight));
+    state original_state = flight_impact(&flight);
+    REQUIRE_EQ(snapshot.vehicle.current_mass, snapshot_mass);
+    REQUIRE_EQ(snapshot.flight.steps, 500);
+
+    // A flight continued from the snapshot reproduces fly() exactly
+    struct flight forked;
+    struct vehicle forked_vehicle;
+    flight_snapshot_restore(&snapshot, &forked, &forked_vehicle, fork_rng, NULL);
+    REQUIRE_TRUE(forked.vehicle == &forked_vehicle);
+    while (!flight_step(&forked));
+    state forked_state = flight_impact(&forked);
+    REQUIRE_EQ(forked_state.x, fly_state.x);
+    REQUIRE_EQ(forked_state.y, fly_state.y);
+    REQUIRE_EQ(forked_state.z, fly_state.z);
+    REQUIRE_EQ(original_state.x, fly_state.x);
+    REQUIRE_EQ(forked.steps, flight.steps);
+
+    gsl_rng_free(fork_rng);
+    gsl_rng_free(rng);
+}
+
+TEST(trajectory, fly_multi_rate){
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.time_step_main = 1;
+    run_params.time_step_reentry = 0.01;
+    run_params.x_aim = 6371e3;
+    run_params.theta_long = M_PI/4;
+    run_params.ins_nav = 1;
+    run_params.gnss_nav = 1;
+    run_params.rv_maneuv = 1;
+    run_params.rv_type = 1;
+
+    state every_step = mc_single_run(&run_params, 1, 0, NULL);
+
+    // Periods equal to the integration step reproduce the single-rate flight exactly
+    run_params.imu_period = 0.01;
+    run_params.gnss_period = 0.01;
+    run_params.guidance_period = 0.01;
+    run_params.lift_period = 0.01;
+    state step_rate = mc_single_run(&run_params, 1, 0, NULL);
+    REQUIRE_EQ(step_rate.x, every_step.x);
+    REQUIRE_EQ(step_rate.y, every_step.y);
+    REQUIRE_EQ(step_rate.z, every_step.z);
+
+    // Slower sensors and guidance move the impact point only slightly
+    run_params.gnss_period = 1;
+    run_params.guidance_period = 0.1;
+    run_params.lift_period = 0.1;
+    state multi_rate = mc_single_run(&run_params, 1, 0, NULL);
+    double miss = sqrt(pow(multi_rate.x - every_step.x, 2) + pow(multi_rate.y - every_step.y, 2) + pow(multi_rate.z - every_step.z, 2));
+    REQUIRE_GT(miss, 0);
+    REQUIRE_LT(miss, 1e3);
+}
+
 TEST(trajectory, update_aimpoint){
     // Set the run parameters
     runparams run_params;
@@ -0,0 +1,34 @@
+#include <tau/tau.h>
+#include "../src/include/unscented.h"
+
+TEST(unscented, unscented_run){
+    runparams run_params;
+    lincov_test_params(&run_params);
+
+    // Without errors only the nominal trajectory is flown
+    runparams no_errors;
+    memset(&no_errors, 0, sizeof(no_errors));
+    no_errors.time_step_main = 1;
+    no_errors.time_step_reentry = 0.1;
+    no_errors.theta_long = 1.04719755;
+    impact_dispersion nominal = unscented_run(no_errors);
+    REQUIRE_EQ(nominal.num_flights, 1);
+    REQUIRE_EQ(nominal.cep, 0);
+
+    // 2n + 1 sigma points, with results that do not depend on the number of threads
+    int sources[NUM_ERROR_SOURCES];
+    int n = active_error_sources(&run_params, sources);
+    run_params.num_threads = 1;
+    impact_dispersion serial = unscented_run(run_params);
+    run_params.num_threads = 4;
+    impact_dispersion parallel = unscented_run(run_params);
+    REQUIRE_EQ(serial.num_flights, 2 * n + 1);
+    REQUIRE_EQ(serial.cep, parallel.cep);
+    REQUIRE_EQ(serial.mean[0], parallel.mean[0]);
+    REQUIRE_EQ(serial.covariance[0][1], parallel.covariance[0][1]);
+
+    // For mild nonlinearity the sigma points agree with the linearization
+    impact_dispersion lincov = lincov_run(run_params);
+    REQUIRE_LT(fabs(serial.cep - lincov.cep), 0.1 * lincov.cep);
+    REQUIRE_LT(fabs(serial.local_covariance[0][0] - lincov.local_covariance[0][0]), 0.1 * lincov.local_covariance[0][0]);
+}
@@ -0,0 +1,79 @@
+#include "../src/include/trajectory.h"
+
+void bench_writer(void){
+    /*
+    Measures fly() throughput with trajectory output off and on, and the cost of the previous per-step fprintf output
+    */
+
+    int num_flights = 5;
+
+    runparams run_params;
+    memset(&run_params, 0, sizeof(run_params));
+    run_params.trajectory_path = "bench_trajectory.txt";
+    run_params.num_runs = 1;
+    run_params.time_step_main = 1;
+    run_params.time_step_reentry = 0.01;
+    run_params.theta_long = 0.785398163397;
+    run_params.x_aim = 6371e3;
+    run_params.ins_nav = 1;
+    run_params.rv_type = 0;
+
+    gsl_rng_env_setup();
+    gsl_rng *rng = gsl_rng_alloc(gsl_rng_default);
+
+    printf("Trajectory writer (%d flights, MMIII ballistic, reentry step %.2f s)\n", num_flights, run_params.time_step_reentry);
+
+    // Trajectory output off and on
+    double elapsed[2];
+    for (int traj_output = 0; traj_output <= 1; traj_output++){
+        run_params.traj_output = traj_output;
+        traj_recorder recorder;
+        recorder_init(&recorder, &run_params);
+        double start = bench_seconds();
+        for (int i = 0; i < num_flights; i++){
+            vehicle vehicle = init_mmiii_ballistic();
+            state initial_state = init_true_state(&run_params, rng);
+            recorder_begin_run(&recorder, 0);
+            fly(&run_params, &initial_state, &vehicle, rng, &recorder);
+            recorder_end_run(&recorder);
+        }
+        elapsed[traj_output] = (bench_seconds() - start) / num_flights;
+        recorder_free(&recorder);
+    }
+
+    // Count the rows written per flight
+    FILE *file = fopen(run_params.trajectory_path, "r");
+    long num_rows = -1;
+    int c;
+    while ((c = fgetc(file)) != EOF){
+        if (c == '\n'){
+            num_rows++;
+        }
+    }
+    fclose(file);
+
+    // Format the same number of rows with fprintf on the calling thread, as fly() did before the writer thread
+    double row[TRAJ_NUM_FIELDS];
+    for (int j = 0; j < TRAJ_NUM_FIELDS; j++){
+        row[j] = 6371e3 + j;
+    }
+    file = fopen(run_params.trajectory_path, "w");
+    double start = bench_seconds();
+    for (long i = 0; i < num_rows; i++){
+        fprintf(file, "%f", row[0]);
+        for (int j = 1; j < TRAJ_NUM_FIELDS; j++){
+            fprintf(file, ", %f", row[j]);
+        }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    double fprintf_time = bench_seconds() - start;
+    remove(run_params.trajectory_path);
+
+    printf("    steps per flight:           %ld\n", num_rows);
+    printf("    output off:                 %8.2f ms/flight  %10.0f steps/s\n", 1e3 * elapsed[0], num_rows / elapsed[0]);
+    printf("    output on (async writer):   %8.2f ms/flight  %10.0f steps/s\n", 1e3 * elapsed[1], num_rows / elapsed[1]);
+    printf("    fprintf on the fly() thread: %7.2f ms/flight of formatting alone (previous behaviour)\n", 1e3 * fprintf_time);
+
+    gsl_rng_free(rng);
+}
@@ -0,0 +1,54 @@
+#include <tau/tau.h>
+#include "../src/include/writer.h"
+
+TEST(writer, traj_writer_push){
+    // Push enough rows to cycle through both blocks several times
+    int num_rows = 5 * TRAJ_BLOCK_SIZE + 7;
+    traj_writer *writer = traj_writer_open("writer_test.txt", "header\n");
+    REQUIRE_TRUE(writer != NULL);
+
+    double row[TRAJ_NUM_FIELDS];
+    for (int i = 0; i < num_rows; i++){
+        for (int j = 0; j < TRAJ_NUM_FIELDS; j++){
+            row[j] = i + 0.5 * j;
+        }
+        traj_writer_push(writer, row);
+    }
+    REQUIRE_EQ(writer->num_rows, num_rows);
+    traj_writer_close(writer);
+
+    // Read the file back and check that every row arrived in order
+    FILE *file = fopen("writer_test.txt", "r");
+    REQUIRE_TRUE(file != NULL);
+    char line[2048];
+    REQUIRE_TRUE(fgets(line, sizeof(line), file) != NULL);
+    REQUIRE_EQ(strcmp(line, "header\n"), 0);
+
+    int count = 0;
+    double first, second;
+    while (fgets(line, sizeof(line), file) != NULL){
+        REQUIRE_EQ(sscanf(line, "%lf, %lf", &first, &second), 2);
+        REQUIRE_EQ(first, count);
+        REQUIRE_EQ(second, count + 0.5);
+        count++;
+    }
+    fclose(file);
+    remove("writer_test.txt");
+
+    REQUIRE_EQ(count, num_rows);
+}
+
+TEST(writer, traj_writer_empty){
+    // Closing a writer with no rows should leave only the header
+    traj_writer *writer = traj_writer_open("writer_test.txt", "header\n");
+    REQUIRE_TRUE(writer != NULL);
+    traj_writer_close(writer);
+
+    FILE *file = fopen("writer_test.txt", "r");
+    REQUIRE_TRUE(file != NULL);
+    char line[2048];
+    REQUIRE_TRUE(fgets(line, sizeof(line), file) != NULL);
+    REQUIRE_TRUE(fgets(line, sizeof(line), file) == NULL);
+    fclose(file);
+    remove("writer_test.txt");
+}